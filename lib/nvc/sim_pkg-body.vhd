@@ -26,4 +26,14 @@ package body sim_pkg is
         return 0;                       -- Has a foreign implementation
     end function;
 
+    impure function test_plusargs (name : string) return boolean is
+    begin
+        return false;                   -- Has a foreign implementation
+    end function;
+
+    impure function value_plusargs (name : string) return string is
+    begin
+        return "";                      -- Has a foreign implementation
+    end function;
+
 end package body;
@@ -31,4 +31,16 @@ package sim_pkg is
 
     attribute foreign of current_delta_cycle : function is "INTERNAL _nvc_current_delta";
 
+    -- Return TRUE if any plusarg passed to the simulation begins with
+    -- NAME, similar to Verilog $test$plusargs
+    impure function test_plusargs (name : string) return boolean;
+
+    attribute foreign of test_plusargs : function is "INTERNAL _nvc_test_plusargs";
+
+    -- Return the remainder of the first plusarg that begins with NAME or
+    -- the empty string if there is no such plusarg
+    impure function value_plusargs (name : string) return string;
+
+    attribute foreign of value_plusargs : function is "INTERNAL _nvc_value_plusargs";
+
 end package;
@@ -36,22 +36,32 @@
 #include <limits.h>
 #include <unistd.h>
 #include <ctype.h>
+#include <dirent.h>
 
 #include <llvm-c/Core.h>
 #include <llvm-c/ExecutionEngine.h>
 
 typedef A(vcode_unit_t) unit_list_t;
 typedef A(char *) obj_list_t;
+typedef A(ident_t) import_list_t;
 
 typedef struct {
-   unit_list_t      units;
-   char            *obj_path;
-   char            *module_name;
-   unsigned         index;
-   cover_data_t    *cover;
-   llvm_obj_t      *obj;
+   unit_list_t       units;
+   import_list_t     imports;
+   obj_list_t       *objs;
+   char             *module_name;
+   unsigned          index;
+   llvm_opt_level_t  olevel;
+   const char       *cache_dir;
 } cgen_job_t;
 
+typedef struct {
+   hset_t          *filter;
+   hset_t          *local;
+   import_list_t   *imports;
+   unit_registry_t *registry;
+} import_args_t;
+
 typedef struct {
    unit_list_t     *units;
    hset_t          *filter;
@@ -201,7 +211,8 @@ static void cgen_linker_setup(void)
 #endif
 }
 
-static void cgen_link(const char *module_name, char **objs, int nobjs)
+static void cgen_link(const char *module_name, char **objs, int nobjs,
+                      bool unlink_objs)
 {
    cgen_linker_setup();
 
@@ -252,7 +263,7 @@ static void cgen_link(const char *module_name, char **objs, int nobjs)
 
    run_program((const char * const *)link_args.items);
 
-   for (int i = 0; i < nobjs ; i++) {
+   for (int i = 0; unlink_objs && i < nobjs ; i++) {
       if (unlink(objs[i]) != 0)
          fatal_errno("unlink: %s", objs[i]);
    }
@@ -264,6 +275,67 @@ static void cgen_link(const char *module_name, char **objs, int nobjs)
    ACLEAR(link_args);
 }
 
+static void cgen_import_cb(ident_t name, void *ctx)
+{
+   import_args_t *args = ctx;
+
+   if (!hset_contains(args->filter, name))
+      return;   // Not part of the design library
+   else if (hset_contains(args->local, name))
+      return;
+
+   vcode_unit_t vu = unit_registry_get(args->registry, name);
+   if (vu == NULL || vcode_unit_kind(vu) != VCODE_UNIT_FUNCTION)
+      return;
+
+   APUSH(*args->imports, name);
+   hset_insert(args->local, name);
+}
+
+static void cgen_find_imports(cgen_job_t *job, unit_registry_t *ur,
+                              hset_t *filter)
+{
+   // Copy the bodies of functions called from this job but defined in
+   // another object so they are visible to the inliner
+   import_args_t args = {
+      .filter   = filter,
+      .local    = hset_new(job->units.count * 2),
+      .imports  = &(job->imports),
+      .registry = ur,
+   };
+
+   for (int i = 0; i < job->units.count; i++)
+      hset_insert(args.local, vcode_unit_name(job->units.items[i]));
+
+   for (int i = 0; i < job->units.count; i++)
+      vcode_walk_dependencies(job->units.items[i], cgen_import_cb, &args);
+
+   hset_free(args.local);
+}
+
+static char *cgen_emit_cached(llvm_obj_t *obj, cgen_job_t *job)
+{
+   char *key LOCAL = llvm_obj_cache_key(obj, job->olevel);
+   char *path = xasprintf("%s" DIR_SEP "%s." LLVM_OBJ_EXT, job->cache_dir, key);
+
+   if (access(path, R_OK) == 0) {
+      llvm_obj_free(obj);
+      return path;
+   }
+
+   llvm_obj_finalise(obj, job->olevel);
+
+   // Write to a temporary file first so a concurrent elaboration never
+   // links a partial object
+   char *tmp LOCAL = xasprintf("%s.%d", path, getpid());
+   llvm_obj_emit(obj, tmp);
+
+   if (rename(tmp, path) != 0)
+      fatal_errno("rename: %s", tmp);
+
+   return path;
+}
+
 static void cgen_async_work(void *context, void *arg)
 {
    jit_t *jit = context;
@@ -283,17 +355,43 @@ static void cgen_async_work(void *context, void *arg)
       llvm_aot_compile(obj, jit, handle);
    }
 
-   llvm_obj_finalise(obj, LLVM_O0);
-   llvm_obj_emit(obj, job->obj_path);
+   for (int i = 0; i < job->imports.count; i++) {
+      jit_handle_t handle = jit_lazy_compile(jit, job->imports.items[i]);
+      assert(handle != JIT_HANDLE_INVALID);
+
+      llvm_aot_import(obj, jit, handle);
+   }
+
+   char *obj_path;
+   if (job->cache_dir != NULL)
+      obj_path = cgen_emit_cached(obj, job);
+   else {
+      char *obj_name LOCAL =
+         xasprintf("_%s.%d." LLVM_OBJ_EXT, job->module_name, getpid());
+
+      char path[PATH_MAX];
+      lib_realpath(lib_work(), obj_name, path, sizeof(path));
+
+      llvm_obj_finalise(obj, job->olevel);
+      llvm_obj_emit(obj, path);
+
+      obj_path = xstrdup(path);
+   }
+
+   // Each job writes a distinct element and the list is not resized
+   // while the work queue is running
+   job->objs->items[job->index] = obj_path;
 
    ACLEAR(job->units);
+   ACLEAR(job->imports);
    free(job->module_name);
    free(job);
 }
 
 static void cgen_partition_jobs(unit_list_t *units, workq_t *wq,
                                 const char *base_name, int units_per_job,
-                                tree_t top, obj_list_t *objs)
+                                unit_registry_t *ur, const char *cache_dir,
+                                obj_list_t *objs)
 {
    int counter = 0;
 
@@ -303,26 +401,77 @@ static void cgen_partition_jobs(unit_list_t *units, workq_t *wq,
    const int clamped = MIN(njobs, MAX_JOBS);
    units_per_job = (units->count + clamped - 1) / clamped;
 
-   for (unsigned i = 0; i < units->count; i += units_per_job, counter++) {
-      char *module_name = xasprintf("%s.%d", base_name, counter);
-      char *obj_name LOCAL =
-         xasprintf("_%s.%d." LLVM_OBJ_EXT, module_name, getpid());
-
-      char obj_path[PATH_MAX];
-      lib_realpath(lib_work(), obj_name, obj_path, sizeof(obj_path));
+   // Code generation at -O0 is much faster and is sufficient unless
+   // the whole design is being optimised
+   llvm_opt_level_t olevel = LLVM_O0;
+   hset_t *filter = NULL;
+   if (opt_get_int(OPT_AOT_OPTIMISE)) {
+      olevel = opt_get_int(OPT_OPTIMISE);
+
+      if (olevel >= LLVM_O2) {
+         filter = hset_new(units->count * 2);
+         for (unsigned i = 0; i < units->count; i++)
+            hset_insert(filter, vcode_unit_name(units->items[i]));
+      }
+   }
 
+   for (unsigned i = 0; i < units->count; i += units_per_job, counter++) {
       cgen_job_t *job = xcalloc(sizeof(cgen_job_t));
-      job->module_name = module_name;
-      job->obj_path    = xstrdup(obj_path);
+      job->module_name = xasprintf("%s.%d", base_name, counter);
+      job->objs        = objs;
       job->index       = counter;
+      job->olevel      = olevel;
+      job->cache_dir   = cache_dir;
 
       for (unsigned j = i; j < units->count && j < i + units_per_job; j++)
          APUSH(job->units, units->items[j]);
 
-      APUSH(*objs, job->obj_path);
+      if (filter != NULL)
+         cgen_find_imports(job, ur, filter);
+
+      APUSH(*objs, NULL);
 
       workq_do(wq, cgen_async_work, job);
    }
+
+   if (filter != NULL)
+      hset_free(filter);
+}
+
+static char *cgen_cache_dir(const char *module_name)
+{
+   char *name LOCAL = xasprintf("_%s.cache", module_name);
+
+   char path[PATH_MAX];
+   lib_realpath(lib_work(), name, path, sizeof(path));
+
+   make_dir(path);
+   return xstrdup(path);
+}
+
+static void cgen_prune_cache(const char *cache_dir, obj_list_t *objs)
+{
+   // Remove objects for units which are no longer part of the design
+   DIR *d = opendir(cache_dir);
+   if (d == NULL)
+      return;
+
+   hset_t *keep = hset_new(objs->count * 2);
+   for (int i = 0; i < objs->count; i++)
+      hset_insert(keep, ident_new(objs->items[i]));
+
+   struct dirent *e;
+   while ((e = readdir(d))) {
+      if (e->d_name[0] == '.')
+         continue;
+
+      char *path LOCAL = xasprintf("%s" DIR_SEP "%s", cache_dir, e->d_name);
+      if (!hset_contains(keep, ident_new(path)) && remove(path) != 0)
+         warnf("remove: %s: %s", path, last_os_error());
+   }
+
+   closedir(d);
+   hset_free(keep);
 }
 
 void cgen(tree_t top, unit_registry_t *ur, jit_t *jit)
@@ -349,15 +498,23 @@ void cgen(tree_t top, unit_registry_t *ur, jit_t *jit)
 
    ident_t name = tree_ident(top);
 
+   char *cache_dir LOCAL = NULL;
+   if (opt_get_int(OPT_AOT_OPTIMISE))
+      cache_dir = cgen_cache_dir(istr(name));
+
    obj_list_t objs = AINIT;
-   cgen_partition_jobs(&units, wq, istr(name), UNITS_PER_JOB, top, &objs);
+   cgen_partition_jobs(&units, wq, istr(name), UNITS_PER_JOB, ur,
+                       cache_dir, &objs);
 
    workq_start(wq);
    workq_drain(wq);
 
    progress("code generation for %d units", units.count);
 
-   cgen_link(istr(name), objs.items, objs.count);
+   cgen_link(istr(name), objs.items, objs.count, cache_dir == NULL);
+
+   if (cache_dir != NULL)
+      cgen_prune_cache(cache_dir, &objs);
 
    for (unsigned i = 0; i < objs.count; i++)
       free(objs.items[i]);
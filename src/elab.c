@@ -34,6 +34,7 @@
 #include "rt/structs.h"
 #include "thread.h"
 #include "type.h"
+#include "vcode.h"
 #include "vlog/vlog-defs.h"
 #include "vlog/vlog-node.h"
 #include "vlog/vlog-phase.h"
@@ -43,6 +44,7 @@
 #include <stdarg.h>
 #include <stdlib.h>
 #include <inttypes.h>
+#include <string.h>
 
 #define MAX_DEPTH 127    // Limited by vcode type indexes
 
@@ -69,8 +71,10 @@ typedef struct _elab_ctx {
    sdf_file_t       *sdf;
    driver_set_t     *drivers;
    hash_t           *modcache;
+   hash_t           *instcache;
    rt_model_t       *model;
    rt_scope_t       *scope;
+   ident_t           shared;
    unsigned          depth;
 } elab_ctx_t;
 
@@ -98,6 +102,19 @@ typedef struct {
    vlog_node_t  module;
 } mod_cache_t;
 
+typedef struct {
+   tree_t        config;
+   tree_t        copy;
+   tree_t       *generics;
+   vcode_unit_t  lowered;
+   ident_t       dotted;
+} inst_variant_t;
+
+typedef struct {
+   bool               shareable;
+   A(inst_variant_t)  variants;
+} inst_cache_t;
+
 static void elab_block(tree_t t, const elab_ctx_t *ctx);
 static void elab_stmts(tree_t t, const elab_ctx_t *ctx);
 static void elab_decls(tree_t t, const elab_ctx_t *ctx);
@@ -283,6 +300,130 @@ static mod_cache_t *elab_cached_module(vlog_node_t mod, const elab_ctx_t *ctx)
    return mc;
 }
 
+static tree_t elab_generic_value(tree_t g, const elab_ctx_t *ctx)
+{
+   if (ctx->generics == NULL)
+      return NULL;
+   else
+      return hash_get(ctx->generics, g);
+}
+
+static bool elab_same_generic(tree_t a, tree_t b)
+{
+   if (a == b)
+      return true;
+   else if (a == NULL || b == NULL || tree_kind(a) != tree_kind(b))
+      return false;
+   else if (tree_kind(a) == T_REF)
+      return tree_ref(a) == tree_ref(b);
+   else if (tree_subkind(a) != tree_subkind(b))
+      return false;
+
+   switch (tree_subkind(a)) {
+   case L_INT:
+   case L_PHYSICAL:
+      return tree_ival(a) == tree_ival(b);
+   case L_REAL:
+      {
+         // Compare the bit patterns as -0.0 == 0.0 but folding can
+         // depend on the sign
+         const double da = tree_dval(a), db = tree_dval(b);
+         return memcmp(&da, &db, sizeof(double)) == 0;
+      }
+   default:
+      return true;
+   }
+}
+
+static void elab_shareable_cb(tree_t t, void *context)
+{
+   bool *shareable = context;
+
+   switch (tree_kind(t)) {
+   case T_FUNC_DECL:
+   case T_PROC_DECL:
+      if (tree_flags(t) & TREE_F_PREDEFINED)
+         break;
+      // Fall-through
+   case T_FUNC_BODY:
+   case T_PROC_BODY:
+   case T_FUNC_INST:
+   case T_PROC_INST:
+   case T_PROT_BODY:
+   case T_PACKAGE:
+   case T_PACK_BODY:
+   case T_PACK_INST:
+      *shareable = false;
+      break;
+   default:
+      break;
+   }
+}
+
+static bool elab_shareable(tree_t arch, tree_t copy)
+{
+   // Subprograms are renamed in each copy of an architecture and the
+   // code generated for them depends on the layout of the enclosing
+   // instance which can vary with the port map, so only architectures
+   // without any can be shared
+
+   tree_t entity = tree_primary(arch), ecopy = tree_primary(copy);
+
+   const int ngenerics = tree_generics(entity);
+   for (int i = 0; i < ngenerics; i++) {
+      tree_t g = tree_generic(entity, i);
+      if (tree_class(g) != C_CONSTANT || tree_generic(ecopy, i) != g)
+         return false;
+   }
+
+   bool shareable = true;
+   tree_visit(copy, elab_shareable_cb, &shareable);
+   return shareable;
+}
+
+static inst_variant_t *elab_cached_instance(inst_cache_t *ic, tree_t arch,
+                                            tree_t config,
+                                            const elab_ctx_t *ctx)
+{
+   tree_t entity = tree_primary(arch);
+   const int ngenerics = tree_generics(entity);
+
+   for (int i = 0; i < ic->variants.count; i++) {
+      inst_variant_t *v = &(ic->variants.items[i]);
+      if (v->config != config)
+         continue;
+
+      bool match = true;
+      for (int j = 0; match && j < ngenerics; j++) {
+         tree_t value = elab_generic_value(tree_generic(entity, j), ctx);
+         match = elab_same_generic(v->generics[j], value);
+      }
+
+      if (match)
+         return v;
+   }
+
+   return NULL;
+}
+
+static void elab_cache_instance(inst_cache_t *ic, tree_t arch, tree_t config,
+                                tree_t copy, const elab_ctx_t *ctx)
+{
+   tree_t entity = tree_primary(arch);
+   const int ngenerics = tree_generics(entity);
+
+   inst_variant_t v = {
+      .config   = config,
+      .copy     = copy,
+      .generics = xmalloc_array(ngenerics, sizeof(tree_t)),
+   };
+
+   for (int i = 0; i < ngenerics; i++)
+      v.generics[i] = elab_generic_value(tree_generic(entity, i), ctx);
+
+   APUSH(ic->variants, v);
+}
+
 static bool elab_synth_binding_cb(lib_t lib, void *__ctx)
 {
    synth_binding_params_t *params = __ctx;
@@ -1324,6 +1465,7 @@ static void elab_inherit_context(elab_ctx_t *ctx, const elab_ctx_t *parent)
    ctx->sdf       = parent->sdf;
    ctx->inst      = ctx->inst ?: parent->inst;
    ctx->modcache  = parent->modcache;
+   ctx->instcache = parent->instcache;
    ctx->depth     = parent->depth + 1;
    ctx->model     = parent->model;
 }
@@ -1432,23 +1574,63 @@ static void elab_architecture(tree_t bind, tree_t arch, tree_t config,
 
    elab_subprogram_prefix(arch, &new_ctx);
 
+   elab_push_scope(arch, &new_ctx);
+
+   const int base_errors = error_count();
+
+   // Instances of the same architecture whose generics have the same
+   // values share a single simplified copy of the design unit
+   inst_cache_t *ic = hash_get(ctx->instcache, arch);
+   inst_variant_t *v = NULL;
+   if (ic != NULL && ic->shareable) {
+      elab_generics(tree_primary(arch), bind, &new_ctx);
+      v = elab_cached_instance(ic, arch, config, &new_ctx);
+   }
+
    tree_t arch_copy;
-   if (config != NULL) {
-      assert(tree_ref(config) == arch);
-      new_ctx.config = elab_copy(config, &new_ctx);
-      arch_copy = tree_ref(new_ctx.config);
+   if (v != NULL) {
+      if (config != NULL) {
+         new_ctx.config = v->copy;
+         arch_copy = tree_ref(new_ctx.config);
+      }
+      else
+         arch_copy = v->copy;
+   }
+   else {
+      if (config != NULL) {
+         assert(tree_ref(config) == arch);
+         new_ctx.config = elab_copy(config, &new_ctx);
+         arch_copy = tree_ref(new_ctx.config);
+      }
+      else
+         arch_copy = elab_copy(arch, &new_ctx);
+
+      tree_t entity = tree_primary(arch_copy);
+
+      elab_context(entity);
+      elab_context(arch_copy);
+
+      if (ic == NULL || !ic->shareable)
+         elab_generics(entity, bind, &new_ctx);
+
+      elab_instance_fixup(arch_copy, &new_ctx);
+      simplify_global(arch_copy, new_ctx.generics, ctx->jit, ctx->registry);
+
+      if (ic == NULL) {
+         ic = xcalloc(sizeof(inst_cache_t));
+         ic->shareable = elab_shareable(arch, arch_copy);
+         hash_put(ctx->instcache, arch, ic);
+      }
+
+      if (ic->shareable && error_count() == base_errors) {
+         elab_cache_instance(ic, arch, config, new_ctx.config ?: arch_copy,
+                             &new_ctx);
+         v = &(ic->variants.items[ic->variants.count - 1]);
+      }
    }
-   else
-      arch_copy = elab_copy(arch, &new_ctx);
 
    tree_t entity = tree_primary(arch_copy);
 
-   elab_push_scope(arch, &new_ctx);
-   elab_context(entity);
-   elab_context(arch_copy);
-   elab_generics(entity, bind, &new_ctx);
-   elab_instance_fixup(arch_copy, &new_ctx);
-   simplify_global(arch_copy, new_ctx.generics, ctx->jit, ctx->registry);
    elab_ports(entity, bind, &new_ctx);
    elab_decls(entity, &new_ctx);
 
@@ -1458,6 +1640,22 @@ static void elab_architecture(tree_t bind, tree_t arch, tree_t config,
    if (error_count() == 0) {
       new_ctx.drivers = find_drivers(arch_copy);
       elab_lower(b, NULL, &new_ctx);
+
+      if (v != NULL && ctx->cover == NULL) {
+         // Processes only reference the variables of the enclosing
+         // instance so if the layout matches the first instance with
+         // this variant its process code can be reused
+         vcode_unit_t vu = get_vcode(new_ctx.lowered);
+         if (v->lowered == NULL) {
+            v->lowered = vu;
+            v->dotted  = ndotted;
+         }
+         else if (vcode_same_layout(v->lowered, vu)) {
+            new_ctx.shared = v->dotted;
+            tree_set_ident2(tree_decl(b, 0), v->dotted);
+         }
+      }
+
       elab_stmts(entity, &new_ctx);
       elab_stmts(arch_copy, &new_ctx);
    }
@@ -1944,7 +2142,7 @@ static void elab_case_generate(tree_t t, const elab_ctx_t *ctx)
 
 static void elab_process(tree_t t, const elab_ctx_t *ctx)
 {
-   if (error_count() == 0)
+   if (error_count() == 0 && ctx->shared == NULL)
       lower_process(ctx->lowered, t, elab_driver_set(ctx));
 
    tree_add_stmt(ctx->out, t);
@@ -2252,6 +2450,7 @@ tree_t elab(object_t *top, jit_t *jit, unit_registry_t *ur, cover_data_t *cover,
       .sdf       = sdf,
       .registry  = ur,
       .modcache  = hash_new(16),
+      .instcache = hash_new(64),
       .dotted    = lib_name(work),
       .model     = m,
       .scope     = create_scope(m, e, NULL),
@@ -2270,6 +2469,17 @@ tree_t elab(object_t *top, jit_t *jit, unit_registry_t *ur, cover_data_t *cover,
 
    hash_free(ctx.modcache);
 
+   for (hash_iter_t it = HASH_BEGIN;
+        hash_iter(ctx.instcache, &it, &key, &value); ) {
+      inst_cache_t *ic = value;
+      for (int i = 0; i < ic->variants.count; i++)
+         free(ic->variants.items[i].generics);
+      ACLEAR(ic->variants);
+      free(ic);
+   }
+
+   hash_free(ctx.instcache);
+
    if (error_count() > 0)
       return NULL;
 
@@ -263,6 +263,14 @@ static uint32_t checksum_finish(cs_state_t *state)
    }
 }
 
+uint32_t fbuf_checksum(fbuf_cs_t algo, const void *data, size_t length)
+{
+   cs_state_t state;
+   checksum_init(&state, algo);
+   checksum_update(&state, (uint8_t *)data, length);
+   return checksum_finish(&state);
+}
+
 void fbuf_cleanup(void)
 {
    for (fbuf_t *it = open_list; it != NULL; it = it->next) {
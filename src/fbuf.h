@@ -45,6 +45,7 @@ void fbuf_close(fbuf_t *f, uint32_t *checksum);
 void fbuf_cleanup(void);
 const char *fbuf_file_name(fbuf_t *f);
 int fbuf_file_handle(fbuf_t *f);
+uint32_t fbuf_checksum(fbuf_cs_t algo, const void *data, size_t length);
 
 int64_t fbuf_get_int(fbuf_t *f);
 uint64_t fbuf_get_uint(fbuf_t *f);
@@ -1090,6 +1090,14 @@ static void code_load_macho(code_blob_t *blob, const void *data, size_t size)
    }
 }
 #elif !defined __MINGW32__
+static bool code_is_descr_name(code_blob_t *blob, const char *name)
+{
+   const char *span_name = istr(blob->span->name);
+   const size_t len = strlen(span_name);
+   return strncmp(name, span_name, len) == 0
+      && strcmp(name + len, ".descr") == 0;
+}
+
 static void code_load_elf(code_blob_t *blob, const void *data, size_t size)
 {
    const Elf64_Ehdr *ehdr = data;
@@ -1135,17 +1143,23 @@ static void code_load_elf(code_blob_t *blob, const void *data, size_t size)
             const Elf64_Sym *sym =
                data + shdr->sh_offset + i * shdr->sh_entsize;
 
-            if (ELF64_ST_TYPE(sym->st_info) != STT_FUNC)
+            if (ELF64_ST_TYPE(sym->st_info) == STT_OBJECT
+                && sym->st_shndx != SHN_UNDEF
+                && load_addr[sym->st_shndx] != NULL
+                && code_is_descr_name(blob, strtab + sym->st_name)) {
+               // Relocation table for code from the persistent cache
+               blob->descr = load_addr[sym->st_shndx] + sym->st_value;
+               continue;
+            }
+            else if (ELF64_ST_TYPE(sym->st_info) != STT_FUNC)
                continue;
             else if (!icmp(blob->span->name, strtab + sym->st_name))
                continue;
             else if (load_addr[sym->st_shndx] == NULL)
                fatal_trace("missing section %d for symbol %s", sym->st_shndx,
                            strtab + sym->st_name);
-            else {
+            else
                blob->span->entry = load_addr[sym->st_shndx] + sym->st_value;
-               break;
-            }
          }
          break;
 
@@ -1190,10 +1204,14 @@ static void code_load_elf(code_blob_t *blob, const void *data, size_t size)
          case STT_SECTION:
             ptr = load_addr[sym->st_shndx];
             break;
+         case STT_OBJECT:
+            if (sym->st_shndx != SHN_UNDEF)
+               ptr = load_addr[sym->st_shndx] + sym->st_value;
+            break;
          }
 
          if (ptr == NULL && icmp(blob->span->name, strtab + sym->st_name))
-            ptr = (char *)blob->span->base;
+            ptr = (char *)blob->span->entry;
 
          if (ptr == NULL)
             fatal_trace("cannot resolve symbol %s type %d",
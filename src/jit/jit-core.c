@@ -25,6 +25,7 @@
 #include "jit/jit.h"
 #include "lib.h"
 #include "lower.h"
+#include "mir/mir-node.h"
 #include "mir/mir-unit.h"
 #include "object.h"
 #include "option.h"
@@ -44,9 +45,15 @@
 #include <string.h>
 #include <unistd.h>
 
-#define FUNC_HASH_SZ    1024
-#define FUNC_LIST_SZ    512
-#define COMPILE_TIMEOUT 10000
+#ifndef __MINGW32__
+#include <signal.h>
+#include <sys/time.h>
+#endif
+
+#define FUNC_HASH_SZ      1024
+#define FUNC_LIST_SZ      512
+#define COMPILE_TIMEOUT   10000
+#define MAX_SAMPLE_FRAMES 32
 
 typedef struct _jit_tier {
    jit_tier_t    *next;
@@ -100,6 +107,8 @@ typedef struct _jit {
    unsigned         cover_ntags;
    jit_irq_fn_t     interrupt;
    void            *interrupt_ctx;
+   jit_sample_fn_t  sample_fn;
+   void            *sample_ctx;
    unit_registry_t *registry;
    mir_context_t   *mir;
 } jit_t;
@@ -171,7 +180,10 @@ static void jit_free_func(jit_func_t *f)
    mptr_free(f->jit->mspace, &(f->privdata));
    free(f->irbuf);
    free(f->linktab);
+   free(f->inlines);
    if (f->owns_cpool) free(f->cpool);
+   free(f->profile);
+   free(f->threaded);
    free(f);
 }
 
@@ -249,6 +261,56 @@ static void jit_install(jit_t *j, jit_func_t *f)
    if (f->unit) chash_put(j->index, f->unit, f);
 }
 
+static jit_handle_t jit_lazy_compile_locked(jit_t *j, ident_t name);
+
+static void jit_bind_relocs_locked(jit_t *j, jit_func_t *f,
+                                   aot_descr_t *descr)
+{
+   assert_lock_held(&j->lock);
+
+   for (aot_reloc_t *r = descr->relocs; r->kind != RELOC_NULL; r++) {
+      const char *str = descr->strtab + r->off;
+      if (r->kind == RELOC_COVER) {
+         // TODO: get rid of the double indirection here by
+         //       allocating coverage memory earlier
+         r->ptr = &(j->cover_mem);
+      }
+      else if (r->kind == RELOC_PROCESSED) {
+         // Detect musl libc brokenness
+         diag_t *d = diag_new(DIAG_FATAL, NULL);
+         diag_printf(d, "shared library containing %s was not properly "
+                     "unloaded", istr(f->name));
+         diag_hint(d, NULL, "this is probably because your libc does not "
+                   "implement dlclose(3) correctly");
+         diag_hint(d, NULL, "run the $bold$-e$$ and $bold$-r$$ steps in "
+                   "separate commands as a workaround");
+         diag_emit(d);
+         fatal_exit(1);
+      }
+      else {
+         jit_handle_t h = jit_lazy_compile_locked(j, ident_new(str));
+         if (h == JIT_HANDLE_INVALID)
+            fatal_trace("relocation against invalid function %s", str);
+
+         switch (r->kind) {
+         case RELOC_FUNC:
+            r->ptr = jit_get_func(j, h);
+            break;
+         case RELOC_HANDLE:
+            r->ptr = (void *)(uintptr_t)h;
+            break;
+         case RELOC_PRIVDATA:
+            r->ptr = jit_get_privdata_ptr(j, jit_get_func(j, h));
+            break;
+         default:
+            fatal_trace("unhandled relocation kind %d", r->kind);
+         }
+      }
+
+      r->kind = RELOC_PROCESSED;
+   }
+}
+
 static jit_handle_t jit_lazy_compile_locked(jit_t *j, ident_t name)
 {
    assert_lock_held(&j->lock);
@@ -274,8 +336,9 @@ static jit_handle_t jit_lazy_compile_locked(jit_t *j, ident_t name)
       }
    }
 
+   jit_entry_fn_t intrinsic = jit_bind_intrinsic(name);
    jit_entry_fn_t entry =
-      jit_bind_intrinsic(name) ?: (descr ? descr->entry : jit_interp);
+      intrinsic ?: (descr ? descr->entry : jit_interp);
 
    f = xcalloc(sizeof(jit_func_t));
    f->name      = name;
@@ -286,52 +349,16 @@ static jit_handle_t jit_lazy_compile_locked(jit_t *j, ident_t name)
    f->hotness   = f->next_tier ? f->next_tier->threshold : 0;
    f->entry     = entry;
 
+   // Arguments the intrinsic cannot handle fall back to the VHDL body
+   // which can still be compiled by the usual tiers
+   if (intrinsic != NULL)
+      f->body = descr ? descr->entry : jit_interp_body;
+
    // Install now to allow circular references in relocations
    jit_install(j, f);
 
    if (descr != NULL) {
-      for (aot_reloc_t *r = descr->relocs; r->kind != RELOC_NULL; r++) {
-         const char *str = descr->strtab + r->off;
-         if (r->kind == RELOC_COVER) {
-            // TODO: get rid of the double indirection here by
-            //       allocating coverage memory earlier
-            r->ptr = &(j->cover_mem);
-         }
-         else if (r->kind == RELOC_PROCESSED) {
-            // Detect musl libc brokenness
-            diag_t *d = diag_new(DIAG_FATAL, NULL);
-            diag_printf(d, "shared library containing %s was not properly "
-                        "unloaded", istr(f->name));
-            diag_hint(d, NULL, "this is probably because your libc does not "
-                      "implement dlclose(3) correctly");
-            diag_hint(d, NULL, "run the $bold$-e$$ and $bold$-r$$ steps in "
-                      "separate commands as a workaround");
-            diag_emit(d);
-            fatal_exit(1);
-         }
-         else {
-            jit_handle_t h = jit_lazy_compile_locked(j, ident_new(str));
-            if (h == JIT_HANDLE_INVALID)
-               fatal_trace("relocation against invalid function %s", str);
-
-            switch (r->kind) {
-            case RELOC_FUNC:
-               r->ptr = jit_get_func(j, h);
-               break;
-            case RELOC_HANDLE:
-               r->ptr = (void *)(uintptr_t)h;
-               break;
-            case RELOC_PRIVDATA:
-               r->ptr = jit_get_privdata_ptr(j, jit_get_func(j, h));
-               break;
-            default:
-               fatal_trace("unhandled relocation kind %d", r->kind);
-            }
-         }
-
-         r->kind = RELOC_PROCESSED;
-      }
-
+      jit_bind_relocs_locked(j, f, descr);
       store_release(&f->state, JIT_FUNC_READY);
    }
 
@@ -348,6 +375,12 @@ jit_handle_t jit_lazy_compile(jit_t *j, ident_t name)
    return jit_lazy_compile_locked(j, name);
 }
 
+void jit_bind_relocs(jit_t *j, jit_handle_t handle, void *descr)
+{
+   SCOPED_LOCK(j->lock);
+   jit_bind_relocs_locked(j, jit_get_func(j, handle), descr);
+}
+
 jit_func_t *jit_get_func(jit_t *j, jit_handle_t handle)
 {
    assert(handle != JIT_HANDLE_INVALID);
@@ -380,36 +413,26 @@ static void jit_missing_unit(jit_func_t *f)
    __builtin_unreachable();
 }
 
-void jit_fill_irbuf(jit_func_t *f)
+static unsigned jit_mir_size(mir_unit_t *mu, unsigned limit)
 {
-   const func_state_t state = load_acquire(&(f->state));
-   switch (state) {
-   case JIT_FUNC_READY:
-      if (f->irbuf != NULL)
-         return;
-      // Fall-through
-   case JIT_FUNC_PLACEHOLDER:
-      if (atomic_cas(&(f->state), state, JIT_FUNC_COMPILING))
-         break;
-      // Fall-through
-   case JIT_FUNC_COMPILING:
-      // Another thread is compiling this function
-      for (int timeout = 0; load_acquire(&(f->state)) != JIT_FUNC_READY; ) {
-         if (++timeout % COMPILE_TIMEOUT == 0)
-            warnf("waiting for %s to finish compiling", istr(f->name));
-         thread_sleep(100);
-      }
-      return;
-   case JIT_FUNC_ERROR:
-      jit_missing_unit(f);
-      break;
-   default:
-      fatal_trace("illegal function state for %s", istr(f->name));
-   }
+   // Almost every MIR node generates at least one IR instruction so
+   // this is a cheap lower bound on the size of the function
+   unsigned size = 0;
+   const int nblocks = mir_count_blocks(mu);
+   for (int i = 0; i < nblocks && size <= limit; i++)
+      size += mir_count_nodes(mu, mir_get_block(mu, i));
+
+   return size;
+}
 
+static bool jit_load_irbuf(jit_func_t *f, bool must_succeed,
+                           unsigned max_size)
+{
    assert(f->irbuf == NULL);
    assert(f->unit == NULL);
 
+   bool ok = true;
+
 #ifndef USE_EMUTLS
    const jit_state_t oldstate = jit_thread_local()->state;
    jit_transition(f->jit, oldstate, JIT_COMPILING);
@@ -432,7 +455,11 @@ void jit_fill_irbuf(jit_func_t *f)
 
    if (f->unit == NULL) {
       store_release(&(f->state), JIT_FUNC_ERROR);
-      jit_missing_unit(f);
+      if (must_succeed)
+         jit_missing_unit(f);
+
+      ok = false;
+      goto done;
    }
 
    mir_unit_t *mu;
@@ -447,6 +474,18 @@ void jit_fill_irbuf(jit_func_t *f)
       }
    }
 
+   if (max_size > 0) {
+      f->mirsize = jit_mir_size(mu, max_size);
+      if (f->mirsize > max_size) {
+         // Too large for the caller so avoid generating the IR: the MIR
+         // stays registered for when the function is compiled later
+         f->unit = NULL;
+         store_release(&(f->state), JIT_FUNC_PLACEHOLDER);
+         ok = false;
+         goto done;
+      }
+   }
+
    jit_irgen(f, mu);
 
    {
@@ -458,6 +497,78 @@ void jit_fill_irbuf(jit_func_t *f)
 #ifndef USE_EMUTLS
    jit_transition(f->jit, JIT_COMPILING, oldstate);
 #endif
+
+   return ok;
+}
+
+void jit_fill_irbuf(jit_func_t *f)
+{
+   func_state_t state;
+ retry:
+   state = load_acquire(&(f->state));
+   switch (state) {
+   case JIT_FUNC_READY:
+      if (f->irbuf != NULL)
+         return;
+      // Fall-through
+   case JIT_FUNC_PLACEHOLDER:
+      if (atomic_cas(&(f->state), state, JIT_FUNC_COMPILING))
+         break;
+      // Fall-through
+   case JIT_FUNC_COMPILING:
+      // Another thread is compiling this function
+      for (int timeout = 0;
+           load_acquire(&(f->state)) == JIT_FUNC_COMPILING; ) {
+         if (++timeout % COMPILE_TIMEOUT == 0)
+            warnf("waiting for %s to finish compiling", istr(f->name));
+         thread_sleep(100);
+      }
+      // The other thread may have given up if the function was too
+      // large to inline
+      goto retry;
+   case JIT_FUNC_ERROR:
+      jit_missing_unit(f);
+      break;
+   default:
+      fatal_trace("illegal function state for %s", istr(f->name));
+   }
+
+   jit_load_irbuf(f, true, 0);
+}
+
+bool jit_try_fill_irbuf(jit_func_t *f, unsigned max_size)
+{
+   // Unlike jit_fill_irbuf this never waits for another thread to
+   // finish compiling the function, which could deadlock if called
+   // while compiling another function, and returns false rather than
+   // raising an error if the unit is missing.  If max_size is non-zero
+   // it also gives up without generating IR for a function which is
+   // known to need more instructions than that.
+   if (max_size > 0 && f->mirsize > max_size)
+      return false;
+
+   const func_state_t state = load_acquire(&(f->state));
+   switch (state) {
+   case JIT_FUNC_READY:
+      if (f->irbuf != NULL)
+         return true;
+      break;
+   case JIT_FUNC_PLACEHOLDER:
+      if (f->jit->registry != NULL) {
+         // Cannot use a unit which is still being lowered
+         SCOPED_LOCK(f->jit->lock);
+         if (unit_registry_pending(f->jit->registry, f->name))
+            return false;
+      }
+      break;
+   default:
+      return false;
+   }
+
+   if (!atomic_cas(&(f->state), state, JIT_FUNC_COMPILING))
+      return false;
+
+   return jit_load_irbuf(f, false, max_size);
 }
 
 jit_handle_t jit_compile(jit_t *j, ident_t name)
@@ -590,14 +701,72 @@ static void jit_emit_trace(diag_t *d, const loc_t *loc, object_t *enclosing,
    }
 }
 
+int jit_inline_at(jit_func_t *f, unsigned pos)
+{
+   // Inlined bodies are sorted by first instruction with enclosing
+   // bodies before nested ones
+   int result = -1;
+   for (int i = 0; i < f->ninlines && f->inlines[i].first <= pos; i++) {
+      if (pos <= f->inlines[i].last)
+         result = i;
+   }
+
+   return result;
+}
+
+static loc_t jit_frame_loc(jit_func_t *f, unsigned pos, int frame)
+{
+   // Scan backwards to find the last debug info skipping over any code
+   // inlined into this frame
+   const int first = frame == -1 ? 0 : f->inlines[frame].first;
+   for (int i = pos; i >= first; i--) {
+      int in = jit_inline_at(f, i);
+      if (in != frame) {
+         while (f->inlines[in].parent != frame)
+            in = f->inlines[in].parent;
+         i = f->inlines[in].first;
+         continue;
+      }
+
+      jit_ir_t *ir = &(f->irbuf[i]);
+      if (ir->op == J_DEBUG)
+         return ir->arg1.loc;
+      else if (ir->target)
+         break;
+   }
+
+   return LOC_INVALID;
+}
+
+static bool jit_frame_irbuf(jit_anchor_t *a)
+{
+#ifdef USE_EMUTLS
+   if (load_acquire(&a->func->state) == JIT_FUNC_COMPILING)
+      return false;   // Cannot use jit_transition in jit_fill_irbuf
+#endif
+
+   jit_fill_irbuf(a->func);
+
+   assert(a->irpos < a->func->nirs);
+   return true;
+}
+
 jit_stack_trace_t *jit_stack_trace(void)
 {
    jit_thread_local_t *thread = jit_thread_local();
 
    int count = 0;
-   for (jit_anchor_t *a = thread->anchor; a; a = a->caller)
+   for (jit_anchor_t *a = thread->anchor; a; a = a->caller) {
       count++;
 
+      // Functions inlined at this position each get their own frame
+      if (jit_frame_irbuf(a)) {
+         for (int in = jit_inline_at(a->func, a->irpos); in != -1;
+              in = a->func->inlines[in].parent)
+            count++;
+      }
+   }
+
    jit_stack_trace_t *stack =
       xmalloc_flex(sizeof(jit_stack_trace_t), count, sizeof(jit_frame_t));
    stack->count = count;
@@ -608,27 +777,38 @@ jit_stack_trace_t *jit_stack_trace(void)
       frame->symbol = a->func->name;
       frame->object = NULL;
 
-#ifdef USE_EMUTLS
-      if (load_acquire(&a->func->state) == JIT_FUNC_COMPILING)
-         continue;   // Cannot use jit_transition in jit_fill_irbuf
-#endif
+      if (!jit_frame_irbuf(a))
+         continue;
 
-      jit_fill_irbuf(a->func);
+      jit_func_t *f = a->func;
+      unsigned pos = a->irpos;
 
-      frame->object = a->func->object;
+      for (int in = jit_inline_at(f, pos); in != -1;
+           in = f->inlines[in].parent, frame++) {
+         jit_func_t *callee = jit_get_func(f->jit, f->inlines[in].handle);
 
-      // Scan backwards to find the last debug info
-      assert(a->irpos < a->func->nirs);
-      frame->loc = frame->object ? frame->object->loc : LOC_INVALID;
-      for (jit_ir_t *ir = &(a->func->irbuf[a->irpos]);
-           ir >= a->func->irbuf; ir--) {
-         if (ir->op == J_DEBUG) {
-            frame->loc = ir->arg1.loc;
-            break;
-         }
-         else if (ir->target)
-            break;
+         // The callee may never have been called directly in which
+         // case its object is not known until the IR is loaded
+         if (callee->object == NULL)
+            jit_try_fill_irbuf(callee, 0);
+
+         frame->symbol = callee->name;
+         frame->object = callee->object;
+         frame->loc    = jit_frame_loc(f, pos, in);
+
+         if (loc_invalid_p(&(frame->loc)) && callee->object != NULL)
+            frame->loc = callee->object->loc;
+
+         // Continue from the original call site
+         pos = f->inlines[in].first - 1;
       }
+
+      frame->symbol = f->name;
+      frame->object = f->object;
+      frame->loc    = jit_frame_loc(f, pos, -1);
+
+      if (loc_invalid_p(&(frame->loc)) && f->object != NULL)
+         frame->loc = f->object->loc;
    }
 
    return stack;
@@ -1009,13 +1189,25 @@ bool jit_exit_status(jit_t *j, int *status)
       return false;
 }
 
+static void jit_tier_cgen(jit_func_t *f, jit_tier_t *tier)
+{
+   (*tier->plugin.cgen)(f->jit, f->handle, tier->context);
+
+   if (tier->next != NULL) {
+      // Start counting towards the following tier once the code for
+      // this one is installed
+      const int delta = tier->next->threshold - tier->threshold;
+      store_release(&f->hotness, MAX(delta, 1));
+   }
+}
+
 static void jit_async_cgen(void *context, void *arg)
 {
    jit_func_t *f = context;
    jit_tier_t *tier = arg;
 
    if (!load_acquire(&f->jit->shutdown))
-      (*tier->plugin.cgen)(f->jit, f->handle, tier->context);
+      jit_tier_cgen(f, tier);
 }
 
 void jit_tier_up(jit_func_t *f)
@@ -1023,13 +1215,44 @@ void jit_tier_up(jit_func_t *f)
    assert(f->hotness <= 0);
    assert(f->next_tier != NULL);
 
+   jit_tier_t *tier = f->next_tier;
+
+   // Do not tier up again until code generation for this tier finishes
+   f->hotness   = UINT_MAX;
+   f->next_tier = tier->next;
+
    if (opt_get_int(OPT_JIT_ASYNC))
-      async_do(jit_async_cgen, f, f->next_tier);
+      async_do(jit_async_cgen, f, tier);
    else
-      (f->next_tier->plugin.cgen)(f->jit, f->handle, f->next_tier->context);
+      jit_tier_cgen(f, tier);
+}
 
-   f->hotness   = 0;
-   f->next_tier = NULL;
+void jit_set_entry(jit_func_t *f, jit_entry_fn_t entry)
+{
+   // Compiled code never replaces an intrinsic, only the body it calls
+   // for arguments it does not handle itself
+   if (f->body != NULL)
+      store_release(&f->body, entry);
+   else
+      store_release(&f->entry, entry);
+}
+
+jit_profile_t *jit_get_profile(jit_func_t *f)
+{
+   jit_profile_t *p = load_acquire(&f->profile);
+   if (p != NULL)
+      return p;
+
+   assert(f->irbuf != NULL);
+
+   const size_t size = sizeof(jit_profile_t) + f->nirs * sizeof(jit_irprof_t);
+   jit_profile_t *new = xcalloc(size);
+
+   if (atomic_cas(&f->profile, NULL, new))
+      return new;
+
+   free(new);   // Raced with another thread
+   return load_acquire(&f->profile);
 }
 
 void jit_add_tier(jit_t *j, int threshold, const jit_plugin_t *plugin)
@@ -1037,12 +1260,17 @@ void jit_add_tier(jit_t *j, int threshold, const jit_plugin_t *plugin)
    assert(threshold > 0);
 
    jit_tier_t *t = xcalloc(sizeof(jit_tier_t));
-   t->next      = j->tiers;
    t->threshold = threshold;
    t->plugin    = *plugin;
    t->context   = (*plugin->init)(j);
 
-   j->tiers = t;
+   // Keep tiers sorted by ascending threshold
+   jit_tier_t **p;
+   for (p = &(j->tiers); *p && (*p)->threshold <= threshold; p = &((*p)->next))
+      ;
+
+   t->next = *p;
+   *p = t;
 }
 
 ident_t jit_get_name(jit_t *j, jit_handle_t handle)
@@ -1136,6 +1364,7 @@ jit_handle_t jit_assemble(jit_t *j, ident_t name, const char *text)
       { "FDIV",    J_FDIV,       1, 2 },
       { "FNEG",    J_FNEG,       1, 1 },
       { "FCMP",    J_FCMP,       0, 2 },
+      { "FCCMP",   J_FCCMP,      0, 2 },
       { "FCVTNS",  J_FCVTNS,     1, 1 },
       { "SCVTF",   J_SCVTF,      1, 1 },
       { "$EXIT",   MACRO_EXIT,   0, 1 },
@@ -1157,6 +1386,7 @@ jit_handle_t jit_assemble(jit_t *j, ident_t name, const char *text)
       { "T",  JIT_CC_T },
       { "F",  JIT_CC_F },
       { "EQ", JIT_CC_EQ },
+      { "NE", JIT_CC_NE },
       { "O",  JIT_CC_O },
       { "C",  JIT_CC_C },
       { "LT", JIT_CC_LT },
@@ -1424,11 +1654,33 @@ int32_t *jit_get_cover_ptr(jit_t *j, jit_value_t addr)
    return base + addr.int64;
 }
 
+static void jit_sample_irq(jit_t *j, void *ctx)
+{
+   jit_thread_local_t *thread = jit_thread_local();
+
+   // The anchor chain is only valid at this point because interrupts
+   // are handled on entry to the runtime
+   ident_t frames[MAX_SAMPLE_FRAMES];
+   int count = 0;
+   for (jit_anchor_t *a = thread->anchor;
+        a != NULL && count < MAX_SAMPLE_FRAMES; a = a->caller)
+      frames[count++] = a->func->name;
+
+   jit_sample_fn_t fn = load_acquire(&j->sample_fn);
+   if (fn != NULL)
+      (*fn)(j, frames, count, relaxed_load(&j->sample_ctx));
+}
+
 void jit_interrupt(jit_t *j, jit_irq_fn_t fn, void *ctx)
 {
    relaxed_store(&j->interrupt_ctx, ctx);
-   if (!atomic_cas(&j->interrupt, NULL, fn))
-      fatal_exit(1);
+
+   // A pending profiler sample may be replaced by a real interrupt
+   jit_irq_fn_t old = NULL;
+   while (!__atomic_cas(&j->interrupt, &old, fn)) {
+      if (old != jit_sample_irq)
+         fatal_exit(1);
+   }
 }
 
 __attribute__((cold, noinline))
@@ -1447,6 +1699,64 @@ void jit_check_interrupt(jit_t *j)
       jit_handle_interrupt(j);
 }
 
+#ifndef __MINGW32__
+static jit_t *sampling_jit = NULL;
+
+static void jit_sigprof_handler(int sig)
+{
+   jit_t *j = atomic_load(&sampling_jit);
+   if (j != NULL)
+      atomic_cas(&j->interrupt, NULL, jit_sample_irq);
+}
+#endif
+
+void jit_start_sampling(jit_t *j, unsigned interval_us, jit_sample_fn_t fn,
+                        void *ctx)
+{
+   relaxed_store(&j->sample_ctx, ctx);
+   store_release(&j->sample_fn, fn);
+
+#ifndef __MINGW32__
+   if (!atomic_cas(&sampling_jit, NULL, j))
+      fatal_trace("sampling already enabled");
+
+   struct sigaction sa = {};
+   sa.sa_handler = jit_sigprof_handler;
+   sa.sa_flags = SA_RESTART;
+   sigemptyset(&sa.sa_mask);
+
+   if (sigaction(SIGPROF, &sa, NULL) != 0)
+      fatal_errno("sigaction");
+
+   const struct itimerval it = {
+      .it_interval = { interval_us / 1000000, interval_us % 1000000 },
+      .it_value    = { interval_us / 1000000, interval_us % 1000000 },
+   };
+
+   if (setitimer(ITIMER_PROF, &it, NULL) != 0)
+      fatal_errno("setitimer");
+#endif
+}
+
+void jit_stop_sampling(jit_t *j)
+{
+#ifndef __MINGW32__
+   if (atomic_load(&sampling_jit) != j)
+      return;
+
+   const struct itimerval it = {};
+   if (setitimer(ITIMER_PROF, &it, NULL) != 0)
+      fatal_errno("setitimer");
+
+   atomic_store(&sampling_jit, NULL);
+#endif
+
+   // Discard any sample which was requested but not yet taken
+   atomic_cas(&j->interrupt, jit_sample_irq, NULL);
+
+   store_release(&j->sample_fn, NULL);
+}
+
 void jit_reset(jit_t *j)
 {
    SCOPED_LOCK(j->lock);
@@ -1460,6 +1770,42 @@ void jit_reset(jit_t *j)
    jit_reset_exit_status(j);
 }
 
+void jit_walk_funcs(jit_t *j, jit_walk_fn_t fn, void *ctx)
+{
+   // Only visits functions which have been compiled or linked
+   const unsigned count = relaxed_load(&j->next_handle);
+   for (jit_handle_t handle = 0; handle < count; handle++) {
+      jit_func_t *f = jit_get_func(j, handle);
+      if (load_acquire(&(f->state)) == JIT_FUNC_READY
+          || f->privdata != MPTR_INVALID)
+         (*fn)(j, handle, ctx);
+   }
+}
+
+void *jit_get_privdata(jit_t *j, jit_handle_t handle)
+{
+   jit_func_t *f = jit_get_func(j, handle);
+   if (f->privdata == MPTR_INVALID)
+      return NULL;
+   else
+      return *mptr_get(f->privdata);
+}
+
+void jit_set_privdata(jit_t *j, jit_handle_t handle, void *ptr)
+{
+   jit_func_t *f = jit_get_func(j, handle);
+   *jit_get_privdata_ptr(j, f) = ptr;
+}
+
+const void *jit_get_cpool(jit_t *j, jit_handle_t handle, size_t *size)
+{
+   jit_func_t *f = jit_get_func(j, handle);
+   jit_fill_irbuf(f);
+
+   *size = f->cpoolsz;
+   return f->cpool;
+}
+
 jit_t *jit_for_thread(void)
 {
    jit_thread_local_t *thread = jit_thread_local();
@@ -23,6 +23,7 @@
 #include "jit/jit.h"
 #include "lib.h"
 #include "object.h"
+#include "option.h"
 #include "psl/psl-node.h"
 #include "rt/assert.h"
 #include "rt/mspace.h"
@@ -969,6 +970,18 @@ void __nvc_do_exit(jit_exit_t which, jit_anchor_t *anchor, jit_scalar_t *args,
       }
       break;
 
+   case JIT_EXIT_POINTER_MAP:
+      {
+         void            *ptr   = args[0].pointer;
+         const ptr_map_t *map   = args[1].pointer;
+         int64_t          count = args[2].integer;
+
+         // Code compiled ahead of time always registers maps
+         if (opt_get_int(OPT_POINTER_MAPS))
+            mspace_set_map(jit_get_mspace(thread->jit), ptr, map, count);
+      }
+      break;
+
    default:
       fatal_trace("unhandled exit %s", jit_exit_name(which));
    }
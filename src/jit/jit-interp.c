@@ -45,6 +45,7 @@ typedef struct _jit_interp {
    mspace_t      *mspace;
    jit_anchor_t  *anchor;
    tlab_t        *tlab;
+   jit_profile_t *profile;
 } jit_interp_t;
 
 #ifdef DEBUG
@@ -597,8 +598,48 @@ static void interp_branch_to(jit_interp_t *state, jit_value_t label)
    JIT_ASSERT(state->pc < state->func->nirs);
 }
 
-static void interp_jump(jit_interp_t *state, jit_ir_t *ir)
+static bool interp_backedge(jit_interp_t *state)
 {
+   jit_func_t *f = state->func;
+
+   // Count loop iterations towards the next tier so that a long
+   // running loop in a function called only once is still compiled
+   if (f->next_tier && --(f->hotness) <= 0)
+      jit_tier_up(f);
+
+   jit_entry_fn_t entry = load_acquire(f->body ? &f->body : &f->entry);
+   if (entry != f->osr_entry || state->pc == 0)
+      return false;
+
+   // Continue this call in the compiled code from the loop header
+   jit_osr_t osr = {
+      .anchor = {
+         .caller    = state->anchor->caller,
+         .func      = f,
+         .irpos     = JIT_OSR_IRPOS,
+         .watermark = state->anchor->watermark,
+      },
+      .regs   = state->regs,
+      .target = state->pc,
+      .flags  = state->flags,
+   };
+
+   (*entry)(f, &osr.anchor, state->args, state->tlab);
+   return true;
+}
+
+static void interp_profile_branch(jit_interp_t *state, unsigned irpos)
+{
+   jit_irprof_t *prof = &(state->profile->irs[irpos]);
+   relaxed_add(&prof->hits, 1);
+   if (state->pc != irpos + 1)
+      relaxed_add(&prof->taken, 1);
+}
+
+static bool interp_jump(jit_interp_t *state, jit_ir_t *ir)
+{
+   const unsigned irpos = ir - state->func->irbuf;
+
    switch (ir->cc) {
    case JIT_CC_NONE:
       interp_branch_to(state, ir->arg1);
@@ -615,6 +656,12 @@ static void interp_jump(jit_interp_t *state, jit_ir_t *ir)
       interp_dump(state);
       fatal_trace("unhandled jump condition code");
    }
+
+   if (state->profile != NULL && ir->cc != JIT_CC_NONE)
+      interp_profile_branch(state, irpos);
+
+   // Returns true if the rest of the call was executed by compiled code
+   return state->pc <= irpos && interp_backedge(state);
 }
 
 static void interp_trap(jit_interp_t *state, jit_ir_t *ir)
@@ -629,6 +676,9 @@ static void interp_call(jit_interp_t *state, jit_ir_t *ir)
 
    state->anchor->irpos = ir - state->func->irbuf;
 
+   if (state->profile != NULL)
+      relaxed_add(&(state->profile->irs[state->anchor->irpos].hits), 1);
+
    if (ir->arg1.handle == JIT_HANDLE_INVALID) {
       jit_dump_with_mark(state->func, state->anchor->irpos, false);
       jit_msg(NULL, DIAG_FATAL, "missing definition for subprogram");
@@ -850,13 +900,18 @@ static void interp_putpriv(jit_interp_t *state, jit_ir_t *ir)
    store_release(jit_get_privdata_ptr(state->func->jit, f), ptr);
 }
 
-static void interp_case(jit_interp_t *state, jit_ir_t *ir)
+static bool interp_case(jit_interp_t *state, jit_ir_t *ir)
 {
    jit_scalar_t test = state->regs[ir->result];
    const int64_t cmp = interp_get_int(state, ir->arg1);
 
-   if (test.integer == cmp)
-      interp_branch_to(state, ir->arg2);
+   if (test.integer != cmp)
+      return false;
+
+   interp_branch_to(state, ir->arg2);
+
+   // Returns true if the rest of the call was executed by compiled code
+   return state->pc <= ir - state->func->irbuf && interp_backedge(state);
 }
 
 static void interp_trim(jit_interp_t *state, jit_ir_t *ir)
@@ -884,195 +939,747 @@ static void interp_sadd(jit_interp_t *state, jit_ir_t *ir)
    FOR_EACH_SIZE(ir->size, SADD);
 }
 
-static void interp_loop(jit_interp_t *state)
-{
-   for (;;) {
-      JIT_ASSERT(state->pc < state->func->nirs);
-      jit_ir_t *ir = &(state->func->irbuf[state->pc++]);
-      switch (ir->op) {
-      case J_RECV:
-         interp_recv(state, ir);
-         break;
-      case J_SEND:
-         interp_send(state, ir);
-         break;
-      case J_AND:
-         interp_and(state, ir);
-         break;
-      case J_OR:
-         interp_or(state, ir);
-         break;
-      case J_XOR:
-         interp_xor(state, ir);
-         break;
-      case J_SUB:
-         interp_sub(state, ir);
-         break;
-      case J_FSUB:
-         interp_fsub(state, ir);
-         break;
-      case J_ADD:
-         interp_add(state, ir);
-         break;
-      case J_FADD:
-         interp_fadd(state, ir);
-         break;
-      case J_MUL:
-         interp_mul(state, ir);
-         break;
-      case J_FMUL:
-         interp_fmul(state, ir);
-         break;
-      case J_DIV:
-         interp_div(state, ir);
-         break;
-      case J_FDIV:
-         interp_fdiv(state, ir);
-         break;
-      case J_SHL:
-         interp_shl(state, ir);
-         break;
-      case J_ASR:
-         interp_asr(state, ir);
-         break;
-      case J_RET:
-         return;
-      case J_STORE:
-         interp_store(state, ir);
-         break;
-      case J_ULOAD:
-         interp_uload(state, ir);
-         break;
-      case J_LOAD:
-         interp_load(state, ir);
-         break;
-      case J_CMP:
-         interp_cmp(state, ir);
-         break;
-      case J_CCMP:
-         interp_ccmp(state, ir);
-         break;
-      case J_FCMP:
-         interp_fcmp(state, ir);
-         break;
-      case J_FCCMP:
-         interp_fccmp(state, ir);
-         break;
-      case J_CSET:
-         interp_cset(state, ir);
-         break;
-      case J_JUMP:
-         interp_jump(state, ir);
-         break;
-      case J_TRAP:
-         interp_trap(state, ir);
-         break;
-      case J_CALL:
-         interp_call(state, ir);
-         break;
-      case J_MOV:
-         interp_mov(state, ir);
-         break;
-      case J_CSEL:
-         interp_csel(state, ir);
-         break;
-      case J_NEG:
-         interp_neg(state, ir);
-         break;
-      case J_FNEG:
-         interp_fneg(state, ir);
-         break;
-      case J_NOT:
-         interp_not(state, ir);
-         break;
-      case J_SCVTF:
-         interp_scvtf(state, ir);
-         break;
-      case J_FCVTNS:
-         interp_fcvtns(state, ir);
-         break;
-      case J_LEA:
-         interp_lea(state, ir);
-         break;
-      case J_REM:
-         interp_rem(state, ir);
-         break;
-      case J_CLAMP:
-         interp_clamp(state, ir);
-         break;
-      case J_DEBUG:
-      case J_NOP:
-         break;
-      case MACRO_COPY:
-         interp_copy(state, ir);
-         break;
-      case MACRO_MOVE:
-         interp_move(state, ir);
-         break;
-      case MACRO_BZERO:
-         interp_bzero(state, ir);
-         break;
-      case MACRO_MEMSET:
-         interp_memset(state, ir);
-         break;
-      case MACRO_GALLOC:
-         interp_galloc(state, ir);
-         break;
-      case MACRO_LALLOC:
-         interp_lalloc(state, ir);
-         break;
-      case MACRO_SALLOC:
-         interp_salloc(state, ir);
-         break;
-      case MACRO_EXIT:
-         interp_exit(state, ir);
-         break;
-      case MACRO_FEXP:
-         interp_fexp(state, ir);
-         break;
-      case MACRO_EXP:
-         interp_exp(state, ir);
-         break;
-      case MACRO_GETPRIV:
-         interp_getpriv(state, ir);
-         break;
-      case MACRO_PUTPRIV:
-         interp_putpriv(state, ir);
-         break;
-      case MACRO_CASE:
-         interp_case(state, ir);
-         break;
-      case MACRO_TRIM:
-         interp_trim(state, ir);
-         break;
-      case MACRO_REEXEC:
-         interp_reexec(state, ir);
-         return;
-      case MACRO_SADD:
-         interp_sadd(state, ir);
-         break;
+static bool interp_step(jit_interp_t *state, jit_ir_t *ir)
+{
+   switch (ir->op) {
+   case J_RECV:
+      interp_recv(state, ir);
+      break;
+   case J_SEND:
+      interp_send(state, ir);
+      break;
+   case J_AND:
+      interp_and(state, ir);
+      break;
+   case J_OR:
+      interp_or(state, ir);
+      break;
+   case J_XOR:
+      interp_xor(state, ir);
+      break;
+   case J_SUB:
+      interp_sub(state, ir);
+      break;
+   case J_FSUB:
+      interp_fsub(state, ir);
+      break;
+   case J_ADD:
+      interp_add(state, ir);
+      break;
+   case J_FADD:
+      interp_fadd(state, ir);
+      break;
+   case J_MUL:
+      interp_mul(state, ir);
+      break;
+   case J_FMUL:
+      interp_fmul(state, ir);
+      break;
+   case J_DIV:
+      interp_div(state, ir);
+      break;
+   case J_FDIV:
+      interp_fdiv(state, ir);
+      break;
+   case J_SHL:
+      interp_shl(state, ir);
+      break;
+   case J_ASR:
+      interp_asr(state, ir);
+      break;
+   case J_RET:
+      return true;
+   case J_STORE:
+      interp_store(state, ir);
+      break;
+   case J_ULOAD:
+      interp_uload(state, ir);
+      break;
+   case J_LOAD:
+      interp_load(state, ir);
+      break;
+   case J_CMP:
+      interp_cmp(state, ir);
+      break;
+   case J_CCMP:
+      interp_ccmp(state, ir);
+      break;
+   case J_FCMP:
+      interp_fcmp(state, ir);
+      break;
+   case J_FCCMP:
+      interp_fccmp(state, ir);
+      break;
+   case J_CSET:
+      interp_cset(state, ir);
+      break;
+   case J_JUMP:
+      return interp_jump(state, ir);
+   case J_TRAP:
+      interp_trap(state, ir);
+      break;
+   case J_CALL:
+      interp_call(state, ir);
+      break;
+   case J_MOV:
+      interp_mov(state, ir);
+      break;
+   case J_CSEL:
+      interp_csel(state, ir);
+      break;
+   case J_NEG:
+      interp_neg(state, ir);
+      break;
+   case J_FNEG:
+      interp_fneg(state, ir);
+      break;
+   case J_NOT:
+      interp_not(state, ir);
+      break;
+   case J_SCVTF:
+      interp_scvtf(state, ir);
+      break;
+   case J_FCVTNS:
+      interp_fcvtns(state, ir);
+      break;
+   case J_LEA:
+      interp_lea(state, ir);
+      break;
+   case J_REM:
+      interp_rem(state, ir);
+      break;
+   case J_CLAMP:
+      interp_clamp(state, ir);
+      break;
+   case J_DEBUG:
+   case J_NOP:
+      break;
+   case MACRO_COPY:
+      interp_copy(state, ir);
+      break;
+   case MACRO_MOVE:
+      interp_move(state, ir);
+      break;
+   case MACRO_BZERO:
+      interp_bzero(state, ir);
+      break;
+   case MACRO_MEMSET:
+      interp_memset(state, ir);
+      break;
+   case MACRO_GALLOC:
+      interp_galloc(state, ir);
+      break;
+   case MACRO_LALLOC:
+      interp_lalloc(state, ir);
+      break;
+   case MACRO_SALLOC:
+      interp_salloc(state, ir);
+      break;
+   case MACRO_EXIT:
+      interp_exit(state, ir);
+      break;
+   case MACRO_FEXP:
+      interp_fexp(state, ir);
+      break;
+   case MACRO_EXP:
+      interp_exp(state, ir);
+      break;
+   case MACRO_GETPRIV:
+      interp_getpriv(state, ir);
+      break;
+   case MACRO_PUTPRIV:
+      interp_putpriv(state, ir);
+      break;
+   case MACRO_CASE:
+      return interp_case(state, ir);
+   case MACRO_TRIM:
+      interp_trim(state, ir);
+      break;
+   case MACRO_REEXEC:
+      interp_reexec(state, ir);
+      return true;
+   case MACRO_SADD:
+      interp_sadd(state, ir);
+      break;
+   default:
+      interp_dump(state);
+      fatal_trace("cannot interpret opcode %s", jit_op_name(ir->op));
+   }
+
+   return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Threaded dispatch
+//
+// Each function's IR is decoded once into an array of pre-resolved
+// instructions which correspond one-to-one with the IR so that program
+// counters, anchors, and profile counters are unchanged.  Common
+// instructions with register or immediate operands get a specialised
+// handler and a few frequent sequences are fused into a single handler
+// which skips over the following instructions.  Everything else falls
+// back to interp_step.
+
+typedef struct _interp_insn {
+   const void *handler;
+   int64_t     imm;
+   uint32_t    target;
+   int32_t     disp;
+   jit_reg_t   result;
+   jit_reg_t   reg1;
+   jit_reg_t   reg2;
+} interp_insn_t;
+
+#define INTERP_BINOPS(x)                                                \
+   x(ADD, +) x(SUB, -) x(MUL, *) x(AND, &) x(OR, |) x(XOR, ^)           \
+   x(SHL, <<) x(ASR, >>)
+
+#define INTERP_CONDS(x)                                                 \
+   x(EQ, ==) x(NE, !=) x(LT, <) x(GT, >) x(LE, <=) x(GE, >=)
+
+#define INTERP_LOADS(x)                                                 \
+   x(LOAD8, int8_t) x(LOAD16, int16_t) x(LOAD32, int32_t)               \
+   x(LOAD64, int64_t) x(ULOAD8, uint8_t) x(ULOAD16, uint16_t)           \
+   x(ULOAD32, uint32_t)
+
+#define INTERP_STORES(x)                                                \
+   x(STORE8, uint8_t) x(STORE16, uint16_t) x(STORE32, uint32_t)         \
+   x(STORE64, uint64_t)
+
+#define INTERP_LDADDS(x) x(LDADD32, int32_t) x(LDADD64, int64_t)
+
+typedef enum {
+   IOP_GENERIC,
+   IOP_NOP,
+   IOP_RET,
+   IOP_MOV_R,
+   IOP_MOV_I,
+   IOP_RECV,
+   IOP_SEND_R,
+   IOP_SEND_I,
+   IOP_CLAMP,
+   IOP_CSET,
+   IOP_LEA,
+   IOP_JUMP,
+   IOP_JUMP_COND,
+#define BINOP_IOPS(name, op) IOP_##name##_RR, IOP_##name##_RI,
+   INTERP_BINOPS(BINOP_IOPS)
+#undef BINOP_IOPS
+   // The order within each group here is relied on by interp_decode
+#define COND_IOPS(name, op)                                     \
+   IOP_CMP_##name##_RR, IOP_CMP_##name##_RI,                    \
+   IOP_CMPJMP_##name##_RR, IOP_CMPJMP_##name##_RI,              \
+   IOP_CLAMPJMP_##name##_RR, IOP_CLAMPJMP_##name##_RI,
+   INTERP_CONDS(COND_IOPS)
+#undef COND_IOPS
+#define MEMORY_IOPS(name, type) IOP_##name,
+   INTERP_LOADS(MEMORY_IOPS)
+#undef MEMORY_IOPS
+#define STORE_IOPS(name, type) IOP_##name##_R, IOP_##name##_I,
+   INTERP_STORES(STORE_IOPS)
+#undef STORE_IOPS
+#define LDADD_IOPS(name, type) IOP_##name##_RR, IOP_##name##_RI,
+   INTERP_LDADDS(LDADD_IOPS)
+#undef LDADD_IOPS
+
+   IOP_COUNT
+} interp_op_t;
+
+STATIC_ASSERT(IOP_CLAMPJMP_EQ_RI == IOP_CMP_EQ_RR + 5);
+STATIC_ASSERT(IOP_CMP_NE_RR == IOP_CMP_EQ_RR + 6);
+
+static int interp_decode_operands(const jit_ir_t *ir, interp_insn_t *insn,
+                                  bool commute)
+{
+   // Returns 0 for a register and register operand, 1 for a register
+   // and immediate, or -1 if the generic path must be used
+   jit_value_t arg1 = ir->arg1, arg2 = ir->arg2;
+
+   if (commute && arg1.kind == JIT_VALUE_INT64 && arg2.kind == JIT_VALUE_REG) {
+      arg1 = ir->arg2;
+      arg2 = ir->arg1;
+   }
+
+   if (arg1.kind != JIT_VALUE_REG)
+      return -1;
+
+   insn->reg1 = arg1.reg;
+
+   switch (arg2.kind) {
+   case JIT_VALUE_REG:
+      insn->reg2 = arg2.reg;
+      return 0;
+   case JIT_VALUE_INT64:
+      insn->imm = arg2.int64;
+      return 1;
+   default:
+      return -1;
+   }
+}
+
+static interp_op_t interp_decode_binop(const jit_ir_t *ir,
+                                       interp_insn_t *insn)
+{
+   if (ir->cc != JIT_CC_NONE)
+      return IOP_GENERIC;
+
+   interp_op_t base;
+   bool commute = true;
+   switch (ir->op) {
+#define BINOP_CASE(name, op) case J_##name: base = IOP_##name##_RR; break;
+      INTERP_BINOPS(BINOP_CASE)
+#undef BINOP_CASE
+   default:
+      return IOP_GENERIC;
+   }
+
+   if (ir->op == J_SUB || ir->op == J_SHL || ir->op == J_ASR)
+      commute = false;
+
+   const int form = interp_decode_operands(ir, insn, commute);
+   return form < 0 ? IOP_GENERIC : base + form;
+}
+
+static interp_op_t interp_decode_cmp(const jit_ir_t *ir, interp_insn_t *insn)
+{
+   if (ir->op != J_CMP)
+      return IOP_GENERIC;
+
+   interp_op_t base;
+   switch (ir->cc) {
+#define COND_CASE(name, op) case JIT_CC_##name: base = IOP_CMP_##name##_RR; break;
+      INTERP_CONDS(COND_CASE)
+#undef COND_CASE
+   default:
+      return IOP_GENERIC;
+   }
+
+   const int form = interp_decode_operands(ir, insn, false);
+   return form < 0 ? IOP_GENERIC : base + form;
+}
+
+static bool interp_is_cond_jump(const jit_ir_t *ir)
+{
+   return ir->op == J_JUMP && ir->arg1.kind == JIT_VALUE_LABEL
+      && (ir->cc == JIT_CC_T || ir->cc == JIT_CC_F);
+}
+
+static interp_op_t interp_decode_load(const jit_ir_t *ir)
+{
+   if (ir->arg1.kind != JIT_ADDR_REG)
+      return IOP_GENERIC;
+
+   switch (ir->size) {
+   case JIT_SZ_8: return ir->op == J_LOAD ? IOP_LOAD8 : IOP_ULOAD8;
+   case JIT_SZ_16: return ir->op == J_LOAD ? IOP_LOAD16 : IOP_ULOAD16;
+   case JIT_SZ_32: return ir->op == J_LOAD ? IOP_LOAD32 : IOP_ULOAD32;
+   case JIT_SZ_64: return IOP_LOAD64;
+   default: return IOP_GENERIC;
+   }
+}
+
+static interp_op_t interp_decode_store(const jit_ir_t *ir,
+                                       interp_insn_t *insn)
+{
+   if (ir->arg2.kind != JIT_ADDR_REG)
+      return IOP_GENERIC;
+
+   insn->reg2 = ir->arg2.reg;
+   insn->disp = ir->arg2.disp;
+
+   int form;
+   switch (ir->arg1.kind) {
+   case JIT_VALUE_REG:
+      insn->reg1 = ir->arg1.reg;
+      form = 0;
+      break;
+   case JIT_VALUE_INT64:
+   case JIT_VALUE_DOUBLE:
+      insn->imm = ir->arg1.int64;
+      form = 1;
+      break;
+   default:
+      return IOP_GENERIC;
+   }
+
+   switch (ir->size) {
+   case JIT_SZ_8: return IOP_STORE8_R + form;
+   case JIT_SZ_16: return IOP_STORE16_R + form;
+   case JIT_SZ_32: return IOP_STORE32_R + form;
+   case JIT_SZ_64: return IOP_STORE64_R + form;
+   default: return IOP_GENERIC;
+   }
+}
+
+static interp_op_t interp_decode_one(jit_func_t *f, unsigned pos,
+                                     interp_insn_t *insn)
+{
+   const jit_ir_t *ir = &(f->irbuf[pos]);
+   const jit_ir_t *next = pos + 1 < f->nirs ? ir + 1 : NULL;
+   const jit_ir_t *next2 = pos + 2 < f->nirs ? ir + 2 : NULL;
+
+   insn->result = ir->result;
+
+   switch (ir->op) {
+   case J_NOP:
+   case J_DEBUG:
+      return IOP_NOP;
+   case J_RET:
+      return IOP_RET;
+   case J_MOV:
+      switch (ir->arg1.kind) {
+      case JIT_VALUE_REG:
+         insn->reg1 = ir->arg1.reg;
+         return IOP_MOV_R;
+      case JIT_VALUE_INT64:
+      case JIT_VALUE_DOUBLE:
+         insn->imm = ir->arg1.int64;
+         return IOP_MOV_I;
+      default:
+         return IOP_GENERIC;
+      }
+   case J_RECV:
+      insn->disp = ir->arg1.int64;
+      return IOP_RECV;
+   case J_SEND:
+      insn->disp = ir->arg1.int64;
+      switch (ir->arg2.kind) {
+      case JIT_VALUE_REG:
+         insn->reg2 = ir->arg2.reg;
+         return IOP_SEND_R;
+      case JIT_VALUE_INT64:
+      case JIT_VALUE_DOUBLE:
+         insn->imm = ir->arg2.int64;
+         return IOP_SEND_I;
+      default:
+         return IOP_GENERIC;
+      }
+   case J_CLAMP:
+      if (ir->arg1.kind != JIT_VALUE_REG)
+         return IOP_GENERIC;
+      insn->reg1 = ir->arg1.reg;
+      if (next2 != NULL && interp_is_cond_jump(next2)) {
+         interp_insn_t tmp;
+         const interp_op_t cmp = interp_decode_cmp(next, &tmp);
+         if (cmp != IOP_GENERIC)
+            return cmp + 4;
+      }
+      return IOP_CLAMP;
+   case J_CSET:
+      return IOP_CSET;
+   case J_LEA:
+      if (ir->arg1.kind != JIT_ADDR_REG)
+         return IOP_GENERIC;
+      insn->reg1 = ir->arg1.reg;
+      insn->disp = ir->arg1.disp;
+      return IOP_LEA;
+   case J_JUMP:
+      if (ir->arg1.kind != JIT_VALUE_LABEL)
+         return IOP_GENERIC;
+      insn->target = ir->arg1.label;
+      switch (ir->cc) {
+      case JIT_CC_NONE:
+         return IOP_JUMP;
+      case JIT_CC_T:
+      case JIT_CC_F:
+         insn->imm = (ir->cc == JIT_CC_T);
+         return IOP_JUMP_COND;
       default:
-         interp_dump(state);
-         fatal_trace("cannot interpret opcode %s", jit_op_name(ir->op));
+         return IOP_GENERIC;
       }
+   case J_CMP:
+      {
+         const interp_op_t cmp = interp_decode_cmp(ir, insn);
+         if (cmp != IOP_GENERIC && next != NULL && interp_is_cond_jump(next))
+            return cmp + 2;
+         return cmp;
+      }
+   case J_LOAD:
+   case J_ULOAD:
+      {
+         const interp_op_t load = interp_decode_load(ir);
+         if (load == IOP_GENERIC)
+            return IOP_GENERIC;
+
+         insn->reg1 = ir->arg1.reg;
+         insn->disp = ir->arg1.disp;
+
+         if ((load == IOP_LOAD32 || load == IOP_LOAD64) && next != NULL
+             && next->op == J_ADD) {
+            interp_insn_t tmp;
+            const interp_op_t add = interp_decode_binop(next, &tmp);
+            if (add != IOP_GENERIC) {
+               const int form = add - IOP_ADD_RR;
+               if (load == IOP_LOAD32)
+                  return IOP_LDADD32_RR + form;
+               else
+                  return IOP_LDADD64_RR + form;
+            }
+         }
+
+         return load;
+      }
+   case J_STORE:
+      return interp_decode_store(ir, insn);
+   default:
+      return interp_decode_binop(ir, insn);
    }
 }
 
-void jit_interp(jit_func_t *f, jit_anchor_t *caller, jit_scalar_t *args,
-                tlab_t *tlab)
+static const interp_insn_t *interp_decode(jit_func_t *f,
+                                          const void *const *handlers)
 {
-   jit_entry_fn_t entry = load_acquire(&f->entry);
-   if (unlikely(entry != jit_interp)) {
-      // Raced with a code generation thread installing a compiled
-      // version of this function
-      return (*entry)(f, caller, args, tlab);
-   }
+   interp_insn_t *code = xcalloc_array(f->nirs, sizeof(interp_insn_t));
 
-   jit_fill_irbuf(f);
+   for (unsigned i = 0; i < f->nirs; i++)
+      code[i].handler = handlers[interp_decode_one(f, i, &(code[i]))];
 
-   if (f->next_tier && --(f->hotness) <= 0)
-      jit_tier_up(f);
+   if (atomic_cas(&f->threaded, NULL, code))
+      return code;
+
+   free(code);   // Raced with another thread
+   return load_acquire(&f->threaded);
+}
+
+static void interp_run(jit_interp_t *state)
+{
+   static const void *const handlers[IOP_COUNT] = {
+      [IOP_GENERIC] = &&op_GENERIC,
+      [IOP_NOP] = &&op_NOP,
+      [IOP_RET] = &&op_RET,
+      [IOP_MOV_R] = &&op_MOV_R,
+      [IOP_MOV_I] = &&op_MOV_I,
+      [IOP_RECV] = &&op_RECV,
+      [IOP_SEND_R] = &&op_SEND_R,
+      [IOP_SEND_I] = &&op_SEND_I,
+      [IOP_CLAMP] = &&op_CLAMP,
+      [IOP_CSET] = &&op_CSET,
+      [IOP_LEA] = &&op_LEA,
+      [IOP_JUMP] = &&op_JUMP,
+      [IOP_JUMP_COND] = &&op_JUMP_COND,
+#define BINOP_LABELS(name, op)                                  \
+      [IOP_##name##_RR] = &&op_##name##_RR,                     \
+      [IOP_##name##_RI] = &&op_##name##_RI,
+      INTERP_BINOPS(BINOP_LABELS)
+#undef BINOP_LABELS
+#define COND_LABELS(name, op)                                   \
+      [IOP_CMP_##name##_RR] = &&op_CMP_##name##_RR,             \
+      [IOP_CMP_##name##_RI] = &&op_CMP_##name##_RI,             \
+      [IOP_CMPJMP_##name##_RR] = &&op_CMPJMP_##name##_RR,       \
+      [IOP_CMPJMP_##name##_RI] = &&op_CMPJMP_##name##_RI,       \
+      [IOP_CLAMPJMP_##name##_RR] = &&op_CLAMPJMP_##name##_RR,   \
+      [IOP_CLAMPJMP_##name##_RI] = &&op_CLAMPJMP_##name##_RI,
+      INTERP_CONDS(COND_LABELS)
+#undef COND_LABELS
+#define LOAD_LABELS(name, type) [IOP_##name] = &&op_##name,
+      INTERP_LOADS(LOAD_LABELS)
+#undef LOAD_LABELS
+#define STORE_LABELS(name, type)                                \
+      [IOP_##name##_R] = &&op_##name##_R,                       \
+      [IOP_##name##_I] = &&op_##name##_I,
+      INTERP_STORES(STORE_LABELS)
+#undef STORE_LABELS
+#define LDADD_LABELS(name, type)                                \
+      [IOP_##name##_RR] = &&op_##name##_RR,                     \
+      [IOP_##name##_RI] = &&op_##name##_RI,
+      INTERP_LDADDS(LDADD_LABELS)
+#undef LDADD_LABELS
+   };
+
+   jit_func_t *f = state->func;
+   const interp_insn_t *code = load_acquire(&f->threaded);
+   if (unlikely(code == NULL))
+      code = interp_decode(f, handlers);
+
+   jit_scalar_t *const regs = state->regs;
+   const bool profiling = state->profile != NULL;
+   const interp_insn_t *ip = code + state->pc;
+
+#define DISPATCH() goto *ip->handler
+#define NEXT(n) do { ip += (n); DISPATCH(); } while (0)
+
+#define BRANCH(insn) do {                                       \
+      const interp_insn_t *from = (insn);                       \
+      ip = code + from->target;                                 \
+      if (ip <= from) {                                         \
+         state->pc = from->target;                              \
+         if (interp_backedge(state))                            \
+            return;                                             \
+      }                                                         \
+      DISPATCH();                                               \
+   } while (0)
+
+#define COND_JUMP(insn) do {                                    \
+      const interp_insn_t *jump = (insn);                       \
+      const bool taken = (state->flags != 0) == jump->imm;      \
+      if (unlikely(profiling)) {                                \
+         state->pc = taken ? jump->target : jump - code + 1;    \
+         interp_profile_branch(state, jump - code);             \
+      }                                                         \
+      if (taken)                                                \
+         BRANCH(jump);                                          \
+      ip = jump + 1;                                            \
+      DISPATCH();                                               \
+   } while (0)
+
+#define BINOP_RR(insn, op)                                      \
+   regs[(insn)->result].integer =                               \
+      regs[(insn)->reg1].integer op regs[(insn)->reg2].integer
+#define BINOP_RI(insn, op)                                      \
+   regs[(insn)->result].integer = regs[(insn)->reg1].integer op (insn)->imm
+#define CMP_RR(insn, op)                                        \
+   state->flags = regs[(insn)->reg1].integer op regs[(insn)->reg2].integer
+#define CMP_RI(insn, op)                                        \
+   state->flags = regs[(insn)->reg1].integer op (insn)->imm
+#define CLAMP(insn) do {                                        \
+      const int64_t value = regs[(insn)->reg1].integer;         \
+      regs[(insn)->result].integer = value < 0 ? 0 : value;     \
+   } while (0)
+#define LOAD(insn, type)                                        \
+   regs[(insn)->result].integer =                               \
+      *(type *)(regs[(insn)->reg1].pointer + (insn)->disp)
+
+   DISPATCH();
+
+ op_GENERIC:
+   state->pc = ip - code + 1;
+   if (interp_step(state, &(f->irbuf[state->pc - 1])))
+      return;
+   ip = code + state->pc;
+   DISPATCH();
+
+ op_NOP:
+   NEXT(1);
+
+ op_RET:
+   return;
+
+ op_MOV_R:
+   regs[ip->result] = regs[ip->reg1];
+   NEXT(1);
+
+ op_MOV_I:
+   regs[ip->result].integer = ip->imm;
+   NEXT(1);
+
+ op_RECV:
+   regs[ip->result] = state->args[ip->disp];
+   state->nargs = MAX(state->nargs, ip->disp + 1);
+   NEXT(1);
+
+ op_SEND_R:
+   state->args[ip->disp] = regs[ip->reg2];
+   state->nargs = MAX(state->nargs, ip->disp + 1);
+   NEXT(1);
+
+ op_SEND_I:
+   state->args[ip->disp].integer = ip->imm;
+   state->nargs = MAX(state->nargs, ip->disp + 1);
+   NEXT(1);
+
+ op_CLAMP:
+   CLAMP(ip);
+   NEXT(1);
+
+ op_CSET:
+   regs[ip->result].integer = !!(state->flags);
+   NEXT(1);
+
+ op_LEA:
+   regs[ip->result].pointer = regs[ip->reg1].pointer + ip->disp;
+   NEXT(1);
+
+ op_JUMP:
+   BRANCH(ip);
+
+ op_JUMP_COND:
+   COND_JUMP(ip);
+
+#define BINOP_HANDLERS(name, op)                                \
+ op_##name##_RR:                                                \
+   BINOP_RR(ip, op);                                            \
+   NEXT(1);                                                     \
+ op_##name##_RI:                                                \
+   BINOP_RI(ip, op);                                            \
+   NEXT(1);
+
+   INTERP_BINOPS(BINOP_HANDLERS)
+#undef BINOP_HANDLERS
+
+#define COND_HANDLERS(name, op)                                 \
+ op_CMP_##name##_RR:                                            \
+   CMP_RR(ip, op);                                              \
+   NEXT(1);                                                     \
+ op_CMP_##name##_RI:                                            \
+   CMP_RI(ip, op);                                              \
+   NEXT(1);                                                     \
+ op_CMPJMP_##name##_RR:                                         \
+   CMP_RR(ip, op);                                              \
+   COND_JUMP(ip + 1);                                           \
+ op_CMPJMP_##name##_RI:                                         \
+   CMP_RI(ip, op);                                              \
+   COND_JUMP(ip + 1);                                           \
+ op_CLAMPJMP_##name##_RR:                                       \
+   CLAMP(ip);                                                   \
+   CMP_RR(ip + 1, op);                                          \
+   COND_JUMP(ip + 2);                                           \
+ op_CLAMPJMP_##name##_RI:                                       \
+   CLAMP(ip);                                                   \
+   CMP_RI(ip + 1, op);                                          \
+   COND_JUMP(ip + 2);
+
+   INTERP_CONDS(COND_HANDLERS)
+#undef COND_HANDLERS
+
+#define LOAD_HANDLERS(name, type)                               \
+ op_##name:                                                     \
+   LOAD(ip, type);                                              \
+   NEXT(1);
+
+   INTERP_LOADS(LOAD_HANDLERS)
+#undef LOAD_HANDLERS
+
+#define STORE_HANDLERS(name, type)                              \
+ op_##name##_R:                                                 \
+   *(type *)(regs[ip->reg2].pointer + ip->disp) =               \
+      regs[ip->reg1].integer;                                   \
+   NEXT(1);                                                     \
+ op_##name##_I:                                                 \
+   *(type *)(regs[ip->reg2].pointer + ip->disp) = ip->imm;      \
+   NEXT(1);
+
+   INTERP_STORES(STORE_HANDLERS)
+#undef STORE_HANDLERS
+
+#define LDADD_HANDLERS(name, type)                              \
+ op_##name##_RR:                                                \
+   LOAD(ip, type);                                              \
+   BINOP_RR(ip + 1, +);                                         \
+   NEXT(2);                                                     \
+ op_##name##_RI:                                                \
+   LOAD(ip, type);                                              \
+   BINOP_RI(ip + 1, +);                                         \
+   NEXT(2);
+
+   INTERP_LDADDS(LDADD_HANDLERS)
+#undef LDADD_HANDLERS
+
+#undef DISPATCH
+#undef NEXT
+#undef BRANCH
+#undef COND_JUMP
+#undef BINOP_RR
+#undef BINOP_RI
+#undef CMP_RR
+#undef CMP_RI
+#undef CLAMP
+#undef LOAD
+}
 
+static void interp_enter(jit_func_t *f, jit_anchor_t *caller,
+                         jit_scalar_t *args, tlab_t *tlab,
+                         jit_profile_t *profile)
+{
    jit_anchor_t anchor = {
       .caller    = caller,
       .func      = f,
@@ -1099,7 +1706,58 @@ void jit_interp(jit_func_t *f, jit_anchor_t *caller, jit_scalar_t *args,
       .mspace   = jit_get_mspace(f->jit),
       .anchor   = &anchor,
       .tlab     = tlab,
+      .profile  = profile,
    };
 
-   interp_loop(&state);
+   interp_run(&state);
+}
+
+void jit_interp(jit_func_t *f, jit_anchor_t *caller, jit_scalar_t *args,
+                tlab_t *tlab)
+{
+   jit_entry_fn_t entry = load_acquire(&f->entry);
+   if (unlikely(entry != jit_interp)) {
+      // Raced with a code generation thread installing a compiled
+      // version of this function
+      return (*entry)(f, caller, args, tlab);
+   }
+
+   jit_fill_irbuf(f);
+
+   if (f->next_tier && --(f->hotness) <= 0)
+      jit_tier_up(f);
+
+   // Only collect a profile while there is a higher tier to use it
+   jit_profile_t *profile = NULL;
+   if (f->next_tier != NULL) {
+      profile = jit_get_profile(f);
+      relaxed_add(&profile->calls, 1);
+   }
+
+   interp_enter(f, caller, args, tlab, profile);
+}
+
+void jit_interp_body(jit_func_t *f, jit_anchor_t *caller, jit_scalar_t *args,
+                     tlab_t *tlab)
+{
+   // Run the VHDL body of a function whose entry point is an intrinsic
+   // for arguments the intrinsic does not handle itself
+   jit_entry_fn_t body = load_acquire(&f->body);
+   if (body != jit_interp_body) {
+      // The body has been compiled by a higher tier
+      return (*body)(f, caller, args, tlab);
+   }
+
+   jit_fill_irbuf(f);
+
+   if (f->next_tier && --(f->hotness) <= 0)
+      jit_tier_up(f);
+
+   jit_profile_t *profile = NULL;
+   if (f->next_tier != NULL) {
+      profile = jit_get_profile(f);
+      relaxed_add(&profile->calls, 1);
+   }
+
+   interp_enter(f, caller, args, tlab, profile);
 }
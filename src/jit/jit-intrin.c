@@ -124,7 +124,7 @@ static const uint8_t or_table[16][16] = {
    {    _U, _X, _X, _1, _X, _X, _X, _1, _X   },  // | - |
 };
 
-#if defined HAVE_SSE41 || defined HAVE_NEON
+#if defined HAVE_SSE41 || defined HAVE_AVX2 || defined HAVE_NEON
 
 // Compressed lookup tables for vectorised intrinsics.  Note the
 // vectorised intrinsics all rely on being able to read up to
@@ -187,6 +187,41 @@ static const uint8_t lane_iota[16] = {
 
 #endif
 
+#ifdef HAVE_AVX2
+
+__attribute__((aligned(32)))
+static const uint8_t lane_iota32[32] = {
+   0,  1,  2,  3,  4,  5,  6,  7,  8,  9,  10, 11, 12, 13, 14, 15,
+   16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31,
+};
+
+// Reverses the bytes in each 128-bit lane
+__attribute__((aligned(32)))
+static const uint8_t reverse_lane[32] = {
+   15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+   15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+};
+
+// Selects the byte of a broadcast 32-bit word holding the bit for
+// each element where the first element is the most significant bit
+__attribute__((aligned(32)))
+static const uint8_t spread_select[32] = {
+   3, 3, 3, 3, 3, 3, 3, 3, 2, 2, 2, 2, 2, 2, 2, 2,
+   1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0,
+};
+
+__attribute__((aligned(32)))
+static const uint8_t spread_mask[32] = {
+   0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+   0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+   0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+   0x80, 0x40, 0x20, 0x10, 0x08, 0x04, 0x02, 0x01,
+};
+
+#endif
+
+static cpu_feature_t cpu_features;
+
 __attribute__((always_inline))
 static inline void *__tlab_alloc(tlab_t *t, size_t size, size_t align)
 {
@@ -325,6 +360,31 @@ static void std_to_x01_sse41(jit_func_t *func, jit_anchor_t *anchor,
 }
 #endif
 
+#ifdef HAVE_AVX2
+__attribute__((target("avx2")))
+static void std_to_x01_avx2(jit_func_t *func, jit_anchor_t *anchor,
+                            jit_scalar_t *args, tlab_t *tlab)
+{
+   const int size = args[3].integer ^ (args[3].integer >> 63);
+   const uint8_t *input = args[1].pointer;
+
+   uint8_t *result = __tlab_alloc(tlab, ALIGN_UP(size, 32), 16);
+
+   __m256i lookup = _mm256_broadcastsi128_si256(
+      _mm_load_si128((const __m128i *)cvt_to_x01));
+
+   for (int pos = 0; pos < size; pos += 32) {
+      __m256i in = _mm256_loadu_si256((const __m256i *)(input + pos));
+      __m256i out = _mm256_shuffle_epi8(lookup, in);
+      _mm256_storeu_si256((__m256i *)(result + pos), out);
+   }
+
+   args[0].pointer = result;
+   args[1].integer = size - 1;
+   args[2].integer = ~size;
+}
+#endif
+
 static void std_to_x01(jit_func_t *func, jit_anchor_t *anchor,
                        jit_scalar_t *args, tlab_t *tlab)
 {
@@ -341,10 +401,39 @@ static void std_to_x01(jit_func_t *func, jit_anchor_t *anchor,
    args[2].integer = ~size;
 }
 
+#ifdef HAVE_AVX2
+__attribute__((target("avx2")))
+static int __all_01_avx2(const void *vec, int size)
+{
+   // Returns the number of leading elements checked or -1 if any of
+   // them is not '0' or '1'
+   const __m256i mask = _mm256_set1_epi8(0x0e);
+   const __m256i want = _mm256_set1_epi8(0x02);
+
+   int pos = 0;
+   for (; pos + 31 < size; pos += 32) {
+      __m256i in  = _mm256_loadu_si256((const __m256i *)(vec + pos));
+      __m256i cmp = _mm256_cmpeq_epi8(_mm256_and_si256(in, mask), want);
+      if (_mm256_movemask_epi8(cmp) != -1)
+         return -1;
+   }
+
+   return pos;
+}
+#endif
+
 __attribute__((always_inline))
 static inline bool __all_01(const void *vec, int size)
 {
    int pos = 0;
+
+#ifdef HAVE_AVX2
+   if (size >= 32 && (cpu_features & CPU_AVX2)) {
+      if ((pos = __all_01_avx2(vec, size)) < 0)
+         return false;
+   }
+#endif
+
    for (; pos + 7 < size; pos += 8) {
       const uint64_t u64 = unaligned_load(vec + pos, uint64_t);
       if (!IS_01(u64))
@@ -509,10 +598,74 @@ static inline void __spread_bits(void* vec, uint8_t packed)
    memcpy(vec, &swap, sizeof(swap));
 }
 
+#ifdef HAVE_AVX2
+__attribute__((target("avx2"), always_inline))
+static inline uint32_t __pack_bits_avx2(const void *vec)
+{
+   // The first element becomes the most significant bit
+   const __m256i rev = _mm256_load_si256((const __m256i *)reverse_lane);
+
+   __m256i in = _mm256_loadu_si256((const __m256i *)vec);
+   in = _mm256_shuffle_epi8(in, rev);
+   in = _mm256_permute4x64_epi64(in, 0x4e);
+   return _mm256_movemask_epi8(_mm256_slli_epi16(in, 7));
+}
+
+__attribute__((target("avx2"), always_inline))
+static inline void __spread_bits_avx2(void *vec, uint32_t packed)
+{
+   const __m256i select = _mm256_load_si256((const __m256i *)spread_select);
+   const __m256i mask = _mm256_load_si256((const __m256i *)spread_mask);
+
+   __m256i bits = _mm256_shuffle_epi8(_mm256_set1_epi32(packed), select);
+   bits = _mm256_cmpeq_epi8(_mm256_and_si256(bits, mask), mask);
+   bits = _mm256_sub_epi8(_mm256_set1_epi8(_0), bits);   // _0 or _1
+   _mm256_storeu_si256((__m256i *)vec, bits);
+}
+
+__attribute__((target("avx2")))
+static int __ieee_packed_add_avx2(const uint8_t *left, const uint8_t *right,
+                                  int size, int carry, uint8_t *result)
+{
+   // Adds the trailing multiple of 32 elements and returns the carry
+   for (int pos = size - 32; pos >= 0; pos -= 32) {
+      const uint64_t lbits = __pack_bits_avx2(left + pos);
+      const uint64_t rbits = __pack_bits_avx2(right + pos);
+      const uint64_t sum = lbits + rbits + carry;
+
+      __spread_bits_avx2(result + pos, sum);
+      carry = sum >> 32;
+   }
+
+   return carry;
+}
+
+__attribute__((target("avx2")))
+static void __pack_limbs_avx2(const uint8_t *vec, int size, uint32_t *limbs)
+{
+   for (int pos = size - 32; pos >= 0; pos -= 32)
+      *limbs++ = __pack_bits_avx2(vec + pos);
+}
+
+__attribute__((target("avx2")))
+static void __unpack_limbs_avx2(const uint32_t *limbs, int size, uint8_t *vec)
+{
+   for (int pos = size - 32; pos >= 0; pos -= 32)
+      __spread_bits_avx2(vec + pos, *limbs++);
+}
+#endif
+
 __attribute__((always_inline))
 static inline void __ieee_packed_add(const uint8_t *left, const uint8_t *right,
                                      int size, int carry, uint8_t *result)
 {
+#ifdef HAVE_AVX2
+   if (size >= 32 && (cpu_features & CPU_AVX2)) {
+      carry = __ieee_packed_add_avx2(left, right, size, carry, result);
+      size &= 31;
+   }
+#endif
+
    int pos = size - 8;
    for (; pos > 0; pos -= 8) {
       const unsigned lbyte = __pack_low_bits(left + pos);
@@ -532,6 +685,85 @@ static inline void __ieee_packed_add(const uint8_t *left, const uint8_t *right,
    }
 }
 
+static void __pack_limbs(const uint8_t *vec, int size, uint32_t *limbs)
+{
+   // Limb zero holds the 32 least significant bits
+   int pos = size;
+
+#ifdef HAVE_AVX2
+   if (size >= 32 && (cpu_features & CPU_AVX2)) {
+      __pack_limbs_avx2(vec, size, limbs);
+      limbs += size / 32;
+      pos = size & 31;
+   }
+#endif
+
+   for (; pos >= 32; pos -= 32) {
+      uint32_t limb = 0;
+      for (int i = 0; i < 4; i++)
+         limb |= (uint32_t)__pack_low_bits(vec + pos - 8 * (i + 1)) << (8 * i);
+      *limbs++ = limb;
+   }
+
+   if (pos > 0) {
+      uint32_t limb = 0;
+      for (int i = pos - 1, bit = 0; i >= 0; i--, bit++)
+         limb |= (uint32_t)(vec[i] & 1) << bit;
+      *limbs = limb;
+   }
+}
+
+static void __unpack_limbs(const uint32_t *limbs, int size, uint8_t *vec)
+{
+   int pos = size;
+
+#ifdef HAVE_AVX2
+   if (size >= 32 && (cpu_features & CPU_AVX2)) {
+      __unpack_limbs_avx2(limbs, size, vec);
+      limbs += size / 32;
+      pos = size & 31;
+   }
+#endif
+
+   for (; pos >= 32; pos -= 32, limbs++) {
+      for (int i = 0; i < 4; i++)
+         __spread_bits(vec + pos - 8 * (i + 1), *limbs >> (8 * i));
+   }
+
+   for (int i = pos - 1, bit = 0; i >= 0; i--, bit++)
+      vec[i] = ((*limbs >> bit) & 1) | _0;
+}
+
+static void __ieee_packed_mul(tlab_t *tlab, const uint8_t *left,
+                              const uint8_t *right, int size, uint8_t *result)
+{
+   // Both arguments must be extended to the size of the result which
+   // is then the product modulo 2^size for signed or unsigned values
+   const int nlimbs = (size + 31) / 32;
+   uint32_t *lw = __tlab_alloc(tlab, nlimbs * sizeof(uint32_t), 8);
+   uint32_t *rw = __tlab_alloc(tlab, nlimbs * sizeof(uint32_t), 8);
+   uint32_t *pw = __tlab_alloc(tlab, nlimbs * sizeof(uint32_t), 8);
+
+   __pack_limbs(left, size, lw);
+   __pack_limbs(right, size, rw);
+
+   memset(pw, '\0', nlimbs * sizeof(uint32_t));
+
+   for (int i = 0; i < nlimbs; i++) {
+      if (lw[i] == 0)
+         continue;
+
+      uint64_t carry = 0;
+      for (int j = 0; i + j < nlimbs; j++) {
+         const uint64_t t = (uint64_t)lw[i] * rw[j] + pw[i + j] + carry;
+         pw[i + j] = t;
+         carry = t >> 32;
+      }
+   }
+
+   __unpack_limbs(pw, size, result);
+}
+
 __attribute__((always_inline))
 static inline uint8_t *__to_unsigned(jit_func_t *func, jit_anchor_t *anchor,
                                      tlab_t *tlab, int64_t arg, int size)
@@ -773,19 +1005,9 @@ static void ieee_mul_unsigned(jit_func_t *func, jit_anchor_t *anchor,
       if (left[0] == _X || right[0] == _X)
          memset(result, _X, size);
       else {
-         memset(result, _0, size);
-
-         uint8_t *adval = __resize_unsigned(tlab, right, rsize, size);
-         for (int i = lsize - 1, shift = 0; i >= 0; i--, shift++) {
-            if (left[i] == _1) {
-               // Delay left-shift until value needed
-               memmove(adval, adval + shift, size - shift);
-               memset(adval + size - shift, _0, shift);
-               shift = 0;
-
-               __ieee_packed_add(result, adval, size, 0, result);
-            }
-         }
+         const uint8_t *lext = __resize_unsigned(tlab, left, lsize, size);
+         const uint8_t *rext = __resize_unsigned(tlab, right, rsize, size);
+         __ieee_packed_mul(tlab, lext, rext, size, result);
       }
 
       __tlab_restore(tlab, mark);
@@ -821,22 +1043,9 @@ static void ieee_mul_signed(jit_func_t *func, jit_anchor_t *anchor,
       if (left[0] == _X || right[0] == _X)
          memset(result, _X, size);
       else {
-         memset(result, _0, size);
-
-         uint8_t *adval = __resize_signed(tlab, right, rsize, size);
-         for (int i = lsize - 1, shift = 0; i >= 0; i--, shift++) {
-            if (left[i] == _1) {
-               // Delay left-shift until value needed
-               memmove(adval, adval + shift, size - shift);
-               memset(adval + size - shift, _0, shift);
-               shift = 0;
-
-               if (i == 0)
-                  __invert_bits(adval, size, adval);
-
-               __ieee_packed_add(result, adval, size, i == 0, result);
-            }
-         }
+         const uint8_t *lext = __resize_signed(tlab, left, lsize, size);
+         const uint8_t *rext = __resize_signed(tlab, right, rsize, size);
+         __ieee_packed_mul(tlab, lext, rext, size, result);
       }
 
       __tlab_restore(tlab, mark);
@@ -847,6 +1056,25 @@ static void ieee_mul_signed(jit_func_t *func, jit_anchor_t *anchor,
    }
 }
 
+#ifdef HAVE_AVX2
+__attribute__((target("avx2")))
+static int __first_difference_avx2(const uint8_t *left, const uint8_t *right,
+                                   int size)
+{
+   int pos = 0;
+   for (; pos + 31 < size; pos += 32) {
+      __m256i left1  = _mm256_loadu_si256((const __m256i *)(left + pos));
+      __m256i right1 = _mm256_loadu_si256((const __m256i *)(right + pos));
+      const uint32_t eq =
+         _mm256_movemask_epi8(_mm256_cmpeq_epi8(left1, right1));
+      if (eq != UINT32_MAX)
+         return pos + __builtin_ctz(~eq);
+   }
+
+   return pos;
+}
+#endif
+
 static bool ieee_unsigned_cmp(jit_func_t *func, jit_anchor_t *anchor,
                               jit_scalar_t *args, tlab_t *tlab,
                               uint8_t *lbyte, uint8_t *rbyte, const char *op)
@@ -881,6 +1109,10 @@ static bool ieee_unsigned_cmp(jit_func_t *func, jit_anchor_t *anchor,
    right = __resize_unsigned(tlab, right, rsize, size);
 
    int pos = 0;
+#ifdef HAVE_AVX2
+   if (size > 32 && (cpu_features & CPU_AVX2))
+      pos = __first_difference_avx2(left, right, size - 1);
+#endif
    for (; pos < size - 1 && left[pos] == right[pos]; pos++);
 
    *lbyte = left[pos];
@@ -930,6 +1162,46 @@ static void ieee_leq_unsigned(jit_func_t *func, jit_anchor_t *anchor,
    args[0].integer = left <= right;
 }
 
+#ifdef HAVE_AVX2
+__attribute__((target("avx2")))
+static void ieee_and_vector_avx2(jit_func_t *func, jit_anchor_t *anchor,
+                                  jit_scalar_t *args, tlab_t *tlab)
+{
+   const int lsize = ffi_array_length(args[3].integer);
+   const int rsize = ffi_array_length(args[6].integer);
+   uint8_t *left = args[1].pointer;
+   uint8_t *right = args[4].pointer;
+
+   if (unlikely(lsize != rsize))
+      __ieee_failure(func, anchor, "STD_LOGIC_1164.\"and\": arguments of "
+                     "overloaded 'and' operator are not of the same length");
+   else {
+      uint8_t *result = __tlab_alloc(tlab, ALIGN_UP(lsize, 32), 16);
+
+      __m256i left_tbl  = _mm256_broadcastsi128_si256(
+         _mm_load_si128((const __m128i *)compress_left));
+      __m256i right_tbl = _mm256_broadcastsi128_si256(
+         _mm_load_si128((const __m128i *)compress_right));
+      __m256i and_tbl  = _mm256_broadcastsi128_si256(
+         _mm_load_si128((const __m128i *)small_and_table));
+
+      for (int pos = 0; pos < lsize; pos += 32) {
+         __m256i left1  = _mm256_loadu_si256((const __m256i *)(left + pos));
+         __m256i right1 = _mm256_loadu_si256((const __m256i *)(right + pos));
+         __m256i left2  = _mm256_shuffle_epi8(left_tbl, left1);
+         __m256i right2 = _mm256_shuffle_epi8(right_tbl, right1);
+         __m256i comb   = _mm256_or_si256(left2, right2);
+         __m256i and   = _mm256_shuffle_epi8(and_tbl, comb);
+         _mm256_storeu_si256((__m256i *)(result + pos), and);
+      }
+
+      args[0].pointer = result;
+      args[1].integer = 1;
+      args[2].integer = lsize;
+   }
+}
+#endif
+
 #ifdef HAVE_SSE41
 __attribute__((target("sse4.1")))
 static void ieee_and_vector_sse41(jit_func_t *func, jit_anchor_t *anchor,
@@ -1026,6 +1298,46 @@ static void ieee_and_vector(jit_func_t *func, jit_anchor_t *anchor,
    }
 }
 
+#ifdef HAVE_AVX2
+__attribute__((target("avx2")))
+static void ieee_or_vector_avx2(jit_func_t *func, jit_anchor_t *anchor,
+                                  jit_scalar_t *args, tlab_t *tlab)
+{
+   const int lsize = ffi_array_length(args[3].integer);
+   const int rsize = ffi_array_length(args[6].integer);
+   uint8_t *left = args[1].pointer;
+   uint8_t *right = args[4].pointer;
+
+   if (unlikely(lsize != rsize))
+      __ieee_failure(func, anchor, "STD_LOGIC_1164.\"or\": arguments of "
+                     "overloaded 'or' operator are not of the same length");
+   else {
+      uint8_t *result = __tlab_alloc(tlab, ALIGN_UP(lsize, 32), 16);
+
+      __m256i left_tbl  = _mm256_broadcastsi128_si256(
+         _mm_load_si128((const __m128i *)compress_left));
+      __m256i right_tbl = _mm256_broadcastsi128_si256(
+         _mm_load_si128((const __m128i *)compress_right));
+      __m256i or_tbl   = _mm256_broadcastsi128_si256(
+         _mm_load_si128((const __m128i *)small_or_table));
+
+      for (int pos = 0; pos < lsize; pos += 32) {
+         __m256i left1  = _mm256_loadu_si256((const __m256i *)(left + pos));
+         __m256i right1 = _mm256_loadu_si256((const __m256i *)(right + pos));
+         __m256i left2  = _mm256_shuffle_epi8(left_tbl, left1);
+         __m256i right2 = _mm256_shuffle_epi8(right_tbl, right1);
+         __m256i comb   = _mm256_or_si256(left2, right2);
+         __m256i orr   = _mm256_shuffle_epi8(or_tbl, comb);
+         _mm256_storeu_si256((__m256i *)(result + pos), orr);
+      }
+
+      args[0].pointer = result;
+      args[1].integer = 1;
+      args[2].integer = lsize;
+   }
+}
+#endif
+
 #ifdef HAVE_SSE41
 __attribute__((target("sse4.1")))
 static void ieee_or_vector_sse41(jit_func_t *func, jit_anchor_t *anchor,
@@ -1122,6 +1434,46 @@ static void ieee_or_vector(jit_func_t *func, jit_anchor_t *anchor,
    }
 }
 
+#ifdef HAVE_AVX2
+__attribute__((target("avx2")))
+static void ieee_xor_vector_avx2(jit_func_t *func, jit_anchor_t *anchor,
+                                  jit_scalar_t *args, tlab_t *tlab)
+{
+   const int lsize = ffi_array_length(args[3].integer);
+   const int rsize = ffi_array_length(args[6].integer);
+   uint8_t *left = args[1].pointer;
+   uint8_t *right = args[4].pointer;
+
+   if (unlikely(lsize != rsize))
+      __ieee_failure(func, anchor, "STD_LOGIC_1164.\"xor\": arguments of "
+                     "overloaded 'xor' operator are not of the same length");
+   else {
+      uint8_t *result = __tlab_alloc(tlab, ALIGN_UP(lsize, 32), 16);
+
+      __m256i left_tbl  = _mm256_broadcastsi128_si256(
+         _mm_load_si128((const __m128i *)compress_left));
+      __m256i right_tbl = _mm256_broadcastsi128_si256(
+         _mm_load_si128((const __m128i *)compress_right));
+      __m256i xor_tbl  = _mm256_broadcastsi128_si256(
+         _mm_load_si128((const __m128i *)small_xor_table));
+
+      for (int pos = 0; pos < lsize; pos += 32) {
+         __m256i left1  = _mm256_loadu_si256((const __m256i *)(left + pos));
+         __m256i right1 = _mm256_loadu_si256((const __m256i *)(right + pos));
+         __m256i left2  = _mm256_shuffle_epi8(left_tbl, left1);
+         __m256i right2 = _mm256_shuffle_epi8(right_tbl, right1);
+         __m256i comb   = _mm256_or_si256(left2, right2);
+         __m256i xor   = _mm256_shuffle_epi8(xor_tbl, comb);
+         _mm256_storeu_si256((__m256i *)(result + pos), xor);
+      }
+
+      args[0].pointer = result;
+      args[1].integer = 1;
+      args[2].integer = lsize;
+   }
+}
+#endif
+
 #ifdef HAVE_SSE41
 __attribute__((target("sse4.1")))
 static void ieee_xor_vector_sse41(jit_func_t *func, jit_anchor_t *anchor,
@@ -1484,22 +1836,10 @@ static void synopsys_mul_unsigned(jit_func_t *func, jit_anchor_t *anchor,
       memset(pa, _X, length);
    else {
       const uint32_t mark = __tlab_mark(tlab);
-      uint8_t *ba = __tlab_alloc(tlab, length, 8);
-
-      memset(pa, _0, length);
-      memset(ba, _0, length - rsize);
-      memcpy(ba + length - rsize, right, rsize);
 
-      for (int i = lsize - 1, shift = 0; i >= 0; i--, shift++) {
-         if (left[i] == _1) {
-            // Delay left-shift until value needed
-            memmove(ba, ba + shift, length - shift);
-            memset(ba + length - shift, _0, shift);
-            shift = 0;
-
-            __ieee_packed_add(pa, ba, length, 0, pa);
-         }
-      }
+      const uint8_t *aa = __resize_unsigned(tlab, left, lsize, length);
+      const uint8_t *ba = __resize_unsigned(tlab, right, rsize, length);
+      __ieee_packed_mul(tlab, aa, ba, length, pa);
 
       __tlab_restore(tlab, mark);
    }
@@ -1530,25 +1870,10 @@ static void synopsys_mul_signed(jit_func_t *func, jit_anchor_t *anchor,
       memset(pa, _X, length);
    else {
       const uint32_t mark = __tlab_mark(tlab);
-      uint8_t *ba = __tlab_alloc(tlab, length, 8);
-
-      memset(pa, _0, length);
-      memset(ba, right[0], length - rsize);
-      memcpy(ba + length - rsize, right, rsize);
-
-      for (int i = lsize - 1, shift = 0; i >= 0; i--, shift++) {
-         if (left[i] == _1) {
-            // Delay left-shift until value needed
-            memmove(ba, ba + shift, length - shift);
-            memset(ba + length - shift, _0, shift);
-            shift = 0;
 
-            if (i == 0)
-               __invert_bits(ba, length, ba);
-
-            __ieee_packed_add(pa, ba, length, i == 0, pa);
-         }
-      }
+      const uint8_t *aa = __resize_signed(tlab, left, lsize, length);
+      const uint8_t *ba = __resize_signed(tlab, right, rsize, length);
+      __ieee_packed_mul(tlab, aa, ba, length, pa);
 
       __tlab_restore(tlab, mark);
    }
@@ -1604,6 +1929,44 @@ static void synopsys_eql_signed(jit_func_t *func, jit_anchor_t *anchor,
    __tlab_restore(tlab, mark);
 }
 
+#ifdef HAVE_AVX2
+__attribute__((target("avx2")))
+static void byte_vector_equal_avx2(jit_func_t *func, jit_anchor_t *anchor,
+                                   jit_scalar_t *args, tlab_t *tlab)
+{
+   const int lsize = ffi_array_length(args[3].integer);
+   const int rsize = ffi_array_length(args[6].integer);
+   uint8_t *left = args[1].pointer;
+   uint8_t *right = args[4].pointer;
+
+   args[0].integer = 0;
+
+   if (lsize != rsize)
+      return;
+
+   int pos = 0;
+   for (; pos + 31 < lsize; pos += 32) {
+      __m256i left1  = _mm256_loadu_si256((const __m256i *)(left + pos));
+      __m256i right1 = _mm256_loadu_si256((const __m256i *)(right + pos));
+      __m256i xor    = _mm256_xor_si256(left1, right1);
+      if (!_mm256_testz_si256(xor, xor))
+         return;
+   }
+
+   if (pos < lsize) {
+      __m256i iota   = _mm256_load_si256((const __m256i *)lane_iota32);
+      __m256i mask   = _mm256_cmpgt_epi8(_mm256_set1_epi8(lsize - pos), iota);
+      __m256i left1  = _mm256_loadu_si256((const __m256i *)(left + pos));
+      __m256i right1 = _mm256_loadu_si256((const __m256i *)(right + pos));
+      __m256i xor    = _mm256_xor_si256(left1, right1);
+      if (!_mm256_testz_si256(xor, mask))
+         return;
+   }
+
+   args[0].integer = 1;
+}
+#endif
+
 #ifdef HAVE_SSE41
 __attribute__((target("sse4.1")))
 static void byte_vector_equal_sse41(jit_func_t *func, jit_anchor_t *anchor,
@@ -1793,6 +2156,475 @@ static void std_textio_shrink(jit_func_t *func, jit_anchor_t *anchor,
    args[0].pointer = NULL;
 }
 
+// The ieee.fixed_pkg and ieee.float_pkg intrinsics only handle the
+// common case of well-formed "downto" operands containing '0' and '1'
+// and defer to the VHDL body for anything else, including any call
+// which would report a warning or error
+
+typedef enum {
+   FIXED_SATURATE, FIXED_WRAP
+} fixed_overflow_t;
+
+typedef enum {
+   FIXED_ROUND, FIXED_TRUNCATE
+} fixed_round_t;
+
+#define FIXED_MAX_INDEX 0x1000000
+
+__attribute__((always_inline))
+static inline bool __fixed_bounds(int64_t left, int64_t dim, int *high,
+                                  int *low)
+{
+   const int64_t length = ffi_array_length(dim);
+   if (!ffi_array_dir(dim) || length == 0)
+      return false;   // Null or ascending range reports an error
+   else if (left >= FIXED_MAX_INDEX || left - length < -FIXED_MAX_INDEX)
+      return false;   // Possibly an unbounded literal
+
+   *high = left;
+   *low = left - length + 1;
+   return true;
+}
+
+__attribute__((always_inline))
+static inline bool __fixed_index_ok(int64_t left, int64_t right)
+{
+   return left >= right && left < FIXED_MAX_INDEX && right > -FIXED_MAX_INDEX;
+}
+
+static void __fixed_saturate(uint8_t *result, int size, bool is_signed,
+                             bool negative)
+{
+   assert(size > 0);
+
+   memset(result, negative ? _0 : _1, size);
+   if (is_signed)
+      result[0] = negative ? _1 : _0;
+}
+
+static bool __fixed_round_up(uint8_t *result, int size, bool is_signed)
+{
+   // Returns true if adding one to the LSB overflows
+   const uint8_t sign = result[0];
+
+   int pos = size - 1;
+   for (; pos >= 0 && result[pos] == _1; pos--)
+      result[pos] = _0;
+
+   if (pos >= 0)
+      result[pos] = _1;
+
+   if (is_signed)
+      return sign == _0 && result[0] == _1;
+   else
+      return pos < 0;
+}
+
+static void __fixed_round(uint8_t *result, int size, const uint8_t *rem,
+                          int remsize, fixed_overflow_t overflow,
+                          bool is_signed)
+{
+   // Round to nearest with ties to even as in ROUND_FIXED
+   bool rounds = false;
+   if (rem[0] == _1) {
+      rounds = result[size - 1] == _1;
+      for (int i = 1; i < remsize && !rounds; i++)
+         rounds = rem[i] == _1;
+   }
+
+   if (rounds) {
+      const bool negative = is_signed && result[0] == _1;
+      if (__fixed_round_up(result, size, is_signed)
+          && overflow == FIXED_SATURATE)
+         __fixed_saturate(result, size, is_signed, negative);
+   }
+}
+
+static uint8_t *__fixed_resize(tlab_t *tlab, const uint8_t *input, int high,
+                               int low, int left, int right,
+                               fixed_overflow_t overflow, fixed_round_t round,
+                               bool is_signed)
+{
+   // Port of RESIZE for an input (high downto low) containing only '0'
+   // and '1' where element zero holds bit HIGH
+   const int size = left - right + 1;
+   const uint8_t sign = is_signed ? input[0] : _0;
+   uint8_t *result = __tlab_alloc(tlab, size, 8);
+   bool needs_rounding = false;
+
+   if (right > high) {
+      memset(result, sign, size);
+      needs_rounding = round == FIXED_ROUND && right == high + 1;
+   }
+   else if (left < low) {
+      memset(result, _0, size);
+      if (overflow == FIXED_SATURATE && memchr(input, _1, high - low + 1))
+         __fixed_saturate(result, size, is_signed, sign == _1);
+   }
+   else if (high > left) {
+      // Bits above LEFT must all match the sign to avoid overflow
+      bool saturate = false;
+      for (int i = is_signed; i < high - left + is_signed; i++)
+         saturate |= input[i] != sign;
+
+      if (overflow == FIXED_SATURATE && saturate)
+         __fixed_saturate(result, size, is_signed, sign == _1);
+      else if (low >= right) {
+         memcpy(result, input + high - left, left - low + 1);
+         memset(result + left - low + 1, _0, low - right);
+      }
+      else {
+         memcpy(result, input + high - left, size);
+         needs_rounding = round == FIXED_ROUND;
+      }
+   }
+   else {
+      memset(result, sign, left - high);
+      if (low >= right) {
+         memcpy(result + left - high, input, high - low + 1);
+         memset(result + left - low + 1, _0, low - right);
+      }
+      else {
+         memcpy(result + left - high, input, high - right + 1);
+         needs_rounding = round == FIXED_ROUND;
+      }
+   }
+
+   if (needs_rounding)
+      __fixed_round(result, size, input + high - right + 1, right - low,
+                    overflow, is_signed);
+
+   return result;
+}
+
+static const uint8_t *__fixed_extend(tlab_t *tlab, const uint8_t *input,
+                                     int high, int low, int newhigh,
+                                     int newlow, bool is_signed)
+{
+   // Widen the input to (newhigh downto newlow) which must contain the
+   // original range
+   if (high == newhigh && low == newlow)
+      return input;
+
+   const int size = high - low + 1, top = newhigh - high;
+   uint8_t *result = __tlab_alloc(tlab, newhigh - newlow + 1, 8);
+   memset(result, is_signed ? input[0] : _0, top);
+   memcpy(result + top, input, size);
+   memset(result + top + size, _0, low - newlow);
+
+   return result;
+}
+
+static void ieee_fixed_add(jit_func_t *func, jit_anchor_t *anchor,
+                           jit_scalar_t *args, tlab_t *tlab,
+                           jit_entry_fn_t op, bool is_signed)
+{
+   int lhigh, llow, rhigh, rlow;
+   if (!__fixed_bounds(args[2].integer, args[3].integer, &lhigh, &llow)
+       || !__fixed_bounds(args[5].integer, args[6].integer, &rhigh, &rlow))
+      return jit_interp_body(func, anchor, args, tlab);
+
+   const int high = MAX(lhigh, rhigh) + 1, low = MIN(llow, rlow);
+   const int size = high - low + 1;
+
+   // The numeric_std operators handle metavalues in the same way
+   args[1].pointer = (void *)__fixed_extend(tlab, args[1].pointer, lhigh,
+                                            llow, high, low, is_signed);
+   args[3].integer = ~size;
+   args[4].pointer = (void *)__fixed_extend(tlab, args[4].pointer, rhigh,
+                                            rlow, high, low, is_signed);
+   args[6].integer = ~size;
+
+   (*op)(func, anchor, args, tlab);
+
+   args[1].integer = high;
+   args[2].integer = ~size;
+}
+
+static void ieee_fixed_plus_unsigned(jit_func_t *func, jit_anchor_t *anchor,
+                                     jit_scalar_t *args, tlab_t *tlab)
+{
+   ieee_fixed_add(func, anchor, args, tlab, ieee_plus_unsigned, false);
+}
+
+static void ieee_fixed_plus_signed(jit_func_t *func, jit_anchor_t *anchor,
+                                   jit_scalar_t *args, tlab_t *tlab)
+{
+   ieee_fixed_add(func, anchor, args, tlab, ieee_plus_signed, true);
+}
+
+static void ieee_fixed_minus_unsigned(jit_func_t *func, jit_anchor_t *anchor,
+                                      jit_scalar_t *args, tlab_t *tlab)
+{
+   ieee_fixed_add(func, anchor, args, tlab, ieee_minus_unsigned, false);
+}
+
+static void ieee_fixed_minus_signed(jit_func_t *func, jit_anchor_t *anchor,
+                                    jit_scalar_t *args, tlab_t *tlab)
+{
+   ieee_fixed_add(func, anchor, args, tlab, ieee_minus_signed, true);
+}
+
+static void ieee_fixed_mul(jit_func_t *func, jit_anchor_t *anchor,
+                           jit_scalar_t *args, tlab_t *tlab,
+                           jit_entry_fn_t op)
+{
+   int lhigh, llow, rhigh, rlow;
+   if (!__fixed_bounds(args[2].integer, args[3].integer, &lhigh, &llow)
+       || !__fixed_bounds(args[5].integer, args[6].integer, &rhigh, &rlow))
+      return jit_interp_body(func, anchor, args, tlab);
+
+   (*op)(func, anchor, args, tlab);
+
+   args[1].integer = lhigh + rhigh + 1;
+}
+
+static void ieee_fixed_mul_unsigned(jit_func_t *func, jit_anchor_t *anchor,
+                                    jit_scalar_t *args, tlab_t *tlab)
+{
+   ieee_fixed_mul(func, anchor, args, tlab, ieee_mul_unsigned);
+}
+
+static void ieee_fixed_mul_signed(jit_func_t *func, jit_anchor_t *anchor,
+                                  jit_scalar_t *args, tlab_t *tlab)
+{
+   ieee_fixed_mul(func, anchor, args, tlab, ieee_mul_signed);
+}
+
+static void ieee_fixed_resize(jit_func_t *func, jit_anchor_t *anchor,
+                              jit_scalar_t *args, tlab_t *tlab,
+                              bool is_signed)
+{
+   const int64_t left = args[4].integer, right = args[5].integer;
+
+   int high, low;
+   if (!__fixed_bounds(args[2].integer, args[3].integer, &high, &low)
+       || !__fixed_index_ok(left, right)
+       || !__all_01(args[1].pointer, high - low + 1))
+      return jit_interp_body(func, anchor, args, tlab);
+
+   args[0].pointer = __fixed_resize(tlab, args[1].pointer, high, low, left,
+                                    right, args[6].integer, args[7].integer,
+                                    is_signed);
+   args[1].integer = left;
+   args[2].integer = ~(left - right + 1);
+}
+
+static void ieee_fixed_resize_unsigned(jit_func_t *func, jit_anchor_t *anchor,
+                                       jit_scalar_t *args, tlab_t *tlab)
+{
+   ieee_fixed_resize(func, anchor, args, tlab, false);
+}
+
+static void ieee_fixed_resize_signed(jit_func_t *func, jit_anchor_t *anchor,
+                                     jit_scalar_t *args, tlab_t *tlab)
+{
+   ieee_fixed_resize(func, anchor, args, tlab, true);
+}
+
+static void ieee_fixed_from_integer(jit_func_t *func, jit_anchor_t *anchor,
+                                    jit_scalar_t *args, tlab_t *tlab,
+                                    bool is_signed)
+{
+   const int64_t arg = args[1].integer;
+   const int64_t left = args[2].integer, right = args[3].integer;
+
+   // Fall back for null ranges or if the integer part does not fit as
+   // that reports a warning
+   bool fits;
+   if (left < 0 || !__fixed_index_ok(left, right))
+      fits = false;
+   else if (left >= 63)
+      fits = true;
+   else if (is_signed)
+      fits = (arg >> left) == 0 || (arg >> left) == -1;
+   else
+      fits = (arg >> (left + 1)) == 0;
+
+   if (!fits)
+      return jit_interp_body(func, anchor, args, tlab);
+
+   uint8_t *sresult = __tlab_alloc(tlab, left + 1, 8);
+   for (int i = 0; i <= left; i++)
+      sresult[left - i] = _0 | ((arg >> MIN(i, 63)) & 1);
+
+   args[0].pointer = __fixed_resize(tlab, sresult, left, 0, left, right,
+                                    args[4].integer, args[5].integer,
+                                    is_signed);
+   args[1].integer = left;
+   args[2].integer = ~(left - right + 1);
+}
+
+static void ieee_fixed_to_ufixed_natural(jit_func_t *func,
+                                         jit_anchor_t *anchor,
+                                         jit_scalar_t *args, tlab_t *tlab)
+{
+   ieee_fixed_from_integer(func, anchor, args, tlab, false);
+}
+
+static void ieee_fixed_to_sfixed_integer(jit_func_t *func,
+                                         jit_anchor_t *anchor,
+                                         jit_scalar_t *args, tlab_t *tlab)
+{
+   ieee_fixed_from_integer(func, anchor, args, tlab, true);
+}
+
+static void ieee_fixed_from_real(jit_func_t *func, jit_anchor_t *anchor,
+                                 jit_scalar_t *args, tlab_t *tlab,
+                                 bool is_signed)
+{
+   const double arg = args[1].real;
+   const int64_t left = args[2].integer, right = args[3].integer;
+   const int64_t guard = args[6].integer;
+
+   // The reference implementation subtracts powers of two from the
+   // argument which is exact and so equivalent to scaling and
+   // truncating if the result fits in a machine word
+   const int64_t high = left + is_signed, low = right - guard;
+   const double limit = ldexp(1.0, left + !is_signed);
+
+   if (!__fixed_index_ok(left, right) || high - low >= 63
+       || left > 1000 || low < -1000 || !isfinite(arg))
+      return jit_interp_body(func, anchor, args, tlab);
+   else if (arg >= limit || arg < (is_signed ? -limit : 0.0))
+      return jit_interp_body(func, anchor, args, tlab);   // Reports error
+
+   const int width = high - low + 1;
+
+   uint64_t bits = ldexp(fabs(arg), -low);
+   if (arg < 0.0)
+      bits = -bits;
+
+   uint8_t *xresult = __tlab_alloc(tlab, width, 8);
+   for (int i = 0; i < width; i++)
+      xresult[width - 1 - i] = _0 | ((bits >> i) & 1);
+
+   uint8_t *result = xresult + high - left;
+   const int size = left - right + 1;
+
+   if (guard > 0 && args[5].integer == FIXED_ROUND)
+      __fixed_round(result, size, result + size, guard, args[4].integer,
+                    is_signed);
+
+   args[0].pointer = result;
+   args[1].integer = left;
+   args[2].integer = ~size;
+}
+
+static void ieee_fixed_to_ufixed_real(jit_func_t *func, jit_anchor_t *anchor,
+                                      jit_scalar_t *args, tlab_t *tlab)
+{
+   ieee_fixed_from_real(func, anchor, args, tlab, false);
+}
+
+static void ieee_fixed_to_sfixed_real(jit_func_t *func, jit_anchor_t *anchor,
+                                      jit_scalar_t *args, tlab_t *tlab)
+{
+   ieee_fixed_from_real(func, anchor, args, tlab, true);
+}
+
+static bool __float_unpack(const uint8_t *input, int size, uint64_t *bits)
+{
+   if (!__all_01(input, size))
+      return false;
+
+   uint64_t value = 0;
+   for (int i = 0; i < size; i++)
+      value = (value << 1) | (input[i] & 1);
+
+   // Denormals, infinities, and NaN take the slow path
+   const int fw = size == 32 ? 23 : 52;
+   const uint64_t emask = size == 32 ? 0xff : 0x7ff;
+   const uint64_t exp = (value >> fw) & emask;
+   if (exp == emask || (exp == 0 && (value << (64 - fw)) != 0))
+      return false;
+
+   *bits = value;
+   return true;
+}
+
+static void ieee_float_op(jit_func_t *func, jit_anchor_t *anchor,
+                          jit_scalar_t *args, tlab_t *tlab, char op)
+{
+   // The reference ADD and MULTIPLY with three guard bits and a sticky
+   // bit are correctly rounded so agree with the host for normal
+   // single and double precision results
+   const int64_t ldim = args[3].integer, left = args[2].integer;
+   const int size = ffi_array_length(ldim);
+
+   uint64_t lbits, rbits;
+   if (left != args[5].integer || ldim != args[6].integer
+       || !ffi_array_dir(ldim)
+       || !((left == 8 && size == 32) || (left == 11 && size == 64))
+       || !__float_unpack(args[1].pointer, size, &lbits)
+       || !__float_unpack(args[4].pointer, size, &rbits))
+      return jit_interp_body(func, anchor, args, tlab);
+
+   uint64_t bits;
+   bool zero_ok = op != '*';
+   if (size == 32) {
+      const uint32_t l32 = lbits, r32 = rbits;
+      float l, r, f;
+      memcpy(&l, &l32, sizeof(float));
+      memcpy(&r, &r32, sizeof(float));
+
+      switch (op) {
+      case '+': f = l + r; break;
+      case '-': f = l - r; break;
+      default: f = l * r; zero_ok = l == 0.0f || r == 0.0f; break;
+      }
+
+      if (!isnormal(f) && !(f == 0.0f && zero_ok))
+         return jit_interp_body(func, anchor, args, tlab);
+
+      uint32_t f32;
+      memcpy(&f32, &f, sizeof(float));
+      bits = f32;
+   }
+   else {
+      double l, r, f;
+      memcpy(&l, &lbits, sizeof(double));
+      memcpy(&r, &rbits, sizeof(double));
+
+      switch (op) {
+      case '+': f = l + r; break;
+      case '-': f = l - r; break;
+      default: f = l * r; zero_ok = l == 0.0 || r == 0.0; break;
+      }
+
+      if (!isnormal(f) && !(f == 0.0 && zero_ok))
+         return jit_interp_body(func, anchor, args, tlab);
+
+      memcpy(&bits, &f, sizeof(double));
+   }
+
+   uint8_t *result = __tlab_alloc(tlab, size, 8);
+   for (int i = 0; i < size; i++)
+      result[size - 1 - i] = _0 | ((bits >> i) & 1);
+
+   args[0].pointer = result;
+   args[1].integer = left;
+   args[2].integer = ldim;
+}
+
+static void ieee_float_plus(jit_func_t *func, jit_anchor_t *anchor,
+                            jit_scalar_t *args, tlab_t *tlab)
+{
+   ieee_float_op(func, anchor, args, tlab, '+');
+}
+
+static void ieee_float_minus(jit_func_t *func, jit_anchor_t *anchor,
+                             jit_scalar_t *args, tlab_t *tlab)
+{
+   ieee_float_op(func, anchor, args, tlab, '-');
+}
+
+static void ieee_float_mul(jit_func_t *func, jit_anchor_t *anchor,
+                           jit_scalar_t *args, tlab_t *tlab)
+{
+   ieee_float_op(func, anchor, args, tlab, '*');
+}
+
 #define UU "36IEEE.NUMERIC_STD.UNRESOLVED_UNSIGNED"
 #define U "25IEEE.NUMERIC_STD.UNSIGNED"
 #define US "34IEEE.NUMERIC_STD.UNRESOLVED_SIGNED"
@@ -1808,6 +2640,13 @@ static void std_textio_shrink(jit_func_t *func, jit_anchor_t *anchor,
 #define SS "IEEE.STD_LOGIC_SIGNED."
 #define AU "29IEEE.STD_LOGIC_ARITH.UNSIGNED"
 #define AS "27IEEE.STD_LOGIC_ARITH.SIGNED"
+#define FX "IEEE.FIXED_PKG."
+#define UF "32IEEE.FIXED_PKG.UNRESOLVED_UFIXED"
+#define SF "32IEEE.FIXED_PKG.UNRESOLVED_SFIXED"
+#define OS "48IEEE.FIXED_FLOAT_TYPES.FIXED_OVERFLOW_STYLE_TYPE"
+#define RS "45IEEE.FIXED_FLOAT_TYPES.FIXED_ROUND_STYLE_TYPE"
+#define FP "IEEE.FLOAT_PKG."
+#define FL "31IEEE.FLOAT_PKG.UNRESOLVED_FLOAT"
 
 static jit_intrinsic_t intrinsic_list[] = {
    { NS "\"+\"(" U U ")" U, ieee_plus_unsigned },
@@ -1834,6 +2673,10 @@ static jit_intrinsic_t intrinsic_list[] = {
    { NS "\">=\"(" UU UU ")B" , ieee_geq_unsigned },
    { NS "\"<=\"(" U U ")B", ieee_leq_unsigned },
    { NS "\"<=\"(" UU UU ")B" , ieee_leq_unsigned },
+#ifdef HAVE_AVX2
+   { SL "TO_X01(V)V", std_to_x01_avx2, CPU_AVX2 },
+   { SL "TO_X01(Y)Y", std_to_x01_avx2, CPU_AVX2 },
+#endif
 #ifdef HAVE_SSE41
    { SL "TO_X01(V)V", std_to_x01_sse41, CPU_SSE41 },
    { SL "TO_X01(Y)Y", std_to_x01_sse41, CPU_SSE41 },
@@ -1848,6 +2691,10 @@ static jit_intrinsic_t intrinsic_list[] = {
    { NS "RESIZE(" UU "N)" UU, ieee_resize_unsigned },
    { NS "RESIZE(" S "N)" S, ieee_resize_signed },
    { NS "RESIZE(" US "N)" US, ieee_resize_signed },
+#ifdef HAVE_AVX2
+   { SL "\"and\"(VV)V", ieee_and_vector_avx2, CPU_AVX2 },
+   { SL "\"and\"(YY)Y", ieee_and_vector_avx2, CPU_AVX2 },
+#endif
 #ifdef HAVE_SSE41
    { SL "\"and\"(VV)V", ieee_and_vector_sse41, CPU_SSE41 },
    { SL "\"and\"(YY)Y", ieee_and_vector_sse41, CPU_SSE41 },
@@ -1858,6 +2705,10 @@ static jit_intrinsic_t intrinsic_list[] = {
 #endif
    { SL "\"and\"(VV)V", ieee_and_vector },
    { SL "\"and\"(YY)Y", ieee_and_vector },
+#ifdef HAVE_AVX2
+   { SL "\"or\"(VV)V", ieee_or_vector_avx2, CPU_AVX2 },
+   { SL "\"or\"(YY)Y", ieee_or_vector_avx2, CPU_AVX2 },
+#endif
 #ifdef HAVE_SSE41
    { SL "\"or\"(VV)V", ieee_or_vector_sse41, CPU_SSE41 },
    { SL "\"or\"(YY)Y", ieee_or_vector_sse41, CPU_SSE41 },
@@ -1868,6 +2719,10 @@ static jit_intrinsic_t intrinsic_list[] = {
 #endif
    { SL "\"or\"(VV)V", ieee_or_vector },
    { SL "\"or\"(YY)Y", ieee_or_vector },
+#ifdef HAVE_AVX2
+   { SL "\"xor\"(VV)V", ieee_xor_vector_avx2, CPU_AVX2 },
+   { SL "\"xor\"(YY)Y", ieee_xor_vector_avx2, CPU_AVX2 },
+#endif
 #ifdef HAVE_SSE41
    { SL "\"xor\"(VV)V", ieee_xor_vector_sse41, CPU_SSE41 },
    { SL "\"xor\"(YY)Y", ieee_xor_vector_sse41, CPU_SSE41 },
@@ -1882,6 +2737,12 @@ static jit_intrinsic_t intrinsic_list[] = {
    { NS "TO_UNSIGNED(NN)" UU, ieee_to_unsigned },
    { NS "TO_SIGNED(IN)" S, ieee_to_signed },
    { NS "TO_SIGNED(IN)" US, ieee_to_signed },
+#ifdef HAVE_AVX2
+   { SL "\"=\"(VV)B$predef", byte_vector_equal_avx2, CPU_AVX2 },
+   { SL "\"=\"(YY)B$predef", byte_vector_equal_avx2, CPU_AVX2 },
+   { ST "\"=\"(QQ)B$predef", byte_vector_equal_avx2, CPU_AVX2 },
+   { ST "\"=\"(SS)B$predef", byte_vector_equal_avx2, CPU_AVX2 },
+#endif
 #ifdef HAVE_SSE41
    { SL "\"=\"(VV)B$predef", byte_vector_equal_sse41, CPU_SSE41 },
    { SL "\"=\"(YY)B$predef", byte_vector_equal_sse41, CPU_SSE41 },
@@ -1947,6 +2808,21 @@ static jit_intrinsic_t intrinsic_list[] = {
    { SA "\"=\"(" AS AS ")B", synopsys_eql_signed },
    { SS "\"=\"(VV)B", synopsys_eql_signed },
    { SS "\"=\"(YY)B", synopsys_eql_signed },
+   { FX "\"+\"(" UF UF ")" UF, ieee_fixed_plus_unsigned },
+   { FX "\"+\"(" SF SF ")" SF, ieee_fixed_plus_signed },
+   { FX "\"-\"(" UF UF ")" UF, ieee_fixed_minus_unsigned },
+   { FX "\"-\"(" SF SF ")" SF, ieee_fixed_minus_signed },
+   { FX "\"*\"(" UF UF ")" UF, ieee_fixed_mul_unsigned },
+   { FX "\"*\"(" SF SF ")" SF, ieee_fixed_mul_signed },
+   { FX "RESIZE(" UF "II" OS RS ")" UF, ieee_fixed_resize_unsigned },
+   { FX "RESIZE(" SF "II" OS RS ")" SF, ieee_fixed_resize_signed },
+   { FX "TO_UFIXED(NII" OS RS ")" UF, ieee_fixed_to_ufixed_natural },
+   { FX "TO_SFIXED(III" OS RS ")" SF, ieee_fixed_to_sfixed_integer },
+   { FX "TO_UFIXED(RII" OS RS "N)" UF, ieee_fixed_to_ufixed_real },
+   { FX "TO_SFIXED(RII" OS RS "N)" SF, ieee_fixed_to_sfixed_real },
+   { FP "\"+\"(" FL FL ")" FL, ieee_float_plus },
+   { FP "\"-\"(" FL FL ")" FL, ieee_float_minus },
+   { FP "\"*\"(" FL FL ")" FL, ieee_float_mul },
    { NULL, NULL }
 };
 
@@ -1975,6 +2851,9 @@ jit_entry_fn_t jit_bind_intrinsic(ident_t name)
             mask |= CPU_NEON;
 #endif
 
+         // Also selects the kernels used by the arithmetic intrinsics
+         cpu_features = mask;
+
          for (jit_intrinsic_t *it = intrinsic_list; it->name; it++) {
             if (it->feature && !(it->feature & mask))
                continue;
@@ -16,6 +16,7 @@
 //
 
 #include "util.h"
+#include "array.h"
 #include "cov/cov-api.h"
 #include "diag.h"
 #include "jit/jit-ffi.h"
@@ -25,6 +26,7 @@
 #include "mir/mir-node.h"
 #include "mir/mir-unit.h"
 #include "option.h"
+#include "rt/mspace.h"
 #include "rt/rt.h"
 #include "tree.h"
 #include "vcode.h"
@@ -38,6 +40,8 @@
 typedef struct _irgen_label irgen_label_t;
 typedef struct _patch_list  patch_list_t;
 
+typedef A(ptr_slot_t) slot_list_t;
+
 #define PATCH_CHUNK_SZ  4
 #define MAX_STACK_ALLOC 65536
 #define DEDUP_PREFIX    16384
@@ -67,12 +71,14 @@ typedef struct {
    size_t          cpoolptr;
    size_t          oldptr;
    jit_value_t     statereg;
+   int             statemap;
    jit_value_t     contextarg;
    mir_value_t     flags;
    mir_block_t     curblock;
    unsigned        bufsz;
    bool            used_tlab;
    bool            stateless;
+   bool            ptrmaps;
    bool            needs_context;
 } jit_irgen_t;
 
@@ -1013,6 +1019,100 @@ static jit_value_t irgen_dedup_cpool(jit_irgen_t *g)
       return jit_value_from_cpool_addr(g->oldptr);
 }
 
+static int irgen_ptr_map(jit_irgen_t *g, mir_type_t type);
+
+static void irgen_ptr_slots(jit_irgen_t *g, mir_type_t type, int offset,
+                            slot_list_t *slots)
+{
+   // The element offset holds the absolute constant pool offset of the
+   // nested map until irgen_finish_ptr_map
+   switch (mir_get_class(g->mu, type)) {
+   case MIR_TYPE_POINTER:
+   case MIR_TYPE_FILE:
+   case MIR_TYPE_TRIGGER:
+   case MIR_TYPE_SIGNAL:
+      APUSH(*slots, ((ptr_slot_t){ offset, PTR_PLAIN, 0, 0, -1 }));
+      break;
+
+   case MIR_TYPE_ACCESS:
+   case MIR_TYPE_CONTEXT:
+      APUSH(*slots, ((ptr_slot_t){ offset, PTR_OBJECT, 0, 0, -1 }));
+      break;
+
+   case MIR_TYPE_UARRAY:
+      {
+         mir_type_t elem = mir_get_elem(g->mu, type);
+         if (mir_get_class(g->mu, elem) == MIR_TYPE_SIGNAL)
+            APUSH(*slots, ((ptr_slot_t){ offset, PTR_PLAIN, 0, 0, -1 }));
+         else {
+            const int ndims = mir_get_dims(g->mu, type);
+            const int map = irgen_ptr_map(g, elem);
+            APUSH(*slots, ((ptr_slot_t){ offset, PTR_UARRAY, ndims, 0, map }));
+         }
+      }
+      break;
+
+   case MIR_TYPE_CARRAY:
+      {
+         mir_type_t elem = mir_get_elem(g->mu, type);
+         const int map = irgen_ptr_map(g, elem);
+         if (map != -1) {
+            const int count = mir_get_size(g->mu, type);
+            APUSH(*slots, ((ptr_slot_t){ offset, PTR_ARRAY, 0, count, map }));
+         }
+      }
+      break;
+
+   case MIR_TYPE_RECORD:
+      {
+         size_t nfields;
+         const mir_type_t *fields = mir_get_fields(g->mu, type, &nfields);
+
+         for (int i = 0, off = 0; i < nfields; i++) {
+            off = ALIGN_UP(off, irgen_align_of(g, fields[i]));
+            irgen_ptr_slots(g, fields[i], offset + off, slots);
+            off += irgen_size_bytes(g, fields[i]);
+         }
+      }
+      break;
+
+   default:
+      break;
+   }
+}
+
+static int irgen_finish_ptr_map(jit_irgen_t *g, slot_list_t *slots, int size)
+{
+   if (slots->count == 0)
+      return -1;
+
+   const size_t bytes = sizeof(ptr_map_t) + slots->count * sizeof(ptr_slot_t);
+   const size_t offset = irgen_append_cpool(g, bytes, sizeof(uint32_t));
+
+   ptr_map_t *map = (ptr_map_t *)(g->func->cpool + offset);
+   map->size   = size;
+   map->nslots = slots->count;
+
+   for (int i = 0; i < slots->count; i++) {
+      map->slots[i] = slots->items[i];
+      if (map->slots[i].elem == -1)
+         map->slots[i].elem = 0;
+      else
+         map->slots[i].elem -= offset;
+   }
+
+   ACLEAR(*slots);
+   return offset;
+}
+
+static int irgen_ptr_map(jit_irgen_t *g, mir_type_t type)
+{
+   slot_list_t slots = AINIT;
+   irgen_ptr_slots(g, type, 0, &slots);
+
+   return irgen_finish_ptr_map(g, &slots, irgen_size_bytes(g, type));
+}
+
 static void irgen_emit_debuginfo(jit_irgen_t *g, mir_value_t n)
 {
    jit_value_t arg1 = jit_value_from_loc(mir_get_loc(g->mu, n));
@@ -2666,6 +2766,28 @@ static void irgen_op_new(jit_irgen_t *g, mir_value_t n)
       jit_value_t body = j_add(g, mem, jit_value_from_int64(headersz));
       j_store(g, JIT_SZ_PTR, body, ptr);
    }
+
+   // Objects containing pointers are registered with a map of the
+   // pointer slots for saving checkpoints
+   if (!g->ptrmaps)
+      return;
+
+   int map;
+   jit_value_t count = jit_value_from_int64(1);
+   if (headersz > 0)
+      map = irgen_ptr_map(g, mir_get_elem(g->mu, mir_get_type(g->mu, n)));
+   else {
+      map = irgen_ptr_map(g, elem);
+      if (mir_count_args(g->mu, n) > 0)
+         count = irgen_get_arg(g, n, 0);
+   }
+
+   if (map != -1) {
+      j_send(g, 0, mem);
+      j_send(g, 1, jit_value_from_cpool_addr(map));
+      j_send(g, 2, count);
+      macro_exit(g, JIT_EXIT_POINTER_MAP);
+   }
 }
 
 static void irgen_op_alloc(jit_irgen_t *g, mir_value_t n)
@@ -4118,6 +4240,27 @@ static void irgen_locals(jit_irgen_t *g)
       for (int i = 0; i < nvars; i++)
          g->vars[i] = jit_addr_from_value(g->statereg, linktab[i].offset);
 
+      if (kind != MIR_UNIT_FUNCTION && kind != MIR_UNIT_THUNK
+          && kind != MIR_UNIT_PLACEHOLDER && g->ptrmaps) {
+         // The state outlives this call so record where it holds
+         // pointers: the context and any suspended procedure state
+         // are themselves registered objects
+         slot_list_t slots = AINIT;
+         APUSH(slots, ((ptr_slot_t){ 0, PTR_OBJECT, 0, 0, -1 }));
+
+         if (kind == MIR_UNIT_PROCESS || kind == MIR_UNIT_PROCEDURE) {
+            const ptr_slot_t pcall = { sizeof(void *), PTR_OBJECT, 0, 0, -1 };
+            APUSH(slots, pcall);
+         }
+
+         for (int i = 0; i < nvars; i++) {
+            mir_type_t type = mir_get_var_type(g->mu, mir_get_var(g->mu, i));
+            irgen_ptr_slots(g, type, linktab[i].offset, &slots);
+         }
+
+         g->statemap = irgen_finish_ptr_map(g, &slots, sz);
+      }
+
       // Publish the variable offset table early to handle circular references
       // This may be read by another thread while in the COMPILING state
       g->func->nvars = nvars;
@@ -4437,9 +4580,11 @@ void jit_irgen(jit_func_t *f, mir_unit_t *mu)
    const int num_nodes = mir_count_nodes(mu, MIR_NULL_BLOCK);
 
    jit_irgen_t *g = xcalloc(sizeof(jit_irgen_t));
-   g->func = f;
-   g->map  = xmalloc_array(num_nodes, sizeof(jit_value_t));
-   g->mu   = mu;
+   g->func     = f;
+   g->map      = xmalloc_array(num_nodes, sizeof(jit_value_t));
+   g->mu       = mu;
+   g->statemap = -1;
+   g->ptrmaps  = opt_get_int(OPT_POINTER_MAPS);
 
    const int nblocks = mir_count_blocks(g->mu);
    g->blocks = xmalloc_array(nblocks, sizeof(irgen_label_t *));
@@ -4481,6 +4626,15 @@ void jit_irgen(jit_func_t *f, mir_unit_t *mu)
       should_not_reach_here();
    }
 
+   if (g->statemap != -1) {
+      // Register the layout of the newly allocated state so pointers
+      // in it can be found when saving a checkpoint
+      j_send(g, 0, g->statereg);
+      j_send(g, 1, jit_value_from_cpool_addr(g->statemap));
+      j_send(g, 2, jit_value_from_int64(1));
+      macro_exit(g, JIT_EXIT_POINTER_MAP);
+   }
+
    for (int i = 0; i < nblocks; i++)
       irgen_block(g, mir_get_block(mu, i));
 
@@ -4497,10 +4651,15 @@ void jit_irgen(jit_func_t *f, mir_unit_t *mu)
    }
    g->labels = NULL;
 
+   int nbce = 0;
    if (mir_get_kind(mu) != MIR_UNIT_THUNK) {
+      jit_do_inline(f);
       jit_do_mem2reg(f);
       jit_do_lvn(f);
       jit_do_cprop(f);
+      jit_do_gvn(f);
+      nbce = jit_do_bce(f);
+      jit_do_licm(f);
       jit_do_dce(f);
       jit_delete_nops(f);
       jit_free_cfg(f);
@@ -4510,6 +4669,9 @@ void jit_irgen(jit_func_t *f, mir_unit_t *mu)
    store_release(&(f->state), JIT_FUNC_READY);
 
    if (opt_get_verbose(OPT_JIT_VERBOSE, istr(f->name))) {
+      if (nbce > 0)
+         debugf("%s: removed %d redundant bounds checks", istr(f->name), nbce);
+
 #ifdef DEBUG
       jit_dump_interleaved(f, mu);
 #else
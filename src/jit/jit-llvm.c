@@ -25,6 +25,7 @@
 #include "object.h"
 #include "option.h"
 #include "rt/rt.h"
+#include "sha1.h"
 #include "thread.h"
 
 #include <assert.h>
@@ -33,6 +34,9 @@
 #include <limits.h>
 #include <string.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 #include <llvm-c/Analysis.h>
 #include <llvm-c/Core.h>
@@ -65,6 +69,7 @@ typedef enum {
 
    LLVM_ENTRY_FN,
    LLVM_ANCHOR,
+   LLVM_OSR,
    LLVM_TLAB,
    LLVM_AOT_RELOC,
    LLVM_STRTAB,
@@ -147,6 +152,8 @@ typedef struct _cgen_block cgen_block_t;
 #define DEBUG_METADATA_VERSION 3
 #define CLOSED_WORLD           1
 #define ARGCACHE_SIZE          6
+#define PROFILE_MIN_CALLS      8
+#define IMPORT_MAX_IRS         200
 #define ENABLE_DWARF           0
 
 #if defined __APPLE__ && defined ARCH_ARM64
@@ -188,7 +195,7 @@ typedef struct _cgen_block {
    cgen_func_t       *func;
 } cgen_block_t;
 
-typedef enum { CGEN_JIT, CGEN_AOT } cgen_mode_t;
+typedef enum { CGEN_JIT, CGEN_AOT, CGEN_CACHE } cgen_mode_t;
 
 typedef struct {
    reloc_kind_t kind;
@@ -218,6 +225,9 @@ typedef struct _cgen_func {
    bit_mask_t       ptr_mask;
    cgen_mode_t      mode;
    cgen_reloc_t    *relocs;
+   jit_profile_t   *profile;
+   bool             osr;
+   bool             import;
 } cgen_func_t;
 
 typedef enum {
@@ -406,6 +416,17 @@ static void llvm_register_types(llvm_obj_t *obj)
                                                         false);
    }
 
+   {
+      LLVMTypeRef fields[] = {
+         obj->types[LLVM_ANCHOR], // Anchor
+         obj->types[LLVM_PTR],    // Registers
+         obj->types[LLVM_INT32],  // Target IR position
+         obj->types[LLVM_INT32]   // Flags
+      };
+      obj->types[LLVM_OSR] = LLVMStructTypeInContext(obj->context, fields,
+                                                     ARRAY_LEN(fields), false);
+   }
+
    for (jit_size_t sz = JIT_SZ_8; sz <= JIT_SZ_64; sz++) {
       LLVMTypeRef fields[] = {
          obj->types[LLVM_INT8 + sz],
@@ -1120,7 +1141,7 @@ static LLVMValueRef cgen_rematerialise_object(llvm_obj_t *obj,
                                               cgen_func_t *func,
                                               object_t *locus)
 {
-   if (func->mode == CGEN_AOT) {
+   if (func->mode != CGEN_JIT) {
       ident_t module;
       ptrdiff_t offset;
       object_locus(locus, &module, &offset);
@@ -1173,7 +1194,7 @@ static LLVMValueRef cgen_get_value(llvm_obj_t *obj, cgen_block_t *cgb,
       return llvm_real(obj, value.dval);
    case JIT_ADDR_CPOOL:
       assert(value.int64 >= 0 && value.int64 <= cgb->func->source->cpoolsz);
-      if (cgb->func->mode == CGEN_AOT) {
+      if (cgb->func->mode != CGEN_JIT) {
          LLVMValueRef indexes[] = {
             llvm_intptr(obj, 0),
             llvm_intptr(obj, value.int64)
@@ -1205,14 +1226,14 @@ static LLVMValueRef cgen_get_value(llvm_obj_t *obj, cgen_block_t *cgb,
    case JIT_VALUE_EXIT:
       return llvm_int32(obj, value.exit);
    case JIT_VALUE_HANDLE:
-      if (cgb->func->mode == CGEN_AOT && value.handle != JIT_HANDLE_INVALID)
+      if (cgb->func->mode != CGEN_JIT && value.handle != JIT_HANDLE_INVALID)
          return cgen_rematerialise_handle(obj, cgb->func, value.handle);
       else
          return llvm_int32(obj, value.handle);
    case JIT_ADDR_ABS:
       return llvm_ptr(obj, (void *)(intptr_t)value.int64);
    case JIT_ADDR_COVER:
-      if (cgb->func->mode == CGEN_AOT) {
+      if (cgb->func->mode != CGEN_JIT) {
          LLVMValueRef ptr =
             cgen_load_from_reloc(obj, cgb->func, RELOC_COVER, 0);
          LLVMValueRef base = LLVMBuildLoad2(obj->builder,
@@ -1748,6 +1769,35 @@ static void cgen_op_ret(llvm_obj_t *obj, jit_ir_t *ir)
    LLVMBuildRetVoid(obj->builder);
 }
 
+static void cgen_branch_weights(llvm_obj_t *obj, cgen_block_t *cgb,
+                                jit_ir_t *ir, LLVMValueRef br, bool invert)
+{
+   jit_profile_t *profile = cgb->func->profile;
+   if (profile == NULL)
+      return;
+
+   const jit_irprof_t *prof = &(profile->irs[ir - cgb->func->source->irbuf]);
+   const uint32_t hits = relaxed_load(&prof->hits);
+   const uint32_t taken = MIN(relaxed_load(&prof->taken), hits);
+
+   if (hits == 0)
+      return;
+
+   const uint32_t weight_t = invert ? hits - taken : taken;
+   const uint32_t weight_f = invert ? taken : hits - taken;
+
+   LLVMMetadataRef mds[] = {
+      LLVMMDStringInContext2(obj->context, "branch_weights", 14),
+      LLVMValueAsMetadata(llvm_int32(obj, weight_t + 1)),
+      LLVMValueAsMetadata(llvm_int32(obj, weight_f + 1)),
+   };
+   LLVMMetadataRef node =
+      LLVMMDNodeInContext2(obj->context, mds, ARRAY_LEN(mds));
+
+   const unsigned kind = LLVMGetMDKindIDInContext(obj->context, "prof", 4);
+   LLVMSetMetadata(br, kind, LLVMMetadataAsValue(obj->context, node));
+}
+
 static void cgen_op_jump(llvm_obj_t *obj, cgen_block_t *cgb, jit_ir_t *ir)
 {
    if (ir->cc == JIT_CC_NONE) {
@@ -1761,14 +1811,18 @@ static void cgen_op_jump(llvm_obj_t *obj, cgen_block_t *cgb, jit_ir_t *ir)
       LLVMBasicBlockRef dest_t =
          cgb->func->blocks[jit_get_edge(&(cgb->source->out), 1)].bbref;
       LLVMBasicBlockRef dest_f = (cgb + 1)->bbref;
-      LLVMBuildCondBr(obj->builder, cgb->outflags, dest_t, dest_f);
+      LLVMValueRef br =
+         LLVMBuildCondBr(obj->builder, cgb->outflags, dest_t, dest_f);
+      cgen_branch_weights(obj, cgb, ir, br, false);
    }
    else if (ir->cc == JIT_CC_F) {
       assert(cgb->source->out.count == 2);
       LLVMBasicBlockRef dest_t =
          cgb->func->blocks[jit_get_edge(&(cgb->source->out), 1)].bbref;
       LLVMBasicBlockRef dest_f = (cgb + 1)->bbref;
-      LLVMBuildCondBr(obj->builder, cgb->outflags, dest_f, dest_t);
+      LLVMValueRef br =
+         LLVMBuildCondBr(obj->builder, cgb->outflags, dest_f, dest_t);
+      cgen_branch_weights(obj, cgb, ir, br, true);
    }
    else
       cgen_abort(cgb, ir, "unhandled jump condition code");
@@ -1853,7 +1907,7 @@ static void cgen_op_call(llvm_obj_t *obj, cgen_block_t *cgb, jit_ir_t *ir)
    jit_func_t *callee = jit_get_func(cgb->func->source->jit, ir->arg1.handle);
 
    LLVMValueRef entry = NULL, fptr = NULL;
-   if (cgb->func->mode == CGEN_AOT) {
+   if (cgb->func->mode != CGEN_JIT) {
       cgen_reloc_t *reloc = cgen_find_reloc(cgb->func->relocs, RELOC_FUNC,
                                             INT_MAX, ir->arg1.handle);
       assert(reloc != NULL);
@@ -1877,7 +1931,7 @@ static void cgen_op_call(llvm_obj_t *obj, cgen_block_t *cgb, jit_ir_t *ir)
 
 #if CLOSED_WORLD
       // Do not generate direct calls for intrinsics
-      if (callee->entry == jit_interp) {
+      if (cgb->func->mode == CGEN_AOT && callee->entry == jit_interp) {
          LOCAL_TEXT_BUF symbol = safe_symbol(callee->name);
          entry = llvm_add_fn(obj, tb_get(symbol), obj->types[LLVM_ENTRY_FN]);
       }
@@ -1904,8 +1958,21 @@ static void cgen_op_call(llvm_obj_t *obj, cgen_block_t *cgb, jit_ir_t *ir)
       cgb->func->args,
       cgb->func->tlab,
    };
-   LLVMBuildCall2(obj->builder, obj->types[LLVM_ENTRY_FN], entry,
-                  args, ARRAY_LEN(args), "");
+   LLVMValueRef call = LLVMBuildCall2(obj->builder,
+                                      obj->types[LLVM_ENTRY_FN], entry,
+                                      args, ARRAY_LEN(args), "");
+
+   jit_profile_t *profile = cgb->func->profile;
+   if (profile != NULL && relaxed_load(&profile->calls) >= PROFILE_MIN_CALLS) {
+      // Move calls never made while profiling out of the hot path
+      const jit_irprof_t *prof =
+         &(profile->irs[ir - cgb->func->source->irbuf]);
+      if (relaxed_load(&prof->hits) == 0) {
+         const unsigned kind = LLVMGetEnumAttributeKindForName("cold", 4);
+         LLVMAttributeRef ref = LLVMCreateEnumAttribute(obj->context, kind, 0);
+         LLVMAddCallSiteAttribute(call, LLVMAttributeFunctionIndex, ref);
+      }
+   }
 }
 
 static void cgen_op_lea(llvm_obj_t *obj, cgen_block_t *cgb, jit_ir_t *ir)
@@ -2202,7 +2269,7 @@ static void cgen_macro_putpriv(llvm_obj_t *obj, cgen_block_t *cgb, jit_ir_t *ir)
 {
    LLVMValueRef value = cgen_coerce_value(obj, cgb, ir->arg2, LLVM_PTR);
 
-   if (cgb->func->mode == CGEN_AOT) {
+   if (cgb->func->mode != CGEN_JIT) {
       LLVMValueRef ptr = cgen_load_from_reloc(obj, cgb->func, RELOC_PRIVDATA,
                                               ir->arg1.handle);
 #ifndef LLVM_HAS_OPAQUE_POINTERS
@@ -2262,7 +2329,7 @@ static void cgen_macro_trim(llvm_obj_t *obj, cgen_block_t *cgb, jit_ir_t *ir)
                                            watermark_ptr, "");
    LLVMValueRef alloc_ptr = LLVMBuildStructGEP2(obj->builder,
                                                 obj->types[LLVM_TLAB],
-                                                cgb->func->tlab, 2, "");
+                                                cgb->func->tlab, 1, "");
    LLVMBuildStore(obj->builder, watermark, alloc_ptr);
 }
 
@@ -2531,7 +2598,7 @@ static void cgen_frame_anchor(llvm_obj_t *obj, cgen_func_t *func)
                                                     func->anchor, 3, "");
    LLVMValueRef alloc_ptr = LLVMBuildStructGEP2(obj->builder,
                                                 obj->types[LLVM_TLAB],
-                                                func->tlab, 2, "");
+                                                func->tlab, 1, "");
    LLVMValueRef alloc = LLVMBuildLoad2(obj->builder, obj->types[LLVM_INT32],
                                        alloc_ptr, "");
    LLVMBuildStore(obj->builder, alloc, watermark_ptr);
@@ -2591,16 +2658,36 @@ static LLVMValueRef cgen_debug_irbuf(llvm_obj_t *obj, jit_func_t *f)
    return global;
 }
 
+static LLVMTypeRef cgen_descr_type(llvm_obj_t *obj, LLVMTypeRef reloc_type)
+{
+   LLVMTypeRef ftypes[] = {
+      obj->types[LLVM_PTR],     // Entry function
+      obj->types[LLVM_PTR],     // String table
+      obj->types[LLVM_PTR],     // JIT pack buffer
+      obj->types[LLVM_PTR],     // Constant pool
+      reloc_type                // Relocations list
+   };
+   return LLVMStructTypeInContext(obj->context, ftypes,
+                                  ARRAY_LEN(ftypes), false);
+}
+
 static LLVMValueRef cgen_reloc_str(llvm_obj_t *obj, const char *str)
 {
    const unsigned off = pack_writer_get_string(obj->pack_writer, str);
    return llvm_intptr(obj, off);
 }
 
-static void cgen_aot_descr(llvm_obj_t *obj, cgen_func_t *func)
+static LLVMValueRef cgen_reloc_name(llvm_obj_t *obj, cgen_func_t *func,
+                                    ident_t name)
 {
-   LLVMValueRef irbuf = cgen_debug_irbuf(obj, func->source);
+   if (func->import)
+      return NULL;   // Only the relocation indexes are needed
+   else
+      return cgen_reloc_str(obj, istr(name));
+}
 
+static void cgen_aot_descr(llvm_obj_t *obj, cgen_func_t *func)
+{
    A(cgen_reloc_t) relocs = AINIT;
 
    for (int i = 0; i < func->source->nirs; i++) {
@@ -2614,7 +2701,7 @@ static void cgen_aot_descr(llvm_obj_t *obj, cgen_func_t *func)
             jit_func_t *f = jit_get_func(func->source->jit, ir->arg1.handle);
             const cgen_reloc_t r = {
                .kind = kind,
-               .str  = cgen_reloc_str(obj, istr(f->name)),
+               .str  = cgen_reloc_name(obj, func, f->name),
                .key  = ir->arg1.handle,
                .nth  = relocs.count,
             };
@@ -2633,7 +2720,7 @@ static void cgen_aot_descr(llvm_obj_t *obj, cgen_func_t *func)
 
                   const cgen_reloc_t r = {
                      .kind = RELOC_HANDLE,
-                     .str  = cgen_reloc_str(obj, istr(name)),
+                     .str  = cgen_reloc_name(obj, func, name),
                      .key  = args[j].handle,
                      .nth  = relocs.count,
                   };
@@ -2659,6 +2746,18 @@ static void cgen_aot_descr(llvm_obj_t *obj, cgen_func_t *func)
 
    func->reloc_type = LLVMArrayType(obj->types[LLVM_AOT_RELOC], relocs.count);
 
+   if (func->import) {
+      // The descriptor is defined in the object file containing the
+      // real definition of this function
+      func->descr_type = cgen_descr_type(obj, func->reloc_type);
+
+      char *name LOCAL = xasprintf("%s.descr", func->name);
+      func->descr = LLVMAddGlobal(obj->module, func->descr_type, name);
+      return;
+   }
+
+   LLVMValueRef irbuf = cgen_debug_irbuf(obj, func->source);
+
    LLVMValueRef *reloc_elems LOCAL =
       xmalloc_array(relocs.count, sizeof(LLVMValueRef));
 
@@ -2674,15 +2773,7 @@ static void cgen_aot_descr(llvm_obj_t *obj, cgen_func_t *func)
    LLVMValueRef reloc_array = LLVMConstArray(obj->types[LLVM_AOT_RELOC],
                                              reloc_elems, relocs.count);
 
-   LLVMTypeRef ftypes[] = {
-      obj->types[LLVM_PTR],     // Entry function
-      obj->types[LLVM_PTR],     // String table
-      obj->types[LLVM_PTR],     // JIT pack buffer
-      obj->types[LLVM_PTR],     // Constant pool
-      func->reloc_type          // Relocations list
-   };
-   func->descr_type = LLVMStructTypeInContext(obj->context, ftypes,
-                                              ARRAY_LEN(ftypes), false);
+   func->descr_type = cgen_descr_type(obj, func->reloc_type);
 
    char *name LOCAL = xasprintf("%s.descr", func->name);
    func->descr = LLVMAddGlobal(obj->module, func->descr_type, name);
@@ -2872,6 +2963,156 @@ static void cgen_reexecute_guard(llvm_obj_t *obj, cgen_func_t *func,
    LLVMPositionBuilderAtEnd(obj->builder, cont_bb);
 }
 
+static bool cgen_is_osr_target(jit_cfg_t *cfg, int nth)
+{
+   // Only the header of a loop can be entered from the interpreter
+   jit_block_t *bb = &(cfg->blocks[nth]);
+   for (int i = 0; i < bb->in.count; i++) {
+      if (jit_get_edge(&bb->in, i) >= nth)
+         return nth > 0;
+   }
+
+   return false;
+}
+
+static bool cgen_can_osr(cgen_func_t *func, jit_cfg_t *cfg, int *ntargets)
+{
+   const int nregs = func->source->nregs;
+
+   *ntargets = 0;
+   for (int i = 0; i < cfg->nblocks; i++) {
+      if (!cgen_is_osr_target(cfg, i))
+         continue;
+
+      // Every live-in value must be merged by a phi instruction
+      cgen_block_t *cgb = &(func->blocks[i]);
+      for (int j = 0; j <= nregs; j++) {
+         if (!mask_test(&cgb->source->livein, j))
+            continue;
+
+         LLVMValueRef value = j == nregs ? cgb->inflags : cgb->inregs[j];
+         if (!LLVMIsAPHINode(value)
+             || LLVMGetInstructionParent(value) != cgb->bbref)
+            return false;
+      }
+
+      (*ntargets)++;
+   }
+
+   return *ntargets > 0;
+}
+
+static void cgen_osr_entry(llvm_obj_t *obj, cgen_func_t *func, jit_cfg_t *cfg)
+{
+   // The interpreter passes a jit_osr_t as the caller's anchor to
+   // continue a call part way through at a loop header
+
+   int ntargets;
+   if (func->mode == CGEN_AOT || !cgen_can_osr(func, cfg, &ntargets)) {
+      LLVMBuildBr(obj->builder, func->blocks[0].bbref);
+      return;
+   }
+
+   LLVMValueRef osr = LLVMGetParam(func->llvmfn, 1);
+
+   LLVMBasicBlockRef check_bb = llvm_append_block(obj, func->llvmfn, "");
+   LLVMBasicBlockRef osr_bb = llvm_append_block(obj, func->llvmfn, "osr");
+   LLVMBasicBlockRef bad_bb = llvm_append_block(obj, func->llvmfn, "");
+
+   LLVMValueRef null = LLVMConstNull(obj->types[LLVM_PTR]);
+   LLVMValueRef has_caller =
+      LLVMBuildICmp(obj->builder, LLVMIntNE, osr, null, "");
+   LLVMBuildCondBr(obj->builder, has_caller, check_bb,
+                   func->blocks[0].bbref);
+
+   LLVMPositionBuilderAtEnd(obj->builder, check_bb);
+
+   LLVMTypeRef anchor_type = obj->types[LLVM_ANCHOR];
+   LLVMValueRef irpos_ptr =
+      LLVMBuildStructGEP2(obj->builder, anchor_type, osr, 2, "");
+   LLVMValueRef irpos =
+      LLVMBuildLoad2(obj->builder, obj->types[LLVM_INT32], irpos_ptr, "");
+   LLVMValueRef is_osr = LLVMBuildICmp(obj->builder, LLVMIntEQ, irpos,
+                                       llvm_int32(obj, JIT_OSR_IRPOS), "");
+   LLVMBuildCondBr(obj->builder, is_osr, osr_bb, func->blocks[0].bbref);
+
+   LLVMPositionBuilderAtEnd(obj->builder, osr_bb);
+
+   // Replace the interpreter's frame in the chain of anchors
+   LLVMValueRef caller_ptr =
+      LLVMBuildStructGEP2(obj->builder, anchor_type, osr, 0, "");
+   LLVMValueRef caller =
+      LLVMBuildLoad2(obj->builder, obj->types[LLVM_PTR], caller_ptr, "");
+   LLVMBuildStore(obj->builder, caller,
+                  LLVMBuildStructGEP2(obj->builder, anchor_type,
+                                      func->anchor, 0, ""));
+
+   LLVMValueRef watermark_ptr =
+      LLVMBuildStructGEP2(obj->builder, anchor_type, osr, 3, "");
+   LLVMValueRef watermark =
+      LLVMBuildLoad2(obj->builder, obj->types[LLVM_INT32], watermark_ptr, "");
+   LLVMBuildStore(obj->builder, watermark,
+                  LLVMBuildStructGEP2(obj->builder, anchor_type,
+                                      func->anchor, 3, ""));
+
+   LLVMTypeRef osr_type = obj->types[LLVM_OSR];
+   LLVMValueRef regs_ptr =
+      LLVMBuildStructGEP2(obj->builder, osr_type, osr, 1, "");
+   LLVMValueRef regs =
+      LLVMBuildLoad2(obj->builder, obj->types[LLVM_PTR], regs_ptr, "regs");
+
+   LLVMValueRef target_ptr =
+      LLVMBuildStructGEP2(obj->builder, osr_type, osr, 2, "");
+   LLVMValueRef target =
+      LLVMBuildLoad2(obj->builder, obj->types[LLVM_INT32], target_ptr, "");
+
+   LLVMValueRef flags_ptr =
+      LLVMBuildStructGEP2(obj->builder, osr_type, osr, 3, "");
+   LLVMValueRef flags =
+      LLVMBuildLoad2(obj->builder, obj->types[LLVM_INT32], flags_ptr, "");
+   LLVMValueRef flags_i1 = LLVMBuildICmp(obj->builder, LLVMIntNE, flags,
+                                         llvm_int32(obj, 0), "");
+
+   LLVMValueRef sw = LLVMBuildSwitch(obj->builder, target, bad_bb, ntargets);
+
+   LLVMPositionBuilderAtEnd(obj->builder, bad_bb);
+   LLVMBuildUnreachable(obj->builder);
+
+   for (int i = 0; i < cfg->nblocks; i++) {
+      if (!cgen_is_osr_target(cfg, i))
+         continue;
+
+      cgen_block_t *cgb = &(func->blocks[i]);
+
+      LLVMBasicBlockRef load_bb = llvm_append_block(obj, func->llvmfn, "");
+      LLVMAddCase(sw, llvm_int32(obj, cgb->source->first), load_bb);
+
+      LLVMPositionBuilderAtEnd(obj->builder, load_bb);
+
+      for (int j = 0; j < func->source->nregs; j++) {
+         if (!mask_test(&cgb->source->livein, j))
+            continue;
+
+         LLVMValueRef indexes[] = { llvm_int32(obj, j) };
+         LLVMValueRef ptr = LLVMBuildInBoundsGEP2(obj->builder,
+                                                  obj->types[LLVM_INT64],
+                                                  regs, indexes,
+                                                  ARRAY_LEN(indexes), "");
+         LLVMTypeRef type = LLVMTypeOf(cgb->inregs[j]);
+         LLVMValueRef value = LLVMBuildLoad2(obj->builder, type, ptr,
+                                             cgen_reg_name(j));
+         LLVMAddIncoming(cgb->inregs[j], &value, &load_bb, 1);
+      }
+
+      if (mask_test(&cgb->source->livein, func->source->nregs))
+         LLVMAddIncoming(cgb->inflags, &flags_i1, &load_bb, 1);
+
+      LLVMBuildBr(obj->builder, cgb->bbref);
+   }
+
+   func->osr = true;
+}
+
 static void cgen_function(llvm_obj_t *obj, cgen_func_t *func)
 {
    func->llvmfn = llvm_add_fn(obj, func->name, obj->types[LLVM_ENTRY_FN]);
@@ -2921,7 +3162,7 @@ static void cgen_function(llvm_obj_t *obj, cgen_func_t *func)
    cgen_debug_loc(obj, func, &(func->source->object->loc));
 #endif  // ENABLE_DWARF
 
-   if (func->mode == CGEN_AOT) {
+   if (func->mode != CGEN_JIT) {
       cgen_aot_cpool(obj, func);
       cgen_aot_descr(obj, func);
    }
@@ -3059,6 +3300,9 @@ static void cgen_function(llvm_obj_t *obj, cgen_func_t *func)
       }
    }
 
+   LLVMPositionBuilderAtEnd(obj->builder, entry_bb);
+   cgen_osr_entry(obj, func, cfg);
+
    for (int i = 0; i < cfg->nblocks; i++) {
       cgen_block_t *cgb = &(func->blocks[i]);
       free(cgb->inregs);
@@ -3066,9 +3310,6 @@ static void cgen_function(llvm_obj_t *obj, cgen_func_t *func)
       cgb->inregs = cgb->outregs = NULL;
    }
 
-   LLVMPositionBuilderAtEnd(obj->builder, entry_bb);
-   LLVMBuildBr(obj->builder, func->blocks[0].bbref);
-
    jit_free_cfg(func->source);
    func->cfg = cfg = NULL;
 
@@ -3346,33 +3587,191 @@ static void cgen_memset_body(llvm_obj_t *obj, llvm_fn_t which,
 
 typedef struct {
    code_cache_t *code;
+   char         *cachedir;
+   SHA1_CTX      keybase;
 } llvm_jit_state_t;
 
-static void *jit_llvm_init(jit_t *jit)
+static void llvm_init_strtab(llvm_obj_t *obj)
 {
-   LLVMInitializeNativeTarget();
-   LLVMInitializeNativeAsmPrinter();
+   obj->pack_writer = pack_writer_new();
 
-   llvm_jit_state_t *state = xcalloc(sizeof(llvm_jit_state_t));
-   state->code = code_cache_new();
+   obj->strtab = LLVMAddGlobal(obj->module, obj->types[LLVM_STRTAB],
+                               "placeholder_strtab");
+   LLVMSetGlobalConstant(obj->strtab, true);
+   LLVMSetLinkage(obj->strtab, LLVMPrivateLinkage);
+}
 
-   return state;
+static void llvm_hash_target(SHA1_CTX *ctx, LLVMTargetMachineRef tm)
+{
+   // Any change to the compiler or the host CPU invalidates the cache
+   LOCAL_TEXT_BUF tb = tb_new();
+   tb_printf(tb, "%s %d %s ", PACKAGE_VERSION, RT_ABI_VERSION, LLVM_VERSION);
+
+   char *triple = LLVMGetTargetMachineTriple(tm);
+   char *cpu = LLVMGetTargetMachineCPU(tm);
+   char *features = LLVMGetTargetMachineFeatureString(tm);
+
+   tb_printf(tb, "%s %s %s", triple, cpu, features);
+
+   LLVMDisposeMessage(triple);
+   LLVMDisposeMessage(cpu);
+   LLVMDisposeMessage(features);
+
+   SHA1Init(ctx);
+   SHA1Update(ctx, (unsigned char *)tb_get(tb), tb_len(tb));
 }
 
-static void jit_llvm_cgen(jit_t *j, jit_handle_t handle, void *context)
+static void llvm_hash_module(SHA1_CTX *ctx, llvm_obj_t *obj, text_buf_t *tb)
 {
-   llvm_jit_state_t *state = context;
+   char *ir = LLVMPrintModuleToString(obj->module);
+   SHA1Update(ctx, (unsigned char *)ir, strlen(ir));
+   LLVMDisposeMessage(ir);
+
+   const char *strtab;
+   size_t len;
+   pack_writer_string_table(obj->pack_writer, &strtab, &len);
+   SHA1Update(ctx, (unsigned char *)strtab, len);
+
+   unsigned char hash[SHA1_LEN];
+   SHA1Final(hash, ctx);
+
+   for (int i = 0; i < SHA1_LEN; i++)
+      tb_printf(tb, "%02x", hash[i]);
+}
+
+static void jit_cache_init(llvm_jit_state_t *state, const char *dir)
+{
+   make_dir(dir);
+   state->cachedir = xstrdup(dir);
+
+   LLVMTargetMachineRef tm = llvm_target_machine(LLVMRelocDefault,
+                                                 JIT_CODE_MODEL);
+   llvm_hash_target(&state->keybase, tm);
+   LLVMDisposeTargetMachine(tm);
+}
+
+static bool jit_cache_locus_ok(jit_value_t value)
+{
+   return value.kind != JIT_VALUE_LOCUS || value.locus == NULL
+      || arena_frozen(object_arena(value.locus));
+}
+
+static bool jit_can_cache(jit_func_t *f)
+{
+   // Objects are referenced by their offset in a saved design unit so
+   // code for units still being elaborated cannot be cached
+   if (f->object == NULL || !arena_frozen(object_arena(f->object)))
+      return false;
+
+   jit_fill_irbuf(f);
+
+   for (int i = 0; i < f->nirs; i++) {
+      const jit_ir_t *ir = &(f->irbuf[i]);
+      if (!jit_cache_locus_ok(ir->arg1) || !jit_cache_locus_ok(ir->arg2))
+         return false;
+   }
+
+   return true;
+}
+
+static char *jit_cache_path(llvm_jit_state_t *state, jit_t *j,
+                            jit_handle_t handle)
+{
+   // The cached code is a function of the JIT IR, the constant pool,
+   // and the names of the functions it references so the key is a hash
+   // of the same serialised form used for pack files which avoids
+   // generating any LLVM IR when the object is already in the cache
+   SHA1_CTX ctx = state->keybase;
 
+   pack_writer_t *pw = pack_writer_new();
+
+   uint8_t *buf LOCAL = NULL;
+   size_t size;
+   pack_writer_emit(pw, j, handle, &buf, &size);
+   SHA1Update(&ctx, buf, size);
+
+   const char *strtab;
+   size_t len;
+   pack_writer_string_table(pw, &strtab, &len);
+   SHA1Update(&ctx, (unsigned char *)strtab, len);
+
+   pack_writer_free(pw);
+
+   // Symbol names in the object are derived from the function name
    jit_func_t *f = jit_get_func(j, handle);
+   const char *name = istr(f->name);
+   SHA1Update(&ctx, (unsigned char *)name, strlen(name) + 1);
+   SHA1Update(&ctx, f->cpool, f->cpoolsz);
 
-#ifdef DEBUG
-   const char *only = getenv("NVC_JIT_ONLY");
-   if (only != NULL && !icmp(f->name, only))
+   unsigned char hash[SHA1_LEN];
+   SHA1Final(hash, &ctx);
+
+   LOCAL_TEXT_BUF tb = tb_new();
+   tb_printf(tb, "%s" DIR_SEP, state->cachedir);
+   for (int i = 0; i < SHA1_LEN; i++)
+      tb_printf(tb, "%02x", hash[i]);
+   tb_cat(tb, ".o");
+
+   return tb_claim(tb);
+}
+
+static void *jit_cache_read(const char *path, size_t *size, bool *osr)
+{
+   int fd = open(path, O_RDONLY);
+   if (fd < 0)
+      return NULL;
+
+   // The object code is followed by a single byte recording whether
+   // the function has an on-stack replacement entry
+   void *map = NULL;
+   file_info_t info;
+   if (get_handle_info(fd, &info) && info.size > 1) {
+      map = map_file(fd, info.size);
+      *size = info.size - 1;
+      *osr = ((uint8_t *)map)[info.size - 1];
+   }
+
+   close(fd);
+   return map;
+}
+
+static void jit_cache_write(const char *path, const void *data, size_t size,
+                            bool osr)
+{
+   // Write to a temporary file first so concurrent simulations never
+   // see a partial object
+   char *tmp LOCAL = xasprintf("%s.%d.%d", path, getpid(), thread_id());
+
+   FILE *f = fopen(tmp, "wb");
+   if (f == NULL)
       return;
+
+   const bool failed = fwrite(data, size, 1, f) != 1 || fputc(osr, f) == EOF;
+
+   if (fclose(f) != 0 || failed || rename(tmp, path) != 0)
+      remove(tmp);
+}
+
+static void *jit_llvm_init(jit_t *jit)
+{
+   LLVMInitializeNativeTarget();
+   LLVMInitializeNativeAsmPrinter();
+
+   llvm_jit_state_t *state = xcalloc(sizeof(llvm_jit_state_t));
+   state->code = code_cache_new();
+
+#if !defined __APPLE__ && !defined __MINGW32__
+   // Only the ELF loader can locate the relocation table of cached code
+   const char *cachedir = opt_get_str(OPT_JIT_CACHE_DIR);
+   if (cachedir != NULL && *cachedir != '\0')
+      jit_cache_init(state, cachedir);
 #endif
 
-   const uint64_t start_us = get_timestamp_us();
+   return state;
+}
 
+static LLVMMemoryBufferRef jit_llvm_emit(cgen_func_t *func)
+{
    LLVMTargetMachineRef tm = llvm_target_machine(LLVMRelocDefault,
                                                  JIT_CODE_MODEL);
 
@@ -3381,10 +3780,7 @@ static void jit_llvm_cgen(jit_t *j, jit_handle_t handle, void *context)
       .target  = tm,
    };
 
-   LOCAL_TEXT_BUF tb = tb_new();
-   tb_istr(tb, f->name);
-
-   obj.module    = LLVMModuleCreateWithNameInContext(tb_get(tb), obj.context);
+   obj.module    = LLVMModuleCreateWithNameInContext(func->name, obj.context);
    obj.builder   = LLVMCreateBuilderInContext(obj.context);
    obj.data_ref  = LLVMCreateTargetDataLayout(tm);
 
@@ -3394,13 +3790,10 @@ static void jit_llvm_cgen(jit_t *j, jit_handle_t handle, void *context)
 
    llvm_register_types(&obj);
 
-   cgen_func_t func = {
-      .name   = tb_claim(tb),
-      .source = f,
-      .mode   = CGEN_JIT,
-   };
+   if (func->mode == CGEN_CACHE)
+      llvm_init_strtab(&obj);
 
-   cgen_function(&obj, &func);
+   cgen_function(&obj, func);
 
    llvm_obj_finalise(&obj, LLVM_O0);
 
@@ -3408,9 +3801,68 @@ static void jit_llvm_cgen(jit_t *j, jit_handle_t handle, void *context)
    char *error;
    if (LLVMTargetMachineEmitToMemoryBuffer(tm, obj.module, LLVMObjectFile,
                                            &error, &buf))
-     fatal("failed to generate native code: %s", error);
+      fatal("failed to generate native code: %s", error);
 
-   const size_t objsz = LLVMGetBufferSize(buf);
+   if (obj.pack_writer != NULL)
+      pack_writer_free(obj.pack_writer);
+
+   LLVMDisposeTargetData(obj.data_ref);
+   LLVMDisposeTargetMachine(tm);
+   LLVMDisposeBuilder(obj.builder);
+   DWARF_ONLY(LLVMDisposeDIBuilder(obj.debuginfo));
+   LLVMContextDispose(obj.context);
+
+   return buf;
+}
+
+static void jit_llvm_cgen(jit_t *j, jit_handle_t handle, void *context)
+{
+   llvm_jit_state_t *state = context;
+
+   jit_func_t *f = jit_get_func(j, handle);
+
+#ifdef DEBUG
+   const char *only = getenv("NVC_JIT_ONLY");
+   if (only != NULL && !icmp(f->name, only))
+      return;
+#endif
+
+   const uint64_t start_us = get_timestamp_us();
+
+   LOCAL_TEXT_BUF tb = tb_new();
+   tb_istr(tb, f->name);
+
+   cgen_func_t func = {
+      .name    = tb_claim(tb),
+      .source  = f,
+      .mode    = CGEN_JIT,
+      .profile = load_acquire(&f->profile),
+   };
+
+   char *path LOCAL = NULL;
+   void *cached = NULL;
+   size_t objsz = 0;
+   if (state->cachedir != NULL && jit_can_cache(f)) {
+      // Cached code must not embed any addresses from this process and
+      // should not depend on the profile so it can be reused
+      func.mode = CGEN_CACHE;
+      func.profile = NULL;
+
+      path = jit_cache_path(state, j, handle);
+      cached = jit_cache_read(path, &objsz, &func.osr);
+   }
+
+   LLVMMemoryBufferRef buf = NULL;
+   const void *objdata = cached;
+   if (cached == NULL) {
+      buf = jit_llvm_emit(&func);
+
+      objsz = LLVMGetBufferSize(buf);
+      objdata = LLVMGetBufferStart(buf);
+
+      if (func.mode == CGEN_CACHE)
+         jit_cache_write(path, objdata, objsz, func.osr);
+   }
 
    code_blob_t *blob = code_blob_new(state->code, f->name, objsz);
    if (blob == NULL)
@@ -3419,23 +3871,41 @@ static void jit_llvm_cgen(jit_t *j, jit_handle_t handle, void *context)
    const uint8_t *base = blob->wptr;
    const void *entry_addr = blob->wptr;
 
-   code_load_object(blob, LLVMGetBufferStart(buf), objsz);
+   code_load_object(blob, objdata, objsz);
+
+   if (func.mode == CGEN_CACHE && !blob->overflow) {
+      if (blob->descr == NULL)
+         fatal_trace("missing relocation table for %s", func.name);
+
+      jit_bind_relocs(j, handle, blob->descr);
+   }
 
    const size_t size = blob->wptr - base;
-   code_blob_finalise(blob, &(f->entry));
+
+   jit_entry_fn_t entry = NULL;
+   code_blob_finalise(blob, &entry);
+
+   if (entry != NULL) {
+      // The interpreter only attempts on-stack replacement when the
+      // current entry point matches this
+      if (func.osr)
+         store_release(&f->osr_entry, entry);
+
+      jit_set_entry(f, entry);
+   }
 
    if (opt_get_int(OPT_JIT_LOG)) {
       const uint64_t end_us = get_timestamp_us();
-      debugf("%s at %p [%zu bytes in %"PRIi64" us]", func.name,
-             entry_addr, size, end_us - start_us);
+      debugf("%s at %p [%zu bytes in %"PRIi64" us%s]", func.name,
+             entry_addr, size, end_us - start_us,
+             cached != NULL ? ", cached" : "");
    }
 
-   LLVMDisposeMemoryBuffer(buf);
-   LLVMDisposeTargetData(obj.data_ref);
-   LLVMDisposeTargetMachine(tm);
-   LLVMDisposeBuilder(obj.builder);
-   DWARF_ONLY(LLVMDisposeDIBuilder(obj.debuginfo));
-   LLVMContextDispose(obj.context);
+   if (cached != NULL)
+      unmap_file(cached, objsz + 1);
+   else
+      LLVMDisposeMemoryBuffer(buf);
+
    free(func.name);
 }
 
@@ -3443,6 +3913,7 @@ static void jit_llvm_cleanup(void *context)
 {
    llvm_jit_state_t *state = context;
    code_cache_free(state->code);
+   free(state->cachedir);
    free(state);
 }
 
@@ -3472,7 +3943,6 @@ llvm_obj_t *llvm_obj_new(const char *name)
    obj->builder     = LLVMCreateBuilderInContext(obj->context);
    obj->target      = llvm_target_machine(LLVMRelocPIC, LLVMCodeModelDefault);
    obj->data_ref    = LLVMCreateTargetDataLayout(obj->target);
-   obj->pack_writer = pack_writer_new();
 
 #if ENABLE_DWARF
    obj->debuginfo = LLVMCreateDIBuilderDisallowUnresolved(obj->module);
@@ -3495,10 +3965,7 @@ llvm_obj_t *llvm_obj_new(const char *name)
 #endif
 #endif
 
-   obj->strtab = LLVMAddGlobal(obj->module, obj->types[LLVM_STRTAB],
-                               "placeholder_strtab");
-   LLVMSetGlobalConstant(obj->strtab, true);
-   LLVMSetLinkage(obj->strtab, LLVMPrivateLinkage);
+   llvm_init_strtab(obj);
 
    return obj;
 }
@@ -3540,6 +4007,47 @@ void llvm_aot_compile(llvm_obj_t *obj, jit_t *j, jit_handle_t handle)
    free(func.name);
 }
 
+void llvm_aot_import(llvm_obj_t *obj, jit_t *j, jit_handle_t handle)
+{
+   jit_func_t *f = jit_get_func(j, handle);
+   jit_fill_irbuf(f);
+
+   if (f->nirs > IMPORT_MAX_IRS)
+      return;   // Unlikely to be inlined
+
+   LOCAL_TEXT_BUF tb = safe_symbol(f->name);
+
+   cgen_func_t func = {
+      .name   = tb_claim(tb),
+      .source = f,
+      .mode   = CGEN_AOT,
+      .import = true,
+   };
+
+   cgen_function(obj, &func);
+
+   // The body is only visible to the optimiser which may inline it and
+   // is discarded before code generation
+   LLVMSetLinkage(func.llvmfn, LLVMAvailableExternallyLinkage);
+   LLVMSetDLLStorageClass(func.llvmfn, LLVMDefaultStorageClass);
+
+   free(func.name);
+}
+
+char *llvm_obj_cache_key(llvm_obj_t *obj, llvm_opt_level_t olevel)
+{
+   SHA1_CTX ctx;
+   llvm_hash_target(&ctx, obj->target);
+
+   const uint8_t level = olevel;
+   SHA1Update(&ctx, &level, 1);
+
+   LOCAL_TEXT_BUF tb = tb_new();
+   llvm_hash_module(&ctx, obj, tb);
+
+   return tb_claim(tb);
+}
+
 static void llvm_finalise_string_table(llvm_obj_t *obj)
 {
    if (obj->pack_writer == NULL)
@@ -3595,6 +4103,11 @@ void llvm_obj_emit(llvm_obj_t *obj, const char *path)
                                    LLVMObjectFile, &error))
       fatal("Failed to write object file: %s", error);
 
+   llvm_obj_free(obj);
+}
+
+void llvm_obj_free(llvm_obj_t *obj)
+{
    LLVMDisposeTargetData(obj->data_ref);
    LLVMDisposeTargetMachine(obj->target);
    LLVMDisposeBuilder(obj->builder);
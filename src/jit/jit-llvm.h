@@ -35,7 +35,10 @@ typedef enum {
 llvm_obj_t *llvm_obj_new(const char *name);
 void llvm_add_abi_version(llvm_obj_t *obj);
 void llvm_aot_compile(llvm_obj_t *obj, jit_t *j, jit_handle_t handle);
+void llvm_aot_import(llvm_obj_t *obj, jit_t *j, jit_handle_t handle);
+char *llvm_obj_cache_key(llvm_obj_t *obj, llvm_opt_level_t olevel);
 void llvm_obj_finalise(llvm_obj_t *obj, llvm_opt_level_t level);
 void llvm_obj_emit(llvm_obj_t *obj, const char *path);
+void llvm_obj_free(llvm_obj_t *obj);
 
 #endif  // _JIT_LLVM_H
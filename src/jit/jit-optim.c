@@ -1043,6 +1043,1763 @@ void jit_do_cprop(jit_func_t *f)
    }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Dominator tree
+
+typedef struct {
+   jit_cfg_t *cfg;
+   int       *idom;
+   int       *order;
+   int       *rpo;
+   int        nreach;
+} dom_info_t;
+
+static int dom_intersect(dom_info_t *di, int b1, int b2)
+{
+   while (b1 != b2) {
+      while (di->order[b1] > di->order[b2])
+         b1 = di->idom[b1];
+      while (di->order[b2] > di->order[b1])
+         b2 = di->idom[b2];
+   }
+
+   return b1;
+}
+
+static void dom_init(dom_info_t *di, jit_cfg_t *cfg)
+{
+   // Algorithm from "A Simple, Fast Dominance Algorithm" by Cooper,
+   // Harvey, and Kennedy
+
+   const int nb = cfg->nblocks;
+
+   di->cfg   = cfg;
+   di->idom  = xmalloc_array(nb, sizeof(int));
+   di->order = xmalloc_array(nb, sizeof(int));
+   di->rpo   = xmalloc_array(nb, sizeof(int));
+
+   for (int i = 0; i < nb; i++)
+      di->idom[i] = di->order[i] = -1;
+
+   int *stack LOCAL = xmalloc_array(nb, sizeof(int));
+   int *next LOCAL = xcalloc_array(nb, sizeof(int));
+
+   int sp = 0, npost = 0;
+   stack[sp++] = 0;
+   di->order[0] = 0;
+
+   while (sp > 0) {
+      const int b = stack[sp - 1];
+      jit_edge_list_t *out = &(cfg->blocks[b].out);
+      if (next[b] < out->count) {
+         const int succ = jit_get_edge(out, next[b]++);
+         if (di->order[succ] == -1) {
+            di->order[succ] = 0;
+            stack[sp++] = succ;
+         }
+      }
+      else {
+         di->rpo[npost++] = b;
+         sp--;
+      }
+   }
+
+   for (int i = 0; i < npost / 2; i++) {
+      const int tmp = di->rpo[i];
+      di->rpo[i] = di->rpo[npost - i - 1];
+      di->rpo[npost - i - 1] = tmp;
+   }
+
+   for (int i = 0; i < npost; i++)
+      di->order[di->rpo[i]] = i;
+
+   di->nreach = npost;
+   di->idom[0] = 0;
+
+   bool changed;
+   do {
+      changed = false;
+
+      for (int i = 1; i < npost; i++) {
+         const int b = di->rpo[i];
+         jit_edge_list_t *in = &(cfg->blocks[b].in);
+
+         int idom = -1;
+         for (int j = 0; j < in->count; j++) {
+            const int pred = jit_get_edge(in, j);
+            if (di->idom[pred] == -1)
+               continue;
+            else if (idom == -1)
+               idom = pred;
+            else
+               idom = dom_intersect(di, pred, idom);
+         }
+
+         if (idom != di->idom[b]) {
+            di->idom[b] = idom;
+            changed = true;
+         }
+      }
+   } while (changed);
+}
+
+static void dom_free(dom_info_t *di)
+{
+   free(di->idom);
+   free(di->order);
+   free(di->rpo);
+}
+
+static bool dom_dominates(dom_info_t *di, int a, int b)
+{
+   if (di->order[a] == -1 || di->order[b] == -1)
+      return false;
+
+   while (di->order[b] > di->order[a])
+      b = di->idom[b];
+
+   return a == b;
+}
+
+static bool dom_dominates_ir(dom_info_t *di, int a, int b)
+{
+   const int ba = jit_block_for(di->cfg, a) - di->cfg->blocks;
+   const int bb = jit_block_for(di->cfg, b) - di->cfg->blocks;
+
+   if (ba == bb)
+      return a < b;
+   else
+      return dom_dominates(di, ba, bb);
+}
+
+static inline bool opt_defines_reg(jit_ir_t *ir)
+{
+   return ir->result != JIT_REG_INVALID && !cfg_reads_result(ir);
+}
+
+static int *opt_count_defs(jit_func_t *f)
+{
+   int *defs = xcalloc_array(f->nregs, sizeof(int));
+
+   for (jit_ir_t *ir = f->irbuf; ir < f->irbuf + f->nirs; ir++) {
+      if (opt_defines_reg(ir))
+         defs[ir->result]++;
+   }
+
+   return defs;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Global value numbering
+
+static bool gvn_is_candidate(jit_ir_t *ir)
+{
+   if (ir->cc != JIT_CC_NONE || ir->result == JIT_REG_INVALID)
+      return false;
+
+   switch (ir->op) {
+   case J_ADD:
+   case J_SUB:
+   case J_MUL:
+   case J_DIV:
+   case J_REM:
+   case J_AND:
+   case J_OR:
+   case J_XOR:
+   case J_SHL:
+   case J_ASR:
+   case J_NEG:
+   case J_NOT:
+   case J_LEA:
+   case J_CLAMP:
+      return true;
+   default:
+      return false;
+   }
+}
+
+static bool gvn_same_value(jit_value_t a, jit_value_t b)
+{
+   if (a.kind != b.kind)
+      return false;
+
+   switch (a.kind) {
+   case JIT_VALUE_INVALID:
+      return true;
+   case JIT_VALUE_REG:
+      return a.reg == b.reg;
+   case JIT_ADDR_REG:
+      return a.reg == b.reg && a.disp == b.disp;
+   case JIT_VALUE_INT64:
+   case JIT_VALUE_DOUBLE:
+   case JIT_ADDR_CPOOL:
+   case JIT_ADDR_ABS:
+      return a.int64 == b.int64 && a.disp == b.disp;
+   default:
+      return false;
+   }
+}
+
+static uint32_t gvn_hash_value(jit_value_t value)
+{
+   switch (value.kind) {
+   case JIT_VALUE_REG:
+      return mix_bits_32(value.reg);
+   case JIT_ADDR_REG:
+      return mix_bits_32(value.reg * 31 + value.disp);
+   case JIT_VALUE_INT64:
+   case JIT_VALUE_DOUBLE:
+   case JIT_ADDR_CPOOL:
+   case JIT_ADDR_ABS:
+      return mix_bits_64(value.int64) + value.disp;
+   default:
+      return value.kind;
+   }
+}
+
+static uint32_t gvn_hash(jit_ir_t *ir)
+{
+   const uint32_t h1 = gvn_hash_value(ir->arg1);
+   const uint32_t h2 = gvn_hash_value(ir->arg2);
+   const uint32_t hop = ir->op | ir->size << 8;
+
+   if (lvn_is_commutative(ir->op))
+      return mix_bits_32(hop + h1 + h2);
+   else
+      return mix_bits_32(hop * 29 + h1 * 1093 + h2);
+}
+
+static bool gvn_same_expr(jit_ir_t *a, jit_ir_t *b)
+{
+   if (a->op != b->op || a->size != b->size)
+      return false;
+   else if (gvn_same_value(a->arg1, b->arg1)
+            && gvn_same_value(a->arg2, b->arg2))
+      return true;
+   else
+      return lvn_is_commutative(a->op)
+         && gvn_same_value(a->arg1, b->arg2)
+         && gvn_same_value(a->arg2, b->arg1);
+}
+
+static bool gvn_available(dom_info_t *di, jit_value_t value, int pos,
+                          const int *defs, const int *defpos)
+{
+   // The value must be the same wherever it is used after this point
+   switch (value.kind) {
+   case JIT_VALUE_REG:
+   case JIT_ADDR_REG:
+      return defs[value.reg] == 1
+         && dom_dominates_ir(di, defpos[value.reg], pos);
+   case JIT_VALUE_INT64:
+   case JIT_VALUE_DOUBLE:
+   case JIT_ADDR_CPOOL:
+   case JIT_ADDR_ABS:
+   case JIT_VALUE_INVALID:
+      return true;
+   default:
+      return false;
+   }
+}
+
+static void gvn_rename(jit_value_t *value, const jit_reg_t *leader)
+{
+   if (value->kind == JIT_VALUE_REG || value->kind == JIT_ADDR_REG)
+      value->reg = leader[value->reg];
+}
+
+void jit_do_gvn(jit_func_t *f)
+{
+   // Extends local value numbering across basic blocks by walking the
+   // blocks in reverse postorder and replacing an expression with the
+   // result of an identical expression in a dominating block.  This
+   // only considers registers with a single definition whose value
+   // cannot change between the two points.
+
+   if (f->nregs == 0)
+      return;
+
+   jit_cfg_t *cfg = jit_get_cfg(f);
+
+   dom_info_t dom;
+   dom_init(&dom, cfg);
+
+   int *defs LOCAL = opt_count_defs(f);
+   int *defpos LOCAL = xmalloc_array(f->nregs, sizeof(int));
+
+   for (int i = 0; i < f->nirs; i++) {
+      if (opt_defines_reg(&(f->irbuf[i])))
+         defpos[f->irbuf[i].result] = i;
+   }
+
+   jit_reg_t *leader LOCAL = xmalloc_array(f->nregs, sizeof(jit_reg_t));
+   for (int i = 0; i < f->nregs; i++)
+      leader[i] = i;
+
+   const size_t tabsz = next_power_of_2(f->nirs * 2);
+   int *tab LOCAL = xmalloc_array(tabsz, sizeof(int));
+   for (int i = 0; i < tabsz; i++)
+      tab[i] = -1;
+
+   for (int i = 0; i < dom.nreach; i++) {
+      jit_block_t *bb = &(cfg->blocks[dom.rpo[i]]);
+      for (int j = bb->first; j <= bb->last; j++) {
+         jit_ir_t *ir = &(f->irbuf[j]);
+         gvn_rename(&(ir->arg1), leader);
+         gvn_rename(&(ir->arg2), leader);
+
+         if (!gvn_is_candidate(ir) || defs[ir->result] != 1)
+            continue;
+         else if (!gvn_available(&dom, ir->arg1, j, defs, defpos))
+            continue;
+         else if (!gvn_available(&dom, ir->arg2, j, defs, defpos))
+            continue;
+
+         int idx = gvn_hash(ir) & (tabsz - 1);
+         for (; tab[idx] != -1; idx = (idx + 1) & (tabsz - 1)) {
+            jit_ir_t *other = &(f->irbuf[tab[idx]]);
+            if (!gvn_same_expr(ir, other))
+               continue;
+            else if (!dom_dominates_ir(&dom, tab[idx], j))
+               continue;
+
+            leader[ir->result] = other->result;
+
+            ir->op        = J_MOV;
+            ir->size      = JIT_SZ_UNSPEC;
+            ir->arg1      = LVN_REG(other->result);
+            ir->arg2.kind = JIT_VALUE_INVALID;
+            break;
+         }
+
+         if (tab[idx] == -1)
+            tab[idx] = j;
+      }
+   }
+
+   dom_free(&dom);
+   jit_free_cfg(f);   // Liveness may have changed
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Loop invariant code motion
+
+#define LICM_MAX_ROUNDS 3
+
+typedef struct {
+   int          header;
+   unsigned     size;
+   bit_mask_t   blocks;
+   A(jit_ir_t)  preheader;
+} licm_loop_t;
+
+typedef A(licm_loop_t) licm_loop_list_t;
+
+typedef struct {
+   jit_func_t       *func;
+   jit_cfg_t        *cfg;
+   dom_info_t        dom;
+   int              *defs;
+   bit_mask_t        defined;
+   bit_mask_t        removed;
+   licm_loop_list_t  loops;
+} licm_state_t;
+
+static void licm_add_loop(licm_state_t *state, int header, int latch)
+{
+   int nth = 0;
+   for (; nth < state->loops.count; nth++) {
+      if (state->loops.items[nth].header == header)
+         break;
+   }
+
+   if (nth == state->loops.count) {
+      licm_loop_t new = { .header = header };
+      mask_init(&new.blocks, state->cfg->nblocks);
+      mask_set(&new.blocks, header);
+      APUSH(state->loops, new);
+   }
+
+   licm_loop_t *loop = &(state->loops.items[nth]);
+
+   // Add every block which can reach the latch without passing through
+   // the loop header
+   SCOPED_A(int) worklist = AINIT;
+   APUSH(worklist, latch);
+
+   while (worklist.count > 0) {
+      const int b = worklist.items[--worklist.count];
+      if (mask_test_and_set(&loop->blocks, b))
+         continue;
+
+      jit_edge_list_t *in = &(state->cfg->blocks[b].in);
+      for (int i = 0; i < in->count; i++)
+         APUSH(worklist, jit_get_edge(in, i));
+   }
+
+   loop->size = mask_popcount(&loop->blocks);
+}
+
+static void licm_find_loops(licm_state_t *state)
+{
+   for (int i = 0; i < state->dom.nreach; i++) {
+      const int b = state->dom.rpo[i];
+      jit_edge_list_t *out = &(state->cfg->blocks[b].out);
+      for (int j = 0; j < out->count; j++) {
+         const int succ = jit_get_edge(out, j);
+         if (dom_dominates(&state->dom, succ, b))
+            licm_add_loop(state, succ, b);
+      }
+   }
+}
+
+static int licm_loop_cmp(const void *a, const void *b)
+{
+   const licm_loop_t *la = a, *lb = b;
+   return (int)la->size - (int)lb->size;
+}
+
+static bool licm_is_pure(jit_ir_t *ir)
+{
+   if (ir->op == J_MOV)
+      return true;
+   else if (ir->op == J_DIV || ir->op == J_REM)
+      return false;   // May trap
+   else
+      return gvn_is_candidate(ir);
+}
+
+static bool licm_is_flag_op(jit_ir_t *ir)
+{
+   switch (ir->op) {
+   case J_CMP:
+   case J_FCMP:
+   case J_CCMP:
+   case J_FCCMP:
+   case J_CSEL:
+   case J_CSET:
+      return true;
+   default:
+      return false;
+   }
+}
+
+static bool licm_has_effects(jit_ir_t *ir)
+{
+   switch (ir->op) {
+   case J_STORE:
+   case J_CALL:
+   case J_RET:
+   case J_TRAP:
+   case MACRO_EXIT:
+   case MACRO_COPY:
+   case MACRO_MOVE:
+   case MACRO_BZERO:
+   case MACRO_MEMSET:
+   case MACRO_PUTPRIV:
+   case MACRO_TRIM:
+   case MACRO_REEXEC:
+   case MACRO_SADD:
+      return true;
+   default:
+      return false;
+   }
+}
+
+static bool licm_invariant(licm_state_t *state, jit_value_t value)
+{
+   switch (value.kind) {
+   case JIT_VALUE_REG:
+   case JIT_ADDR_REG:
+      return !mask_test(&state->defined, value.reg);
+   case JIT_VALUE_LABEL:
+      return false;
+   default:
+      return true;
+   }
+}
+
+static bool licm_preheader_has_effects(licm_state_t *state, int block)
+{
+   for (int i = 0; i < state->loops.count; i++) {
+      licm_loop_t *loop = &(state->loops.items[i]);
+      if (loop->header != block)
+         continue;
+
+      for (int j = 0; j < loop->preheader.count; j++) {
+         if (licm_has_effects(&(loop->preheader.items[j])))
+            return true;
+      }
+   }
+
+   return false;
+}
+
+static void licm_hoist_pure(licm_state_t *state, licm_loop_t *loop, int pos)
+{
+   jit_ir_t *ir = &(state->func->irbuf[pos]);
+   jit_block_t *header = &(state->cfg->blocks[loop->header]);
+
+   if (!licm_is_pure(ir) || state->defs[ir->result] != 1)
+      return;
+   else if (mask_test(&header->livein, ir->result))
+      return;   // Value from the previous iteration is used
+   else if (!licm_invariant(state, ir->arg1))
+      return;
+   else if (!licm_invariant(state, ir->arg2))
+      return;
+
+   jit_ir_t copy = *ir;
+   copy.target = 0;
+   APUSH(loop->preheader, copy);
+
+   mask_clear(&state->defined, ir->result);
+   lvn_convert_nop(ir);
+}
+
+static bool licm_first_iteration(licm_state_t *state, licm_loop_t *loop,
+                                 int block, int start)
+{
+   // True if the instruction at start is always executed on the first
+   // iteration of the loop before any instruction with side effects
+   jit_func_t *f = state->func;
+   jit_cfg_t *cfg = state->cfg;
+
+   for (int i = cfg->blocks[block].first; i < start; i++) {
+      if (licm_has_effects(&(f->irbuf[i])))
+         return false;
+   }
+
+   if (block == loop->header)
+      return true;
+   else if (licm_preheader_has_effects(state, block))
+      return false;
+
+   bit_mask_t visited;
+   mask_init(&visited, cfg->nblocks);
+
+   SCOPED_A(int) worklist = AINIT;
+   APUSH(worklist, loop->header);
+   mask_set(&visited, loop->header);
+
+   bool result = true;
+   while (result && worklist.count > 0) {
+      const int b = worklist.items[--worklist.count];
+      jit_block_t *bb = &(cfg->blocks[b]);
+
+      if (b != loop->header && licm_preheader_has_effects(state, b)) {
+         result = false;
+         break;
+      }
+
+      for (int i = bb->first; i <= bb->last; i++) {
+         if (licm_has_effects(&(f->irbuf[i]))) {
+            result = false;
+            break;
+         }
+      }
+
+      for (int i = 0; result && i < bb->out.count; i++) {
+         const int succ = jit_get_edge(&bb->out, i);
+         if (succ == block)
+            continue;
+         else if (succ == loop->header)
+            result = false;   // Next iteration without executing check
+         else if (!mask_test(&loop->blocks, succ)) {
+            // Can only leave through the failure path of a check which
+            // has already been moved out of the loop
+            result = mask_test(&state->removed, b) && succ == b + 1;
+         }
+         else if (dom_dominates(&state->dom, succ, b))
+            result = false;   // Inner loop may not terminate
+         else if (!mask_test_and_set(&visited, succ))
+            APUSH(worklist, succ);
+      }
+   }
+
+   mask_free(&visited);
+   return result;
+}
+
+static bool licm_fail_block(licm_state_t *state, jit_block_t *bb)
+{
+   for (int i = bb->first; i <= bb->last; i++) {
+      jit_ir_t *ir = &(state->func->irbuf[i]);
+      switch (ir->op) {
+      case J_NOP:
+      case J_DEBUG:
+         break;
+      case J_SEND:
+         if (!licm_invariant(state, ir->arg2))
+            return false;
+         break;
+      case MACRO_EXIT:
+         if (i != bb->last || !jit_will_abort(ir))
+            return false;
+         break;
+      default:
+         return false;
+      }
+   }
+
+   return true;
+}
+
+static void licm_hoist_check(licm_state_t *state, licm_loop_t *loop, int block)
+{
+   // Move a bounds or range check whose operands do not change inside
+   // the loop to the preheader if it would have been executed on the
+   // first iteration anyway
+
+   jit_func_t *f = state->func;
+   jit_cfg_t *cfg = state->cfg;
+   jit_block_t *bb = &(cfg->blocks[block]);
+   jit_block_t *header = &(cfg->blocks[loop->header]);
+   jit_ir_t *jump = &(f->irbuf[bb->last]);
+
+   if (jump->op != J_JUMP || jump->cc == JIT_CC_NONE)
+      return;
+   else if (block + 1 >= cfg->nblocks)
+      return;
+
+   jit_block_t *fail = bb + 1;
+   if (mask_test(&loop->blocks, block + 1) || !fail->aborts)
+      return;
+   else if (fail->in.count != 1)
+      return;
+   else if (mask_test(&bb->liveout, f->nregs))
+      return;   // Flags used after the branch
+   else if (mask_test(&header->livein, f->nregs))
+      return;
+
+   // Find the first instruction that computes the flags for the branch
+   int start = -1;
+   for (int i = bb->last - 1; i >= bb->first; i--) {
+      jit_ir_t *ir = &(f->irbuf[i]);
+      if (ir->op == J_NOP || ir->op == J_DEBUG)
+         continue;
+      else if (!licm_is_flag_op(ir) && !licm_is_pure(ir))
+         return;
+      else if (jit_writes_flags(ir) && !jit_reads_flags(ir)) {
+         start = i;
+         break;
+      }
+   }
+
+   if (start == -1)
+      return;
+   else if (jit_inline_at(f, start) != jit_inline_at(f, header->first))
+      return;   // Would lose the inlined frame in stack traces
+
+   SCOPED_A(jit_reg_t) killed = AINIT;
+   bool ok = true;
+
+   for (int i = start; ok && i < bb->last; i++) {
+      jit_ir_t *ir = &(f->irbuf[i]);
+      if (ir->op == J_NOP || ir->op == J_DEBUG)
+         continue;
+      else if (!licm_invariant(state, ir->arg1))
+         ok = false;
+      else if (!licm_invariant(state, ir->arg2))
+         ok = false;
+      else if (ir->result == JIT_REG_INVALID)
+         continue;
+      else if (state->defs[ir->result] != 1)
+         ok = false;
+      else if (mask_test(&header->livein, ir->result))
+         ok = false;
+      else {
+         mask_clear(&state->defined, ir->result);
+         APUSH(killed, ir->result);
+      }
+   }
+
+   ok = ok && licm_fail_block(state, fail)
+      && licm_first_iteration(state, loop, block, start);
+
+   if (!ok) {
+      for (int i = 0; i < killed.count; i++)
+         mask_set(&state->defined, killed.items[i]);
+      return;
+   }
+
+   // Keep the source location of the check for error messages
+   for (int i = start - 1; i >= bb->first; i--) {
+      jit_ir_t *ir = &(f->irbuf[i]);
+      if (ir->op == J_DEBUG) {
+         jit_ir_t copy = *ir;
+         copy.target = 0;
+         APUSH(loop->preheader, copy);
+         break;
+      }
+   }
+
+   for (int i = start; i < bb->last; i++) {
+      jit_ir_t *ir = &(f->irbuf[i]);
+      if (ir->op == J_NOP || ir->op == J_DEBUG)
+         continue;
+
+      jit_ir_t copy = *ir;
+      copy.target = 0;
+      APUSH(loop->preheader, copy);
+      lvn_convert_nop(ir);
+   }
+
+   const int branch = loop->preheader.count;
+
+   jit_ir_t copy = *jump;
+   copy.target = 0;
+   APUSH(loop->preheader, copy);
+
+   for (int i = fail->first; i <= fail->last; i++) {
+      jit_ir_t *ir = &(f->irbuf[i]);
+      if (ir->op == J_NOP)
+         continue;
+
+      jit_ir_t copy = *ir;
+      copy.target = 0;
+      APUSH(loop->preheader, copy);
+      lvn_convert_nop(ir);
+   }
+
+   // Labels in the preheader are relative to its first instruction
+   loop->preheader.items[branch].arg1.label = loop->preheader.count;
+
+   if (jump->arg1.label == fail->last + 1)
+      lvn_convert_nop(jump);
+   else
+      jump->cc = JIT_CC_NONE;
+
+   mask_set(&state->removed, block);
+}
+
+static void licm_hoist_loop(licm_state_t *state, licm_loop_t *loop)
+{
+   jit_func_t *f = state->func;
+   jit_cfg_t *cfg = state->cfg;
+
+   if (loop->header == 0 || mask_test(&loop->blocks, loop->header - 1))
+      return;   // Cannot insert a preheader before the loop
+
+   mask_clearall(&state->defined);
+
+   size_t b = -1;
+   while (mask_iter(&loop->blocks, &b)) {
+      jit_block_t *bb = &(cfg->blocks[b]);
+      for (int i = bb->first; i <= bb->last; i++) {
+         jit_ir_t *ir = &(f->irbuf[i]);
+         if (opt_defines_reg(ir))
+            mask_set(&state->defined, ir->result);
+      }
+   }
+
+   // Code already moved to the preheader of a nested loop will still
+   // be executed inside this loop
+   for (int i = 0; i < state->loops.count; i++) {
+      licm_loop_t *inner = &(state->loops.items[i]);
+      if (inner == loop || !mask_test(&loop->blocks, inner->header))
+         continue;
+
+      for (int j = 0; j < inner->preheader.count; j++) {
+         jit_ir_t *ir = &(inner->preheader.items[j]);
+         if (opt_defines_reg(ir))
+            mask_set(&state->defined, ir->result);
+      }
+   }
+
+   for (int i = 0; i < state->dom.nreach; i++) {
+      const int b = state->dom.rpo[i];
+      if (!mask_test(&loop->blocks, b))
+         continue;
+
+      jit_block_t *bb = &(cfg->blocks[b]);
+      for (int j = bb->first; j <= bb->last; j++)
+         licm_hoist_pure(state, loop, j);
+
+      licm_hoist_check(state, loop, b);
+   }
+}
+
+static void licm_relabel(licm_state_t *state, jit_value_t *value, int from,
+                         const int *inserted, const int *prestart,
+                         const jit_label_t *map)
+{
+   if (value->kind != JIT_VALUE_LABEL)
+      return;
+
+   const int nth = inserted[value->label];
+   if (nth == -1)
+      value->label = map[value->label];
+   else {
+      // Only jumps from outside the loop enter through the preheader
+      licm_loop_t *loop = &(state->loops.items[nth]);
+      const int block = jit_block_for(state->cfg, from) - state->cfg->blocks;
+      if (mask_test(&loop->blocks, block))
+         value->label = map[value->label];
+      else
+         value->label = prestart[nth];
+   }
+}
+
+static bool licm_rebuild(licm_state_t *state)
+{
+   jit_func_t *f = state->func;
+
+   int *inserted LOCAL = xmalloc_array(f->nirs, sizeof(int));
+   for (int i = 0; i < f->nirs; i++)
+      inserted[i] = -1;
+
+   unsigned newnirs = f->nirs;
+   for (int i = 0; i < state->loops.count; i++) {
+      licm_loop_t *loop = &(state->loops.items[i]);
+      if (loop->preheader.count > 0) {
+         inserted[state->cfg->blocks[loop->header].first] = i;
+         newnirs += loop->preheader.count;
+      }
+   }
+
+   if (newnirs == f->nirs)
+      return false;
+
+   jit_label_t *map LOCAL = xmalloc_array(f->nirs, sizeof(jit_label_t));
+   int *prestart LOCAL = xmalloc_array(state->loops.count, sizeof(int));
+
+   for (int i = 0, wptr = 0; i < f->nirs; i++) {
+      if (inserted[i] != -1) {
+         prestart[inserted[i]] = wptr;
+         wptr += state->loops.items[inserted[i]].preheader.count;
+      }
+      map[i] = wptr++;
+   }
+
+   jit_ir_t *irbuf = xcalloc_array(newnirs, sizeof(jit_ir_t));
+
+   for (int i = 0; i < f->nirs; i++) {
+      if (inserted[i] != -1) {
+         licm_loop_t *loop = &(state->loops.items[inserted[i]]);
+         const int base = prestart[inserted[i]];
+         for (int j = 0; j < loop->preheader.count; j++) {
+            jit_ir_t *ir = &(irbuf[base + j]);
+            *ir = loop->preheader.items[j];
+            if (ir->arg1.kind == JIT_VALUE_LABEL)
+               ir->arg1.label += base;
+         }
+      }
+
+      jit_ir_t *ir = &(irbuf[map[i]]);
+      *ir = f->irbuf[i];
+
+      licm_relabel(state, &(ir->arg1), i, inserted, prestart, map);
+      licm_relabel(state, &(ir->arg2), i, inserted, prestart, map);
+   }
+
+   for (jit_ir_t *ir = irbuf; ir < irbuf + newnirs; ir++) {
+      if (ir->arg1.kind == JIT_VALUE_LABEL)
+         irbuf[ir->arg1.label].target = 1;
+      if (ir->arg2.kind == JIT_VALUE_LABEL)
+         irbuf[ir->arg2.label].target = 1;
+   }
+
+   for (int i = 0; i < f->ninlines; i++) {
+      jit_inline_t *in = &(f->inlines[i]);
+      if (inserted[in->first] != -1)
+         in->first = prestart[inserted[in->first]];
+      else
+         in->first = map[in->first];
+      in->last = map[in->last];
+   }
+
+   free(f->irbuf);
+   f->irbuf = irbuf;
+   f->nirs  = newnirs;
+
+   return true;
+}
+
+static bool licm_round(jit_func_t *f)
+{
+   licm_state_t state = {
+      .func = f,
+      .cfg  = jit_get_cfg(f),
+   };
+
+   dom_init(&state.dom, state.cfg);
+   licm_find_loops(&state);
+
+   bool changed = false;
+   if (state.loops.count > 0) {
+      // Visit inner loops first
+      qsort(state.loops.items, state.loops.count, sizeof(licm_loop_t),
+            licm_loop_cmp);
+
+      state.defs = opt_count_defs(f);
+      mask_init(&state.defined, f->nregs + 1);
+      mask_init(&state.removed, state.cfg->nblocks);
+
+      for (int i = 0; i < state.loops.count; i++)
+         licm_hoist_loop(&state, &(state.loops.items[i]));
+
+      changed = licm_rebuild(&state);
+
+      free(state.defs);
+      mask_free(&state.defined);
+      mask_free(&state.removed);
+   }
+
+   for (int i = 0; i < state.loops.count; i++) {
+      mask_free(&(state.loops.items[i].blocks));
+      ACLEAR(state.loops.items[i].preheader);
+   }
+   ACLEAR(state.loops);
+
+   dom_free(&state.dom);
+   jit_free_cfg(f);
+
+   return changed;
+}
+
+void jit_do_licm(jit_func_t *f)
+{
+   // Each round can move code out of one more level of nested loops
+   for (int round = 0; round < LICM_MAX_ROUNDS; round++) {
+      if (!licm_round(f))
+         break;
+   }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Bounds check elimination
+
+typedef struct {
+   int64_t low;
+   int64_t high;
+} bce_range_t;
+
+typedef struct {
+   jit_value_t lhs;
+   jit_cc_t    cc;
+   jit_value_t rhs;
+} bce_fact_t;
+
+typedef struct {
+   jit_reg_t   reg;
+   bce_range_t range;
+} bce_undo_t;
+
+typedef struct {
+   int        count;
+   bool       negate;
+   bce_fact_t terms[2];
+} bce_cond_t;
+
+typedef struct {
+   int block;
+   int next;
+   int undo;
+   int facts;
+} bce_frame_t;
+
+typedef struct {
+   jit_func_t      *func;
+   jit_cfg_t       *cfg;
+   dom_info_t       dom;
+   int             *defs;
+   bce_range_t     *ranges;
+   bce_range_t     *base;
+   A(bce_undo_t)    undo;
+   A(bce_fact_t)    facts;
+   int              removed;
+} bce_state_t;
+
+static const bce_range_t bce_full = { INT64_MIN, INT64_MAX };
+
+static bool bce_same_value(jit_value_t a, jit_value_t b)
+{
+   if (a.kind != b.kind)
+      return false;
+   else if (a.kind == JIT_VALUE_REG)
+      return a.reg == b.reg;
+   else if (a.kind == JIT_VALUE_INT64)
+      return a.int64 == b.int64;
+   else
+      return false;
+}
+
+static bool bce_tracked(bce_state_t *state, jit_value_t value)
+{
+   // Facts about a register are only valid everywhere it is used if it
+   // has a single definition
+   if (value.kind == JIT_VALUE_INT64)
+      return true;
+   else if (value.kind == JIT_VALUE_REG)
+      return state->defs[value.reg] == 1;
+   else
+      return false;
+}
+
+static bce_range_t bce_get_range(bce_state_t *state, jit_value_t value)
+{
+   switch (value.kind) {
+   case JIT_VALUE_INT64:
+      return (bce_range_t){ value.int64, value.int64 };
+   case JIT_VALUE_REG:
+      return state->ranges[value.reg];
+   default:
+      return bce_full;
+   }
+}
+
+static void bce_set_range(bce_state_t *state, jit_reg_t reg, bce_range_t r)
+{
+   const bce_undo_t undo = { reg, state->ranges[reg] };
+   APUSH(state->undo, undo);
+
+   state->ranges[reg] = r;
+}
+
+static void bce_narrow(bce_state_t *state, jit_value_t value, int64_t low,
+                       int64_t high)
+{
+   // Registers with multiple definitions may also be narrowed but the
+   // range only holds until the next definition or control flow merge
+   if (value.kind != JIT_VALUE_REG)
+      return;
+
+   const bce_range_t r = state->ranges[value.reg];
+   if (low <= r.low && high >= r.high)
+      return;
+
+   const bce_range_t new = { MAX(r.low, low), MIN(r.high, high) };
+   bce_set_range(state, value.reg, new);
+}
+
+static void bce_kill_local(bce_state_t *state)
+{
+   for (int i = 0; i < state->undo.count; i++) {
+      const jit_reg_t reg = state->undo.items[i].reg;
+      if (state->defs[reg] == 1)
+         continue;
+
+      const bce_range_t r = state->ranges[reg], b = state->base[reg];
+      if (r.low != b.low || r.high != b.high)
+         bce_set_range(state, reg, b);
+   }
+}
+
+static void bce_add_fact(bce_state_t *state, jit_value_t lhs, jit_cc_t cc,
+                         jit_value_t rhs)
+{
+   const bce_range_t rl = bce_get_range(state, lhs);
+   const bce_range_t rr = bce_get_range(state, rhs);
+
+   switch (cc) {
+   case JIT_CC_EQ:
+      bce_narrow(state, lhs, rr.low, rr.high);
+      bce_narrow(state, rhs, rl.low, rl.high);
+      break;
+   case JIT_CC_LT:
+      if (rr.high > INT64_MIN)
+         bce_narrow(state, lhs, INT64_MIN, rr.high - 1);
+      if (rl.low < INT64_MAX)
+         bce_narrow(state, rhs, rl.low + 1, INT64_MAX);
+      cc = JIT_CC_LE;
+      break;
+   case JIT_CC_LE:
+      bce_narrow(state, lhs, INT64_MIN, rr.high);
+      bce_narrow(state, rhs, rl.low, INT64_MAX);
+      break;
+   case JIT_CC_GT:
+      if (rr.low < INT64_MAX)
+         bce_narrow(state, lhs, rr.low + 1, INT64_MAX);
+      if (rl.high > INT64_MIN)
+         bce_narrow(state, rhs, INT64_MIN, rl.high - 1);
+      cc = JIT_CC_GE;
+      break;
+   case JIT_CC_GE:
+      bce_narrow(state, lhs, rr.low, INT64_MAX);
+      bce_narrow(state, rhs, INT64_MIN, rl.high);
+      break;
+   default:
+      return;
+   }
+
+   if (!bce_tracked(state, lhs) || !bce_tracked(state, rhs))
+      return;
+   else if (lhs.kind == JIT_VALUE_INT64 && rhs.kind == JIT_VALUE_INT64)
+      return;
+
+   const bce_fact_t fact = { lhs, cc, rhs };
+   APUSH(state->facts, fact);
+}
+
+static bool bce_proves(bce_state_t *state, jit_value_t lhs, jit_cc_t cc,
+                       jit_value_t rhs)
+{
+   const bce_range_t rl = bce_get_range(state, lhs);
+   const bce_range_t rr = bce_get_range(state, rhs);
+
+   switch (cc) {
+   case JIT_CC_GE:
+      if (rl.low >= rr.high)
+         return true;
+      break;
+   case JIT_CC_LE:
+      if (rl.high <= rr.low)
+         return true;
+      break;
+   case JIT_CC_EQ:
+      if (rl.low == rl.high && rr.low == rr.high && rl.low == rr.low)
+         return true;
+      break;
+   default:
+      return false;
+   }
+
+   if (!bce_tracked(state, lhs) || !bce_tracked(state, rhs))
+      return false;
+
+   // Look for a dominating comparison with the same operands or with a
+   // bound which is at least as tight
+   for (int i = state->facts.count - 1; i >= 0; i--) {
+      const bce_fact_t *f = &(state->facts.items[i]);
+
+      jit_value_t other;
+      jit_cc_t fcc = f->cc;
+      if (bce_same_value(f->lhs, lhs))
+         other = f->rhs;
+      else if (bce_same_value(f->rhs, lhs)) {
+         other = f->lhs;
+         if (fcc == JIT_CC_GE)
+            fcc = JIT_CC_LE;
+         else if (fcc == JIT_CC_LE)
+            fcc = JIT_CC_GE;
+      }
+      else
+         continue;
+
+      if (bce_same_value(other, rhs)) {
+         if (fcc == cc || fcc == JIT_CC_EQ)
+            return true;
+      }
+      else if (cc == JIT_CC_EQ)
+         continue;
+      else if (fcc != cc && fcc != JIT_CC_EQ)
+         continue;
+      else {
+         const bce_range_t ro = bce_get_range(state, other);
+         if (cc == JIT_CC_GE && ro.low >= rr.high)
+            return true;
+         else if (cc == JIT_CC_LE && ro.high <= rr.low)
+            return true;
+      }
+   }
+
+   return false;
+}
+
+static bool bce_parse_cond(bce_state_t *state, jit_block_t *bb,
+                           bce_cond_t *cond)
+{
+   // Recognise the condition for a branch at the end of a block as
+   // generated for bounds checks and simple comparisons
+   jit_ir_t *jump = &(state->func->irbuf[bb->last]);
+   if (jump->op != J_JUMP)
+      return false;
+   else if (jump->cc != JIT_CC_T && jump->cc != JIT_CC_F)
+      return false;
+
+   cond->count = 0;
+   cond->negate = (jump->cc == JIT_CC_F);
+
+   for (int i = bb->last - 1; i >= bb->first; i--) {
+      jit_ir_t *ir = &(state->func->irbuf[i]);
+      if (ir->op == J_NOP || ir->op == J_DEBUG)
+         continue;
+      else if (ir->op != J_CMP && ir->op != J_CCMP)
+         return false;
+      else if (cond->count == 2)
+         return false;
+
+      bce_fact_t *term = &(cond->terms[cond->count++]);
+      term->lhs = ir->arg1;
+      term->cc  = ir->cc;
+      term->rhs = ir->arg2;
+
+      if (ir->op == J_CMP)
+         return !cond->negate || cond->count == 1;
+   }
+
+   return false;
+}
+
+static jit_cc_t bce_negate_cc(jit_cc_t cc)
+{
+   switch (cc) {
+   case JIT_CC_EQ: return JIT_CC_NE;
+   case JIT_CC_NE: return JIT_CC_EQ;
+   case JIT_CC_LT: return JIT_CC_GE;
+   case JIT_CC_GE: return JIT_CC_LT;
+   case JIT_CC_GT: return JIT_CC_LE;
+   case JIT_CC_LE: return JIT_CC_GT;
+   default: return JIT_CC_NONE;
+   }
+}
+
+static void bce_edge_facts(bce_state_t *state, int block)
+{
+   // Facts from a conditional branch hold in a block whose only
+   // predecessor is that branch
+   jit_block_t *bb = &(state->cfg->blocks[block]);
+   if (bb->in.count != 1)
+      return;
+
+   const int pred = jit_get_edge(&bb->in, 0);
+   jit_block_t *pb = &(state->cfg->blocks[pred]);
+
+   bce_cond_t cond;
+   if (!bce_parse_cond(state, pb, &cond))
+      return;
+
+   jit_ir_t *jump = &(state->func->irbuf[pb->last]);
+   const bool is_target = jump->arg1.label == bb->first;
+   const bool is_next = (block == pred + 1);
+
+   if (is_target == is_next)
+      return;
+
+   if (is_target != cond.negate) {
+      for (int i = 0; i < cond.count; i++)
+         bce_add_fact(state, cond.terms[i].lhs, cond.terms[i].cc,
+                      cond.terms[i].rhs);
+   }
+   else if (cond.count == 1)
+      bce_add_fact(state, cond.terms[0].lhs,
+                   bce_negate_cc(cond.terms[0].cc), cond.terms[0].rhs);
+}
+
+static bool bce_check_fails(bce_state_t *state, jit_block_t *fail)
+{
+   if (fail->in.count != 1 || !fail->aborts)
+      return false;
+
+   for (int i = fail->first; i <= fail->last; i++) {
+      jit_ir_t *ir = &(state->func->irbuf[i]);
+      switch (ir->op) {
+      case J_NOP:
+      case J_DEBUG:
+      case J_SEND:
+         break;
+      case MACRO_EXIT:
+         if (i != fail->last)
+            return false;
+         switch (ir->arg1.exit) {
+         case JIT_EXIT_INDEX_FAIL:
+         case JIT_EXIT_RANGE_FAIL:
+         case JIT_EXIT_LENGTH_FAIL:
+            break;
+         default:
+            return false;
+         }
+         break;
+      default:
+         return false;
+      }
+   }
+
+   return true;
+}
+
+static void bce_visit_check(bce_state_t *state, int block)
+{
+   jit_func_t *f = state->func;
+   jit_block_t *bb = &(state->cfg->blocks[block]);
+
+   if (block + 1 >= state->cfg->nblocks)
+      return;
+
+   jit_block_t *fail = bb + 1;
+   jit_ir_t *jump = &(f->irbuf[bb->last]);
+
+   bce_cond_t cond;
+   if (!bce_parse_cond(state, bb, &cond) || cond.negate)
+      return;
+   else if (jump->arg1.label == fail->first)
+      return;
+   else if (!bce_check_fails(state, fail))
+      return;
+
+   bool redundant = !mask_test(&bb->liveout, f->nregs);
+   for (int i = 0; redundant && i < cond.count; i++)
+      redundant = bce_proves(state, cond.terms[i].lhs, cond.terms[i].cc,
+                             cond.terms[i].rhs);
+
+   // Every block dominated by this one is only reached if the check
+   // passes
+   for (int i = 0; i < cond.count; i++)
+      bce_add_fact(state, cond.terms[i].lhs, cond.terms[i].cc,
+                   cond.terms[i].rhs);
+
+   if (!redundant)
+      return;
+
+   for (int i = bb->last - 1, nterms = 0; nterms < cond.count; i--) {
+      jit_ir_t *ir = &(f->irbuf[i]);
+      if (ir->op == J_CMP || ir->op == J_CCMP) {
+         lvn_convert_nop(ir);
+         nterms++;
+      }
+   }
+
+   if (jump->arg1.label == fail->last + 1)
+      lvn_convert_nop(jump);
+   else
+      jump->cc = JIT_CC_NONE;
+
+   for (int i = fail->first; i <= fail->last; i++)
+      lvn_convert_nop(&(f->irbuf[i]));
+
+   state->removed++;
+}
+
+static bce_range_t bce_range_add(bce_range_t a, bce_range_t b)
+{
+   bce_range_t r;
+   if (__builtin_add_overflow(a.low, b.low, &r.low)
+       || __builtin_add_overflow(a.high, b.high, &r.high))
+      return bce_full;
+   else
+      return r;
+}
+
+static bce_range_t bce_range_sub(bce_range_t a, bce_range_t b)
+{
+   bce_range_t r;
+   if (__builtin_sub_overflow(a.low, b.high, &r.low)
+       || __builtin_sub_overflow(a.high, b.low, &r.high))
+      return bce_full;
+   else
+      return r;
+}
+
+static bce_range_t bce_range_mul(bce_range_t a, bce_range_t b)
+{
+   int64_t p[4];
+   if (__builtin_mul_overflow(a.low, b.low, &p[0])
+       || __builtin_mul_overflow(a.low, b.high, &p[1])
+       || __builtin_mul_overflow(a.high, b.low, &p[2])
+       || __builtin_mul_overflow(a.high, b.high, &p[3]))
+      return bce_full;
+
+   bce_range_t r = { p[0], p[0] };
+   for (int i = 1; i < 4; i++) {
+      r.low = MIN(r.low, p[i]);
+      r.high = MAX(r.high, p[i]);
+   }
+
+   return r;
+}
+
+static bce_range_t bce_eval(bce_state_t *state, jit_ir_t *ir)
+{
+   if (ir->size != JIT_SZ_UNSPEC && ir->size != JIT_SZ_64)
+      return bce_full;   // May wrap at a smaller width
+   else if (ir->cc != JIT_CC_NONE && ir->op != J_CSET)
+      return bce_full;
+
+   const bce_range_t a = bce_get_range(state, ir->arg1);
+   const bce_range_t b = bce_get_range(state, ir->arg2);
+
+   switch (ir->op) {
+   case J_MOV:
+      return a;
+   case J_ADD:
+      return bce_range_add(a, b);
+   case J_SUB:
+      return bce_range_sub(a, b);
+   case J_MUL:
+      return bce_range_mul(a, b);
+   case J_NEG:
+      if (a.low == INT64_MIN)
+         return bce_full;
+      return (bce_range_t){ -a.high, -a.low };
+   case J_AND:
+      if (a.low >= 0 && b.low >= 0)
+         return (bce_range_t){ 0, MIN(a.high, b.high) };
+      else if (a.low >= 0)
+         return (bce_range_t){ 0, a.high };
+      else if (b.low >= 0)
+         return (bce_range_t){ 0, b.high };
+      else
+         return bce_full;
+   case J_REM:
+      if (a.low >= 0 && b.low > 0)
+         return (bce_range_t){ 0, MIN(a.high, b.high - 1) };
+      else
+         return bce_full;
+   case J_ASR:
+      if (b.low == b.high && b.low >= 0 && b.low < 64)
+         return (bce_range_t){ a.low >> b.low, a.high >> b.low };
+      else
+         return bce_full;
+   case J_CLAMP:
+      return (bce_range_t){ MAX(a.low, 0), MAX(a.high, 0) };
+   case J_CSET:
+      return (bce_range_t){ 0, 1 };
+   case J_CSEL:
+      return (bce_range_t){ MIN(a.low, b.low), MAX(a.high, b.high) };
+   default:
+      return bce_full;
+   }
+}
+
+static void bce_visit_block(bce_state_t *state, int block)
+{
+   jit_func_t *f = state->func;
+   jit_block_t *bb = &(state->cfg->blocks[block]);
+
+   if (bb->in.count != 1)
+      bce_kill_local(state);
+
+   bce_edge_facts(state, block);
+
+   for (int i = bb->first; i <= bb->last; i++) {
+      jit_ir_t *ir = &(f->irbuf[i]);
+      if (!opt_defines_reg(ir))
+         continue;
+      else if (state->defs[ir->result] == 1)
+         state->ranges[ir->result] = bce_eval(state, ir);
+      else {
+         const bce_range_t r = bce_eval(state, ir);
+         const bce_range_t b = state->base[ir->result];
+         const bce_range_t new = { MAX(r.low, b.low), MIN(r.high, b.high) };
+         bce_set_range(state, ir->result, new);
+      }
+   }
+
+   bce_visit_check(state, block);
+}
+
+static bool bce_equiv_at(jit_func_t *f, jit_reg_t reg, jit_value_t value,
+                         int pos, const int *defs)
+{
+   // True if value is the same as the current value of reg at pos,
+   // considering only the block containing pos
+   if (value.kind != JIT_VALUE_REG)
+      return false;
+   else if (value.reg == reg)
+      return true;
+   else if (defs[value.reg] != 1)
+      return false;
+
+   for (int i = pos - 1; i >= 0; i--) {
+      jit_ir_t *ir = &(f->irbuf[i]);
+      if (ir->result == value.reg && opt_defines_reg(ir))
+         return ir->op == J_MOV && ir->arg1.kind == JIT_VALUE_REG
+            && ir->arg1.reg == reg;
+      else if (ir->result == reg && opt_defines_reg(ir))
+         return false;
+      else if (ir->target || cfg_is_terminator(f, ir))
+         return false;
+   }
+
+   return false;
+}
+
+static bool bce_reaches_self(bce_state_t *state, int from, int region)
+{
+   // True if the block can be executed again without leaving the region
+   // dominated by the given block
+   jit_cfg_t *cfg = state->cfg;
+
+   bit_mask_t visited;
+   mask_init(&visited, cfg->nblocks);
+
+   SCOPED_A(int) worklist = AINIT;
+   APUSH(worklist, from);
+
+   bool result = false;
+   while (!result && worklist.count > 0) {
+      jit_block_t *bb = &(cfg->blocks[worklist.items[--worklist.count]]);
+      for (int i = 0; i < bb->out.count; i++) {
+         const int succ = jit_get_edge(&bb->out, i);
+         if (succ == from) {
+            result = true;
+            break;
+         }
+         else if (!dom_dominates(&state->dom, region, succ))
+            continue;
+         else if (!mask_test_and_set(&visited, succ))
+            APUSH(worklist, succ);
+      }
+   }
+
+   mask_free(&visited);
+   return result;
+}
+
+static bool bce_step_bound(bce_state_t *state, jit_reg_t reg, int pos,
+                           int step, int64_t *bound, bool *is_ne)
+{
+   // Find a guard which dominates an increment or decrement of an
+   // induction variable and limits the value before the step
+   jit_func_t *f = state->func;
+   jit_cfg_t *cfg = state->cfg;
+
+   const int sblock = jit_block_for(cfg, pos) - cfg->blocks;
+
+   // No other definition between the start of the block and the step
+   for (int i = cfg->blocks[sblock].first; i < pos; i++) {
+      if (f->irbuf[i].result == reg && opt_defines_reg(&(f->irbuf[i])))
+         return false;
+   }
+
+   for (int region = sblock; region != 0; region = state->dom.idom[region]) {
+      jit_block_t *rb = &(cfg->blocks[region]);
+      if (rb->in.count != 1)
+         continue;
+
+      const int guard = jit_get_edge(&rb->in, 0);
+      jit_block_t *gb = &(cfg->blocks[guard]);
+
+      bce_cond_t cond;
+      if (!bce_parse_cond(state, gb, &cond) || cond.count != 1)
+         continue;
+
+      jit_ir_t *jump = &(f->irbuf[gb->last]);
+      const bool is_target = jump->arg1.label == rb->first;
+      const bool is_next = (region == guard + 1);
+      if (is_target == is_next)
+         continue;
+
+      const int cmppos = jump - f->irbuf - 1;
+      const bce_fact_t *term = &(cond.terms[0]);
+      if (term->rhs.kind != JIT_VALUE_INT64)
+         continue;
+      else if (!bce_equiv_at(f, reg, term->lhs, cmppos, state->defs))
+         continue;
+
+      jit_cc_t cc = term->cc;
+      if (is_target == cond.negate)
+         cc = bce_negate_cc(cc);
+
+      // The register must not change between the guard and the step
+      for (int i = cmppos + 1; i <= gb->last; i++) {
+         if (f->irbuf[i].result == reg && opt_defines_reg(&(f->irbuf[i])))
+            return false;
+      }
+
+      for (int i = 0; i < cfg->nblocks; i++) {
+         if (i == sblock || !dom_dominates(&state->dom, region, i))
+            continue;
+
+         jit_block_t *bb = &(cfg->blocks[i]);
+         for (int j = bb->first; j <= bb->last; j++) {
+            if (f->irbuf[j].result == reg && opt_defines_reg(&(f->irbuf[j])))
+               return false;
+         }
+      }
+
+      if (bce_reaches_self(state, sblock, region))
+         return false;
+
+      const int64_t n = term->rhs.int64;
+      *is_ne = false;
+
+      if (step > 0) {
+         switch (cc) {
+         case JIT_CC_LT: *bound = n; return true;
+         case JIT_CC_LE: *bound = n + 1; return n < INT64_MAX;
+         case JIT_CC_NE: *bound = n; *is_ne = true; return true;
+         default: return false;
+         }
+      }
+      else {
+         switch (cc) {
+         case JIT_CC_GT: *bound = n; return true;
+         case JIT_CC_GE: *bound = n - 1; return n > INT64_MIN;
+         case JIT_CC_NE: *bound = n; *is_ne = true; return true;
+         default: return false;
+         }
+      }
+   }
+
+   return false;
+}
+
+static void bce_induction(bce_state_t *state, jit_reg_t reg)
+{
+   // Compute a range for a register which is initialised with constants
+   // and then only incremented or decremented by one when a dominating
+   // comparison shows it has not yet reached a constant limit
+   jit_func_t *f = state->func;
+
+   int64_t init_low = INT64_MAX, init_high = INT64_MIN;
+   int64_t limit = 0, ne_limit = 0;
+   int direction = 0;
+   bool have_ne = false, have_limit = false;
+
+   for (int i = 0; i < f->nirs; i++) {
+      jit_ir_t *ir = &(f->irbuf[i]);
+      if (ir->result != reg || !opt_defines_reg(ir))
+         continue;
+      else if (ir->op == J_MOV && ir->arg1.kind == JIT_VALUE_INT64) {
+         init_low = MIN(init_low, ir->arg1.int64);
+         init_high = MAX(init_high, ir->arg1.int64);
+         continue;
+      }
+      else if (ir->op != J_ADD && ir->op != J_SUB)
+         return;
+      else if (ir->cc != JIT_CC_NONE)
+         return;
+      else if (ir->size != JIT_SZ_UNSPEC && ir->size != JIT_SZ_64)
+         return;
+      else if (ir->arg2.kind != JIT_VALUE_INT64)
+         return;
+      else if (!bce_equiv_at(f, reg, ir->arg1, i, state->defs))
+         return;
+
+      int step = ir->arg2.int64;
+      if (ir->op == J_SUB)
+         step = -step;
+
+      if (step != 1 && step != -1)
+         return;
+      else if (direction != 0 && step != direction)
+         return;
+
+      direction = step;
+
+      int64_t bound;
+      bool is_ne;
+      if (!bce_step_bound(state, reg, i, step, &bound, &is_ne))
+         return;
+      else if (is_ne) {
+         if (have_ne && bound != ne_limit)
+            return;
+         ne_limit = bound;
+         have_ne = true;
+      }
+      else if (!have_limit || (step > 0 ? bound > limit : bound < limit)) {
+         limit = bound;
+         have_limit = true;
+      }
+   }
+
+   if (direction == 0 || init_low > init_high)
+      return;
+
+   if (direction > 0) {
+      int64_t high = have_limit ? MAX(init_high, limit) : init_high;
+      if (have_ne) {
+         if (high > ne_limit)
+            return;   // Might step past the limit
+         high = ne_limit;
+      }
+
+      state->base[reg] = (bce_range_t){ init_low, high };
+   }
+   else {
+      int64_t low = have_limit ? MIN(init_low, limit) : init_low;
+      if (have_ne) {
+         if (low < ne_limit)
+            return;
+         low = ne_limit;
+      }
+
+      state->base[reg] = (bce_range_t){ low, init_high };
+   }
+}
+
+int jit_do_bce(jit_func_t *f)
+{
+   // Remove bounds checks which can be proved to always pass using
+   // value ranges derived from constants, induction variables, and
+   // dominating comparisons
+
+   if (f->nregs == 0)
+      return 0;
+
+   bce_state_t state = {
+      .func   = f,
+      .cfg    = jit_get_cfg(f),
+      .defs   = opt_count_defs(f),
+      .ranges = xmalloc_array(f->nregs, sizeof(bce_range_t)),
+      .base   = xmalloc_array(f->nregs, sizeof(bce_range_t)),
+   };
+
+   dom_init(&state.dom, state.cfg);
+
+   for (int i = 0; i < f->nregs; i++)
+      state.base[i] = bce_full;
+
+   for (int i = 0; i < f->nregs; i++) {
+      if (state.defs[i] > 1)
+         bce_induction(&state, i);
+   }
+
+   memcpy(state.ranges, state.base, f->nregs * sizeof(bce_range_t));
+
+   // Visit blocks in a depth-first walk of the dominator tree so facts
+   // from a block are available in every block it dominates
+   const int nb = state.cfg->nblocks;
+   int *children LOCAL = xmalloc_array(nb, sizeof(int));
+   int *nchildren LOCAL = xcalloc_array(nb + 1, sizeof(int));
+
+   for (int i = 1; i < state.dom.nreach; i++)
+      nchildren[state.dom.idom[state.dom.rpo[i]] + 1]++;
+
+   for (int i = 1; i <= nb; i++)
+      nchildren[i] += nchildren[i - 1];
+
+   int *fill LOCAL = xmalloc_array(nb, sizeof(int));
+   memcpy(fill, nchildren, nb * sizeof(int));
+
+   for (int i = 1; i < state.dom.nreach; i++) {
+      const int b = state.dom.rpo[i];
+      children[fill[state.dom.idom[b]]++] = b;
+   }
+
+   SCOPED_A(bce_frame_t) stack = AINIT;
+
+   const bce_frame_t root = { 0, nchildren[0], 0, 0 };
+   APUSH(stack, root);
+   bce_visit_block(&state, 0);
+
+   while (stack.count > 0) {
+      bce_frame_t *top = &(stack.items[stack.count - 1]);
+      if (top->next < nchildren[top->block + 1]) {
+         const int child = children[top->next++];
+         const bce_frame_t frame = {
+            .block = child,
+            .next  = nchildren[child],
+            .undo  = state.undo.count,
+            .facts = state.facts.count,
+         };
+         APUSH(stack, frame);
+         bce_visit_block(&state, child);
+      }
+      else {
+         while (state.undo.count > top->undo) {
+            const bce_undo_t *u = &(state.undo.items[--state.undo.count]);
+            state.ranges[u->reg] = u->range;
+         }
+
+         state.facts.count = top->facts;
+         stack.count--;
+      }
+   }
+
+   ACLEAR(state.undo);
+   ACLEAR(state.facts);
+   free(state.defs);
+   free(state.ranges);
+   free(state.base);
+   dom_free(&state.dom);
+
+   jit_free_cfg(f);   // Branches may have been removed
+   return state.removed;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Dead code elimination
 
@@ -1123,7 +2880,7 @@ void jit_do_dce(jit_func_t *f)
 
 void jit_delete_nops(jit_func_t *f)
 {
-   jit_label_t *map LOCAL = xmalloc_array(f->nirs, sizeof(jit_label_t));
+   jit_label_t *map LOCAL = xmalloc_array(f->nirs + 1, sizeof(jit_label_t));
 
    int wptr = 0;
    for (jit_ir_t *ir = f->irbuf; ir < f->irbuf + f->nirs; ir++) {
@@ -1136,6 +2893,14 @@ void jit_delete_nops(jit_func_t *f)
       }
    }
 
+   map[f->nirs] = wptr;
+
+   for (int i = 0; i < f->ninlines; i++) {
+      jit_inline_t *in = &(f->inlines[i]);
+      in->first = map[in->first];
+      in->last  = map[in->last + 1] - 1;
+   }
+
    for (jit_ir_t *ir = f->irbuf; ir < f->irbuf + f->nirs; ir++) {
       if (ir->arg1.kind == JIT_VALUE_LABEL) {
          ir->arg1.label = map[ir->arg1.label];
@@ -1150,6 +2915,231 @@ void jit_delete_nops(jit_func_t *f)
    f->nirs = wptr;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Inlining of small subprograms
+
+#define INLINE_MAX_IRS   40
+#define INLINE_MAX_TOTAL 5000
+
+static bool inline_is_safe(jit_func_t *callee)
+{
+   if (callee->nvars > 0 || callee->nirs > INLINE_MAX_IRS)
+      return false;
+
+   for (int i = 0; i < callee->nirs; i++) {
+      const jit_ir_t *ir = &(callee->irbuf[i]);
+      switch (ir->op) {
+      case MACRO_TRIM:
+      case MACRO_REEXEC:
+         // Depends on having its own anchor
+         return false;
+      case MACRO_GETPRIV:
+      case MACRO_PUTPRIV:
+         // Package or instance initialisation
+         if (ir->arg1.handle == callee->handle)
+            return false;
+         break;
+      default:
+         break;
+      }
+   }
+
+   return true;
+}
+
+static jit_func_t *inline_callee(jit_func_t *f, const jit_ir_t *ir)
+{
+   if (ir->op != J_CALL)
+      return NULL;
+
+   jit_func_t *callee = jit_get_func(f->jit, ir->arg1.handle);
+   if (callee == f || jit_bind_intrinsic(callee->name) != NULL)
+      return NULL;
+   else if (!jit_try_fill_irbuf(callee, INLINE_MAX_IRS))
+      return NULL;
+   else if (!inline_is_safe(callee))
+      return NULL;
+
+   return callee;
+}
+
+static unsigned inline_cpool(jit_func_t *f, jit_func_t *callee)
+{
+   const unsigned base = ALIGN_UP(f->cpoolsz, 8);
+   if (callee->cpoolsz == 0)
+      return base;
+
+   const unsigned newsz = base + callee->cpoolsz;
+   if (f->owns_cpool)
+      f->cpool = xrealloc(f->cpool, newsz);
+   else {
+      unsigned char *cpool = xmalloc(newsz);
+      if (f->cpoolsz > 0)
+         memcpy(cpool, f->cpool, f->cpoolsz);
+      f->cpool = cpool;
+      f->owns_cpool = true;
+   }
+
+   memset(f->cpool + f->cpoolsz, '\0', base - f->cpoolsz);
+   memcpy(f->cpool + base, callee->cpool, callee->cpoolsz);
+   f->cpoolsz = newsz;
+
+   return base;
+}
+
+static void inline_rebase(jit_value_t *value, unsigned first,
+                          unsigned regbase, unsigned cpoolbase)
+{
+   switch (value->kind) {
+   case JIT_VALUE_REG:
+   case JIT_ADDR_REG:
+      value->reg += regbase;
+      break;
+   case JIT_ADDR_CPOOL:
+      value->int64 += cpoolbase;
+      break;
+   case JIT_VALUE_LABEL:
+      value->label += first;
+      break;
+   default:
+      break;
+   }
+}
+
+static void inline_body(jit_func_t *f, jit_func_t *callee, jit_ir_t *irbuf,
+                        unsigned first)
+{
+   const unsigned regbase = f->nregs;
+   const unsigned framebase = f->framesz;
+   const unsigned cpoolbase = inline_cpool(f, callee);
+   const unsigned cont = first + callee->nirs;
+
+   for (int i = 0; i < callee->nirs; i++) {
+      jit_ir_t *ir = &(irbuf[first + i]);
+      *ir = callee->irbuf[i];
+
+      if (ir->op == J_RET) {
+         // Return becomes a jump to the instruction after the call
+         ir->op = J_JUMP;
+         ir->arg1.kind = JIT_VALUE_LABEL;
+         ir->arg1.label = cont;
+         continue;
+      }
+
+      if (ir->result != JIT_REG_INVALID)
+         ir->result += regbase;
+
+      inline_rebase(&(ir->arg1), first, regbase, cpoolbase);
+      inline_rebase(&(ir->arg2), first, regbase, cpoolbase);
+
+      if (ir->op == MACRO_SALLOC)
+         ir->arg1.int64 += framebase;
+   }
+
+   f->nregs += callee->nregs;
+   f->framesz += callee->framesz;
+}
+
+void jit_do_inline(jit_func_t *f)
+{
+   // Replace calls to small functions with a copy of their body which
+   // also allows the caller's optimisation passes to see through the
+   // call.  The inline table records the original call stack for each
+   // inlined instruction so that any runtime errors in the callee can
+   // still be reported from the correct frame.
+
+   if (f->nirs > INLINE_MAX_TOTAL)
+      return;
+
+   jit_func_t **callees LOCAL = xcalloc_array(f->nirs, sizeof(jit_func_t *));
+
+   unsigned newnirs = f->nirs, newregs = f->nregs, ninlines = 0;
+   for (int i = 0; i < f->nirs; i++) {
+      jit_func_t *callee = inline_callee(f, &(f->irbuf[i]));
+      if (callee == NULL)
+         continue;
+      else if (newnirs + callee->nirs > INLINE_MAX_TOTAL)
+         break;
+      else if (newregs + callee->nregs >= JIT_REG_INVALID)
+         break;
+
+      callees[i] = callee;
+      newnirs += callee->nirs - 1;
+      newregs += callee->nregs;
+      ninlines += callee->ninlines + 1;
+   }
+
+   if (ninlines == 0)
+      return;
+
+   jit_label_t *map LOCAL = xmalloc_array(f->nirs, sizeof(jit_label_t));
+
+   for (int i = 0, wptr = 0; i < f->nirs; i++) {
+      map[i] = wptr;
+      wptr += callees[i] ? callees[i]->nirs : 1;
+   }
+
+   jit_ir_t *irbuf = xcalloc_array(newnirs, sizeof(jit_ir_t));
+   jit_inline_t *inlines = xcalloc_array(ninlines, sizeof(jit_inline_t));
+
+   int nextin = 0;
+   for (int i = 0; i < f->nirs; i++) {
+      jit_func_t *callee = callees[i];
+      if (callee == NULL) {
+         jit_ir_t *ir = &(irbuf[map[i]]);
+         *ir = f->irbuf[i];
+
+         if (ir->arg1.kind == JIT_VALUE_LABEL)
+            ir->arg1.label = map[ir->arg1.label];
+         if (ir->arg2.kind == JIT_VALUE_LABEL)
+            ir->arg2.label = map[ir->arg2.label];
+
+         continue;
+      }
+
+      const unsigned first = map[i];
+      inline_body(f, callee, irbuf, first);
+
+      if (f->irbuf[i].target)
+         irbuf[first].target = 1;
+
+      const int parent = nextin;
+      inlines[nextin++] = (jit_inline_t){
+         .handle = callee->handle,
+         .first  = first,
+         .last   = first + callee->nirs - 1,
+         .parent = -1,
+      };
+
+      for (int j = 0; j < callee->ninlines; j++) {
+         const jit_inline_t *in = &(callee->inlines[j]);
+         inlines[nextin++] = (jit_inline_t){
+            .handle = in->handle,
+            .first  = in->first + first,
+            .last   = in->last + first,
+            .parent = in->parent == -1 ? parent : parent + 1 + in->parent,
+         };
+      }
+   }
+
+   assert(nextin == ninlines);
+
+   for (jit_ir_t *ir = irbuf; ir < irbuf + newnirs; ir++) {
+      if (ir->arg1.kind == JIT_VALUE_LABEL)
+         irbuf[ir->arg1.label].target = 1;
+      if (ir->arg2.kind == JIT_VALUE_LABEL)
+         irbuf[ir->arg2.label].target = 1;
+   }
+
+   free(f->irbuf);
+   free(f->inlines);
+
+   f->irbuf    = irbuf;
+   f->nirs     = newnirs;
+   f->inlines  = inlines;
+   f->ninlines = ninlines;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Memory to register promotion
 
@@ -1252,6 +3242,8 @@ void jit_do_mem2reg(jit_func_t *f)
    if (replaced == 0)
       return;
 
+   // Inlined bodies may contain allocations after the first block so
+   // all of them must be moved when the frame shrinks
    int newsize = 0;
    for (int i = 0; i < f->nirs; i++) {
       jit_ir_t *ir = &(f->irbuf[i]);
@@ -1263,8 +3255,6 @@ void jit_do_mem2reg(jit_func_t *f)
          assert(ir->arg2.kind == JIT_VALUE_INT64);
          newsize += ALIGN_UP(ir->arg2.int64, 8);
       }
-      else if (cfg_is_terminator(f, ir))
-         break;
    }
 
    assert(newsize <= f->framesz);
@@ -1297,7 +3287,8 @@ static void lscan_walk_cfg(jit_func_t *f, jit_cfg_t *cfg, int bi,
 
    jit_block_t *b = &(cfg->blocks[bi]);
 
-   for (size_t bit = -1; mask_iter(&b->livein, &bit);)
+   // The last bit in the live sets is the flags register
+   for (size_t bit = -1; mask_iter(&b->livein, &bit) && bit < f->nregs;)
       lscan_grow_range(bit, li, b->first);
 
    for (int i = b->first; i <= b->last; i++) {
@@ -1313,7 +3304,7 @@ static void lscan_walk_cfg(jit_func_t *f, jit_cfg_t *cfg, int bi,
          lscan_grow_range(ir->arg2.reg, li, i);
    }
 
-   for (size_t bit = -1; mask_iter(&b->liveout, &bit); )
+   for (size_t bit = -1; mask_iter(&b->liveout, &bit) && bit < f->nregs; )
       lscan_grow_range(bit, li, b->last);
 
    for (int i = 0; i < b->out.count; i++) {
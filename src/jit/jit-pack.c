@@ -268,6 +268,15 @@ static void pack_func(pack_writer_t *pw, jit_t *j, jit_func_t *f)
       pack_value(pw, j, ir->arg1);
       pack_value(pw, j, ir->arg2);
    }
+
+   pack_uint(pw, f->ninlines);
+
+   for (int i = 0; i < f->ninlines; i++) {
+      pack_handle(pw, j, f->inlines[i].handle);
+      pack_uint(pw, f->inlines[i].first);
+      pack_uint(pw, f->inlines[i].last);
+      pack_int(pw, f->inlines[i].parent);
+   }
 }
 
 pack_writer_t *pack_writer_new(void)
@@ -596,6 +605,17 @@ bool jit_pack_fill(jit_pack_t *jp, jit_t *j, jit_func_t *f)
       ir->arg2 = unpack_value(pf, j);
    }
 
+   if ((f->ninlines = unpack_uint(pf)) > 0) {
+      f->inlines = xmalloc_array(f->ninlines, sizeof(jit_inline_t));
+
+      for (int i = 0; i < f->ninlines; i++) {
+         f->inlines[i].handle = unpack_handle(pf, j);
+         f->inlines[i].first  = unpack_uint(pf);
+         f->inlines[i].last   = unpack_uint(pf);
+         f->inlines[i].parent = unpack_int(pf);
+      }
+   }
+
    pf->rptr = NULL;
 
    store_release(&(f->state), JIT_FUNC_READY);
@@ -610,7 +630,7 @@ typedef struct {
    uint32_t strtab;
 } pack_header_t;
 
-#define PACK_MAGIC "JIT1"
+#define PACK_MAGIC "JIT2"
 
 static void write_fully(const void *buf, size_t size, FILE *f)
 {
@@ -643,6 +663,7 @@ static void write_children(jit_t *j, vcode_unit_t vu, pack_writer_t *pw,
    write_fully(bytes, cpool_nbytes, file);
 
    write_fully(buf, size, file);
+   free(buf);
 
    if (f->cpoolsz > 0)
       write_fully(f->cpool, f->cpoolsz, file);
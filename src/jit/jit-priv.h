@@ -172,6 +172,7 @@ typedef enum {
    JIT_EXIT_BIND_EXTERNAL,
    JIT_EXIT_SYSCALL,
    JIT_EXIT_PUT_CONVERSION,
+   JIT_EXIT_POINTER_MAP,
 } jit_exit_t;
 
 typedef uint16_t jit_reg_t;
@@ -234,6 +235,7 @@ STATIC_ASSERT(sizeof(jit_ir_t) <= 40);
 
 typedef struct _jit_tier jit_tier_t;
 typedef struct _jit_func jit_func_t;
+typedef struct _interp_insn interp_insn_t;
 typedef struct _jit_block jit_block_t;
 typedef struct _jit_anchor jit_anchor_t;
 
@@ -287,6 +289,24 @@ typedef struct {
    unsigned offset;
 } link_tab_t;
 
+typedef struct {
+   uint32_t hits;     // Number of times executed
+   uint32_t taken;    // Number of times a conditional branch was taken
+} jit_irprof_t;
+
+typedef struct {
+   uint32_t     calls;
+   jit_irprof_t irs[0];
+} jit_profile_t;
+
+// Instructions copied from another function by the inliner
+typedef struct {
+   jit_handle_t handle;    // Function the code was copied from
+   unsigned     first;     // First instruction of inlined body
+   unsigned     last;      // Last instruction of inlined body
+   int          parent;    // Enclosing inlined body or -1
+} jit_inline_t;
+
 typedef struct _jit_func {
    jit_entry_fn_t  entry;    // Must be first
    func_state_t    state;
@@ -302,11 +322,18 @@ typedef struct _jit_func {
    unsigned        nregs;
    unsigned        nvars;
    unsigned        cpoolsz;
+   unsigned        ninlines;
+   unsigned        mirsize;  // Lower bound on nirs before IR generated
    bool            owns_cpool;
    jit_handle_t    handle;
    unsigned        hotness;
    jit_tier_t     *next_tier;
+   jit_profile_t  *profile;
+   jit_entry_fn_t  osr_entry;
+   jit_entry_fn_t  body;     // VHDL body if entry is an intrinsic
+   jit_inline_t   *inlines;
    jit_cfg_t      *cfg;
+   interp_insn_t  *threaded;
    ffi_spec_t      spec;
    object_t       *object;
 } jit_func_t;
@@ -319,6 +346,17 @@ typedef struct _jit_anchor {
    uint32_t      watermark;
 } jit_anchor_t;
 
+#define JIT_OSR_IRPOS UINT32_MAX
+
+// Passed as the caller anchor to enter compiled code at a loop header
+// with the interpreter state: the code generator knows this layout
+typedef struct {
+   jit_anchor_t  anchor;
+   jit_scalar_t *regs;
+   uint32_t      target;
+   uint32_t      flags;
+} jit_osr_t;
+
 typedef enum {
    JIT_IDLE,
    JIT_RUNNING,
@@ -353,6 +391,7 @@ typedef struct {
    uint8_t      *wptr;
    ihash_t      *labels;
    patch_list_t *patches;
+   void         *descr;
    bool          overflow;
 } code_blob_t;
 
@@ -371,15 +410,22 @@ const char *jit_cc_name(jit_cc_t cc);
 const char *jit_exit_name(jit_exit_t exit);
 void jit_interp(jit_func_t *f, jit_anchor_t *caller, jit_scalar_t *args,
                 tlab_t *tlab);
+void jit_interp_body(jit_func_t *f, jit_anchor_t *caller, jit_scalar_t *args,
+                     tlab_t *tlab);
 jit_func_t *jit_get_func(jit_t *j, jit_handle_t handle);
 void jit_hexdump(const unsigned char *data, size_t sz, int blocksz,
                  const void *highlight, const char *prefix);
 void **jit_get_privdata_ptr(jit_t *j, jit_func_t *f);
+void jit_bind_relocs(jit_t *j, jit_handle_t handle, void *descr);
 void jit_tier_up(jit_func_t *f);
+void jit_set_entry(jit_func_t *f, jit_entry_fn_t entry);
+jit_profile_t *jit_get_profile(jit_func_t *f);
 jit_thread_local_t *jit_thread_local(void);
 void jit_fill_irbuf(jit_func_t *f);
+bool jit_try_fill_irbuf(jit_func_t *f, unsigned max_size);
 int32_t *jit_get_cover_ptr(jit_t *j, jit_value_t addr);
 jit_entry_fn_t jit_bind_intrinsic(ident_t name);
+int jit_inline_at(jit_func_t *f, unsigned pos);
 jit_thread_local_t *jit_attach_thread(jit_anchor_t *anchor);
 
 jit_cfg_t *jit_get_cfg(jit_func_t *f);
@@ -396,6 +442,10 @@ void jit_do_cprop(jit_func_t *f);
 void jit_do_dce(jit_func_t *f);
 void jit_delete_nops(jit_func_t *f);
 void jit_do_mem2reg(jit_func_t *f);
+void jit_do_inline(jit_func_t *f);
+void jit_do_gvn(jit_func_t *f);
+void jit_do_licm(jit_func_t *f);
+int jit_do_bce(jit_func_t *f);
 
 typedef unsigned phys_slot_t;
 #define INT_BASE   0
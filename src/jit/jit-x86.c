@@ -16,6 +16,7 @@
 //
 
 #include "util.h"
+#include "hash.h"
 #include "ident.h"
 #include "option.h"
 #include "jit/jit-priv.h"
@@ -38,6 +39,7 @@ typedef enum {
    TLAB_STUB,
    FEXP_STUB,
    ROUND_STUB,
+   TIER_STUB,
 
    NUM_STUBS
 } jit_x86_stub_t;
@@ -53,6 +55,8 @@ typedef struct {
 
 #define FRAME_FIXED_SIZE 80    // Size of fixed part of call frame
 #define ANCHOR_OFFSET    -24   // Offset of frame anchor from RBP
+#define IRPOS_OFFSET     -8    // Offset of anchor IR position from RBP
+#define SCRATCH_OFFSET   -56   // Offset of helper result slot from RBP
 
 ////////////////////////////////////////////////////////////////////////////////
 // X86 assembler
@@ -101,7 +105,8 @@ STATIC_ASSERT(sizeof(x86_operand_t) == 16);
    ((x86_operand_t){ X86_ADDR2, { .addr2 = { (r1).reg, (r2).reg, (o) }}})
 #define PATCH(n) ((x86_operand_t){ X86_PATCH, { .imm = (n) }})
 
-#define COMBINE(a, b) (((a).kind << 4) | (b).kind)
+#define X86_CLASS(x) ((x).kind == X86_ADDR2 ? X86_ADDR : (x).kind)
+#define COMBINE(a, b) ((X86_CLASS(a) << 4) | X86_CLASS(b))
 #define REG_REG ((X86_REG << 4) | X86_REG)
 #define MEM_REG ((X86_ADDR << 4) | X86_REG)
 #define MEM_IMM ((X86_ADDR << 4) | X86_IMM)
@@ -112,7 +117,6 @@ STATIC_ASSERT(sizeof(x86_operand_t) == 16);
 #define REG_XMM ((X86_REG << 4) | X86_XMM)
 #define XMM_REG ((X86_XMM << 4) | X86_REG)
 #define XMM_XMM ((X86_XMM << 4) | X86_XMM)
-#define REG_MEM2 ((X86_REG << 4) | X86_ADDR2)
 
 static const x86_operand_t __EAX = REG(0);
 static const x86_operand_t __ECX = REG(1);
@@ -126,12 +130,6 @@ static const x86_operand_t __R8  = REG(16);
 static const x86_operand_t __R9  = REG(17);
 static const x86_operand_t __R10 = REG(18);
 static const x86_operand_t __R11 = REG(19);
-#if 0
-static const x86_operand_t __R12 = REG(20);
-static const x86_operand_t __R13 = REG(21);
-static const x86_operand_t __R14 = REG(22);
-static const x86_operand_t __R15 = REG(23);
-#endif
 
 static const x86_operand_t __XMM0 = XMM(0);
 static const x86_operand_t __XMM1 = XMM(1);
@@ -165,6 +163,9 @@ typedef enum {
    X86_CMP_EQ = 0x04,
    X86_CMP_NE = 0x05,
    X86_CMP_BE = 0x06,
+   X86_CMP_A  = 0x07,
+   X86_CMP_P  = 0x0a,
+   X86_CMP_NP = 0x0b,
    X86_CMP_LE = 0x0e,
    X86_CMP_LT = 0x0c,
    X86_CMP_GE = 0x0d,
@@ -184,16 +185,16 @@ typedef enum {
 #define CLD() __(0xfc)
 #define PUSH(src) asm_push(blob, (src))
 #define POP(dst) asm_pop(blob, (dst))
-#define ADD(dst, src, size) asm_add(blob, (dst), (src), (size))
-#define SUB(dst, src, size) asm_sub(blob, (dst), (src), (size))
+#define ADD(dst, src, size) asm_alu(blob, X86_ALU_ADD, (dst), (src), (size))
+#define SUB(dst, src, size) asm_alu(blob, X86_ALU_SUB, (dst), (src), (size))
 #define MUL(src, size) asm_mul(blob, (src), (size))
 #define IMUL(dst, src, size) asm_imul(blob, (dst), (src), (size))
 #define IDIV(src, size) asm_idiv(blob, (src), (size))
-#define AND(dst, src, size) asm_and(blob, (dst), (src), (size))
-#define OR(dst, src, size) asm_or(blob, (dst), (src), (size))
-#define SHL(src, size) asm_shl(blob, (src), (size))
-#define SAR(src, count, size) asm_sar(blob, (src), (count), (size))
-#define XOR(dst, src, size) asm_xor(blob, (dst), (src), (size))
+#define AND(dst, src, size) asm_alu(blob, X86_ALU_AND, (dst), (src), (size))
+#define OR(dst, src, size) asm_alu(blob, X86_ALU_OR, (dst), (src), (size))
+#define XOR(dst, src, size) asm_alu(blob, X86_ALU_XOR, (dst), (src), (size))
+#define SHL(dst, count, size) asm_shift(blob, 4, (dst), (count), (size))
+#define SAR(dst, count, size) asm_shift(blob, 7, (dst), (count), (size))
 #define NEG(dst, size) asm_neg(blob, (dst), (size))
 #define MOV(dst, src, size) asm_mov(blob, (dst), (src), (size))
 #define MOVSX(dst, src, dsize, ssize) \
@@ -208,6 +209,8 @@ typedef enum {
    asm_cmovcc(blob, (dst), (src), (size), X86_CMP_GT)
 #define CMOVLT(dst, src, size)                          \
    asm_cmovcc(blob, (dst), (src), (size), X86_CMP_LT)
+#define CMOVC(dst, src, size)                           \
+   asm_cmovcc(blob, (dst), (src), (size), X86_CMP_C)
 #define LEA(dst, addr) asm_lea(blob, (dst), (addr))
 #define SETO(dst) asm_setcc(blob, (dst), X86_CMP_O)
 #define SETC(dst) asm_setcc(blob, (dst), X86_CMP_C)
@@ -221,15 +224,20 @@ typedef enum {
 #define SETAE(dst) asm_setcc(blob, (dst), 0x3)
 #define SETB(dst) asm_setcc(blob, (dst), 0x2)
 #define SETBE(dst) asm_setcc(blob, (dst), 0x6)
+#define SETP(dst) asm_setcc(blob, (dst), X86_CMP_P)
+#define SETNP(dst) asm_setcc(blob, (dst), X86_CMP_NP)
 #define TEST(src1, src2, size) asm_test(blob, (src1), (src2), (size))
-#define CMP(src1, src2, size) asm_cmp(blob, (src1), (src2), (size))
+#define CMP(src1, src2, size) \
+   asm_alu(blob, X86_ALU_CMP, (src1), (src2), (size))
 #define CALL(addr) asm_call(blob, (addr))
 #define JMP(addr) asm_jmp(blob, (addr))
+#define JCC(addr, cmp) asm_jcc(blob, (addr), (cmp))
 #define JZ(addr) asm_jcc(blob, (addr), X86_CMP_EQ)
 #define JNZ(addr) asm_jcc(blob, (addr), X86_CMP_NE)
 #define JLT(addr) asm_jcc(blob, (addr), X86_CMP_LT)
 #define JB(addr) asm_jcc(blob, (addr), X86_CMP_C)
 #define JBE(addr) asm_jcc(blob, (addr), X86_CMP_BE)
+#define JA(addr) asm_jcc(blob, (addr), X86_CMP_A)
 #define MULSD(dst, src) asm_mulsd(blob, (dst), (src))
 #define DIVSD(dst, src) asm_divsd(blob, (dst), (src))
 #define ADDSD(dst, src) asm_addsd(blob, (dst), (src))
@@ -350,72 +358,241 @@ static inline void x86_emit(code_blob_t *blob, const x86_insn_t *insn)
    code_blob_emit(blob, insn->bytes, insn->len);
 }
 
-static void asm_xor(code_blob_t *blob, x86_operand_t dst, x86_operand_t src,
-                    x86_size_t size)
+static void x86_rex_mem(x86_insn_t *insn, x86_size_t size, x86_reg_t reg,
+                        x86_operand_t mem)
+{
+   if (mem.kind == X86_ADDR2)
+      x86_rex(insn, size, reg, mem.addr2.reg1, mem.addr2.reg2);
+   else
+      x86_rex(insn, size, reg, mem.addr.reg, 0);
+}
+
+static void x86_modrm_mem(x86_insn_t *insn, int r, x86_operand_t mem)
+{
+   x86_reg_t base, index;
+   int32_t off;
+   if (mem.kind == X86_ADDR2) {
+      base  = mem.addr2.reg1;
+      index = mem.addr2.reg2;
+      off   = mem.addr2.off;
+      assert(index != __ESP.reg);   // Means no index
+   }
+   else {
+      assert(mem.kind == X86_ADDR);
+      base  = mem.addr.reg;
+      index = __ESP.reg;
+      off   = mem.addr.off;
+   }
+
+   // RBP and R13 as base always need a displacement and RSP and R12
+   // as base always need a SIB byte
+   int mod;
+   if (off == 0 && (base & 7) != __EBP.reg)
+      mod = 0;
+   else if (is_imm8(off))
+      mod = 1;
+   else
+      mod = 2;
+
+   if (mem.kind == X86_ADDR2 || (base & 7) == __ESP.reg) {
+      x86_modrm(insn, mod, r, 4);
+      x86_sib(insn, 0, index, base);
+   }
+   else
+      x86_modrm(insn, mod, r, base);
+
+   if (mod == 1)
+      x86_imm8(insn, off);
+   else if (mod == 2)
+      x86_imm32(insn, off);
+}
+
+static void x86_imm_sized(x86_insn_t *insn, int64_t imm, x86_size_t size)
+{
+   switch (size) {
+   case __BYTE:
+      insn->bytes[insn->len++] = imm & 0xff;
+      break;
+   case __WORD:
+      insn->bytes[insn->len++] = imm & 0xff;
+      insn->bytes[insn->len++] = (imm >> 8) & 0xff;
+      break;
+   default:
+      // Callers check the immediate fits in 32 bits
+      insn->bytes[insn->len++] = imm & 0xff;
+      insn->bytes[insn->len++] = (imm >> 8) & 0xff;
+      insn->bytes[insn->len++] = (imm >> 16) & 0xff;
+      insn->bytes[insn->len++] = (imm >> 24) & 0xff;
+      break;
+   }
+}
+
+typedef enum {
+   X86_ALU_ADD = 0,
+   X86_ALU_OR  = 1,
+   X86_ALU_AND = 4,
+   X86_ALU_SUB = 5,
+   X86_ALU_XOR = 6,
+   X86_ALU_CMP = 7,
+} x86_alu_t;
+
+static void asm_alu(code_blob_t *blob, x86_alu_t op, x86_operand_t dst,
+                    x86_operand_t src, x86_size_t size)
 {
    x86_insn_t insn = {};
 
-   assert(COMBINE(dst, src) == REG_REG);
-   x86_rex(&insn, size, dst.reg, src.reg, 0);
-   x86_opcode(&insn, 0x33);
-   x86_modrm(&insn, 3, dst.reg, src.reg);
+   x86_override(&insn, size == __WORD);
+
+   switch (COMBINE(dst, src)) {
+   case REG_REG:
+      x86_rex(&insn, size, src.reg, dst.reg, 0);
+      x86_opcode(&insn, (op << 3) | (size == __BYTE ? 0 : 1));
+      x86_modrm(&insn, 3, src.reg, dst.reg);
+      break;
+
+   case MEM_REG:
+      x86_rex_mem(&insn, size, src.reg, dst);
+      x86_opcode(&insn, (op << 3) | (size == __BYTE ? 0 : 1));
+      x86_modrm_mem(&insn, src.reg, dst);
+      break;
+
+   case REG_MEM:
+      x86_rex_mem(&insn, size, dst.reg, src);
+      x86_opcode(&insn, (op << 3) | (size == __BYTE ? 2 : 3));
+      x86_modrm_mem(&insn, dst.reg, src);
+      break;
+
+   case REG_IMM:
+   case MEM_IMM:
+      assert(is_imm32(src.imm));
+      if (dst.kind == X86_REG)
+         x86_rex(&insn, size, 0, dst.reg, 0);
+      else
+         x86_rex_mem(&insn, size, 0, dst);
+
+      if (size == __BYTE)
+         x86_opcode(&insn, 0x80);
+      else if (is_imm8(src.imm))
+         x86_opcode(&insn, 0x83);
+      else
+         x86_opcode(&insn, 0x81);
+
+      if (dst.kind == X86_REG)
+         x86_modrm(&insn, 3, op, dst.reg);
+      else
+         x86_modrm_mem(&insn, op, dst);
+
+      if (size == __BYTE || is_imm8(src.imm))
+         x86_imm_sized(&insn, src.imm, __BYTE);
+      else
+         x86_imm_sized(&insn, src.imm, size);
+      break;
+
+   default:
+      fatal_trace("invalid operand combination for ALU operation");
+   }
 
    x86_emit(blob, &insn);
 }
 
-static void asm_neg(code_blob_t *blob, x86_operand_t dst, x86_size_t size)
+static void asm_unary(code_blob_t *blob, int digit, x86_operand_t dst,
+                      x86_size_t size)
 {
+   // Group 3 instructions with a single register or memory operand
    x86_insn_t insn = {};
 
-   assert(dst.kind == X86_REG);
-   x86_rex(&insn, size, 0, dst.reg, 0);
-   x86_opcode(&insn, 0xf7);
-   x86_modrm(&insn, 3, 3, dst.reg);
+   x86_override(&insn, size == __WORD);
+
+   if (dst.kind == X86_REG) {
+      x86_rex(&insn, size, 0, dst.reg, 0);
+      x86_opcode(&insn, size == __BYTE ? 0xf6 : 0xf7);
+      x86_modrm(&insn, 3, digit, dst.reg);
+   }
+   else {
+      x86_rex_mem(&insn, size, 0, dst);
+      x86_opcode(&insn, size == __BYTE ? 0xf6 : 0xf7);
+      x86_modrm_mem(&insn, digit, dst);
+   }
 
    x86_emit(blob, &insn);
 }
 
-static void asm_lea(code_blob_t *blob, x86_operand_t dst, x86_operand_t src)
+static void asm_neg(code_blob_t *blob, x86_operand_t dst, x86_size_t size)
+{
+   asm_unary(blob, 3, dst, size);
+}
+
+static void asm_mul(code_blob_t *blob, x86_operand_t src, x86_size_t size)
 {
+   asm_unary(blob, 4, src, size);   // No immediate encoding
+}
+
+static void asm_idiv(code_blob_t *blob, x86_operand_t src, x86_size_t size)
+{
+   asm_unary(blob, 7, src, size);   // No immediate encoding
+}
+
+static void asm_imul(code_blob_t *blob, x86_operand_t dst, x86_operand_t src,
+                     x86_size_t size)
+{
+   if (size == __BYTE) {
+      // No two operand form: AX = AL * r/m8
+      assert(dst.kind == X86_REG && dst.reg == __EAX.reg);
+      asm_unary(blob, 5, src, size);
+      return;
+   }
+
    x86_insn_t insn = {};
 
+   x86_override(&insn, size == __WORD);
+
    switch (COMBINE(dst, src)) {
+   case REG_REG:
+      x86_rex(&insn, size, dst.reg, src.reg, 0);
+      x86_opcode_2(&insn, 0x0f, 0xaf);
+      x86_modrm(&insn, 3, dst.reg, src.reg);
+      break;
+
    case REG_MEM:
-      x86_rex(&insn, __QWORD, dst.reg, src.addr.reg, 0);
-      x86_opcode(&insn, 0x8d);
-      if (is_imm8(src.addr.off)) {
-         x86_modrm(&insn, 1, dst.reg, src.addr.reg);
-         x86_imm8(&insn, src.addr.off);
-      }
-      else {
-         x86_modrm(&insn, 2, dst.reg, src.addr.reg);
-         x86_imm32(&insn, src.addr.off);
-      }
+      x86_rex_mem(&insn, size, dst.reg, src);
+      x86_opcode_2(&insn, 0x0f, 0xaf);
+      x86_modrm_mem(&insn, dst.reg, src);
       break;
 
-   case REG_MEM2:
-      x86_rex(&insn, __QWORD, dst.reg, src.addr2.reg1, src.addr2.reg2);
-      x86_opcode(&insn, 0x8d);
-      if (src.addr2.off == 0) {
-         x86_modrm(&insn, 0, dst.reg, 4);
-         x86_sib(&insn, 0, src.addr2.reg2, src.addr2.reg1);
+   case REG_IMM:
+      assert(is_imm32(src.imm));
+      x86_rex(&insn, size, dst.reg, dst.reg, 0);
+      if (is_imm8(src.imm)) {
+         x86_opcode(&insn, 0x6b);
+         x86_modrm(&insn, 3, dst.reg, dst.reg);
+         x86_imm8(&insn, src.imm);
       }
-      else if (is_imm8(src.addr2.off)) {
-         x86_modrm(&insn, 1, dst.reg, 4);
-         x86_sib(&insn, 0, src.addr2.reg2, src.addr2.reg1);
-         x86_imm8(&insn, src.addr2.off);
+      else {
+         x86_opcode(&insn, 0x69);
+         x86_modrm(&insn, 3, dst.reg, dst.reg);
+         x86_imm_sized(&insn, src.imm, size);
       }
-      else
-         fatal_trace("immediate too big for LEA instruction");
       break;
 
    default:
-      fatal_trace("unhandled operand combination in asm_lea");
+      fatal_trace("invalid operand combination for IMUL");
    }
 
    x86_emit(blob, &insn);
 }
 
+static void asm_lea(code_blob_t *blob, x86_operand_t dst, x86_operand_t src)
+{
+   x86_insn_t insn = {};
+
+   assert(COMBINE(dst, src) == REG_MEM);
+   x86_rex_mem(&insn, __QWORD, dst.reg, src);
+   x86_opcode(&insn, 0x8d);
+   x86_modrm_mem(&insn, dst.reg, src);
+
+   x86_emit(blob, &insn);
+}
+
 static void asm_mov(code_blob_t *blob, x86_operand_t dst, x86_operand_t src,
                     x86_size_t size)
 {
@@ -423,69 +600,42 @@ static void asm_mov(code_blob_t *blob, x86_operand_t dst, x86_operand_t src,
 
    switch (COMBINE(dst, src)) {
    case REG_REG:
-      if (dst.reg != src.reg) {
+      if (dst.reg != src.reg || size == __DWORD) {
+         x86_override(&insn, size == __WORD);
          x86_rex(&insn, size, dst.reg, src.reg, 0);
-         x86_opcode(&insn, 0x8b);
+         x86_opcode(&insn, size == __BYTE ? 0x8a : 0x8b);
          x86_modrm(&insn, 3, dst.reg, src.reg);
       }
       break;
 
    case MEM_REG:
-      x86_rex(&insn, size, src.reg, dst.addr.reg, 0);
       x86_override(&insn, size == __WORD);
+      x86_rex_mem(&insn, size, src.reg, dst);
       x86_opcode(&insn, size == __BYTE ? 0x88 : 0x89);
-      if (is_imm8(dst.addr.off)) {
-         x86_modrm(&insn, 1, src.reg, dst.addr.reg);
-         x86_imm8(&insn, dst.addr.off);
-      }
-      else {
-         x86_modrm(&insn, 2, src.reg, dst.addr.reg);
-         x86_imm32(&insn, dst.addr.off);
-      }
+      x86_modrm_mem(&insn, src.reg, dst);
       break;
 
    case REG_MEM:
-      x86_rex(&insn, size, dst.reg, src.addr.reg, 0);
       x86_override(&insn, size == __WORD);
+      x86_rex_mem(&insn, size, dst.reg, src);
       x86_opcode(&insn, size == __BYTE ? 0x8a : 0x8b);
-      if (is_imm8(src.addr.off)) {
-         x86_modrm(&insn, 1, dst.reg, src.addr.reg);
-         x86_imm8(&insn, src.addr.off);
-      }
-      else {
-         x86_modrm(&insn, 2, dst.reg, src.addr.reg);
-         x86_imm32(&insn, src.addr.off);
-      }
+      x86_modrm_mem(&insn, dst.reg, src);
       break;
 
    case XMM_MEM:
       assert(size == __QWORD);
       x86_override(&insn, true);
-      x86_rex(&insn, size, dst.reg, src.addr.reg, 0);
+      x86_rex_mem(&insn, size, dst.reg, src);
       x86_opcode_2(&insn, 0x0f, 0x6e);
-      if (is_imm8(src.addr.off)) {
-         x86_modrm(&insn, 1, dst.reg, src.addr.reg);
-         x86_imm8(&insn, src.addr.off);
-      }
-      else {
-         x86_modrm(&insn, 2, dst.reg, src.addr.reg);
-         x86_imm32(&insn, src.addr.off);
-      }
+      x86_modrm_mem(&insn, dst.reg, src);
       break;
 
    case MEM_XMM:
       assert(size == __QWORD);
       x86_override(&insn, true);
-      x86_rex(&insn, size, src.addr.reg, dst.reg, 0);
+      x86_rex_mem(&insn, size, src.reg, dst);
       x86_opcode_2(&insn, 0x0f, 0x7e);
-      if (is_imm8(dst.addr.off)) {
-         x86_modrm(&insn, 1, src.reg, dst.addr.reg);
-         x86_imm8(&insn, dst.addr.off);
-      }
-      else {
-         x86_modrm(&insn, 2, src.reg, dst.addr.reg);
-         x86_imm32(&insn, dst.addr.off);
-      }
+      x86_modrm_mem(&insn, src.reg, dst);
       break;
 
    case XMM_REG:
@@ -504,393 +654,240 @@ static void asm_mov(code_blob_t *blob, x86_operand_t dst, x86_operand_t src,
       x86_modrm(&insn, 3, src.reg, dst.reg);
       break;
 
-   case REG_IMM:
-      if (src.imm == 0)
-         XOR(dst, dst, MIN(size, __DWORD));
-      else {
-         switch (size) {
-         case __QWORD:
-            if (is_imm32(src.imm)) {
-               if (src.imm > 0) {
-                  x86_rex(&insn, __DWORD, 0, dst.reg, 0);
-                  x86_opcode(&insn, 0xb8 + (dst.reg & 7));
-               }
-               else {
-                  x86_rex(&insn, __QWORD, 0, dst.reg, 0);
-                  x86_opcode(&insn, 0xc7);
-                  x86_modrm(&insn, 3, 0, dst.reg);
-               }
-               x86_imm32(&insn, src.imm);
-            }
-            else {
-               x86_rex(&insn, __QWORD, 0, dst.reg, 0);
-               x86_opcode(&insn, 0xb8 + (dst.reg & 7));
-               x86_imm64(&insn, src.imm);
-            }
-            break;
-         case __DWORD:
-            x86_rex(&insn, __DWORD, 0, dst.reg, 0);
-            x86_opcode(&insn, 0xb8 + (dst.reg & 7));
-            x86_imm32(&insn, src.imm);
-            break;
-         default:
-            fatal_trace("unhandled immediate size %d in asm_mov", size);
-         }
+   case XMM_XMM:
+      assert(size == __QWORD);
+      if (dst.reg != src.reg) {
+         x86_prefix(&insn, 0xf3);
+         x86_rex(&insn, __DWORD, dst.reg, src.reg, 0);
+         x86_opcode_2(&insn, 0x0f, 0x7e);
+         x86_modrm(&insn, 3, dst.reg, src.reg);
       }
       break;
 
-   case MEM_IMM:
+   case REG_IMM:
       switch (size) {
       case __QWORD:
-         assert(is_imm32(src.imm));
-         x86_rex(&insn, size, 0, dst.addr.reg, 0);
-         x86_opcode(&insn, 0xc7);
-         if (is_imm8(dst.addr.off)) {
-            x86_modrm(&insn, 1, 0, dst.addr.reg);
-            x86_imm8(&insn, dst.addr.off);
+         if (src.imm == 0)
+            XOR(dst, dst, __DWORD);   // Clears upper half but sets flags
+         else if (src.imm > 0 && src.imm <= UINT32_MAX) {
+            // Writing the 32-bit register clears the upper half
+            x86_rex(&insn, __DWORD, 0, dst.reg, 0);
+            x86_opcode(&insn, 0xb8 + (dst.reg & 7));
+            insn.bytes[insn.len++] = src.imm & 0xff;
+            insn.bytes[insn.len++] = (src.imm >> 8) & 0xff;
+            insn.bytes[insn.len++] = (src.imm >> 16) & 0xff;
+            insn.bytes[insn.len++] = (src.imm >> 24) & 0xff;
+         }
+         else if (is_imm32(src.imm)) {
+            x86_rex(&insn, __QWORD, 0, dst.reg, 0);
+            x86_opcode(&insn, 0xc7);
+            x86_modrm(&insn, 3, 0, dst.reg);
+            x86_imm32(&insn, src.imm);
          }
          else {
-            x86_modrm(&insn, 2, 0, dst.addr.reg);
-            x86_imm32(&insn, dst.addr.off);
+            x86_rex(&insn, __QWORD, 0, dst.reg, 0);
+            x86_opcode(&insn, 0xb8 + (dst.reg & 7));
+            x86_imm64(&insn, src.imm);
          }
-         x86_imm32(&insn, src.imm);
          break;
-      default:
-         fatal_trace("unhandled immediate size %d in asm_mov", size);
-      }
-      break;
-
-   default:
-      fatal_trace("unhandled operand combination in asm_mov");
-   }
-
-   x86_emit(blob, &insn);
-}
-
-static void asm_movsx(code_blob_t *blob, x86_operand_t dst, x86_operand_t src,
-                      x86_size_t dsize, x86_size_t ssize)
-{
-   x86_insn_t insn = {};
-
-   switch (COMBINE(dst, src)) {
-   case REG_REG:
-      x86_rex(&insn, dsize, src.reg, dst.reg, 0);
-      switch (ssize) {
+      case __DWORD:
+         if (src.imm == 0)
+            XOR(dst, dst, __DWORD);
+         else {
+            x86_rex(&insn, __DWORD, 0, dst.reg, 0);
+            x86_opcode(&insn, 0xb8 + (dst.reg & 7));
+            x86_imm_sized(&insn, src.imm, __DWORD);
+         }
+         break;
+      case __WORD:
+         x86_override(&insn, true);
+         x86_rex(&insn, __WORD, 0, dst.reg, 0);
+         x86_opcode(&insn, 0xb8 + (dst.reg & 7));
+         x86_imm_sized(&insn, src.imm, __WORD);
+         break;
       case __BYTE:
-         x86_opcode_2(&insn, 0x0f, 0xbe);
-         x86_modrm(&insn, 3, src.reg, dst.reg);
+         x86_rex(&insn, __BYTE, 0, dst.reg, 0);
+         x86_opcode(&insn, 0xb0 + (dst.reg & 7));
+         x86_imm_sized(&insn, src.imm, __BYTE);
          break;
-      default:
-         fatal_trace("unhandled source size %d in asm_movsx", ssize);
       }
       break;
 
-   case REG_MEM:
-      x86_rex(&insn, dsize, src.addr.reg, dst.reg, 0);
-      switch (ssize) {
-      case __QWORD: x86_opcode(&insn, 0x8b); break;
-      case __DWORD: x86_opcode(&insn, 0x63); break;
-      case __BYTE: x86_opcode_2(&insn, 0x0f, 0xbe); break;
-      default:
-         fatal_trace("unhandled source size %d in asm_movsx", ssize);
-      }
-      if (is_imm8(src.addr.off)) {
-         x86_modrm(&insn, 1, dst.reg, src.addr.reg);
-         x86_imm8(&insn, src.addr.off);
-      }
-      else {
-         x86_modrm(&insn, 2, dst.reg, src.addr.reg);
-         x86_imm32(&insn, src.addr.off);
-      }
+   case MEM_IMM:
+      assert(is_imm32(src.imm));
+      x86_override(&insn, size == __WORD);
+      x86_rex_mem(&insn, size, 0, dst);
+      x86_opcode(&insn, size == __BYTE ? 0xc6 : 0xc7);
+      x86_modrm_mem(&insn, 0, dst);
+      x86_imm_sized(&insn, src.imm, size);
       break;
 
    default:
-      fatal_trace("unhandled operand combination in asm_mov");
+      fatal_trace("invalid operand combination for MOV");
    }
 
    x86_emit(blob, &insn);
 }
 
-static void asm_movzx(code_blob_t *blob, x86_operand_t dst, x86_operand_t src,
+static void asm_movsx(code_blob_t *blob, x86_operand_t dst, x86_operand_t src,
                       x86_size_t dsize, x86_size_t ssize)
 {
-   x86_insn_t insn = {};
-
-   assert(COMBINE(dst, src) == REG_MEM);
-   x86_rex(&insn, ssize, dst.reg, src.addr.reg, 0);
-   switch (ssize) {
-   case __QWORD:
-   case __DWORD: x86_opcode(&insn, 0x8b); break;
-   case __WORD: x86_opcode_2(&insn, 0x0f, 0xb7); break;
-   case __BYTE: x86_opcode_2(&insn, 0x0f, 0xb6); break;
-   }
-   if (is_imm8(src.addr.off)) {
-      x86_modrm(&insn, 1, dst.reg, src.addr.reg);
-      x86_imm8(&insn, src.addr.off);
-   }
-   else {
-      x86_modrm(&insn, 2, dst.reg, src.addr.reg);
-      x86_imm32(&insn, src.addr.off);
-   }
-
-   x86_emit(blob, &insn);
-}
-
-static void asm_cmovcc(code_blob_t *blob, x86_operand_t dst, x86_operand_t src,
-                       x86_size_t size, x86_cmp_t cmp)
-{
-   x86_insn_t insn = {};
+   assert(dst.kind == X86_REG);
 
-   assert(COMBINE(dst, src) == REG_REG);
-   x86_rex(&insn, size, dst.reg, src.reg, 0);
-   switch (size) {
-   case __DWORD:
-   case __QWORD:
-      x86_opcode_2(&insn, 0x0f, 0x40 + cmp);
-      x86_modrm(&insn, 3, dst.reg, src.reg);
-      break;
-   default:
-      fatal_trace("unhandled size %d in asm_cmovcc", size);
+   if (ssize >= dsize) {
+      MOV(dst, src, dsize);
+      return;
    }
 
-   x86_emit(blob, &insn);
-}
-
-static void asm_push(code_blob_t *blob, x86_operand_t src)
-{
-   x86_insn_t insn = {};
-
-   x86_rex(&insn, __DWORD, 0, src.reg, 0);   // Actually pushes QWORD
-   x86_opcode(&insn, 0x50 + (src.reg & 7));
-
-   x86_emit(blob, &insn);
-}
-
-static void asm_pop(code_blob_t *blob, x86_operand_t dst)
-{
-   x86_insn_t insn = {};
-
-   x86_rex(&insn, __DWORD, 0, dst.reg, 0);   // Actually pops QWORD
-   x86_opcode(&insn, 0x58 + (dst.reg & 7));
-
-   x86_emit(blob, &insn);
-}
-
-static void asm_add(code_blob_t *blob, x86_operand_t dst, x86_operand_t src,
-                    x86_size_t size)
-{
    x86_insn_t insn = {};
 
-   x86_override(&insn, size == __WORD);
+   x86_override(&insn, dsize == __WORD);
 
-   switch (COMBINE(dst, src)) {
-   case REG_REG:
-      x86_rex(&insn, size, src.reg, dst.reg, 0);
-      x86_opcode(&insn, size == __BYTE ? 0x00 : 0x01);
-      x86_modrm(&insn, 3, src.reg, dst.reg);
-      break;
+   const int before = insn.len;
+   if (src.kind == X86_REG)
+      x86_rex(&insn, dsize, dst.reg, src.reg, 0);
+   else
+      x86_rex_mem(&insn, dsize, dst.reg, src);
 
-   case REG_IMM:
-      x86_rex(&insn, size, 0, dst.reg, 0);
-      if (size == __BYTE) {
-         x86_opcode(&insn, 0x80);
-         x86_modrm(&insn, 3, 0, dst.reg);
-         x86_imm8(&insn, src.imm);
-      }
-      else if (is_imm8(src.imm)) {
-         x86_opcode(&insn, 0x83);
-         x86_modrm(&insn, 3, 0, dst.reg);
-         x86_imm8(&insn, src.imm);
-      }
-      else {
-         x86_opcode(&insn, 0x81);
-         x86_modrm(&insn, 3, 0, dst.reg);
-         x86_imm32(&insn, src.imm);
-      }
-      break;
+   // A byte source in SPL, BPL, SIL or DIL needs a REX prefix
+   const bool need_rex = src.kind == X86_REG && ssize == __BYTE
+      && (src.reg & 7) >= 4;
+   if (need_rex && insn.len == before)
+      x86_prefix(&insn, 0x40);
 
-   default:
-      fatal_trace("unhandled operand combination in asm_sub");
+   switch (ssize) {
+   case __BYTE: x86_opcode_2(&insn, 0x0f, 0xbe); break;
+   case __WORD: x86_opcode_2(&insn, 0x0f, 0xbf); break;
+   default: x86_opcode(&insn, 0x63); break;
    }
 
+   if (src.kind == X86_REG)
+      x86_modrm(&insn, 3, dst.reg, src.reg);
+   else
+      x86_modrm_mem(&insn, dst.reg, src);
+
    x86_emit(blob, &insn);
 }
 
-static void asm_sub(code_blob_t *blob, x86_operand_t dst, x86_operand_t src,
-                    x86_size_t size)
+static void asm_movzx(code_blob_t *blob, x86_operand_t dst, x86_operand_t src,
+                      x86_size_t dsize, x86_size_t ssize)
 {
-   x86_insn_t insn = {};
-
-   x86_override(&insn, size == __WORD);
-
-   switch (COMBINE(dst, src)) {
-   case REG_REG:
-      x86_rex(&insn, size, src.reg, dst.reg, 0);
-      x86_opcode(&insn, size == __BYTE ? 0x28 : 0x29);
-      x86_modrm(&insn, 3, src.reg, dst.reg);
-      break;
-
-   case REG_IMM:
-      x86_rex(&insn, size, 0, dst.reg, 0);
-      if (size == __BYTE) {
-         x86_opcode(&insn, 0x80);
-         x86_modrm(&insn, 3, 5, dst.reg);
-         x86_imm8(&insn, src.imm);
-      }
-      else if (is_imm8(src.imm)) {
-         x86_opcode(&insn, 0x83);
-         x86_modrm(&insn, 3, 5, dst.reg);
-         x86_imm8(&insn, src.imm);
-      }
-      else {
-         x86_opcode(&insn, 0x81);
-         x86_modrm(&insn, 3, 5, dst.reg);
-         x86_imm32(&insn, src.imm);
-      }
-      break;
+   assert(dst.kind == X86_REG);
 
-   default:
-      fatal_trace("unhandled operand combination in asm_sub");
+   // Writing the 32-bit register clears the upper half
+   if (ssize >= __DWORD) {
+      MOV(dst, src, ssize);
+      return;
    }
 
-   x86_emit(blob, &insn);
-}
-
-static void asm_mul(code_blob_t *blob, x86_operand_t src, x86_size_t size)
-{
    x86_insn_t insn = {};
 
-   assert(src.kind == X86_REG);   // No immediate encoding
-   x86_override(&insn, size == __WORD || size == __BYTE);
-   x86_rex(&insn, size, 0, src.reg, 0);
-   x86_opcode(&insn, 0xf7);
-   x86_modrm(&insn, 3, 4, src.reg);
+   const x86_size_t opsize = dsize == __WORD ? __WORD : __DWORD;
+   x86_override(&insn, opsize == __WORD);
 
-   x86_emit(blob, &insn);
-}
+   if (src.kind == X86_REG)
+      x86_rex(&insn, ssize, dst.reg, src.reg, 0);
+   else
+      x86_rex_mem(&insn, opsize, dst.reg, src);
 
-static void asm_imul(code_blob_t *blob, x86_operand_t dst, x86_operand_t src,
-                     x86_size_t size)
-{
-   x86_insn_t insn = {};
+   x86_opcode_2(&insn, 0x0f, ssize == __BYTE ? 0xb6 : 0xb7);
 
-   assert(COMBINE(dst, src) == REG_REG);
-   x86_override(&insn, size == __WORD || size == __BYTE);
-   x86_rex(&insn, size, dst.reg, src.reg, 0);
-   x86_opcode_2(&insn, 0x0f, 0xaf);
-   x86_modrm(&insn, 3, dst.reg, src.reg);
+   if (src.kind == X86_REG)
+      x86_modrm(&insn, 3, dst.reg, src.reg);
+   else
+      x86_modrm_mem(&insn, dst.reg, src);
 
    x86_emit(blob, &insn);
 }
 
-static void asm_idiv(code_blob_t *blob, x86_operand_t src, x86_size_t size)
+static void asm_cmovcc(code_blob_t *blob, x86_operand_t dst, x86_operand_t src,
+                       x86_size_t size, x86_cmp_t cmp)
 {
    x86_insn_t insn = {};
 
-   assert(src.kind == X86_REG);
-   x86_override(&insn, size == __WORD || size == __BYTE);
-   x86_rex(&insn, size, 0, src.reg, 0);
-   x86_opcode(&insn, 0xf7);
-   x86_modrm(&insn, 3, 7, src.reg);
-
-   x86_emit(blob, &insn);
-}
+   // There is no byte form so use the 32-bit version which also
+   // preserves the low byte
+   if (size == __BYTE)
+      size = __DWORD;
 
-static void asm_and(code_blob_t *blob, x86_operand_t dst, x86_operand_t src,
-                    x86_size_t size)
-{
-   x86_insn_t insn = {};
+   x86_override(&insn, size == __WORD);
 
    switch (COMBINE(dst, src)) {
-   case REG_IMM:
-      x86_rex(&insn, size, 0, dst.reg, 0);
-      switch (size) {
-      case __QWORD:
-      case __DWORD:
-         if (is_imm8(src.imm)) {
-            x86_opcode(&insn, 0x83);
-            x86_modrm(&insn, 3, 4, dst.reg);
-            x86_imm8(&insn, src.imm);
-         }
-         else {
-            x86_opcode(&insn, 0x81);
-            x86_modrm(&insn, 3, 4, dst.reg);
-            x86_imm32(&insn, src.imm);
-         }
-         break;
-      default:
-         fatal_trace("unhandled size %d in asm_and", size);
-      }
-      break;
-
    case REG_REG:
-      x86_rex(&insn, size, src.reg, dst.reg, 0);
-      x86_opcode(&insn, size == __BYTE ? 0x20 : 0x21);
-      x86_modrm(&insn, 3, src.reg, dst.reg);
+      x86_rex(&insn, size, dst.reg, src.reg, 0);
+      x86_opcode_2(&insn, 0x0f, 0x40 + cmp);
+      x86_modrm(&insn, 3, dst.reg, src.reg);
+      break;
+
+   case REG_MEM:
+      x86_rex_mem(&insn, size, dst.reg, src);
+      x86_opcode_2(&insn, 0x0f, 0x40 + cmp);
+      x86_modrm_mem(&insn, dst.reg, src);
       break;
 
    default:
-      fatal_trace("unhandled operand combination in asm_and");
+      fatal_trace("invalid operand combination for CMOVcc");
    }
 
    x86_emit(blob, &insn);
 }
 
-static void asm_or(code_blob_t *blob, x86_operand_t dst, x86_operand_t src,
-                   x86_size_t size)
+static void asm_push(code_blob_t *blob, x86_operand_t src)
 {
    x86_insn_t insn = {};
 
-   assert(COMBINE(dst, src) == REG_REG);
-   x86_rex(&insn, size, src.reg, dst.reg, 0);
-   x86_opcode(&insn, size == __BYTE ? 0x08 : 0x09);
-   x86_modrm(&insn, 3, src.reg, dst.reg);
+   assert(src.kind == X86_REG);
+   x86_rex(&insn, __DWORD, 0, src.reg, 0);   // Actually pushes QWORD
+   x86_opcode(&insn, 0x50 + (src.reg & 7));
 
    x86_emit(blob, &insn);
 }
 
-static void asm_shl(code_blob_t *blob, x86_operand_t src, x86_size_t size)
+static void asm_pop(code_blob_t *blob, x86_operand_t dst)
 {
    x86_insn_t insn = {};
 
-   assert(src.kind == X86_REG);
-   x86_rex(&insn, size, src.reg, 0, 0);
-   x86_opcode(&insn, 0xd3);
-   x86_modrm(&insn, 3, 4, src.reg);
+   assert(dst.kind == X86_REG);
+   x86_rex(&insn, __DWORD, 0, dst.reg, 0);   // Actually pops QWORD
+   x86_opcode(&insn, 0x58 + (dst.reg & 7));
 
    x86_emit(blob, &insn);
 }
 
-static void asm_sar(code_blob_t *blob, x86_operand_t src, x86_operand_t count,
-                    x86_size_t size)
+static void asm_shift(code_blob_t *blob, int digit, x86_operand_t dst,
+                      x86_operand_t count, x86_size_t size)
 {
    x86_insn_t insn = {};
 
-   switch (COMBINE(src, count)) {
-   case REG_REG:
+   x86_override(&insn, size == __WORD);
+
+   if (dst.kind == X86_REG)
+      x86_rex(&insn, size, 0, dst.reg, 0);
+   else
+      x86_rex_mem(&insn, size, 0, dst);
+
+   const uint8_t base = size == __BYTE ? 0xd0 : 0xd1;
+
+   switch (count.kind) {
+   case X86_REG:
       assert(count.reg == __ECX.reg);
-      x86_rex(&insn,size, src.reg, 0, 0);
-      x86_opcode(&insn, 0xd3);
-      x86_modrm(&insn, 3, 7, src.reg);
+      x86_opcode(&insn, base + 2);
       break;
-
-   case REG_IMM:
-      x86_rex(&insn, size, src.reg, 0, 0);
-      if (count.imm == 1) {
-         x86_opcode(&insn, 0xd1);
-         x86_modrm(&insn, 3, 7, src.reg);
-      }
-      else {
-         x86_opcode(&insn, 0xc1);
-         x86_modrm(&insn, 3, 7, src.reg);
-         x86_imm8(&insn, count.imm);
-      }
+   case X86_IMM:
+      x86_opcode(&insn, count.imm == 1 ? base : base - 0x10);
       break;
-
    default:
-      fatal_trace("unhandled operand combination in asm_sar");
+      fatal_trace("invalid shift count operand");
    }
 
+   if (dst.kind == X86_REG)
+      x86_modrm(&insn, 3, digit, dst.reg);
+   else
+      x86_modrm_mem(&insn, digit, dst);
+
+   if (count.kind == X86_IMM && count.imm != 1)
+      x86_imm_sized(&insn, count.imm, __BYTE);
+
    x86_emit(blob, &insn);
 }
 
@@ -899,19 +896,22 @@ static void asm_test(code_blob_t *blob, x86_operand_t src1,
 {
    x86_insn_t insn = {};
 
+   x86_override(&insn, size == __WORD);
+
    switch (COMBINE(src1, src2)) {
    case REG_IMM:
-      x86_rex(&insn, size, 0, src1.reg, 0);
-      if (size == __BYTE) {
-         x86_opcode(&insn, 0xf6);
-         x86_modrm(&insn, 3, 0, src1.reg);
-         x86_imm8(&insn, src2.imm);
-      }
-      else {
-         x86_opcode(&insn, 0xf7);
+   case MEM_IMM:
+      assert(is_imm32(src2.imm));
+      if (src1.kind == X86_REG)
+         x86_rex(&insn, size, 0, src1.reg, 0);
+      else
+         x86_rex_mem(&insn, size, 0, src1);
+      x86_opcode(&insn, size == __BYTE ? 0xf6 : 0xf7);
+      if (src1.kind == X86_REG)
          x86_modrm(&insn, 3, 0, src1.reg);
-         x86_imm32(&insn, src2.imm);
-      }
+      else
+         x86_modrm_mem(&insn, 0, src1);
+      x86_imm_sized(&insn, src2.imm, size);
       break;
 
    case REG_REG:
@@ -920,40 +920,14 @@ static void asm_test(code_blob_t *blob, x86_operand_t src1,
       x86_modrm(&insn, 3, src2.reg, src1.reg);
       break;
 
-   default:
-      fatal_trace("unhandled operand combination in asm_test");
-   }
-
-   x86_emit(blob, &insn);
-}
-
-static void asm_cmp(code_blob_t *blob, x86_operand_t src1,
-                    x86_operand_t src2, x86_size_t size)
-{
-   x86_insn_t insn = {};
-
-   switch (COMBINE(src1, src2)) {
-   case REG_REG:
-      x86_rex(&insn, size, src2.reg, src1.reg, 0);
-      x86_opcode(&insn, 0x39);
-      x86_modrm(&insn, 3, src2.reg, src1.reg);
-      break;
-
    case MEM_REG:
-      x86_rex(&insn, size, src2.reg, src1.addr.reg, 0);
-      x86_opcode(&insn, 0x39);
-      if (is_imm8(src1.addr.off)) {
-         x86_modrm(&insn, 1, src2.reg, src1.reg);
-         x86_imm8(&insn, src1.addr.off);
-      }
-      else {
-         x86_modrm(&insn, 2, src2.reg, src1.reg);
-         x86_imm32(&insn, src1.addr.off);
-      }
+      x86_rex_mem(&insn, size, src2.reg, src1);
+      x86_opcode(&insn, size == __BYTE ? 0x84 : 0x85);
+      x86_modrm_mem(&insn, src2.reg, src1);
       break;
 
    default:
-      fatal_trace("unhandled operand combination in asm_test");
+      fatal_trace("invalid operand combination for TEST");
    }
 
    x86_emit(blob, &insn);
@@ -964,7 +938,7 @@ static void asm_setcc(code_blob_t *blob, x86_operand_t dst, x86_cmp_t cmp)
    x86_insn_t insn = {};
 
    assert(dst.kind == X86_REG);
-   x86_rex(&insn, 1, 0, dst.reg, 0);
+   x86_rex(&insn, __BYTE, 0, dst.reg, 0);
    x86_opcode_2(&insn, 0x0f, 0x90 + cmp);
    x86_modrm(&insn, 3, 0, dst.reg);
 
@@ -979,16 +953,36 @@ static void asm_call(code_blob_t *blob, x86_operand_t addr)
    case X86_IMM:
       {
          const ptrdiff_t rel = (uint8_t *)addr.imm - blob->wptr - 5;
-         x86_opcode(&insn, 0xe8);
-         x86_imm32(&insn, rel);
+         if (is_imm32(rel)) {
+            x86_opcode(&insn, 0xe8);
+            x86_imm32(&insn, rel);
+         }
+         else {
+            // Too far for a relative call: call through an absolute
+            // address stored after the instruction
+            x86_opcode_2(&insn, 0xff, 0x15);   // CALL [RIP+2]
+            x86_imm32(&insn, 2);
+            x86_opcode_2(&insn, 0xeb, 0x08);   // JMP +8
+            x86_emit(blob, &insn);
+
+            insn.len = 0;
+            x86_imm64(&insn, addr.imm);
+         }
       }
       break;
    case X86_REG:
+      x86_rex(&insn, __DWORD, 0, addr.reg, 0);
       x86_opcode(&insn, 0xff);
       x86_modrm(&insn, 3, 2, addr.reg);
       break;
+   case X86_ADDR:
+   case X86_ADDR2:
+      x86_rex_mem(&insn, __DWORD, 0, addr);
+      x86_opcode(&insn, 0xff);
+      x86_modrm_mem(&insn, 2, addr);
+      break;
    default:
-      fatal_trace("unhandled operand kind in asm_call");
+      fatal_trace("invalid operand for CALL");
    }
 
    x86_emit(blob, &insn);
@@ -1019,8 +1013,19 @@ static void asm_jmp(code_blob_t *blob, x86_operand_t addr)
          x86_imm32(&insn, addr.imm);
       }
       break;
+   case X86_REG:
+      x86_rex(&insn, __DWORD, 0, addr.reg, 0);
+      x86_opcode(&insn, 0xff);
+      x86_modrm(&insn, 3, 4, addr.reg);
+      break;
+   case X86_ADDR:
+   case X86_ADDR2:
+      x86_rex_mem(&insn, __DWORD, 0, addr);
+      x86_opcode(&insn, 0xff);
+      x86_modrm_mem(&insn, 4, addr);
+      break;
    default:
-      fatal_trace("unhandled operand kind in asm_jmp");
+      fatal_trace("invalid operand for JMP");
    }
 
    x86_emit(blob, &insn);
@@ -1052,12 +1057,36 @@ static void asm_jcc(code_blob_t *blob, x86_operand_t addr, x86_cmp_t cmp)
       }
       break;
    default:
-      fatal_trace("unhandled operand kind in asm_jcc");
+      fatal_trace("invalid operand for Jcc");
    }
 
    x86_emit(blob, &insn);
 }
 
+static uint8_t *asm_jcc_forward(code_blob_t *blob, x86_cmp_t cmp)
+{
+   // Short forward branch to a point fixed up by asm_bind
+   JCC(IMM(0), cmp);
+   return blob->wptr;
+}
+
+static void asm_bind(code_blob_t *blob, uint8_t *after)
+{
+   if (blob->overflow)
+      return;   // Code was not written
+
+   const ptrdiff_t rel = blob->wptr - after;
+   assert(rel >= 0 && is_imm8(rel));
+   *(after - 1) = rel;
+}
+
+static void asm_jcc_back(code_blob_t *blob, uint8_t *target, x86_cmp_t cmp)
+{
+   const ptrdiff_t rel = target - (blob->wptr + 2);
+   assert(is_imm8(rel));
+   JCC(IMM(rel), cmp);
+}
+
 static void asm_mulsd(code_blob_t *blob, x86_operand_t dst, x86_operand_t src)
 {
    x86_insn_t insn = {};
@@ -1225,14 +1254,14 @@ static void jit_x86_pop_call_clobbered(code_blob_t *blob)
 static x86_operand_t jit_x86_locals(code_blob_t *blob, ptrdiff_t off)
 {
    const ptrdiff_t locals =
-      FRAME_FIXED_SIZE + blob->func->nregs*8 + blob->func->framesz;
+      FRAME_FIXED_SIZE + ALIGN_UP(blob->func->framesz, 16);
    return ADDR(__EBP, -locals + off);
 }
 
 static x86_operand_t jit_x86_spill_slot(code_blob_t *blob, unsigned slot)
 {
    assert(slot >= STACK_BASE);
-   const ptrdiff_t off = (slot - STACK_BASE) * sizeof(int64_t);
+   const ptrdiff_t off = (slot - STACK_BASE + 1) * sizeof(int64_t);
    return jit_x86_locals(blob, -off);
 }
 
@@ -1256,7 +1285,12 @@ static void jit_x86_get_copy(code_blob_t *blob, x86_operand_t dst,
       break;
    case JIT_VALUE_INT64:
    case JIT_ADDR_ABS:
-      MOV(dst, IMM(src.int64), __QWORD);
+      if (dst.kind == X86_XMM) {
+         MOV(__EAX, IMM(src.int64), __QWORD);
+         MOV(dst, __EAX, __QWORD);
+      }
+      else
+         MOV(dst, IMM(src.int64), __QWORD);
       break;
    case JIT_VALUE_HANDLE:
       MOV(dst, IMM(src.handle), __DWORD);
@@ -1335,12 +1369,16 @@ static x86_operand_t jit_x86_get_addr(code_blob_t *blob, jit_value_t addr,
                                       const phys_slot_t *slots)
 {
    switch (addr.kind) {
+   case JIT_VALUE_REG:
+      jit_x86_get_reg(blob, tmp, addr.reg, slots);
+      return ADDR(tmp, 0);
    case JIT_ADDR_REG:
       jit_x86_get_reg(blob, tmp, addr.reg, slots);
       return ADDR(tmp, addr.disp);
    case JIT_ADDR_CPOOL:
       MOV(tmp, PTR(blob->func->cpool + addr.int64), __QWORD);
       return ADDR(tmp, 0);
+   case JIT_VALUE_INT64:
    case JIT_ADDR_ABS:
       MOV(tmp, IMM(addr.int64), __QWORD);
       return ADDR(tmp, 0);
@@ -1373,6 +1411,24 @@ static void jit_x86_patch(code_blob_t *blob, jit_label_t label, uint8_t *wptr,
       *(wptr - 1) = rel;
 }
 
+static int jit_x86_branch_distance(code_blob_t *blob, jit_label_t label)
+{
+   // Only a backwards branch to a label that has already been placed
+   // has a known displacement and can use the short encoding
+   const uint8_t *dest;
+   if (blob->labels != NULL && (dest = ihash_get(blob->labels, label)))
+      return dest - blob->wptr - 6;   // Longest branch instruction
+   else
+      return INT32_MAX;
+}
+
+static void jit_x86_save_irpos(code_blob_t *blob, jit_ir_t *ir)
+{
+   // Keep the frame anchor up to date for stack traces
+   const int irpos = ir - blob->func->irbuf;
+   MOV(ADDR(__EBP, IRPOS_OFFSET), IMM(irpos), __DWORD);
+}
+
 static void jit_x86_put(code_blob_t *blob, jit_reg_t dst, x86_operand_t src,
                         const phys_slot_t *slots)
 {
@@ -1414,6 +1470,36 @@ static void jit_x86_sext(code_blob_t *blob, x86_operand_t reg, x86_size_t size)
    }
 }
 
+static void jit_x86_zext(code_blob_t *blob, x86_operand_t reg, x86_size_t size)
+{
+   if (size < __QWORD)
+      MOVZX(reg, reg, __QWORD, size);
+}
+
+static void jit_x86_extend(code_blob_t *blob, jit_ir_t *ir, x86_operand_t reg,
+                           x86_size_t size)
+{
+   // Results of unsigned overflow checking operations are zero extended
+   if (ir->cc == JIT_CC_C)
+      jit_x86_zext(blob, reg, size);
+   else
+      jit_x86_sext(blob, reg, size);
+}
+
+static x86_operand_t jit_x86_get_rhs(code_blob_t *blob, x86_operand_t tmp,
+                                     jit_value_t src, x86_size_t size,
+                                     const phys_slot_t *slots)
+{
+   // Immediates are only sign extended correctly for 32 and 64-bit
+   // operations
+   if (size < __DWORD) {
+      jit_x86_get_copy(blob, tmp, src, slots);
+      return tmp;
+   }
+   else
+      return jit_x86_get(blob, tmp, src, slots);
+}
+
 static x86_size_t jit_x86_size(jit_ir_t *ir)
 {
    switch (ir->size) {
@@ -1455,33 +1541,40 @@ static void jit_x86_send(code_blob_t *blob, jit_ir_t *ir,
    MOV(ADDR(ARGS_REG, nth * sizeof(int64_t)), src, __QWORD);
 }
 
+static x86_size_t jit_x86_arith_size(jit_ir_t *ir)
+{
+   // Without overflow checking the interpreter computes the result
+   // with 64-bit arithmetic regardless of the operation size
+   return ir->cc == JIT_CC_NONE ? __QWORD : jit_x86_size(ir);
+}
+
 static void jit_x86_add(code_blob_t *blob, jit_ir_t *ir,
                         const phys_slot_t *slots)
 {
-   jit_x86_get_copy(blob, __EAX, ir->arg1, slots);
-   x86_operand_t rhs = jit_x86_get(blob, __ECX, ir->arg2, slots);
+   const x86_size_t size = jit_x86_arith_size(ir);
 
-   const x86_size_t size = jit_x86_size(ir);
+   jit_x86_get_copy(blob, __EAX, ir->arg1, slots);
+   x86_operand_t rhs = jit_x86_get_rhs(blob, __ECX, ir->arg2, size, slots);
 
    ADD(__EAX, rhs, size);
 
    jit_x86_set_flags(blob, ir);
-   jit_x86_sext(blob, __EAX, size);
+   jit_x86_extend(blob, ir, __EAX, size);
    jit_x86_put(blob, ir->result, __EAX, slots);
 }
 
 static void jit_x86_sub(code_blob_t *blob, jit_ir_t *ir,
                         const phys_slot_t *slots)
 {
-   jit_x86_get_copy(blob, __EAX, ir->arg1, slots);
-   x86_operand_t rhs = jit_x86_get(blob, __ECX, ir->arg2, slots);
+   const x86_size_t size = jit_x86_arith_size(ir);
 
-   const x86_size_t size = jit_x86_size(ir);
+   jit_x86_get_copy(blob, __EAX, ir->arg1, slots);
+   x86_operand_t rhs = jit_x86_get_rhs(blob, __ECX, ir->arg2, size, slots);
 
    SUB(__EAX, rhs, size);
 
    jit_x86_set_flags(blob, ir);
-   jit_x86_sext(blob, __EAX, size);
+   jit_x86_extend(blob, ir, __EAX, size);
    jit_x86_put(blob, ir->result, __EAX, slots);
 }
 
@@ -1491,15 +1584,15 @@ static void jit_x86_mul(code_blob_t *blob, jit_ir_t *ir,
    jit_x86_get_copy(blob, __EAX, ir->arg1, slots);
    jit_x86_get_copy(blob, __ECX, ir->arg2, slots);  // No immediate version
 
-   const x86_size_t size = jit_x86_size(ir);
+   const x86_size_t size = jit_x86_arith_size(ir);
 
-   if (ir->cc == JIT_CC_O)
-      IMUL(__EAX, __ECX, size);
-   else
+   if (ir->cc == JIT_CC_C)
       MUL(__ECX, size);
+   else
+      IMUL(__EAX, __ECX, size);
 
    jit_x86_set_flags(blob, ir);
-   jit_x86_sext(blob, __EAX, size);
+   jit_x86_extend(blob, ir, __EAX, size);
    jit_x86_put(blob, ir->result, __EAX, slots);
 }
 
@@ -1507,40 +1600,25 @@ static void jit_x86_rem(code_blob_t *blob, jit_ir_t *ir,
                         const phys_slot_t *slots)
 {
    jit_x86_get_copy(blob, __EAX, ir->arg1, slots);
-   x86_operand_t rhs = jit_x86_get(blob, __ECX, ir->arg2, slots);
-
-   const x86_size_t size = jit_x86_size(ir);
-
-   switch (size) {
-   case __WORD: CWD(); break;
-   case __DWORD: CDQ(); break;
-   default: CQO(); break;
-   }
+   jit_x86_get_copy(blob, __ECX, ir->arg2, slots);  // No immediate version
 
-   IDIV(rhs, size);
-   MOV(__EAX, __EDX, MAX(size, __DWORD));
+   // Operands are already sign extended so a 64-bit division gives
+   // the same result as the interpreter for every operation size
+   CQO();
+   IDIV(__ECX, __QWORD);
 
-   jit_x86_sext(blob, __EAX, size);
-   jit_x86_put(blob, ir->result, __EAX, slots);
+   jit_x86_put(blob, ir->result, __EDX, slots);
 }
 
 static void jit_x86_div(code_blob_t *blob, jit_ir_t *ir,
                         const phys_slot_t *slots)
 {
    jit_x86_get_copy(blob, __EAX, ir->arg1, slots);
-   x86_operand_t rhs = jit_x86_get(blob, __ECX, ir->arg2, slots);
-
-   const x86_size_t size = jit_x86_size(ir);
-
-   switch (size) {
-   case __WORD: CWD(); break;
-   case __DWORD: CDQ(); break;
-   default: CQO(); break;
-   }
+   jit_x86_get_copy(blob, __ECX, ir->arg2, slots);  // No immediate version
 
-   IDIV(rhs, size);
+   CQO();
+   IDIV(__ECX, __QWORD);
 
-   jit_x86_sext(blob, __EAX, size);
    jit_x86_put(blob, ir->result, __EAX, slots);
 }
 
@@ -1557,10 +1635,10 @@ static void jit_x86_neg(code_blob_t *blob, jit_ir_t *ir,
 static void jit_x86_not(code_blob_t *blob, jit_ir_t *ir,
                         const phys_slot_t *slots)
 {
-   x86_operand_t src = jit_x86_get(blob, __ECX, ir->arg1, slots);
+   jit_x86_get_copy(blob, __ECX, ir->arg1, slots);
 
    XOR(__EAX, __EAX, __DWORD);
-   TEST(src, src, __BYTE);
+   TEST(__ECX, __ECX, __QWORD);
    SETZ(__EAX);
 
    jit_x86_put(blob, ir->result, __EAX, slots);
@@ -1581,9 +1659,9 @@ static void jit_x86_or(code_blob_t *blob, jit_ir_t *ir,
                        const phys_slot_t *slots)
 {
    jit_x86_get_copy(blob, __EAX, ir->arg1, slots);
-   x86_operand_t rhs = jit_x86_get(blob, __ECX, ir->arg2, slots);
+   jit_x86_get_copy(blob, __ECX, ir->arg2, slots);
 
-   OR(__EAX, rhs, __QWORD);
+   OR(__EAX, __ECX, __QWORD);
 
    jit_x86_put(blob, ir->result, __EAX, slots);
 }
@@ -1592,9 +1670,9 @@ static void jit_x86_xor(code_blob_t *blob, jit_ir_t *ir,
                         const phys_slot_t *slots)
 {
    jit_x86_get_copy(blob, __EAX, ir->arg1, slots);
-   x86_operand_t rhs = jit_x86_get(blob, __ECX, ir->arg2, slots);
+   jit_x86_get_copy(blob, __ECX, ir->arg2, slots);
 
-   XOR(__EAX, rhs, __QWORD);
+   XOR(__EAX, __ECX, __QWORD);
 
    jit_x86_put(blob, ir->result, __EAX, slots);
 }
@@ -1609,19 +1687,18 @@ static void jit_x86_mov(code_blob_t *blob, jit_ir_t *ir,
 static void jit_x86_clamp(code_blob_t *blob, jit_ir_t *ir,
                           const phys_slot_t *slots)
 {
-   x86_operand_t src = jit_x86_get(blob, __ECX, ir->arg1, slots);
+   jit_x86_get_copy(blob, __ECX, ir->arg1, slots);
 
    XOR(__EAX, __EAX, __DWORD);
-   TEST(src, src, __QWORD);
-   CMOVGT(__EAX, src, __QWORD);
+   TEST(__ECX, __ECX, __QWORD);
+   CMOVGT(__EAX, __ECX, __QWORD);
 
    jit_x86_put(blob, ir->result, __EAX, slots);
 }
 
 static void jit_x86_jump(code_blob_t *blob, jit_ir_t *ir)
 {
-   const int this = ir - blob->func->irbuf;
-   const int distance = (this - ir->arg1.label) * BYTES_PER_IR;
+   const int distance = jit_x86_branch_distance(blob, ir->arg1.label);
 
    if (ir->cc == JIT_CC_NONE)
       JMP(PATCH(distance));
@@ -1643,8 +1720,7 @@ static void jit_x86_ret(code_blob_t *blob, jit_ir_t *ir)
 {
    jit_ir_t *endir = blob->func->irbuf + blob->func->nirs;
    if (ir + 1 < endir) {
-      const int distance = (endir - ir) * BYTES_PER_IR;
-      JMP(PATCH(distance));
+      JMP(PATCH(INT32_MAX));
       code_blob_patch(blob, JIT_LABEL_INVALID, jit_x86_patch);
    }
 }
@@ -1701,11 +1777,13 @@ static void jit_x86_ccmp(code_blob_t *blob, jit_ir_t *ir,
    jit_x86_get_copy(blob, __ECX, ir->arg2, slots);
 
    TEST(FLAGS_REG, IMM(1), __BYTE);
-   JZ(IMM(6));
+   uint8_t *skip = asm_jcc_forward(blob, X86_CMP_EQ);
 
    CMP(__EAX, __ECX, __QWORD);
 
    jit_x86_set_flags(blob, ir);
+
+   asm_bind(blob, skip);
 }
 
 static void jit_x86_cset(code_blob_t *blob, jit_ir_t *ir,
@@ -1718,10 +1796,10 @@ static void jit_x86_csel(code_blob_t *blob, jit_ir_t *ir,
                          const phys_slot_t *slots)
 {
    jit_x86_get_copy(blob, __EAX, ir->arg1, slots);
-   x86_operand_t rhs = jit_x86_get(blob, __ECX, ir->arg2, slots);
+   jit_x86_get_copy(blob, __ECX, ir->arg2, slots);
 
    TEST(FLAGS_REG, FLAGS_REG, __BYTE);
-   CMOVZ(__EAX, rhs, __QWORD);
+   CMOVZ(__EAX, __ECX, __QWORD);
 
    jit_x86_put(blob, ir->result, __EAX, slots);
 }
@@ -1731,6 +1809,8 @@ static void jit_x86_call(code_blob_t *blob, jit_x86_state_t *state,
 {
    jit_func_t *f = jit_get_func(state->jit, ir->arg1.handle);
 
+   jit_x86_save_irpos(blob, ir);
+
    MOV(__EAX, PTR(f), __QWORD);
    CALL(PTR(state->stubs[CALL_STUB]));
 }
@@ -1741,7 +1821,7 @@ static void jit_x86_shl(code_blob_t *blob, jit_ir_t *ir,
    jit_x86_get_copy(blob, __EAX, ir->arg1, slots);
    jit_x86_get_copy(blob, __ECX, ir->arg2, slots);
 
-   SHL(__EAX, __QWORD);
+   SHL(__EAX, __ECX, __QWORD);
 
    jit_x86_put(blob, ir->result, __EAX, slots);
 }
@@ -1817,24 +1897,66 @@ static void jit_x86_fneg(code_blob_t *blob, jit_ir_t *ir,
    jit_x86_put(blob, ir->result, __XMM1, slots);
 }
 
+static void jit_x86_fcompare(code_blob_t *blob, jit_ir_t *ir)
+{
+   // An unordered comparison sets ZF, PF and CF so only the "above"
+   // conditions give false for NaN operands: swap the operands for
+   // less-than and check the parity flag for equality to match the
+   // interpreter which uses C semantics
+   switch (ir->cc) {
+   case JIT_CC_LT:
+      UCOMISD(__XMM1, __XMM0);
+      SETA(__EAX);
+      break;
+   case JIT_CC_LE:
+      UCOMISD(__XMM1, __XMM0);
+      SETAE(__EAX);
+      break;
+   case JIT_CC_GT:
+      UCOMISD(__XMM0, __XMM1);
+      SETA(__EAX);
+      break;
+   case JIT_CC_GE:
+      UCOMISD(__XMM0, __XMM1);
+      SETAE(__EAX);
+      break;
+   case JIT_CC_EQ:
+      UCOMISD(__XMM0, __XMM1);
+      SETZ(__EAX);
+      SETNP(__ECX);
+      AND(__EAX, __ECX, __BYTE);
+      break;
+   case JIT_CC_NE:
+      UCOMISD(__XMM0, __XMM1);
+      SETNZ(__EAX);
+      SETP(__ECX);
+      OR(__EAX, __ECX, __BYTE);
+      break;
+   default:
+      fatal_trace("unhandled FCMP comparison code %d", ir->cc);
+   }
+
+   MOVZX(__EAX, __EAX, __DWORD, __BYTE);
+}
+
 static void jit_x86_fcmp(code_blob_t *blob, jit_ir_t *ir,
                          const phys_slot_t *slots)
 {
    jit_x86_get_copy(blob, __XMM0, ir->arg1, slots);
    jit_x86_get_copy(blob, __XMM1, ir->arg2, slots);
 
-   UCOMISD(__XMM0, __XMM1);
+   jit_x86_fcompare(blob, ir);
+   MOV(FLAGS_REG, __EAX, __DWORD);
+}
 
-   switch (ir->cc) {
-   case JIT_CC_LT: SETB(FLAGS_REG); break;
-   case JIT_CC_LE: SETBE(FLAGS_REG); break;
-   case JIT_CC_GT: SETA(FLAGS_REG); break;
-   case JIT_CC_GE: SETAE(FLAGS_REG); break;
-   case JIT_CC_EQ: SETZ(FLAGS_REG); break;
-   case JIT_CC_NE: SETNZ(FLAGS_REG); break;
-   default:
-      fatal_trace("unhandled FCMP comparison code %d", ir->cc);
-   }
+static void jit_x86_fccmp(code_blob_t *blob, jit_ir_t *ir,
+                          const phys_slot_t *slots)
+{
+   jit_x86_get_copy(blob, __XMM0, ir->arg1, slots);
+   jit_x86_get_copy(blob, __XMM1, ir->arg2, slots);
+
+   jit_x86_fcompare(blob, ir);
+   AND(FLAGS_REG, __EAX, __DWORD);
 }
 
 static void jit_x86_fcvtns(code_blob_t *blob, jit_x86_state_t *state,
@@ -1865,6 +1987,8 @@ static void jit_x86_scvtf(code_blob_t *blob, jit_ir_t *ir,
 static void jit_x86_macro_exit(code_blob_t *blob, jit_x86_state_t *state,
                                jit_ir_t *ir)
 {
+   jit_x86_save_irpos(blob, ir);
+
    MOV(__EAX, IMM(ir->arg1.exit), __DWORD);
    CALL(PTR(state->stubs[EXIT_STUB]));
 
@@ -1888,6 +2012,7 @@ static void jit_x86_macro_salloc(code_blob_t *blob, jit_ir_t *ir,
 static void jit_x86_macro_lalloc(code_blob_t *blob, jit_x86_state_t *state,
                                  jit_ir_t *ir, const phys_slot_t *slots)
 {
+   jit_x86_save_irpos(blob, ir);
    jit_x86_get_copy(blob, __EAX, ir->arg1, slots);
 
    CALL(PTR(state->stubs[TLAB_STUB]));
@@ -1898,6 +2023,7 @@ static void jit_x86_macro_lalloc(code_blob_t *blob, jit_x86_state_t *state,
 static void jit_x86_macro_galloc(code_blob_t *blob, jit_x86_state_t *state,
                                  jit_ir_t *ir, const phys_slot_t *slots)
 {
+   jit_x86_save_irpos(blob, ir);
    jit_x86_get_copy(blob, __EAX, ir->arg1, slots);
 
    CALL(PTR(state->stubs[ALLOC_STUB]));
@@ -1939,16 +2065,19 @@ static void jit_x86_macro_move(code_blob_t *blob, jit_ir_t *ir,
    jit_x86_get_reg(blob, __ECX, ir->result, slots);
 
    CMP(__EDI, __ESI, __QWORD);
-   JB(IMM(19));                   // Source before destination
+   uint8_t *before = asm_jcc_forward(blob, X86_CMP_C);  // Source first
    LEA(__EAX, ADDR2(__EDI, __ECX, -1));
    CMP(__EAX, __ESI, __QWORD);
-   JBE(IMM(9));                   // Destination end before source
+   uint8_t *disjoint = asm_jcc_forward(blob, X86_CMP_BE);
 
    // Overlap
    MOV(__EDI, __EAX, __QWORD);
    LEA(__ESI, ADDR2(__ESI, __ECX, -1));
    STD();
 
+   asm_bind(blob, before);
+   asm_bind(blob, disjoint);
+
    REPMOVS(__BYTE);
    CLD();
 
@@ -2017,29 +2146,105 @@ static void jit_x86_macro_case(code_blob_t *blob, jit_ir_t *ir,
 
    CMP(__EAX, __ECX, __QWORD);
 
-   const int this = ir - blob->func->irbuf;
-   const int distance = (this - ir->arg2.label) * BYTES_PER_IR;
+   const int distance = jit_x86_branch_distance(blob, ir->arg2.label);
 
    JZ(PATCH(distance));
 
    code_blob_patch(blob, ir->arg2.label, jit_x86_patch);
 }
 
+static int64_t jit_x86_exp_helper(int64_t x, int64_t y, const jit_ir_t *ir,
+                                  int64_t *overflow)
+{
+   int64_t result = 0;
+   bool xo = false, ro = false;
+
+#define EXP_OVERFLOW(type) do {                                 \
+      type xt = x, yt = y, r = 1;                               \
+      while (yt) {                                              \
+         if (yt & 1)                                            \
+            ro |= xo || __builtin_mul_overflow(r, xt, &r);      \
+         yt >>= 1;                                              \
+         xo |= __builtin_mul_overflow(xt, xt, &xt);             \
+      }                                                         \
+      result = r;                                               \
+   } while (0)
+
+   if (ir->cc == JIT_CC_C) {
+      switch (ir->size) {
+      case JIT_SZ_8: EXP_OVERFLOW(uint8_t); break;
+      case JIT_SZ_16: EXP_OVERFLOW(uint16_t); break;
+      case JIT_SZ_32: EXP_OVERFLOW(uint32_t); break;
+      default: EXP_OVERFLOW(uint64_t); break;
+      }
+   }
+   else {
+      switch (ir->size) {
+      case JIT_SZ_8: EXP_OVERFLOW(int8_t); break;
+      case JIT_SZ_16: EXP_OVERFLOW(int16_t); break;
+      case JIT_SZ_32: EXP_OVERFLOW(int32_t); break;
+      default: EXP_OVERFLOW(int64_t); break;
+      }
+   }
+
+#undef EXP_OVERFLOW
+
+   *overflow = ro;
+   return result;
+}
+
 static void jit_x86_macro_exp(code_blob_t *blob, jit_ir_t *ir,
                               const phys_slot_t *slots)
 {
+   if (ir->cc != JIT_CC_NONE) {
+      // Overflow checking version is implemented in C
+      PUSH(__R8);
+      PUSH(__R9);
+      PUSH(__R10);
+      PUSH(__R11);
+#ifdef __MINGW32__
+      SUB(__ESP, IMM(32), __QWORD);   // Shadow space
+#endif
+
+      jit_x86_get_copy(blob, CARG0_REG, ir->arg1, slots);
+      jit_x86_get_copy(blob, CARG1_REG, ir->arg2, slots);
+      MOV(CARG2_REG, PTR(ir), __QWORD);
+      LEA(CARG3_REG, ADDR(__EBP, SCRATCH_OFFSET));
+
+      MOV(__EAX, PTR(jit_x86_exp_helper), __QWORD);
+      CALL(__EAX);
+
+#ifdef __MINGW32__
+      ADD(__ESP, IMM(32), __QWORD);
+#endif
+      POP(__R11);
+      POP(__R10);
+      POP(__R9);
+      POP(__R8);
+
+      MOV(FLAGS_REG, ADDR(__EBP, SCRATCH_OFFSET), __QWORD);
+
+      jit_x86_put(blob, ir->result, __EAX, slots);
+      return;
+   }
+
    jit_x86_get_copy(blob, __EDI, ir->arg1, slots);
    jit_x86_get_copy(blob, __ECX, ir->arg2, slots);
 
-   TEST(__ECX, __ECX, __QWORD);
    MOV(__EAX, IMM(1), __DWORD);
-   JZ(IMM(18));
+   TEST(__ECX, __ECX, __QWORD);
+   uint8_t *done = asm_jcc_forward(blob, X86_CMP_EQ);
+
+   uint8_t *loop = blob->wptr;
    TEST(__ECX, IMM(1), __BYTE);
-   JZ(IMM(4));
+   uint8_t *even = asm_jcc_forward(blob, X86_CMP_EQ);
    IMUL(__EAX, __EDI, __QWORD);
+   asm_bind(blob, even);
    IMUL(__EDI, __EDI, __QWORD);
    SAR(__ECX, IMM(1), __QWORD);
-   JNZ(IMM(-18));
+   asm_jcc_back(blob, loop, X86_CMP_NE);
+
+   asm_bind(blob, done);
 
    jit_x86_put(blob, ir->result, __EAX, slots);
 }
@@ -2062,6 +2267,39 @@ static void jit_x86_macro_trim(code_blob_t *blob, jit_ir_t *ir)
    MOV(ADDR(TLAB_REG, offsetof(tlab_t, alloc)), __EAX, __DWORD);
 }
 
+static void jit_x86_macro_reexec(code_blob_t *blob, jit_ir_t *ir)
+{
+   // Call the current entry point for this function with the same
+   // arguments and then return its result
+   const ptrdiff_t func_off = offsetof(jit_anchor_t, func);
+   const ptrdiff_t caller_off = offsetof(jit_anchor_t, caller);
+
+   MOV(CARG0_REG, ADDR(__EBP, ANCHOR_OFFSET + func_off), __QWORD);
+   MOV(CARG1_REG, ADDR(__EBP, ANCHOR_OFFSET + caller_off), __QWORD);
+   MOV(CARG2_REG, ARGS_REG, __QWORD);
+   MOV(CARG3_REG, TLAB_REG, __QWORD);
+
+   MOV(__EAX, ADDR(CARG0_REG, offsetof(jit_func_t, entry)), __QWORD);
+   CALL(__EAX);
+
+   jit_x86_ret(blob, ir);
+}
+
+static void jit_x86_macro_sadd(code_blob_t *blob, jit_ir_t *ir,
+                               const phys_slot_t *slots)
+{
+   const x86_size_t size = jit_x86_size(ir);
+
+   x86_operand_t addr = jit_x86_get_addr(blob, ir->arg1, __ECX, slots);
+   jit_x86_get_copy(blob, __EDX, ir->arg2, slots);
+
+   MOVZX(__EAX, addr, __QWORD, size);
+   ADD(__EAX, __EDX, size);
+   MOV(__EDX, IMM(-1), __QWORD);   // Does not modify flags
+   CMOVC(__EAX, __EDX, MAX(size, __DWORD));
+   MOV(addr, __EAX, size);
+}
+
 static void jit_x86_op(code_blob_t *blob, jit_x86_state_t *state, jit_ir_t *ir,
                        const phys_slot_t *slots)
 {
@@ -2171,6 +2409,9 @@ static void jit_x86_op(code_blob_t *blob, jit_x86_state_t *state, jit_ir_t *ir,
    case J_FCMP:
       jit_x86_fcmp(blob, ir, slots);
       break;
+   case J_FCCMP:
+      jit_x86_fccmp(blob, ir, slots);
+      break;
    case J_FCVTNS:
       jit_x86_fcvtns(blob, state, ir, slots);
       break;
@@ -2219,6 +2460,12 @@ static void jit_x86_op(code_blob_t *blob, jit_x86_state_t *state, jit_ir_t *ir,
    case MACRO_TRIM:
       jit_x86_macro_trim(blob, ir);
       break;
+   case MACRO_REEXEC:
+      jit_x86_macro_reexec(blob, ir);
+      break;
+   case MACRO_SADD:
+      jit_x86_macro_sadd(blob, ir, slots);
+      break;
    default:
       jit_dump_with_mark(blob->func, ir - blob->func->irbuf, false);
       fatal_trace("unhandled opcode %s in x86 backend", jit_op_name(ir->op));
@@ -2237,6 +2484,14 @@ static void jit_x86_cgen(jit_t *j, jit_handle_t handle, void *context)
       return;
 #endif
 
+   for (int i = 0; i < f->nirs; i++) {
+      // Leave functions with unresolved calls in the interpreter which
+      // can report the error with a proper stack trace
+      const jit_ir_t *ir = &(f->irbuf[i]);
+      if (ir->op == J_CALL && ir->arg1.handle == JIT_HANDLE_INVALID)
+         return;
+   }
+
    code_blob_t *blob = code_blob_new(state->code, f->name, 0);
    if (blob == NULL)
       return;
@@ -2265,11 +2520,11 @@ static void jit_x86_cgen(jit_t *j, jit_handle_t handle, void *context)
    //       |-------------------|
    //   -32 | Saved RBX         |
    //       | Saved RDI (Win)   |
-   //       | Saved RSI (Win)   |
-   //       | Saved R12         |
-   //       | Saved R13         |
-   //       | Saved R14         |
-   //   -80 | Saved R15         |
+   //   -48 | Saved RSI (Win)   |
+   //       |-------------------|
+   //   -56 | Helper scratch    |
+   //       .                   .
+   //   -80 |                   |
    //       |-------------------|    <--- End of fixed frame
    //       | Local variables   |
    //       .                   .
@@ -2278,10 +2533,10 @@ static void jit_x86_cgen(jit_t *j, jit_handle_t handle, void *context)
    //       .                   .
    //       |-------------------|    <--- RSP
 
-   const size_t framebytes =
-      f->framesz + spills * sizeof(int64_t) + FRAME_FIXED_SIZE;
+   const size_t framebytes = FRAME_FIXED_SIZE + ALIGN_UP(f->framesz, 16)
+      + spills * sizeof(int64_t);
    const size_t framesz = ALIGN_UP(framebytes, 16);
-   SUB(__ESP, IMM(framesz*2), __QWORD);
+   SUB(__ESP, IMM(framesz), __QWORD);
 
    // Callee saves
    MOV(ADDR(__EBP, -32), __EBX, __QWORD);
@@ -2289,13 +2544,6 @@ static void jit_x86_cgen(jit_t *j, jit_handle_t handle, void *context)
    MOV(ADDR(__EBP, -40), __EDI, __QWORD);
    MOV(ADDR(__EBP, -48), __ESI, __QWORD);
 #endif
-#if 0
-   // Not currently used
-   MOV(ADDR(__EBP, -56), __R12, __QWORD);
-   MOV(ADDR(__EBP, -64), __R13, __QWORD);
-   MOV(ADDR(__EBP, -72), __R14, __QWORD);
-   MOV(ADDR(__EBP, -80), __R15, __QWORD);
-#endif
 
    XOR(FLAGS_REG, FLAGS_REG, __DWORD);
 
@@ -2312,6 +2560,15 @@ static void jit_x86_cgen(jit_t *j, jit_handle_t handle, void *context)
 
    STATIC_ASSERT(ANCHOR_OFFSET == -24);
 
+   if (f->next_tier != NULL) {
+      // Count down to the next tier in the same way as the interpreter
+      MOV(__EAX, PTR(f), __QWORD);
+      SUB(ADDR(__EAX, offsetof(jit_func_t, hotness)), IMM(1), __DWORD);
+      uint8_t *skip = asm_jcc_forward(blob, X86_CMP_NE);
+      CALL(PTR(state->stubs[TIER_STUB]));
+      asm_bind(blob, skip);
+   }
+
    for (int i = 0; i < f->nirs; i++) {
       if (f->irbuf[i].target)
          code_blob_mark(blob, i);
@@ -2326,17 +2583,15 @@ static void jit_x86_cgen(jit_t *j, jit_handle_t handle, void *context)
    MOV(__EDI, ADDR(__EBP, -40), __QWORD);
    MOV(__ESI, ADDR(__EBP, -48), __QWORD);
 #endif
-#if 0
-   MOV(__R12, ADDR(__EBP, -56), __QWORD);
-   MOV(__R13, ADDR(__EBP, -64), __QWORD);
-   MOV(__R14, ADDR(__EBP, -72), __QWORD);
-   MOV(__R15, ADDR(__EBP, -80), __QWORD);
-#endif
 
    LEAVE();
    RET();
 
-   code_blob_finalise(blob, &(f->entry));
+   jit_entry_fn_t entry = NULL;
+   code_blob_finalise(blob, &entry);
+
+   if (entry != NULL)
+      jit_set_entry(f, entry);
 }
 
 static void jit_x86_gen_exit_stub(jit_x86_state_t *state)
@@ -2400,7 +2655,7 @@ static void jit_x86_gen_alloc_stub(jit_x86_state_t *state)
    jit_x86_push_call_clobbered(blob);
 
    // Size in EAX
-   MOV(CARG0_REG, __EAX, __DWORD);
+   MOV(CARG0_REG, __EAX, __QWORD);
    LEA(CARG1_REG, ADDR(__EBP, ANCHOR_OFFSET));
 
    MOV(__EAX, PTR(__nvc_mspace_alloc), __QWORD);
@@ -2419,29 +2674,32 @@ static void jit_x86_gen_tlab_stub(jit_x86_state_t *state)
    ident_t name = ident_new("tlab stub");
    code_blob_t *blob = code_blob_new(state->code, name, 0);
 
-   // Fast path: allocate from TLAB
+   // Fast path: allocate from TLAB, size is 64 bits in EAX
 
    MOV(__ECX, ADDR(TLAB_REG, offsetof(tlab_t, alloc)), __DWORD);
-   MOV(__EDI, __ECX, __DWORD);
-   ADD(__EDI, __EAX, __DWORD);
-   ADD(__EDI, IMM(RT_ALIGN_MASK), __DWORD);
-   AND(__EDI, IMM(~RT_ALIGN_MASK), __DWORD);
+   MOV(__EDI, __ECX, __QWORD);
+   ADD(__EDI, __EAX, __QWORD);
+   ADD(__EDI, IMM(RT_ALIGN_MASK), __QWORD);
+   AND(__EDI, IMM(~RT_ALIGN_MASK), __QWORD);
 
-   CMP(ADDR(TLAB_REG, offsetof(tlab_t, limit)), __EDI, __DWORD);
-   JLT(IMM(12));
+   MOV(__EDX, ADDR(TLAB_REG, offsetof(tlab_t, limit)), __DWORD);
+   CMP(__EDI, __EDX, __QWORD);
+   uint8_t *slow = asm_jcc_forward(blob, X86_CMP_A);
 
    MOV(ADDR(TLAB_REG, offsetof(tlab_t, alloc)), __EDI, __DWORD);
    LEA(__EAX, ADDR(TLAB_REG, offsetof(tlab_t, data)));
    ADD(__EAX, __ECX, __QWORD);
    RET();
 
+   asm_bind(blob, slow);
+
    // Slow path: call into runtime
 
    SUB(__ESP, IMM(8), __QWORD);   // Ensure stack aligned
 
    jit_x86_push_call_clobbered(blob);
 
-   MOV(CARG0_REG, __EAX, __DWORD);
+   MOV(CARG0_REG, __EAX, __QWORD);
    LEA(CARG1_REG, ADDR(__EBP, ANCHOR_OFFSET));
 
    MOV(__EAX, PTR(__nvc_mspace_alloc), __QWORD);
@@ -2520,6 +2778,35 @@ static void jit_x86_gen_round_stub(jit_x86_state_t *state)
    code_blob_finalise(blob, &(state->stubs[ROUND_STUB]));
 }
 
+static void jit_x86_tier_up(jit_func_t *f)
+{
+   if (f->next_tier != NULL)
+      jit_tier_up(f);
+}
+
+static void jit_x86_gen_tier_stub(jit_x86_state_t *state)
+{
+   ident_t name = ident_new("tier stub");
+   code_blob_t *blob = code_blob_new(state->code, name, 0);
+
+   SUB(__ESP, IMM(8), __QWORD);   // Ensure stack aligned
+
+   jit_x86_push_call_clobbered(blob);
+
+   // Function pointer in EAX
+   MOV(CARG0_REG, __EAX, __QWORD);
+
+   MOV(__EAX, PTR(jit_x86_tier_up), __QWORD);
+   CALL(__EAX);
+
+   jit_x86_pop_call_clobbered(blob);
+
+   ADD(__ESP, IMM(8), __QWORD);
+   RET();
+
+   code_blob_finalise(blob, &(state->stubs[TIER_STUB]));
+}
+
 static void *jit_x86_init(jit_t *jit)
 {
    jit_x86_state_t *state = xcalloc(sizeof(jit_x86_state_t));
@@ -2531,6 +2818,7 @@ static void *jit_x86_init(jit_t *jit)
    jit_x86_gen_alloc_stub(state);
    jit_x86_gen_tlab_stub(state);
    jit_x86_gen_fexp_stub(state);
+   jit_x86_gen_tier_stub(state);
    DEBUG_ONLY(jit_x86_gen_debug_stub(state));
 
    if (!__builtin_cpu_supports("sse4.1"))
@@ -2555,9 +2843,9 @@ static const jit_plugin_t jit_x86 = {
 
 void jit_register_native_plugin(jit_t *j)
 {
-   const int threshold = opt_get_int(OPT_JIT_THRESHOLD);
+   const int threshold = opt_get_int(OPT_JIT_NATIVE_THRESHOLD);
    if (threshold > 0)
       jit_add_tier(j, threshold, &jit_x86);
    else if (threshold < 0)
-      warnf("invalid NVC_JIT_THRESOLD setting %d", threshold);
+      warnf("invalid NVC_JIT_NATIVE_THRESHOLD setting %d", threshold);
 }
@@ -51,6 +51,8 @@ typedef struct {
 } jit_stack_trace_t;
 
 typedef void (*jit_irq_fn_t)(jit_t *, void *);
+typedef void (*jit_sample_fn_t)(jit_t *, const ident_t *, int, void *);
+typedef void (*jit_walk_fn_t)(jit_t *, jit_handle_t, void *);
 
 jit_t *jit_new(unit_registry_t *ur);
 void jit_free(jit_t *j);
@@ -72,8 +74,15 @@ object_t *jit_get_object(jit_t *j, jit_handle_t handle);
 void jit_register_native_plugin(jit_t *j);
 void jit_interrupt(jit_t *j, jit_irq_fn_t fn, void *ctx);
 void jit_check_interrupt(jit_t *j);
+void jit_start_sampling(jit_t *j, unsigned interval_us, jit_sample_fn_t fn,
+                        void *ctx);
+void jit_stop_sampling(jit_t *j);
 void jit_reset(jit_t *j);
 int32_t *jit_get_cover_mem(jit_t *j, int mintags);
+void jit_walk_funcs(jit_t *j, jit_walk_fn_t fn, void *ctx);
+void *jit_get_privdata(jit_t *j, jit_handle_t handle);
+void jit_set_privdata(jit_t *j, jit_handle_t handle, void *ptr);
+const void *jit_get_cpool(jit_t *j, jit_handle_t handle, size_t *size);
 
 void *jit_mspace_alloc(size_t size) RETURNS_NONNULL;
 jit_stack_trace_t *jit_stack_trace(void);
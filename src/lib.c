@@ -50,14 +50,15 @@ typedef struct _lib_unit    lib_unit_t;
 #define INDEX_FILE_MAGIC 0x55225511
 
 struct _lib_unit {
-   object_t     *object;
-   ident_t       name;
-   uint64_t      mtime;
-   unit_meta_t   meta;
-   lib_unit_t   *next;
-   tree_kind_t   kind;
-   bool          dirty;
-   bool          error;
+   object_t       *object;
+   ident_t         name;
+   uint64_t        mtime;
+   unit_meta_t     meta;
+   lib_unit_t     *next;
+   object_arena_t *replaced;
+   tree_kind_t     kind;
+   bool            dirty;
+   bool            error;
 };
 
 struct _lib_index {
@@ -225,6 +226,23 @@ static bool lib_name_cmp(const void *a, const void *b)
       return false;
 }
 
+static void lib_open_lock(lib_t lib)
+{
+   LOCAL_TEXT_BUF lock_path = lib_file_path(lib, "_NVC_LIB");
+
+   // Try to open the lock file read-write as this is required for
+   // exlusive locking on some NFS implementations
+   if ((lib->lock_fd = open(tb_get(lock_path), O_RDWR)) < 0
+       && (errno == EACCES || errno == EPERM || errno == EROFS)) {
+      // Try again in read-only mode
+      lib->lock_fd = open(tb_get(lock_path), O_RDONLY);
+      lib->readonly = true;
+   }
+
+   if (lib->lock_fd < 0)
+      fatal_errno("open: %s", tb_get(lock_path));
+}
+
 static lib_t lib_init(const char *name, const char *rpath, int lock_fd)
 {
    lib_t l = xcalloc(sizeof(struct _lib));
@@ -254,20 +272,7 @@ static lib_t lib_init(const char *name, const char *rpath, int lock_fd)
       debugf("library %s at %s", istr(l->name), l->path);
 
    if (l->lock_fd == -1 && rpath != NULL) {
-      LOCAL_TEXT_BUF lock_path = lib_file_path(l, "_NVC_LIB");
-
-      // Try to open the lock file read-write as this is required for
-      // exlusive locking on some NFS implementations
-      if ((l->lock_fd = open(tb_get(lock_path), O_RDWR)) < 0
-          && (errno == EACCES || errno == EPERM || errno == EROFS)) {
-         // Try again in read-only mode
-         l->lock_fd = open(tb_get(lock_path), O_RDONLY);
-         l->readonly = true;
-      }
-
-      if (l->lock_fd < 0)
-         fatal_errno("open: %s", tb_get(lock_path));
-
+      lib_open_lock(l);
       file_read_lock(l->lock_fd);
    }
 
@@ -328,7 +333,8 @@ static void lib_mark_obsolete(lib_t lib, lib_unit_t *lu, object_t *new)
       diag_emit(d);
    }
 
-   arena_set_obsolete(object_arena(lu->object), true);
+   lu->replaced = object_arena(lu->object);
+   arena_set_obsolete(lu->replaced, true);
 }
 
 static lib_unit_t *lib_put_aux(lib_t lib, object_t *object, bool dirty,
@@ -578,6 +584,18 @@ lib_t lib_new(const char *spec)
    return lib_init(name, path, fd);
 }
 
+void lib_reopen_locks(void)
+{
+   // A forked child shares the open file description and hence the
+   // flock(2) lock with its parent so must open its own lock file
+   for (lib_list_t *it = loaded; it != NULL; it = it->next) {
+      if (it->item->lock_fd != -1) {
+         close(it->item->lock_fd);
+         lib_open_lock(it->item);
+      }
+   }
+}
+
 lib_t lib_tmp(const char *name)
 {
    // For unit tests, avoids creating files
@@ -853,18 +871,29 @@ static void lib_read_meta(fbuf_t *f, unit_meta_t *meta)
    read_raw(meta->cover_file, len + 1, f);
 }
 
-static lib_unit_t *lib_read_unit(lib_t lib, ident_t id)
+static lib_unit_t *lib_map_unit(lib_t lib, int fd, const char *name)
 {
-   LOCAL_TEXT_BUF tb = tb_new();
-   lib_encode_file_name(id, tb);
+   LOCAL_TEXT_BUF path = lib_file_path(lib, name);
+
+   file_info_t info;
+   if (!get_handle_info(fd, &info))
+      fatal_errno("%s", tb_get(path));
 
-   fbuf_t *f = lib_fbuf_open(lib, tb_get(tb), FBUF_IN, FBUF_CS_ADLER32);
+   object_t *obj = object_map_image(fd, tb_get(path), lib_load_handler);
+
+   unit_meta_t meta = {};
+   return lib_put_aux(lib, obj, false, false, info.mtime, &meta);
+}
+
+static lib_unit_t *lib_read_stream(lib_t lib, const char *name)
+{
+   fbuf_t *f = lib_fbuf_open(lib, name, FBUF_IN, FBUF_CS_ADLER32);
    if (f == NULL)
       return NULL;
 
    file_info_t info;
    if (!get_handle_info(fbuf_file_handle(f), &info))
-      fatal_errno("%s", tb_get(tb));
+      fatal_errno("%s", name);
 
    ident_rd_ctx_t ident_ctx = ident_read_begin(f);
    loc_rd_ctx_t *loc_ctx = loc_read_begin(f);
@@ -885,24 +914,46 @@ static lib_unit_t *lib_read_unit(lib_t lib, ident_t id)
          // Ignore it (remove after 1.12 release)
          break;
       default:
-         fatal_trace("unhandled tag %c in %s", tag, tb_get(tb));
+         fatal_trace("unhandled tag %c in %s", tag, name);
       }
    }
 
    loc_read_end(loc_ctx);
    ident_read_end(ident_ctx);
 
-   uint32_t checksum;
-   fbuf_close(f, &checksum);
+   fbuf_close(f, NULL);
 
    if (obj == NULL)
-      fatal_trace("%s did not contain a HDL design unit", tb_get(tb));
-
-   arena_set_checksum(object_arena(obj), checksum);
+      fatal_trace("%s did not contain a HDL design unit", name);
 
    return lib_put_aux(lib, obj, false, false, info.mtime, &meta);
 }
 
+static lib_unit_t *lib_read_unit(lib_t lib, ident_t id)
+{
+   LOCAL_TEXT_BUF tb = tb_new();
+   lib_encode_file_name(id, tb);
+
+   FILE *f = lib_fopen(lib, tb_get(tb), "rb");
+   if (f == NULL)
+      return NULL;
+
+   // Units saved as arena images are mapped directly and anything else
+   // must have been written using the older compressed format
+   char magic[4];
+   const bool image = fread(magic, sizeof(magic), 1, f) == 1
+      && memcmp(magic, "FBUF", sizeof(magic)) != 0;
+
+   lib_unit_t *lu;
+   if (image)
+      lu = lib_map_unit(lib, fileno(f), tb_get(tb));
+   else
+      lu = lib_read_stream(lib, tb_get(tb));
+
+   fclose(f);
+   return lu;
+}
+
 static lib_unit_t *lib_get_aux(lib_t lib, ident_t ident)
 {
    assert(lib != NULL);
@@ -1060,11 +1111,51 @@ ident_t lib_name(lib_t lib)
    return lib->name;
 }
 
+static bool lib_save_image(lib_t lib, lib_unit_t *unit, const char *name)
+{
+   if (unit->meta.cover_file != NULL)
+      return false;
+
+   size_t size;
+   void *image = object_write_image(unit->object, &size);
+   if (image == NULL)
+      return false;
+
+   LOCAL_TEXT_BUF path = lib_file_path(lib, name);
+
+   // Write to a temporary file first as other processes may have the
+   // existing unit mapped into memory
+   char *tmp LOCAL = xasprintf("%s.%d", tb_get(path), getpid());
+
+   FILE *f = fopen(tmp, "wb");
+   if (f == NULL)
+      fatal_errno("failed to create %s in library %s", name, istr(lib->name));
+
+   if (fwrite(image, size, 1, f) != 1 || fclose(f) != 0)
+      fatal_errno("failed to write %s", tmp);
+
+#ifdef __MINGW32__
+   remove(tb_get(path));
+#endif
+
+   if (rename(tmp, tb_get(path)) != 0)
+      fatal_errno("rename: %s", tmp);
+
+   free(image);
+   return true;
+}
+
 static void lib_save_unit(lib_t lib, lib_unit_t *unit)
 {
    LOCAL_TEXT_BUF tb = tb_new();
    lib_encode_file_name(unit->name, tb);
 
+   if (lib_save_image(lib, unit, tb_get(tb))) {
+      assert(unit->dirty);
+      unit->dirty = false;
+      return;
+   }
+
    fbuf_t *f = lib_fbuf_open(lib, tb_get(tb), FBUF_OUT, FBUF_CS_ADLER32);
    if (f == NULL)
       fatal("failed to create %s in library %s", tb_get(tb), istr(lib->name));
@@ -1074,8 +1165,6 @@ static void lib_save_unit(lib_t lib, lib_unit_t *unit)
    ident_wr_ctx_t ident_ctx = ident_write_begin(f);
    loc_wr_ctx_t *loc_ctx = loc_write_begin(f);
 
-   object_arena_t *arena = object_arena(unit->object);
-
    object_write(unit->object, f, ident_ctx, loc_ctx);
 
    if (unit->meta.cover_file != NULL) {
@@ -1091,10 +1180,7 @@ static void lib_save_unit(lib_t lib, lib_unit_t *unit)
    loc_write_end(loc_ctx);
    ident_write_end(ident_ctx);
 
-   uint32_t checksum;
-   fbuf_close(f, &checksum);
-
-   arena_set_checksum(arena, checksum);
+   fbuf_close(f, NULL);
 
    assert(unit->dirty);
    unit->dirty = false;
@@ -1110,6 +1196,17 @@ void lib_save(lib_t lib)
 
    freeze_global_arena();
 
+   // Units that depend on a replaced design unit are still valid if the
+   // new version has the same interface fingerprint
+   for (lib_unit_t *lu = lib->units; lu; lu = lu->next) {
+      if (lu->dirty && !lu->error && lu->replaced != NULL) {
+         object_arena_t *arena = object_arena(lu->object);
+         if (arena_fingerprint(lu->replaced) == arena_fingerprint(arena))
+            arena_set_obsolete(lu->replaced, false);
+         lu->replaced = NULL;
+      }
+   }
+
    for (lib_unit_t *lu = lib->units; lu; lu = lu->next) {
       if (lu->dirty) {
          if (lu->error)
@@ -47,6 +47,7 @@ void lib_add_map(const char *name, const char *path);
 void lib_delete(lib_t lib, const char *name);
 void lib_print_search_paths(text_buf_t *tb);
 void lib_search_paths_to_diag(diag_t *d);
+void lib_reopen_locks(void);
 
 typedef bool (*lib_walk_fn_t)(lib_t, void *);
 void lib_for_all(lib_walk_fn_t fn, void *ctx);
@@ -13499,6 +13499,12 @@ bool unit_registry_query(unit_registry_t *ur, ident_t ident)
    return hash_get(ur->map, ident) != NULL;
 }
 
+bool unit_registry_pending(unit_registry_t *ur, ident_t ident)
+{
+   void *ptr = hash_get(ur->map, ident);
+   return ptr != NULL && pointer_tag(ptr) == UNIT_GENERATED;
+}
+
 void unit_registry_purge(unit_registry_t *ur, ident_t prefix)
 {
    if (hash_get(ur->map, prefix) == NULL)
@@ -36,6 +36,7 @@ void unit_registry_defer(unit_registry_t *ur, ident_t ident,
                          object_t *object);
 void unit_registry_purge(unit_registry_t *ur, ident_t prefix);
 bool unit_registry_query(unit_registry_t *ur, ident_t ident);
+bool unit_registry_pending(unit_registry_t *ur, ident_t ident);
 void unit_registry_finalise(unit_registry_t *ur, lower_unit_t *lu);
 void unit_registry_flush(unit_registry_t *ur, ident_t name);
 vcode_unit_t unit_registry_get_parent(unit_registry_t *ur, ident_t name);
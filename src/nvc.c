@@ -16,9 +16,12 @@
 //
 
 #include "util.h"
+#include "array.h"
 #include "common.h"
 #include "cov/cov-api.h"
 #include "diag.h"
+#include "hash.h"
+#include "ident.h"
 #include "jit/jit-llvm.h"
 #include "jit/jit.h"
 #include "lib.h"
@@ -50,6 +53,11 @@
 #include <dirent.h>
 #include <time.h>
 
+#ifndef __MINGW32__
+#include <fcntl.h>
+#include <sys/wait.h>
+#endif
+
 #if HAVE_GIT_SHA
 #include "gitsha.h"
 #define GIT_SHA_ONLY(x) x
@@ -151,7 +159,9 @@ static void parse_pp_define(char *optarg)
    }
 }
 
-static void do_file_list(const char *file, jit_t *jit, unit_registry_t *ur)
+typedef A(char *) string_list_t;
+
+static void read_file_list(const char *file, string_list_t *files)
 {
    FILE *f;
    if (strcmp(file, "-") == 0)
@@ -172,13 +182,330 @@ static void do_file_list(const char *file, jit_t *jit, unit_registry_t *ur)
       if (strlen(line) == 0)
          continue;
 
-      analyse_file(line, jit, ur);
+      APUSH(*files, xstrdup(line));
    }
 
    free(line);
    fclose(f);
 }
 
+typedef enum {
+   JOB_PENDING, JOB_RUNNING, JOB_DONE, JOB_FAILED, JOB_SKIPPED
+} job_state_t;
+
+typedef A(int) index_list_t;
+typedef A(ident_t) ident_list_t;
+
+typedef struct {
+   const char   *file;
+   char         *logfile;
+   pid_t         pid;
+   job_state_t   state;
+   bool          barrier;
+   ident_list_t  refs;
+   ident_list_t  defines;
+   index_list_t  deps;
+} analysis_job_t;
+
+typedef A(analysis_job_t) analysis_list_t;
+
+#ifndef __MINGW32__
+static void drop_diag(diag_t *d, void *ctx)
+{
+   // Errors are reported again when the file is analysed
+}
+
+static void scan_dependencies(analysis_job_t *job, ident_list_t *preload,
+                              hset_t *preload_set)
+{
+   input_from_file(job->file);
+
+   if (source_kind() != SOURCE_VHDL) {
+      job->barrier = true;   // Dependencies only tracked for VHDL
+      return;
+   }
+
+   extern yylval_t yylval;
+
+   ident_t work_i = well_known(W_WORK), work_name = lib_name(lib_work());
+   hset_t *seen = hset_new(128);
+
+   // Match design unit declarations and context clauses against a
+   // small window of the most recent tokens without a full parse
+   token_t tok[5] = {};
+   ident_t id[5] = {};
+   for (token_t next; (next = processed_yylex()) != tEOF; ) {
+      memmove(tok, tok + 1, 4 * sizeof(token_t));
+      memmove(id, id + 1, 4 * sizeof(ident_t));
+      tok[4] = next;
+      id[4] = next == tID ? yylval.ident : NULL;
+      free_token(next, &yylval);
+
+      switch (next) {
+      case tID:
+         if (!hset_contains(seen, id[4])) {
+            hset_insert(seen, id[4]);
+            APUSH(job->refs, id[4]);
+         }
+
+         if (tok[3] == tDOT && tok[2] == tID
+             && (tok[1] == tUSE || tok[1] == tCONTEXT)
+             && id[2] != work_i && id[2] != work_name) {
+            ident_t qual = ident_prefix(id[2], id[4], '.');
+            if (!hset_contains(preload_set, qual)) {
+               hset_insert(preload_set, qual);
+               APUSH(*preload, qual);
+            }
+         }
+         break;
+
+      case tIS:
+         if (tok[3] != tID)
+            break;
+         else if (tok[2] == tENTITY || tok[2] == tPACKAGE
+                  || tok[2] == tCONTEXT || tok[2] == tBODY)
+            APUSH(job->defines, id[3]);
+         else if (tok[2] == tOF && tok[1] == tID && tok[0] == tARCHITECTURE)
+            APUSH(job->defines, id[3]);   // Make the entity depend on it
+         break;
+
+      case tOF:
+         if (tok[3] == tID && tok[2] == tCONFIGURATION)
+            APUSH(job->defines, id[3]);
+         break;
+      }
+   }
+
+   hset_free(seen);
+}
+
+static int index_cmp(const void *a, const void *b)
+{
+   return *(const int *)a - *(const int *)b;
+}
+
+static void build_dependencies(analysis_list_t *jobs)
+{
+   hash_t *definers = hash_new(256);
+   index_list_t *lists = xcalloc_array(jobs->count, sizeof(index_list_t));
+
+   for (int i = 0, nlists = 0; i < jobs->count; i++) {
+      analysis_job_t *job = &(jobs->items[i]);
+      for (int j = 0; j < job->defines.count; j++) {
+         index_list_t *l = hash_get(definers, job->defines.items[j]);
+         if (l == NULL) {
+            l = &(lists[nlists++]);
+            hash_put(definers, job->defines.items[j], l);
+         }
+
+         if (l->count == 0 || l->items[l->count - 1] != i)
+            APUSH(*l, i);
+      }
+   }
+
+   // A file depends on every other file which defines a unit it might
+   // reference: the order of the files on the command line breaks any
+   // cycles so the dependencies always point backwards
+   for (int i = 0; i < jobs->count; i++) {
+      analysis_job_t *job = &(jobs->items[i]);
+      for (int j = 0; j < job->refs.count; j++) {
+         index_list_t *l = hash_get(definers, job->refs.items[j]);
+         for (int k = 0; l != NULL && k < l->count; k++) {
+            const int other = l->items[k];
+            if (other < i)
+               APUSH(job->deps, other);
+            else if (other > i)
+               APUSH(jobs->items[other].deps, i);
+         }
+      }
+   }
+
+   for (int i = 0, last_barrier = -1; i < jobs->count; i++) {
+      analysis_job_t *job = &(jobs->items[i]);
+      if (job->barrier) {
+         for (int j = 0; j < i; j++)
+            APUSH(job->deps, j);
+         last_barrier = i;
+      }
+      else if (last_barrier >= 0)
+         APUSH(job->deps, last_barrier);
+
+      qsort(job->deps.items, job->deps.count, sizeof(int), index_cmp);
+
+      int n = 0;
+      for (int j = 0; j < job->deps.count; j++) {
+         if (n == 0 || job->deps.items[n - 1] != job->deps.items[j])
+            job->deps.items[n++] = job->deps.items[j];
+      }
+      ATRIM(job->deps, n);
+   }
+
+   for (int i = 0; i < jobs->count; i++)
+      ACLEAR(lists[i]);
+   free(lists);
+   hash_free(definers);
+}
+
+__attribute__((noreturn))
+static void run_analysis_job(analysis_job_t *job, cmd_state_t *state)
+{
+   const int fd = open(job->logfile, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+   if (fd < 0)
+      fatal_errno("cannot create %s", job->logfile);
+
+   dup2(fd, STDOUT_FILENO);
+   dup2(fd, STDERR_FILENO);
+   close(fd);
+
+   term_init();   // Output is no longer a terminal
+
+   lib_reopen_locks();
+
+   jit_t *jit = jit_new(state->registry);
+   analyse_file(job->file, jit, state->registry);
+   jit_free(jit);
+
+   if (error_count() == 0)
+      lib_save(lib_work());
+
+   fflush(NULL);
+   _exit(error_count() > 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+static void copy_analysis_log(analysis_job_t *job)
+{
+   FILE *f = fopen(job->logfile, "r");
+   if (f == NULL)
+      fatal_errno("cannot open %s", job->logfile);
+
+   char buf[4096];
+   size_t nbytes;
+   while ((nbytes = fread(buf, 1, sizeof(buf), f)) > 0)
+      fwrite(buf, 1, nbytes, stderr);
+
+   fclose(f);
+   remove(job->logfile);
+}
+
+static bool analyse_parallel(string_list_t *files, int max_jobs,
+                             cmd_state_t *state)
+{
+   analysis_list_t jobs = AINIT;
+   ident_list_t preload = AINIT;
+   hset_t *preload_set = hset_new(64);
+
+   diag_set_consumer(drop_diag, NULL);
+
+   for (int i = 0; i < files->count; i++) {
+      analysis_job_t job = { .file = files->items[i] };
+      APUSH(jobs, job);
+      scan_dependencies(&(jobs.items[i]), &preload, preload_set);
+   }
+
+   diag_set_consumer(NULL, NULL);
+   reset_error_count();
+
+   build_dependencies(&jobs);
+
+   // Units from other libraries loaded here are shared with each child
+   // rather than read from disk again
+   for (int i = 0; i < preload.count; i++) {
+      ident_t uname = preload.items[i];
+      lib_t lib = lib_find(ident_walk_selected(&uname));
+      if (lib != NULL) {
+         bool error;
+         lib_get_allow_error(lib, preload.items[i], &error);
+      }
+   }
+
+   // Flush buffered output so it is not repeated by each child
+   fflush(NULL);
+
+   int running = 0, finished = 0, failed = 0;
+   while (finished < jobs.count) {
+      analysis_job_t *ready = NULL;
+      for (int i = 0; i < jobs.count && ready == NULL; i++) {
+         analysis_job_t *job = &(jobs.items[i]);
+         if (job->state != JOB_PENDING)
+            continue;
+
+         bool blocked = false;
+         for (int j = 0; j < job->deps.count; j++) {
+            const job_state_t dep = jobs.items[job->deps.items[j]].state;
+            if (dep == JOB_FAILED || dep == JOB_SKIPPED) {
+               job->state = JOB_SKIPPED;
+               finished++;
+               break;
+            }
+            else if (dep != JOB_DONE)
+               blocked = true;
+         }
+
+         if (job->state == JOB_PENDING && !blocked)
+            ready = job;
+      }
+
+      if (ready != NULL && running < max_jobs) {
+         ready->logfile = nvc_temp_file();
+         ready->state = JOB_RUNNING;
+
+         if ((ready->pid = thread_fork()) == 0)
+            run_analysis_job(ready, state);
+
+         running++;
+         continue;
+      }
+      else if (running == 0)
+         continue;   // Jobs were skipped
+
+      int status;
+      const pid_t pid = waitpid(-1, &status, 0);
+      if (pid < 0)
+         fatal_errno("waitpid");
+
+      analysis_job_t *job = NULL;
+      for (int i = 0; i < jobs.count && job == NULL; i++) {
+         if (jobs.items[i].state == JOB_RUNNING && jobs.items[i].pid == pid)
+            job = &(jobs.items[i]);
+      }
+
+      if (job == NULL)
+         continue;   // Not one of ours
+
+      running--;
+      finished++;
+
+      copy_analysis_log(job);
+
+      if (WIFSIGNALED(status)) {
+         errorf("analysis of %s terminated by signal %d", job->file,
+                WTERMSIG(status));
+         job->state = JOB_FAILED;
+      }
+      else if (WEXITSTATUS(status) != 0)
+         job->state = JOB_FAILED;
+      else
+         job->state = JOB_DONE;
+
+      if (job->state == JOB_FAILED)
+         failed++;
+   }
+
+   for (int i = 0; i < jobs.count; i++) {
+      analysis_job_t *job = &(jobs.items[i]);
+      ACLEAR(job->refs);
+      ACLEAR(job->defines);
+      ACLEAR(job->deps);
+      free(job->logfile);
+   }
+   ACLEAR(jobs);
+   ACLEAR(preload);
+   hset_free(preload_set);
+
+   return failed == 0;
+}
+#endif
+
 static int analyse(int argc, char **argv, cmd_state_t *state)
 {
    static struct option long_options[] = {
@@ -194,13 +521,14 @@ static int analyse(int argc, char **argv, cmd_state_t *state)
       { "no-save",         no_argument,       0, 'N' },
       { "single-unit",     no_argument,       0, 'u' },
       { "preserve-case",   no_argument,       0, 'p' },
+      { "jobs",            required_argument, 0, 'j' },
       { 0, 0, 0, 0 }
    };
 
    const int next_cmd = scan_cmd(2, argc, argv);
-   int c, index = 0, error_limit = 20;
+   int c, index = 0, error_limit = 20, max_jobs = 1;
    const char *file_list = NULL;
-   const char *spec = ":D:f:";
+   const char *spec = ":D:f:j:";
    bool no_save = false;
 
    while ((c = getopt_long(next_cmd, argv, spec, long_options, &index)) != -1) {
@@ -250,6 +578,10 @@ static int analyse(int argc, char **argv, cmd_state_t *state)
       case 'p':
          opt_set_int(OPT_PRESERVE_CASE, 1);
          break;
+      case 'j':
+         if ((max_jobs = parse_int(optarg)) < 1)
+            fatal("invalid number of jobs: %s", optarg);
+         break;
       default:
          should_not_reach_here();
       }
@@ -261,22 +593,50 @@ static int analyse(int argc, char **argv, cmd_state_t *state)
       state->registry = unit_registry_new();
 
    lib_t work = lib_work();
-   jit_t *jit = jit_new(state->registry);
+
+   string_list_t files = AINIT;
 
    if (file_list != NULL)
-      do_file_list(file_list, jit, state->registry);
+      read_file_list(file_list, &files);
 
    for (int i = optind; i < next_cmd; i++) {
       if (argv[i][0] == '@')
-         do_file_list(argv[i] + 1, jit, state->registry);
+         read_file_list(argv[i] + 1, &files);
       else
-         analyse_file(argv[i], jit, state->registry);
+         APUSH(files, xstrdup(argv[i]));
    }
 
-   jit_free(jit);
+   // Options which affect the contents of the work library across
+   // files must use the serial path below
+   bool parallel = max_jobs > 1 && files.count > 1 && !no_save
+      && !opt_get_int(OPT_SINGLE_UNIT) && !opt_get_int(OPT_PRESERVE_CASE)
+      && error_count() == 0;
+
+   for (int i = 0; parallel && i < files.count; i++)
+      parallel = strcmp(files.items[i], "-") != 0;
+
+   bool ok = true;
+#ifndef __MINGW32__
+   if (parallel)
+      ok = analyse_parallel(&files, max_jobs, state);
+   else
+#endif
+   {
+      jit_t *jit = jit_new(state->registry);
+
+      for (int i = 0; i < files.count; i++)
+         analyse_file(files.items[i], jit, state->registry);
+
+      jit_free(jit);
+   }
+
+   for (int i = 0; i < files.count; i++)
+      free(files.items[i]);
+   ACLEAR(files);
+
    set_error_limit(0);
 
-   if (error_count() > 0)
+   if (!ok || error_count() > 0)
       return EXIT_FAILURE;
 
    if (!no_save)
@@ -403,6 +763,7 @@ static int elaborate(int argc, char **argv, cmd_state_t *state)
       { "jit",             no_argument,       0, 'j' },
       { "no-collapse",     no_argument,       0, 'C' },
       { "trace",           no_argument,       0, 't' },
+      { "aot",             no_argument,       0, 'A' },
       { 0, 0, 0, 0 }
    };
 
@@ -446,6 +807,13 @@ static int elaborate(int argc, char **argv, cmd_state_t *state)
       case 'j':
          use_jit = true;
          break;
+      case 'A':
+#ifndef HAVE_LLVM
+         fatal("$bold$--aot$$ requires LLVM support");
+#endif
+         opt_set_int(OPT_AOT_OPTIMISE, 1);
+         use_jit = false;
+         break;
       case 'g':
          parse_generic(optarg);
          break;
@@ -674,6 +1042,271 @@ static void ctrl_c_handler(void *arg)
    model_interrupt(model);
 }
 
+typedef struct {
+   const char *fname;
+   uint64_t    when;
+} checkpoint_req_t;
+
+static void checkpoint_cb(rt_model_t *m, void *user)
+{
+   const checkpoint_req_t *req = user;
+
+   // Wait until the next time step would be after the requested time
+   if ((uint64_t)model_next_time(m) <= req->when) {
+      model_set_global_cb(m, RT_END_TIME_STEP, checkpoint_cb, user);
+      return;
+   }
+
+   fbuf_t *f = fbuf_open(req->fname, FBUF_OUT, FBUF_CS_NONE);
+   if (f == NULL)
+      fatal_errno("cannot create %s", req->fname);
+
+   model_save(m, f);
+   fbuf_close(f, NULL);
+}
+
+static void restore_checkpoint(rt_model_t *m, const char *fname)
+{
+   fbuf_t *f = fbuf_open(fname, FBUF_IN, FBUF_CS_NONE);
+   if (f == NULL)
+      fatal_errno("cannot open %s", fname);
+
+   model_restore(m, f);
+   fbuf_close(f, NULL);
+}
+
+typedef struct {
+   string_list_t plusargs;
+   string_list_t env;
+   bool          shuffle;
+   unsigned      seed;
+   char         *logfile;
+   pid_t         pid;
+   uint64_t      start;
+} batch_job_t;
+
+typedef A(batch_job_t) batch_list_t;
+
+static void read_batch_file(const char *file, batch_list_t *jobs)
+{
+   FILE *f = fopen(file, "r");
+   if (f == NULL)
+      fatal_errno("failed to open %s", file);
+
+   char *line = NULL;
+   size_t nchars, bufsz = 0;
+   for (int lineno = 1; (nchars = getline(&line, &bufsz, f)) != -1;
+        lineno++) {
+      char *stop = strpbrk(line, "\r\n#") ?: line + nchars;
+      *stop = '\0';
+
+      batch_job_t job = {};
+
+      for (char *tok = strtok(line, " \t"); tok; tok = strtok(NULL, " \t")) {
+         if (tok[0] == '+')
+            APUSH(job.plusargs, xstrdup(tok));
+         else if (strncmp(tok, "--seed=", 7) == 0) {
+            job.shuffle = true;
+            job.seed = parse_int(tok + 7);
+         }
+         else if (strchr(tok, '=') != NULL && tok[0] != '=')
+            APUSH(job.env, xstrdup(tok));
+         else
+            fatal("%s:%d: unexpected '%s' in batch file", file, lineno, tok);
+      }
+
+      if (job.plusargs.count > 0 || job.env.count > 0 || job.shuffle)
+         APUSH(*jobs, job);
+   }
+
+   free(line);
+   fclose(f);
+}
+
+typedef struct {
+   tree_t       top;
+   const char  *plugins;
+   int          nplusargs;
+   char       **plusargs;
+   const char  *restore;
+   uint64_t     stop_time;
+} run_args_t;
+
+static void start_model(cmd_state_t *state, const run_args_t *args)
+{
+   // Package and instance initialisers run as the scopes are created
+   // and may read the plusargs, unless the model was already created
+   // during elaboration with --jit
+   sim_pkg_set_plusargs(args->nplusargs, args->plusargs);
+
+   if (state->model == NULL) {
+      state->model = model_new(state->jit, state->cover);
+      create_scope(state->model, args->top, NULL);
+   }
+
+   if (state->vhpi == NULL)
+      state->vhpi = vhpi_context_new();
+
+   if (state->vpi == NULL)
+      state->vpi = vpi_context_new();
+
+   if (args->plugins != NULL || state->plugins != NULL) {
+      vhpi_context_initialise(state->vhpi, args->top, state->model,
+                              state->jit, args->nplusargs, args->plusargs);
+      vpi_context_initialise(state->vpi, args->top, state->model,
+                             state->jit, args->nplusargs, args->plusargs);
+   }
+
+   if (args->plugins != NULL)
+      vhpi_load_plugins(args->plugins);
+}
+
+static void stop_model(cmd_state_t *state)
+{
+   vhpi_context_free(state->vhpi);
+   state->vhpi = NULL;
+
+   vpi_context_free(state->vpi);
+   state->vpi = NULL;
+
+   model_free(state->model);
+   state->model = NULL;
+}
+
+#ifndef __MINGW32__
+__attribute__((noreturn))
+static void run_batch_job(batch_job_t *job, cmd_state_t *state,
+                          const run_args_t *args)
+{
+   const int fd = open(job->logfile, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+   if (fd < 0)
+      fatal_errno("cannot create %s", job->logfile);
+
+   dup2(fd, STDOUT_FILENO);
+   dup2(fd, STDERR_FILENO);
+   close(fd);
+
+   term_init();   // Output is no longer a terminal
+
+   for (int i = 0; i < job->env.count; i++) {
+      char *eq = strchr(job->env.items[i], '=');
+      *eq = '\0';
+      setenv(job->env.items[i], eq + 1, 1);
+   }
+
+   // The model is only created now so that package and instance
+   // initialisers see this job's environment and plusargs
+   run_args_t job_args = *args;
+   job_args.nplusargs += job->plusargs.count;
+   job_args.plusargs = xmalloc_array(job_args.nplusargs, sizeof(char *));
+
+   for (int i = 0; i < args->nplusargs; i++)
+      job_args.plusargs[i] = args->plusargs[i];
+   for (int i = 0; i < job->plusargs.count; i++)
+      job_args.plusargs[args->nplusargs + i] = job->plusargs.items[i];
+
+   start_model(state, &job_args);
+
+   set_ctrl_c_handler(ctrl_c_handler, state->model);
+
+   model_reset(state->model);
+
+   if (args->restore != NULL)
+      restore_checkpoint(state->model, args->restore);
+
+   if (job->shuffle)
+      model_shuffle(state->model, job->seed);
+
+   model_run(state->model, args->stop_time);
+
+   const int rc = model_exit_status(state->model);
+
+   stop_model(state);
+
+   fflush(NULL);
+   _exit(rc);
+}
+#endif
+
+static int run_batch(const char *file, int max_jobs, cmd_state_t *state,
+                     const run_args_t *args)
+{
+#ifdef __MINGW32__
+   fatal("$bold$--batch$$ is not supported on this platform");
+#else
+   batch_list_t jobs = AINIT;
+   read_batch_file(file, &jobs);
+
+   if (jobs.count == 0)
+      fatal("no jobs in batch file %s", file);
+
+   // Flush buffered output so it is not repeated by each child
+   fflush(NULL);
+
+   int next = 0, running = 0, failed = 0;
+   while (next < jobs.count || running > 0) {
+      if (next < jobs.count && running < max_jobs) {
+         batch_job_t *job = &(jobs.items[next]);
+         job->logfile = xasprintf("%s.%d.log", top_level_orig, ++next);
+         job->start = get_timestamp_us();
+
+         if ((job->pid = thread_fork()) == 0)
+            run_batch_job(job, state, args);
+
+         running++;
+         continue;
+      }
+
+      int status;
+      const pid_t pid = waitpid(-1, &status, 0);
+      if (pid < 0)
+         fatal_errno("waitpid");
+
+      batch_job_t *job = NULL;
+      for (int i = 0; i < next && job == NULL; i++) {
+         if (jobs.items[i].pid == pid)
+            job = &(jobs.items[i]);
+      }
+
+      if (job == NULL)
+         continue;   // Not one of ours
+
+      running--;
+
+      const double secs = (get_timestamp_us() - job->start) / 1e6;
+
+      if (WIFSIGNALED(status)) {
+         errorf("%s terminated by signal %d after %.2fs", job->logfile,
+                WTERMSIG(status), secs);
+         failed++;
+      }
+      else if (WEXITSTATUS(status) != 0) {
+         errorf("%s failed with status %d after %.2fs", job->logfile,
+                WEXITSTATUS(status), secs);
+         failed++;
+      }
+      else
+         notef("%s passed in %.2fs", job->logfile, secs);
+   }
+
+   notef("%d of %d batch jobs passed", jobs.count - failed, jobs.count);
+
+   for (int i = 0; i < jobs.count; i++) {
+      batch_job_t *job = &(jobs.items[i]);
+      for (int j = 0; j < job->plusargs.count; j++)
+         free(job->plusargs.items[j]);
+      for (int j = 0; j < job->env.count; j++)
+         free(job->env.items[j]);
+      ACLEAR(job->plusargs);
+      ACLEAR(job->env);
+      free(job->logfile);
+   }
+   ACLEAR(jobs);
+
+   return failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+#endif
+}
+
 static jit_t *get_jit(unit_registry_t *ur)
 {
    jit_t *jit = jit_new(ur);
@@ -682,11 +1315,12 @@ static jit_t *get_jit(unit_registry_t *ur)
    jit_preload(jit);
 #endif
 
-#if defined HAVE_LLVM && 1
-   jit_register_llvm_plugin(jit);
-#elif defined ARCH_X86_64 && 0
+#ifdef ARCH_X86_64
    jit_register_native_plugin(jit);
 #endif
+#ifdef HAVE_LLVM
+   jit_register_llvm_plugin(jit);
+#endif
 
    _std_standard_init();
    _std_env_init();
@@ -748,7 +1382,7 @@ static int run_cmd(int argc, char **argv, cmd_state_t *state)
 {
    static struct option long_options[] = {
       { "trace",         no_argument,       0, 't' },
-      { "profile",       no_argument,       0, 'p' },   // DEPRECATED 1.14
+      { "profile",       optional_argument, 0, 'p' },
       { "stop-time",     required_argument, 0, 's' },
       { "stats",         no_argument,       0, 'S' },
       { "wave",          optional_argument, 0, 'w' },
@@ -764,14 +1398,25 @@ static int run_cmd(int argc, char **argv, cmd_state_t *state)
       { "vhpi-trace",    no_argument,       0, 'T' },
       { "gtkw",          optional_argument, 0, 'g' },
       { "shuffle",       no_argument,       0, 'H' },
+      { "parallel",      no_argument,       0, 'P' },
+      { "checkpoint",    required_argument, 0, 'c' },
+      { "checkpoint-at", required_argument, 0, 'C' },
+      { "restore",       required_argument, 0, 'R' },
+      { "batch",         required_argument, 0, 'B' },
+      { "jobs",          required_argument, 0, 'j' },
       { 0, 0, 0, 0 }
    };
 
-   wave_format_t wave_fmt = WAVE_FORMAT_FST;
-   uint64_t      stop_time = TIME_HIGH;
-   const char   *wave_fname = NULL;
-   const char   *gtkw_fname = NULL;
-   const char   *pli_plugins = NULL;
+   wave_format_t    wave_fmt = WAVE_FORMAT_FST;
+   uint64_t         stop_time = TIME_HIGH;
+   const char      *wave_fname = NULL;
+   const char      *gtkw_fname = NULL;
+   const char      *pli_plugins = NULL;
+   const char      *restore_fname = NULL;
+   const char      *batch_fname = NULL;
+   int              batch_jobs = nvc_nprocs();
+   checkpoint_req_t checkpoint = { NULL, 0 };
+   bool             checkpoint_at = false;
 
    static bool have_run = false;
    if (have_run)
@@ -796,7 +1441,7 @@ static int run_cmd(int argc, char **argv, cmd_state_t *state)
          opt_set_int(OPT_RT_TRACE, 1);
          break;
       case 'p':
-         warnf("the $bold$--profile$$ option is deprecated and has no effect");
+         opt_set_str(OPT_RT_PROFILE, optarg ?: "");
          break;
       case 'T':
          opt_set_str(OPT_PLI_TRACE, "1");
@@ -871,11 +1516,47 @@ static int run_cmd(int argc, char **argv, cmd_state_t *state)
                "as non-deterministic behaviour");
          opt_set_int(OPT_SHUFFLE_PROCS, 1);
          break;
+      case 'P':
+         opt_set_int(OPT_PARALLEL_PROCS, 1);
+         break;
+      case 'c':
+         checkpoint.fname = optarg;
+         break;
+      case 'C':
+         checkpoint.when = parse_time(optarg);
+         checkpoint_at = true;
+         break;
+      case 'R':
+         restore_fname = optarg;
+         break;
+      case 'B':
+         batch_fname = optarg;
+         break;
+      case 'j':
+         if ((batch_jobs = parse_int(optarg)) < 1)
+            fatal("invalid number of jobs: %s", optarg);
+         break;
       default:
          should_not_reach_here();
       }
    }
 
+   if (checkpoint_at && checkpoint.fname == NULL)
+      fatal("$bold$--checkpoint-at$$ cannot be used without "
+            "$bold$--checkpoint$$");
+
+   if (checkpoint.fname != NULL && pli_plugins != NULL)
+      fatal("$bold$--checkpoint$$ cannot be used with $bold$--load$$");
+
+   if (batch_fname != NULL && checkpoint.fname != NULL)
+      fatal("$bold$--batch$$ cannot be used with $bold$--checkpoint$$");
+   else if (batch_fname != NULL && wave_fname != NULL)
+      fatal("$bold$--batch$$ cannot be used with $bold$--wave$$");
+
+   // Heap objects only need to be registered with the layout of their
+   // pointers if a checkpoint will be saved
+   opt_set_int(OPT_POINTER_MAPS, checkpoint.fname != NULL);
+
    // Shuffle the arguments to put all the plusargs first
    qsort(argv + optind, next_cmd - optind, sizeof(char *), plusarg_cmp);
 
@@ -944,56 +1625,51 @@ static int run_cmd(int argc, char **argv, cmd_state_t *state)
    if (state->cover == NULL)
       state->cover = load_coverage(meta, state->jit);
 
-   if (state->model == NULL) {
-      state->model = model_new(state->jit, state->cover);
-      create_scope(state->model, top, NULL);
-   }
-
-   if (state->vhpi == NULL)
-      state->vhpi = vhpi_context_new();
-
-   if (state->vpi == NULL)
-      state->vpi = vpi_context_new();
+   if (batch_fname != NULL && state->cover != NULL)
+      fatal("$bold$--batch$$ cannot be used with coverage collection");
 
-   if (pli_plugins != NULL || state->plugins != NULL) {
-      vhpi_context_initialise(state->vhpi, top, state->model, state->jit,
-                              nplusargs, plusargs);
-      vpi_context_initialise(state->vpi, top, state->model, state->jit,
-                             nplusargs, plusargs);
-   }
-   else if (nplusargs > 0)
-      warnf("found plusargs on command line but no VHPI plugin was loaded");
+   run_args_t args = {
+      .top       = top,
+      .plugins   = pli_plugins,
+      .nplusargs = nplusargs,
+      .plusargs  = plusargs,
+      .restore   = restore_fname,
+      .stop_time = stop_time,
+   };
 
-   if (pli_plugins != NULL)
-      vhpi_load_plugins(pli_plugins);
+   int rc;
+   if (batch_fname != NULL)
+      rc = run_batch(batch_fname, batch_jobs, state, &args);
+   else {
+      start_model(state, &args);
 
-   set_ctrl_c_handler(ctrl_c_handler, state->model);
+      set_ctrl_c_handler(ctrl_c_handler, state->model);
 
-   model_reset(state->model);
+      model_reset(state->model);
 
-   if (dumper != NULL)
-      wave_dumper_restart(dumper, state->model, state->jit);
+      if (restore_fname != NULL)
+         restore_checkpoint(state->model, restore_fname);
 
-   model_run(state->model, stop_time);
+      if (checkpoint.fname != NULL)
+         model_set_global_cb(state->model, RT_END_TIME_STEP, checkpoint_cb,
+                             &checkpoint);
 
-   set_ctrl_c_handler(NULL, NULL);
+      if (dumper != NULL)
+         wave_dumper_restart(dumper, state->model, state->jit);
 
-   const int rc = model_exit_status(state->model);
+      model_run(state->model, stop_time);
+      rc = model_exit_status(state->model);
 
-   if (dumper != NULL)
-      wave_dumper_free(dumper);
+      set_ctrl_c_handler(NULL, NULL);
 
-   if (state->cover != NULL)
-      emit_coverage(meta, state->jit, state->cover);
+      if (dumper != NULL)
+         wave_dumper_free(dumper);
 
-   vhpi_context_free(state->vhpi);
-   state->vhpi = NULL;
-
-   vpi_context_free(state->vpi);
-   state->vpi = NULL;
+      if (state->cover != NULL)
+         emit_coverage(meta, state->jit, state->cover);
 
-   model_free(state->model);
-   state->model = NULL;
+      stop_model(state);
+   }
 
    argc -= next_cmd - 1;
    argv += next_cmd - 1;
@@ -2067,7 +2743,7 @@ static void usage(void)
       struct {
          const char *args;
          const char *usage;
-      } options[16];
+      } options[20];
    } groups[] = {
       { "Commands",
         {
@@ -2138,6 +2814,7 @@ static void usage(void)
       },
       { "Elaboration options",
         {
+           { "--aot", "Optimise and cache native code for the whole design" },
            { "--cover[={statement,branch,expression,toggle,...}]",
              "Enable code coverage collection" },
            { "--cover-file=FILE",
@@ -2155,6 +2832,14 @@ static void usage(void)
       },
       { "Run options",
         {
+           { "--batch=FILE",
+             "Fork a run for each set of plusargs, environment variables "
+             "and seed listed in FILE" },
+           { "--checkpoint=FILE",
+             "Save the simulation state to FILE at the time given by "
+             "--checkpoint-at" },
+           { "--checkpoint-at=T",
+             "Time after which to save a checkpoint (default 0)" },
            { "--dump-arrays[=N]",
              "Include nested arrays with up to N elements in waveform dump" },
            { "--exclude=GLOB",
@@ -2164,6 +2849,13 @@ static void usage(void)
            { "--format={fst,vcd}", "Waveform dump format" },
            { "--include=GLOB",
              "Include signals matching GLOB in waveform dump" },
+           { "--jobs=N", "Run at most N batch jobs at once" },
+           { "--parallel",
+             "Run processes woken in the same cycle on multiple threads" },
+           { "--profile[=FILE]",
+             "Print a profile summary and write sampled stacks to FILE" },
+           { "--restore=FILE",
+             "Continue simulation from a checkpoint saved in FILE" },
            { "--shuffle", "Run processes in random order" },
            { "--stats", "Print time and memory usage at end of run" },
            { "--stop-delta=N", "Stop after N delta cycles (default 10000)" },
@@ -29,6 +29,7 @@
 #include <stdlib.h>
 #include <inttypes.h>
 #include <signal.h>
+#include <unistd.h>
 
 typedef uint64_t mark_mask_t;
 
@@ -54,7 +55,7 @@ typedef struct _object_arena {
    object_t       *root;
    obj_src_t       source;
    vhdl_standard_t std;
-   uint32_t        checksum;
+   uint32_t        fingerprint;
    generation_t    copygen;
    bool            copyflag;
    bool            frozen;
@@ -185,11 +186,6 @@ static bool object_marked_p(object_t *object, generation_t generation)
    return marked;
 }
 
-void arena_set_checksum(object_arena_t *arena, uint32_t checksum)
-{
-   arena->checksum = checksum;
-}
-
 object_t *arena_root(object_arena_t *arena)
 {
    return arena->root ?: (object_t *)arena->base;
@@ -212,7 +208,7 @@ void arena_set_flags(object_arena_t *arena, uint32_t flags)
 
 void arena_set_obsolete(object_arena_t *arena, bool obsolete)
 {
-   arena->obsolete = true;
+   arena->obsolete = obsolete;
 }
 
 object_arena_t *object_arena(object_t *object)
@@ -431,7 +427,7 @@ static void object_one_time_init(void)
 
          // Increment this each time a incompatible change is made to
          // the on-disk format not expressed in the object items table
-         const uint32_t format_fudge = 43;
+         const uint32_t format_fudge = 44;
 
          format_digest += format_fudge * UINT32_C(2654435761);
 
@@ -775,6 +771,138 @@ object_t *object_rewrite(object_t *object, object_rewrite_ctx_t *ctx)
       return (ctx->cache[index] = object);
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Interface fingerprints
+//
+// The fingerprint of a frozen arena is a hash over every live object in
+// compacted order excluding source locations, combined with the name
+// and fingerprint of each dependency.  Other units refer to objects in
+// this arena by offset so the fingerprint only stays the same when all
+// those offsets and the values they point at are unchanged, which is
+// exactly when units analysed against a previous version remain valid.
+// In particular editing comments or reformatting the source does not
+// change the fingerprint.
+
+static inline uint64_t fingerprint_mix(uint64_t hash, uint64_t value)
+{
+   return mix_bits_64(hash ^ value) + UINT64_C(0x9e3779b97f4a7c15);
+}
+
+static uint64_t fingerprint_bytes(uint64_t hash, const char *bytes,
+                                  size_t len)
+{
+   hash = fingerprint_mix(hash, len);
+
+   for (; len >= sizeof(uint64_t); len -= 8, bytes += 8)
+      hash = fingerprint_mix(hash, unaligned_load(bytes, uint64_t));
+
+   uint64_t tail = 0;
+   memcpy(&tail, bytes, len);
+   return fingerprint_mix(hash, tail);
+}
+
+static uint64_t fingerprint_ref(uint64_t hash, const unsigned *slots,
+                                object_t *object)
+{
+   if (object == NULL)
+      return fingerprint_mix(hash, 0);
+
+   object_arena_t *arena = __object_arena(object);
+   assert(slots[arena->key] != 0);
+
+   uint64_t offset = (void *)object - arena->base;
+   if (arena->forward != NULL)
+      offset = arena->forward[offset >> OBJECT_ALIGN_BITS];
+
+   return fingerprint_mix(hash, ((uint64_t)slots[arena->key] << 32) | offset);
+}
+
+static uint32_t object_fingerprint(object_arena_t *arena)
+{
+   unsigned *slots LOCAL = xcalloc_array(all_arenas.count, sizeof(unsigned));
+   slots[arena->key] = 1;
+
+   uint64_t hash = fingerprint_mix(format_digest, arena->std);
+   hash = fingerprint_mix(hash, arena->flags);
+
+   for (unsigned i = 0; i < arena->deps.count; i++) {
+      object_arena_t *a = arena->deps.items[i];
+      ident_t name = object_arena_name(a);
+      hash = fingerprint_bytes(hash, istr(name), ident_len(name));
+      hash = fingerprint_mix(hash, ((uint64_t)a->std << 32)
+                             | arena_fingerprint(a));
+      slots[a->key] = i + 2;
+   }
+
+   for (void *p = arena->base, *next; p != arena->alloc; p = next) {
+      assert(p < arena->alloc);
+
+      object_t *object = p;
+      const object_class_t *class = classes[object->tag];
+
+      next = p + ALIGN_UP(class->object_size[object->kind], OBJECT_ALIGN);
+
+      if (arena->forward[(p - arena->base) >> OBJECT_ALIGN_BITS] == UINT32_MAX)
+         continue;   // Dead object
+
+      hash = fingerprint_mix(hash, object->tag | (object->kind << 2));
+
+      const imask_t has = class->has_map[object->kind];
+      const int nitems = __builtin_popcountll(has);
+      imask_t mask = 1;
+      for (int n = 0; n < nitems; mask <<= 1) {
+         if (!(has & mask))
+            continue;
+
+         const item_t *item = &(object->items[n++]);
+         if (ITEM_IDENT & mask) {
+            if (item->ident == NULL)
+               hash = fingerprint_mix(hash, 0);
+            else
+               hash = fingerprint_bytes(hash, istr(item->ident),
+                                        ident_len(item->ident));
+         }
+         else if (ITEM_OBJECT & mask)
+            hash = fingerprint_ref(hash, slots, item->object);
+         else if (ITEM_OBJ_ARRAY & mask) {
+            const obj_array_t *a = item->obj_array;
+            const unsigned count = a ? a->count : 0;
+            hash = fingerprint_mix(hash, count);
+            for (unsigned i = 0; i < count; i++)
+               hash = fingerprint_ref(hash, slots, a->items[i]);
+         }
+         else if (ITEM_TEXT & mask)
+            hash = fingerprint_bytes(hash, item->text, strlen(item->text));
+         else if (ITEM_NUMBER & mask) {
+            if (item->number.common.tag == TAG_BIGNUM) {
+               const unsigned width = number_width(item->number);
+               hash = fingerprint_mix(hash, width);
+               for (unsigned i = 0; i < width; i++)
+                  hash = fingerprint_mix(hash, number_bit(item->number, i));
+            }
+            else
+               hash = fingerprint_mix(hash, item->number.bits);
+         }
+         else
+            hash = fingerprint_mix(hash, item->ival);
+      }
+   }
+
+   return (hash >> 32) ^ hash;
+}
+
+uint32_t arena_fingerprint(object_arena_t *arena)
+{
+   if (!arena->frozen)
+      return 0;   // Still being analysed
+   else if (arena->fingerprint == 0) {
+      assert(arena->source == OBJ_FRESH);
+      arena->fingerprint = object_fingerprint(arena) ?: 1;
+   }
+
+   return arena->fingerprint;
+}
+
 static void object_write_ref(object_t *object, fbuf_t *f)
 {
    if (object == NULL)
@@ -811,6 +939,7 @@ void object_write(object_t *root, fbuf_t *f, ident_wr_ctx_t ident_ctx,
    fbuf_put_uint(f, standard());
    fbuf_put_uint(f, ALIGN_UP(arena->live_bytes, OBJECT_PAGE_SZ));
    fbuf_put_uint(f, arena->flags);
+   fbuf_put_uint(f, arena_fingerprint(arena));
    fbuf_put_uint(f, arena->key);
    ident_write(object_arena_name(arena), ident_ctx);
 
@@ -823,7 +952,7 @@ void object_write(object_t *root, fbuf_t *f, ident_wr_ctx_t ident_ctx,
    for (unsigned i = 0; i < arena->deps.count; i++) {
       fbuf_put_uint(f, arena->deps.items[i]->key);
       fbuf_put_uint(f, arena->deps.items[i]->std);
-      fbuf_put_uint(f, arena->deps.items[i]->checksum);
+      fbuf_put_uint(f, arena_fingerprint(arena->deps.items[i]));
       ident_write(object_arena_name(arena->deps.items[i]), ident_ctx);
    }
 
@@ -909,6 +1038,48 @@ static object_t *object_read_ref(fbuf_t *f, const arena_key_t *key_map)
    return (object_t *)((char *)arena->base + offset);
 }
 
+static object_arena_t *object_load_dep(ident_t dep, vhdl_standard_t dstd,
+                                       uint32_t fingerprint,
+                                       object_load_fn_t loader_fn,
+                                       const char *fname, ident_t name)
+{
+   object_arena_t *a = NULL;
+   for (unsigned j = 1; a == NULL && j < all_arenas.count; j++) {
+      if (dep == object_arena_name(all_arenas.items[j]))
+         a = all_arenas.items[j];
+   }
+
+   if (a == NULL) {
+      object_t *droot = NULL;
+      if (loader_fn) droot = (*loader_fn)(dep);
+
+      if (droot == NULL)
+         fatal("%s depends on %s which cannot be found", fname, istr(dep));
+
+      a = __object_arena(droot);
+   }
+
+   if (a->std != dstd)
+      fatal("%s: design unit depends on %s version of %s but conflicting "
+            "%s version has been loaded", fname, standard_text(dstd),
+            istr(dep), standard_text(a->std));
+   else if (arena_fingerprint(a) != fingerprint) {
+      // Units analysed against an earlier version of the dependency
+      // remain valid if none of the objects they can refer to changed
+      diag_t *d = diag_new(DIAG_FATAL, NULL);
+      diag_suppress(d, false);
+      diag_printf(d, "%s: design unit depends on %s with checksum %08x "
+                  "but the current version in the library has checksum "
+                  "%08x", fname, istr(dep), fingerprint, a->fingerprint);
+      diag_hint(d, NULL, "this usually means %s is outdated and needs to "
+                "be reanalysed", istr(name));
+      diag_emit(d);
+      fatal_exit(EXIT_FAILURE);
+   }
+
+   return a;
+}
+
 object_t *object_read(fbuf_t *f, object_load_fn_t loader_fn,
                       ident_rd_ctx_t ident_ctx, loc_rd_ctx_t *loc_ctx)
 {
@@ -940,6 +1111,7 @@ object_t *object_read(fbuf_t *f, object_load_fn_t loader_fn,
    object_arena_t *arena = object_arena_new(size, std);
    arena->source = OBJ_DISK;
    arena->flags  = fbuf_get_uint(f);
+   arena->fingerprint = fbuf_get_uint(f);
 
    arena_key_t key = fbuf_get_uint(f);
    ident_t name = ident_read(ident_ctx);
@@ -953,42 +1125,11 @@ object_t *object_read(fbuf_t *f, object_load_fn_t loader_fn,
    for (int i = 0; i < ndeps; i++) {
       arena_key_t dkey = fbuf_get_uint(f);
       vhdl_standard_t dstd = fbuf_get_uint(f);
-      uint32_t checksum = fbuf_get_uint(f);
+      uint32_t fingerprint = fbuf_get_uint(f);
       ident_t dep = ident_read(ident_ctx);
 
-      object_arena_t *a = NULL;
-      for (unsigned j = 1; a == NULL && j < all_arenas.count; j++) {
-         if (dep == object_arena_name(all_arenas.items[j]))
-            a = all_arenas.items[j];
-      }
-
-      if (a == NULL) {
-         object_t *droot = NULL;
-         if (loader_fn) droot = (*loader_fn)(dep);
-
-         if (droot == NULL)
-            fatal("%s depends on %s which cannot be found",
-                  fbuf_file_name(f), istr(dep));
-
-         a = __object_arena(droot);
-      }
-
-      if (a->std != dstd)
-         fatal("%s: design unit depends on %s version of %s but conflicting "
-               "%s version has been loaded", fbuf_file_name(f),
-               standard_text(dstd), istr(dep), standard_text(a->std));
-      else if (a->checksum != checksum) {
-         diag_t *d = diag_new(DIAG_FATAL, NULL);
-         diag_suppress(d, false);
-         diag_printf(d, "%s: design unit depends on %s with checksum %08x "
-                     "but the current version in the library has checksum %08x",
-                     fbuf_file_name(f), istr(dep), checksum, a->checksum);
-         diag_hint(d, NULL, "this usually means %s is outdated and needs to "
-                   "be reanalysed", istr(name));
-         diag_emit(d);
-         fatal_exit(EXIT_FAILURE);
-      }
-
+      object_arena_t *a = object_load_dep(dep, dstd, fingerprint, loader_fn,
+                                          fbuf_file_name(f), name);
       APUSH(arena->deps, a);
 
       assert(dkey <= max_key);
@@ -1061,6 +1202,464 @@ object_t *object_read(fbuf_t *f, object_load_fn_t loader_fn,
    return (object_t *)arena->base;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Relocatable arena images
+//
+// An image is the compacted contents of a frozen arena followed by the
+// external object arrays and strings, a table of dependencies, the
+// identifier and source file names, and a fixed-size trailer.  Object
+// pointers are stored as an arena slot in the upper 32 bits and a byte
+// offset in the lower 32 bits where slot one is the image itself and
+// the following slots are its dependencies in order.  Identifiers and
+// file references are indexes into the string table.  Loading maps the
+// file copy-on-write over a fresh arena, relocates every object in a
+// single pass, and then write-protects it like any other frozen arena.
+
+#define IMAGE_MAGIC 0x49435653
+
+typedef struct {
+   uint32_t magic;
+   uint32_t digest;
+   uint32_t std;
+   uint32_t flags;
+   uint32_t checksum;
+   uint32_t fingerprint;
+   uint32_t name;
+   uint32_t root;
+   uint32_t objects;
+   uint32_t deps;
+   uint32_t ndeps;
+   uint32_t strings;
+   uint32_t nidents;
+   uint32_t nfiles;
+} image_trailer_t;
+
+typedef struct {
+   uint32_t name;
+   uint32_t std;
+   uint32_t fingerprint;
+} image_dep_t;
+
+typedef struct {
+   uint8_t      *bytes;
+   size_t        size;
+   size_t        limit;
+   unsigned     *slots;
+   hash_t       *ident_map;
+   ihash_t      *file_map;
+   A(ident_t)    idents;
+   A(const char *) files;
+} image_wr_ctx_t;
+
+static size_t image_alloc(image_wr_ctx_t *ctx, size_t size)
+{
+   const size_t offset = ctx->size;
+   const size_t newsz = ALIGN_UP(offset + size, sizeof(uint64_t));
+
+   if (newsz > ctx->limit) {
+      ctx->limit = MAX(newsz, ctx->limit * 2);
+      ctx->bytes = xrealloc(ctx->bytes, ctx->limit);
+   }
+
+   memset(ctx->bytes + offset, '\0', newsz - offset);
+   ctx->size = newsz;
+   return offset;
+}
+
+static uint32_t image_ident(image_wr_ctx_t *ctx, ident_t id)
+{
+   if (id == NULL)
+      return 0;
+
+   void *index = hash_get(ctx->ident_map, id);
+   if (index == NULL) {
+      APUSH(ctx->idents, id);
+      index = (void *)(uintptr_t)ctx->idents.count;
+      hash_put(ctx->ident_map, id, index);
+   }
+
+   return (uintptr_t)index;
+}
+
+static file_ref_t image_file_ref(image_wr_ctx_t *ctx, const loc_t *loc)
+{
+   if (loc->file_ref == FILE_INVALID)
+      return FILE_INVALID;
+
+   void *index = ihash_get(ctx->file_map, loc->file_ref);
+   if (index == NULL) {
+      APUSH(ctx->files, loc_file_str(loc));
+      index = (void *)(uintptr_t)ctx->files.count;
+      ihash_put(ctx->file_map, loc->file_ref, index);
+   }
+
+   return (uintptr_t)index - 1;
+}
+
+static uint64_t image_object_ref(image_wr_ctx_t *ctx, object_t *object)
+{
+   if (object == NULL)
+      return 0;
+
+   object_arena_t *arena = __object_arena(object);
+
+   const uint64_t slot = ctx->slots[arena->key];
+   if (slot == 0)
+      fatal_trace("object in arena %s is not a dependency",
+                  istr(object_arena_name(arena)));
+
+   uint64_t offset = (void *)object - arena->base;
+   if (arena->forward != NULL)
+      offset = arena->forward[offset >> OBJECT_ALIGN_BITS];
+
+   return (slot << 32) | offset;
+}
+
+void *object_write_image(object_t *root, size_t *size)
+{
+   object_arena_t *arena = __object_arena(root);
+   if (root != arena_root(arena))
+      fatal_trace("must write root object first");
+   else if (arena->source == OBJ_DISK)
+      fatal_trace("writing arena %s originally read from disk",
+                  istr(object_arena_name(arena)));
+   else if (!arena->frozen)
+      fatal_trace("arena %s must be frozen before writing to disk",
+                  istr(object_arena_name(arena)));
+   else if (arena->obsolete)
+      fatal_trace("writing obsolete arena %s", istr(object_arena_name(arena)));
+
+   if (sizeof(object_t *) != sizeof(uint64_t))
+      return NULL;   // Encoded references do not fit in an object array
+
+   image_wr_ctx_t ctx = {
+      .slots     = xcalloc_array(all_arenas.count, sizeof(unsigned)),
+      .ident_map = hash_new(256),
+      .file_map  = ihash_new(16),
+   };
+
+   ctx.slots[arena->key] = 1;
+   for (unsigned i = 0; i < arena->deps.count; i++)
+      ctx.slots[arena->deps.items[i]->key] = i + 2;
+
+   image_alloc(&ctx, arena->live_bytes);
+
+   bool valid = true;
+   for (void *p = arena->base, *next; valid && p != arena->alloc; p = next) {
+      assert(p < arena->alloc);
+
+      object_t *object = p;
+      const object_class_t *class = classes[object->tag];
+      const size_t objsz =
+         ALIGN_UP(class->object_size[object->kind], OBJECT_ALIGN);
+
+      next = p + objsz;
+
+      const uint32_t offset =
+         arena->forward[(p - arena->base) >> OBJECT_ALIGN_BITS];
+      if (offset == UINT32_MAX)
+         continue;   // Dead object
+
+      memcpy(ctx.bytes + offset, object, objsz);
+
+      object_t *copy = (object_t *)(ctx.bytes + offset);
+      copy->arena = 0;
+
+      if (class->has_loc)
+         copy->loc.file_ref = image_file_ref(&ctx, &object->loc);
+
+      const imask_t has = class->has_map[object->kind];
+      const int nitems = __builtin_popcountll(has);
+      imask_t mask = 1;
+      for (int n = 0; n < nitems; mask <<= 1) {
+         if (!(has & mask))
+            continue;
+
+         const item_t *item = &(object->items[n]);
+         uint64_t value = 0;
+         if (ITEM_IDENT & mask)
+            value = image_ident(&ctx, item->ident);
+         else if (ITEM_OBJECT & mask)
+            value = image_object_ref(&ctx, item->object);
+         else if (ITEM_OBJ_ARRAY & mask) {
+            const obj_array_t *a = item->obj_array;
+            if (a != NULL) {
+               value = image_alloc(&ctx, sizeof(obj_array_t)
+                                   + a->count * sizeof(object_t *));
+
+               obj_array_t *acopy = (obj_array_t *)(ctx.bytes + value);
+               acopy->count = acopy->limit = a->count;
+               for (unsigned i = 0; i < a->count; i++) {
+                  const uint64_t ref = image_object_ref(&ctx, a->items[i]);
+                  acopy->items[i] = (object_t *)(uintptr_t)ref;
+               }
+            }
+         }
+         else if (ITEM_TEXT & mask) {
+            const size_t len = strlen(item->text) + 1;
+            value = image_alloc(&ctx, len);
+            memcpy(ctx.bytes + value, item->text, len);
+         }
+         else if (ITEM_NUMBER & mask) {
+            if (item->number.common.tag == TAG_BIGNUM)
+               valid = false;   // Not worth supporting in images
+            else
+               value = item->number.bits;
+         }
+         else
+            value = item->ival;
+
+         // The buffer may have been reallocated above
+         copy = (object_t *)(ctx.bytes + offset);
+         copy->items[n++].ival = value;
+      }
+   }
+
+   void *result = NULL;
+   if (valid) {
+      const uint32_t deps = image_alloc(&ctx, arena->deps.count
+                                        * sizeof(image_dep_t));
+      for (unsigned i = 0; i < arena->deps.count; i++) {
+         object_arena_t *a = arena->deps.items[i];
+         const uint32_t name = image_ident(&ctx, object_arena_name(a));
+
+         image_dep_t *dep = (image_dep_t *)(ctx.bytes + deps) + i;
+         dep->name        = name;
+         dep->std         = a->std;
+         dep->fingerprint = arena_fingerprint(a);
+      }
+
+      const uint32_t name = image_ident(&ctx, object_arena_name(arena));
+
+      size_t strsz = 0;
+      for (int i = 0; i < ctx.idents.count; i++)
+         strsz += ident_len(ctx.idents.items[i]) + 1;
+      for (int i = 0; i < ctx.files.count; i++)
+         strsz += strlen(ctx.files.items[i]) + 1;
+
+      const uint32_t strings = image_alloc(&ctx, strsz);
+
+      char *wptr = (char *)ctx.bytes + strings;
+      for (int i = 0; i < ctx.idents.count; i++)
+         wptr = stpcpy(wptr, istr(ctx.idents.items[i])) + 1;
+      for (int i = 0; i < ctx.files.count; i++)
+         wptr = stpcpy(wptr, ctx.files.items[i]) + 1;
+
+      const size_t toff = image_alloc(&ctx, sizeof(image_trailer_t));
+      image_trailer_t *tail = (image_trailer_t *)(ctx.bytes + toff);
+      tail->magic       = IMAGE_MAGIC;
+      tail->digest      = format_digest;
+      tail->std         = standard();
+      tail->flags       = arena->flags;
+      tail->fingerprint = arena_fingerprint(arena);
+      tail->name        = name;
+      tail->root        = arena->forward[((void *)root - arena->base)
+                                         >> OBJECT_ALIGN_BITS];
+      tail->objects     = arena->live_bytes;
+      tail->deps        = deps;
+      tail->ndeps       = arena->deps.count;
+      tail->strings     = strings;
+      tail->nidents     = ctx.idents.count;
+      tail->nfiles      = ctx.files.count;
+      tail->checksum    = fbuf_checksum(FBUF_CS_ADLER32, ctx.bytes, toff);
+
+      *size = ctx.size;
+      result = ctx.bytes;
+   }
+   else
+      free(ctx.bytes);
+
+   ACLEAR(ctx.idents);
+   ACLEAR(ctx.files);
+   hash_free(ctx.ident_map);
+   ihash_free(ctx.file_map);
+   free(ctx.slots);
+
+   return result;
+}
+
+static object_t *image_object(object_arena_t **slots, unsigned nslots,
+                              uint64_t value, const char *fname)
+{
+   if (value == 0)
+      return NULL;
+
+   const unsigned slot = value >> 32;
+   const uint32_t offset = value;
+
+   if (unlikely(slot == 0 || slot >= nslots))
+      fatal("%s: corrupt object reference %"PRIx64, fname, value);
+
+   object_arena_t *arena = slots[slot];
+   assert(offset < arena->alloc - arena->base);
+
+   return (object_t *)((char *)arena->base + offset);
+}
+
+object_t *object_map_image(int fd, const char *fname,
+                           object_load_fn_t loader_fn)
+{
+   object_one_time_init();
+
+   file_info_t info;
+   if (!get_handle_info(fd, &info))
+      fatal_errno("%s: cannot get file info", fname);
+
+   image_trailer_t tail;
+   if (info.size < sizeof(tail)
+       || lseek(fd, info.size - sizeof(tail), SEEK_SET) < 0
+       || read(fd, &tail, sizeof(tail)) != sizeof(tail)
+       || tail.magic != IMAGE_MAGIC)
+      fatal("%s is not a valid design unit image", fname);
+
+   if (tail.digest != format_digest)
+      fatal("%s: serialised format digest is %x expected %x. This design "
+            "unit uses a library format from an earlier version of "
+            PACKAGE_NAME " and should be reanalysed.",
+            fname, tail.digest, format_digest);
+
+   // If this is the first design unit we've loaded then allow it to set
+   // the default standard
+   if (all_arenas.count == 0)
+      set_default_standard(tail.std);
+
+   if (tail.std > standard())
+      fatal("%s: design unit was analysed using standard revision %s which "
+            "is more recent that the currently selected standard %s",
+            fname, standard_text(tail.std), standard_text(standard()));
+
+   const size_t trailer_off = info.size - sizeof(tail);
+   if (tail.objects > tail.deps
+       || tail.deps + tail.ndeps * sizeof(image_dep_t) > tail.strings
+       || tail.strings > trailer_off
+       || tail.root >= tail.objects)
+      fatal("%s: corrupt design unit image", fname);
+
+   const size_t mapsz = ALIGN_UP(info.size, OBJECT_PAGE_SZ);
+
+   object_arena_t *arena = object_arena_new(mapsz, tail.std);
+   arena->source   = OBJ_DISK;
+   arena->flags    = tail.flags;
+   arena->fingerprint = tail.fingerprint;
+
+   map_file_fixed(fd, arena->base, info.size);
+
+   const uint32_t checksum =
+      fbuf_checksum(FBUF_CS_ADLER32, arena->base, trailer_off);
+   if (checksum != tail.checksum)
+      fatal("library unit %s is corrupt: incorrect checksum %08x, "
+            "expected %08x", fname, checksum, tail.checksum);
+
+   arena->alloc = (char *)arena->base + tail.objects;
+   arena->root  = (object_t *)((char *)arena->base + tail.root);
+
+   ident_t *idents LOCAL = xmalloc_array(tail.nidents + 1, sizeof(ident_t));
+   file_ref_t *files LOCAL = xmalloc_array(tail.nfiles + 1, sizeof(file_ref_t));
+
+   const char *str = (char *)arena->base + tail.strings;
+   const char *str_end = (char *)arena->base + trailer_off;
+
+   idents[0] = NULL;
+   for (unsigned i = 1; i <= tail.nidents; i++) {
+      const size_t len = strnlen(str, str_end - str);
+      if (str + len == str_end)
+         fatal("%s: corrupt design unit image", fname);
+
+      idents[i] = ident_new_n(str, len);
+      str += len + 1;
+   }
+
+   for (unsigned i = 0; i < tail.nfiles; i++) {
+      const size_t len = strnlen(str, str_end - str);
+      if (str + len == str_end)
+         fatal("%s: corrupt design unit image", fname);
+
+      files[i] = loc_file_ref(str, NULL);
+      str += len + 1;
+   }
+
+   if (tail.name == 0 || tail.name > tail.nidents)
+      fatal("%s: corrupt design unit image", fname);
+
+   const unsigned nslots = tail.ndeps + 2;
+   object_arena_t **slots LOCAL =
+      xcalloc_array(nslots, sizeof(object_arena_t *));
+   slots[1] = arena;
+
+   const image_dep_t *deps =
+      (image_dep_t *)((char *)arena->base + tail.deps);
+   for (unsigned i = 0; i < tail.ndeps; i++) {
+      if (deps[i].name == 0 || deps[i].name > tail.nidents)
+         fatal("%s: corrupt design unit image", fname);
+
+      object_arena_t *a = object_load_dep(idents[deps[i].name], deps[i].std,
+                                          deps[i].fingerprint, loader_fn, fname,
+                                          idents[tail.name]);
+      APUSH(arena->deps, a);
+      slots[i + 2] = a;
+   }
+
+   for (void *p = arena->base; p != arena->alloc; ) {
+      object_t *object = p;
+      if (unlikely(object->tag >= OBJECT_TAG_COUNT))
+         fatal("%s: corrupt design unit image", fname);
+
+      const object_class_t *class = classes[object->tag];
+      object->arena = arena->key;
+
+      if (class->has_loc && object->loc.file_ref != FILE_INVALID) {
+         if (unlikely(object->loc.file_ref >= tail.nfiles))
+            fatal("%s: corrupt location file reference", fname);
+         object->loc.file_ref = files[object->loc.file_ref];
+      }
+
+      const imask_t has = class->has_map[object->kind];
+      const int nitems = __builtin_popcountll(has);
+      imask_t mask = 1;
+      for (int n = 0; n < nitems; mask <<= 1) {
+         if (!(has & mask))
+            continue;
+
+         item_t *item = &(object->items[n++]);
+         if (ITEM_IDENT & mask) {
+            if (unlikely(item->ival < 0 || item->ival > tail.nidents))
+               fatal("%s: corrupt identifier reference", fname);
+            item->ident = idents[item->ival];
+         }
+         else if (ITEM_OBJECT & mask)
+            item->object = image_object(slots, nslots, item->ival, fname);
+         else if (ITEM_OBJ_ARRAY & mask) {
+            if (item->ival != 0) {
+               obj_array_t *a = (obj_array_t *)
+                  ((char *)arena->base + item->ival);
+               for (unsigned i = 0; i < a->count; i++) {
+                  const uint64_t ref = (uintptr_t)a->items[i];
+                  a->items[i] = image_object(slots, nslots, ref, fname);
+               }
+               item->obj_array = a;
+            }
+         }
+         else if (ITEM_TEXT & mask)
+            item->text = (char *)arena->base + item->ival;
+      }
+
+      p += ALIGN_UP(class->object_size[object->kind], OBJECT_ALIGN);
+      if (unlikely(p > arena->alloc))
+         fatal("%s: corrupt design unit image", fname);
+   }
+
+   if (opt_get_verbose(OPT_OBJECT_VERBOSE, NULL))
+      debugf("arena %s mapped (%zu bytes)", istr(idents[tail.name]),
+             info.size);
+
+   nvc_memprotect(arena->base, mapsz, MEM_RO);
+
+   arena->frozen = true;
+   chash_put(arena_lookup, idents[tail.name], arena);
+
+   return arena->root;
+}
+
 unsigned object_next_generation(void)
 {
    return next_generation++;
@@ -237,16 +237,19 @@ void object_copy(object_copy_ctx_t *ctx);
 object_arena_t *object_arena(object_t *object);
 size_t object_arena_default_size(void);
 object_t *arena_root(object_arena_t *arena);
-void arena_set_checksum(object_arena_t *arena, uint32_t checksum);
 bool arena_frozen(object_arena_t *arena);
 uint32_t arena_flags(object_arena_t *arena);
 void arena_set_flags(object_arena_t *arena, uint32_t flags);
 void arena_set_obsolete(object_arena_t *arena, bool obsolete);
+uint32_t arena_fingerprint(object_arena_t *arena);
 
 void object_write(object_t *object, fbuf_t *f, ident_wr_ctx_t ident_ctx,
                   loc_wr_ctx_t *loc_ctx);
 object_t *object_read(fbuf_t *f, object_load_fn_t loader,
                       ident_rd_ctx_t ident_ctx, loc_rd_ctx_t *loc_ctx);
+void *object_write_image(object_t *root, size_t *size);
+object_t *object_map_image(int fd, const char *fname,
+                           object_load_fn_t loader);
 
 #define object_write_barrier(lhs, rhs) do {                     \
       uintptr_t __lp = (uintptr_t)(lhs) & ~OBJECT_PAGE_MASK;    \
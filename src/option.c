@@ -156,6 +156,8 @@ void set_default_options(void)
    opt_set_int(OPT_NO_SAVE, 0);
    opt_set_str(OPT_LLVM_VERBOSE, getenv("NVC_LLVM_VERBOSE"));
    opt_set_int(OPT_JIT_THRESHOLD, get_int_env("NVC_JIT_THRESHOLD", 100));
+   opt_set_int(OPT_JIT_NATIVE_THRESHOLD,
+               get_int_env("NVC_JIT_NATIVE_THRESHOLD", 10));
    opt_set_str(OPT_ASM_VERBOSE, getenv("NVC_ASM_VERBOSE"));
    opt_set_int(OPT_JIT_ASYNC, get_int_env("NVC_JIT_ASYNC", 1));
    opt_set_int(OPT_PERF_MAP, get_int_env("NVC_PERF_MAP", 0));
@@ -180,4 +182,9 @@ void set_default_options(void)
    opt_set_int(OPT_PRESERVE_CASE, 0);
    opt_set_str(OPT_GVN_VERBOSE, getenv("NVC_GVN_VERBOSE"));
    opt_set_str(OPT_DCE_VERBOSE, getenv("NVC_GVN_VERBOSE"));
+   opt_set_int(OPT_PARALLEL_PROCS, 0);
+   opt_set_str(OPT_RT_PROFILE, NULL);
+   opt_set_str(OPT_JIT_CACHE_DIR, getenv("NVC_JIT_CACHE"));
+   opt_set_int(OPT_AOT_OPTIMISE, 0);
+   opt_set_int(OPT_POINTER_MAPS, 1);
 }
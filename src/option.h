@@ -51,6 +51,7 @@ typedef enum {
    OPT_NO_SAVE,
    OPT_LLVM_VERBOSE,
    OPT_JIT_THRESHOLD,
+   OPT_JIT_NATIVE_THRESHOLD,
    OPT_ASM_VERBOSE,
    OPT_JIT_ASYNC,
    OPT_PERF_MAP,
@@ -75,6 +76,11 @@ typedef enum {
    OPT_PRESERVE_CASE,
    OPT_GVN_VERBOSE,
    OPT_DCE_VERBOSE,
+   OPT_PARALLEL_PROCS,
+   OPT_RT_PROFILE,
+   OPT_JIT_CACHE_DIR,
+   OPT_AOT_OPTIMISE,
+   OPT_POINTER_MAPS,
 
    OPT_LAST_NAME
 } opt_name_t;
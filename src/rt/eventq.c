@@ -0,0 +1,190 @@
+//
+//  Copyright (C) 2025  Nick Gasson
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "util.h"
+#include "rt/eventq.h"
+#include "rt/heap.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+//
+// Calendar queue for simulation events
+//
+// Designs driven by clocks tend to schedule very large numbers of
+// events at a small set of repeating near-future times.  Each distinct
+// time is given a FIFO bucket in a hashed wheel so inserting an event
+// for a time which already has a bucket is O(1) and only the distinct
+// times are kept ordered in a binary heap.  Events which collide with
+// a bucket for a different time, or arrive when the wheel is already
+// half full, fall back to a plain heap.
+//
+
+#define WHEEL_BITS   8
+#define WHEEL_SIZE   (1 << WHEEL_BITS)
+#define MAX_BUCKETS  (WHEEL_SIZE / 2)
+#define BUCKET_MIN   16
+
+typedef struct {
+   uint64_t   when;
+   unsigned   head;
+   unsigned   tail;
+   unsigned   max;
+   void     **events;
+} bucket_t;
+
+typedef struct _eventq {
+   heap_t   *times;
+   heap_t   *overflow;
+   size_t    size;
+   bucket_t  wheel[WHEEL_SIZE];
+} eventq_t;
+
+static inline bucket_t *wheel_slot(eventq_t *eq, uint64_t key)
+{
+   // Fibonacci hashing spreads multiples of the clock period evenly
+   const uint64_t hash = key * UINT64_C(0x9e3779b97f4a7c15);
+   return &(eq->wheel[hash >> (64 - WHEEL_BITS)]);
+}
+
+static void bucket_push(bucket_t *b, void *user)
+{
+   if (unlikely(b->tail == b->max)) {
+      b->max = MAX(b->max * 2, BUCKET_MIN);
+      b->events = xrealloc_array(b->events, b->max, sizeof(void *));
+   }
+
+   b->events[b->tail++] = user;
+}
+
+eventq_t *eventq_new(void)
+{
+   eventq_t *eq = xcalloc(sizeof(eventq_t));
+   eq->times    = heap_new(MAX_BUCKETS);
+   eq->overflow = heap_new(64);
+
+   return eq;
+}
+
+void eventq_free(eventq_t *eq)
+{
+   for (int i = 0; i < WHEEL_SIZE; i++)
+      free(eq->wheel[i].events);
+
+   heap_free(eq->times);
+   heap_free(eq->overflow);
+   free(eq);
+}
+
+void eventq_insert(eventq_t *eq, uint64_t key, void *user)
+{
+   bucket_t *b = wheel_slot(eq, key);
+
+   if (b->tail > 0 && b->when == key)
+      bucket_push(b, user);
+   else if (b->tail == 0 && heap_size(eq->times) < MAX_BUCKETS) {
+      b->when = key;
+      bucket_push(b, user);
+      heap_insert(eq->times, key, b);
+   }
+   else
+      heap_insert(eq->overflow, key, user);
+
+   eq->size++;
+}
+
+static inline bool wheel_is_min(eventq_t *eq)
+{
+   if (heap_size(eq->times) == 0)
+      return false;
+   else if (heap_size(eq->overflow) == 0)
+      return true;
+   else
+      return heap_min_key(eq->times) <= heap_min_key(eq->overflow);
+}
+
+void *eventq_extract_min(eventq_t *eq)
+{
+   assert(eq->size > 0);
+   eq->size--;
+
+   if (wheel_is_min(eq)) {
+      bucket_t *b = heap_min(eq->times);
+      assert(b->head < b->tail);
+
+      void *user = b->events[b->head++];
+
+      if (b->head == b->tail) {
+         b->head = b->tail = 0;
+         heap_extract_min(eq->times);
+      }
+
+      return user;
+   }
+   else
+      return heap_extract_min(eq->overflow);
+}
+
+uint64_t eventq_min_key(eventq_t *eq)
+{
+   assert(eq->size > 0);
+
+   if (wheel_is_min(eq))
+      return heap_min_key(eq->times);
+   else
+      return heap_min_key(eq->overflow);
+}
+
+size_t eventq_size(eventq_t *eq)
+{
+   return eq->size;
+}
+
+static bool delete_bucket_cb(uint64_t key, void *user, void *context)
+{
+   return user == context;
+}
+
+bool eventq_delete(eventq_t *eq, eventq_delete_fn_t fn, void *context)
+{
+   for (int i = 0; i < WHEEL_SIZE; i++) {
+      bucket_t *b = &(eq->wheel[i]);
+      for (unsigned j = b->head; j < b->tail; j++) {
+         if (!(*fn)(b->when, b->events[j], context))
+            continue;
+
+         memmove(b->events + j, b->events + j + 1,
+                 (b->tail - j - 1) * sizeof(void *));
+
+         if (--(b->tail) == b->head) {
+            b->head = b->tail = 0;
+            heap_delete(eq->times, delete_bucket_cb, b);
+         }
+
+         eq->size--;
+         return true;
+      }
+   }
+
+   if (heap_delete(eq->overflow, fn, context)) {
+      eq->size--;
+      return true;
+   }
+
+   return false;
+}
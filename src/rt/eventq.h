@@ -0,0 +1,37 @@
+//
+//  Copyright (C) 2025  Nick Gasson
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#ifndef _EVENTQ_H
+#define _EVENTQ_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct _eventq eventq_t;
+
+typedef bool (*eventq_delete_fn_t)(uint64_t key, void *user, void *context);
+
+eventq_t *eventq_new(void);
+void eventq_free(eventq_t *eq);
+void eventq_insert(eventq_t *eq, uint64_t key, void *user);
+void *eventq_extract_min(eventq_t *eq);
+uint64_t eventq_min_key(eventq_t *eq);
+size_t eventq_size(eventq_t *eq);
+bool eventq_delete(eventq_t *eq, eventq_delete_fn_t fn, void *context);
+
+#endif  // _EVENTQ_H
@@ -20,6 +20,7 @@
 #include "jit/jit-exits.h"
 #include "jit/jit-ffi.h"
 #include "rt/rt.h"
+#include "thread.h"
 
 #include <assert.h>
 #include <stdio.h>
@@ -57,13 +58,17 @@ typedef enum {
    READ_WRITE_MODE
 } file_open_kind_t;
 
+static int open_files = 0;
+
 DLLEXPORT
 void __nvc_file_close(jit_scalar_t *args)
 {
    FILE **fp = args[2].pointer;
 
-   if (*fp != NULL && *fp != stdin && *fp != stdout)
+   if (*fp != NULL && *fp != stdin && *fp != stdout) {
       fclose(*fp);
+      relaxed_add(&open_files, -1);
+   }
 
    *fp = NULL;
 }
@@ -318,6 +323,8 @@ void x_file_open(int8_t *status, void **_fp, const uint8_t *name_bytes,
             }
          }
       }
+      else
+         relaxed_add(&open_files, 1);
    }
 }
 
@@ -346,6 +353,11 @@ int64_t x_file_read(void **_fp, void *data, int64_t size, int64_t count)
    return actual;
 }
 
+int file_io_open_count(void)
+{
+   return relaxed_load(&open_files);
+}
+
 void _file_io_init(void)
 {
    // Dummy function to force linking
@@ -94,8 +94,6 @@ void heap_free(heap_t *h)
 
 void *heap_extract_min(heap_t *h)
 {
-   RT_LOCK(h->lock);
-
    assert(h->size >= 1);
 
    void *min = USER(h, 1);
@@ -107,22 +105,18 @@ void *heap_extract_min(heap_t *h)
 
 void *heap_min(heap_t *h)
 {
-   RT_LOCK(h->lock);
    assert(h->size >= 1);
    return USER(h, 1);
 }
 
 uint64_t heap_min_key(heap_t *h)
 {
-   RT_LOCK(h->lock);
    assert(h->size >= 1);
    return KEY(h, 1);
 }
 
 void heap_insert(heap_t *h, uint64_t key, void *user)
 {
-   RT_LOCK(h->lock);
-
    if (unlikely(h->size == h->max_size)) {
       h->max_size *= 2;
       h->nodes = xrealloc_array(h->nodes, h->max_size, sizeof(heap_node_t));
@@ -138,16 +132,12 @@ void heap_insert(heap_t *h, uint64_t key, void *user)
 
 void heap_walk(heap_t *h, heap_walk_fn_t fn, void *context)
 {
-   RT_LOCK(h->lock);
-
    for (size_t i = 1; i <= h->size; i++)
       (*fn)(KEY(h, i), USER(h, i), context);
 }
 
 bool heap_delete(heap_t *h, heap_delete_fn_t fn, void *context)
 {
-   RT_LOCK(h->lock);
-
    for (size_t i = 1; i <= h->size; i++) {
       if ((*fn)(KEY(h, i), USER(h, i), context)) {
          if (i == h->size)
@@ -18,8 +18,6 @@
 #ifndef _HEAP_H
 #define _HEAP_H
 
-#include "thread.h"
-
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -30,7 +28,6 @@ typedef struct {
    heap_node_t *nodes;
    size_t       size;
    size_t       max_size;
-   nvc_lock_t   lock;
 } heap_t;
 
 typedef void (*heap_walk_fn_t)(uint64_t key, void *user, void *context);
@@ -45,6 +42,6 @@ void heap_insert(heap_t *h, uint64_t key, void *user);
 void heap_walk(heap_t *h, heap_walk_fn_t fn, void *context);
 bool heap_delete(heap_t *h, heap_delete_fn_t fn, void *context);
 
-#define heap_size(h) atomic_load(&(h)->size)
+#define heap_size(h) ((h)->size)
 
 #endif
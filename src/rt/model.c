@@ -19,6 +19,7 @@
 #include "array.h"
 #include "common.h"
 #include "debug.h"
+#include "fbuf.h"
 #include "hash.h"
 #include "jit/jit-exits.h"
 #include "jit/jit.h"
@@ -27,6 +28,7 @@
 #include "psl/psl-node.h"
 #include "rt/assert.h"
 #include "rt/copy.h"
+#include "rt/eventq.h"
 #include "rt/heap.h"
 #include "rt/model.h"
 #include "rt/structs.h"
@@ -43,6 +45,7 @@
 
 typedef struct _rt_callback rt_callback_t;
 typedef struct _memblock memblock_t;
+typedef struct _rt_profile rt_profile_t;
 
 typedef struct _rt_callback {
    rt_event_fn_t  fn;
@@ -59,6 +62,11 @@ typedef enum {
 #define MEMBLOCK_ALIGN   64
 #define MEMBLOCK_PAGE_SZ 0x800000
 #define TRIGGER_TAB_SIZE 64
+#define PARALLEL_MIN     64
+#define PARALLEL_BATCH   16
+#define RESOLVE_MIN      4096
+#define RESOLVE_GRAIN    1024
+#define FREE_VALUES_MAX  256
 
 #if ASAN_ENABLED
 #define MEMBLOCK_REDZONE 16
@@ -75,13 +83,6 @@ typedef struct _memblock {
 
 STATIC_ASSERT(sizeof(memblock_t) <= MEMBLOCK_ALIGN);
 
-typedef struct {
-   waveform_t    *free_waveforms;
-   tlab_t        *tlab;
-   rt_wakeable_t *active_obj;
-   rt_scope_t    *active_scope;
-} __attribute__((aligned(64))) model_thread_t;
-
 typedef void (*defer_fn_t)(rt_model_t *, void *);
 
 typedef struct {
@@ -95,6 +96,36 @@ typedef struct {
    unsigned      max;
 } deferq_t;
 
+typedef struct {
+   waveform_t    *free_waveforms;
+   void          *free_values[FREE_VALUES_MAX + 1];
+   ihash_t       *free_large;
+   tlab_t        *tlab;
+   rt_wakeable_t *active_obj;
+   rt_scope_t    *active_scope;
+   deferq_t       delta_procq;
+   deferq_t       delta_driverq;
+} __attribute__((aligned(64))) model_thread_t;
+
+typedef struct {
+   rt_proc_t **procs;
+   unsigned    count;
+} proc_batch_t;
+
+typedef struct {
+   rt_nexus_t *nexus;
+   void       *resolved;
+} rank_item_t;
+
+typedef struct {
+   rt_nexus_t  *nexus;
+   rt_source_t *s0;
+   int          nonnull;
+   int          first;
+   int          count;
+   void        *resolved;
+} resolve_job_t;
+
 typedef struct _rt_model {
    tree_t             top;
    hash_t            *scopes;
@@ -110,7 +141,7 @@ typedef struct _rt_model {
    bool               next_is_delta;
    bool               force_stop;
    unsigned           n_signals;
-   heap_t            *eventq_heap;
+   eventq_t          *eventq;
    ihash_t           *res_memo;
    rt_watch_t        *watches;
    deferq_t           procq;
@@ -124,20 +155,35 @@ typedef struct _rt_model {
    rt_callback_t     *global_cbs[RT_LAST_EVENT];
    cover_data_t      *cover;
    nvc_rusage_t       ready_rusage;
-   nvc_lock_t         memlock;
+   nvc_lock_t         lock;
    memblock_t        *memblocks;
    model_thread_t    *threads[MAX_THREADS];
    signal_list_t      eventsigs;
    bool               shuffle;
    bool               liveness;
+   bool               parallel;
+   bool               concurrent;
+   workq_t           *workq;
+   A(rt_proc_t *)     runnable;
+   A(proc_batch_t)    batches;
+   A(rank_item_t)     rankq;
+   A(resolve_job_t)   resolvejobs;
+   uint8_t           *resolvebuf;
+   size_t             resolvebufsz;
    rt_trigger_t      *triggertab[TRIGGER_TAB_SIZE];
+   rt_profile_t      *profile;
+   A(rt_proc_t *)     proctab;
+   bit_mask_t         wakemask;
+   bool               densewake;
 } rt_model_t;
 
 #define FMT_VALUES_SZ   128
 #define NEXUS_INDEX_MIN 8
+#define NEXUS_CHUNK_MAX 64
 #define TRACE_SIGNALS   1
 #define WAVEFORM_CHUNK  256
 #define PENDING_MIN     4
+#define PENDING_DENSE   32
 #define MAX_RANK        UINT8_MAX
 
 #define TRACE(...) do {                                 \
@@ -149,21 +195,30 @@ typedef struct _rt_model {
    rt_model_t *__save __attribute__((unused, cleanup(__model_exit)));   \
    __model_entry(m, &__save);                                           \
 
+// Runtime calls which modify shared state are serialised on the model
+// lock while processes are running concurrently
+#define MODEL_LOCK()                                                    \
+   __attribute__((cleanup(__model_unlock), unused))                     \
+   rt_model_t *UNIQUE(__lock) = __model_lock();
+
 #if USE_EMUTLS
 static rt_model_t *__model = NULL;
 #else
 static __thread rt_model_t *__model = NULL;
 #endif
 
+static __thread int __lock_depth = 0;
+
 static bool __trace_on = false;
 
 static void *source_value(rt_nexus_t *nexus, rt_source_t *src);
-static void free_value(rt_nexus_t *n, rt_value_t v);
+static void free_value(rt_model_t *m, rt_nexus_t *n, rt_value_t v);
 static rt_nexus_t *clone_nexus(rt_model_t *m, rt_nexus_t *old, int offset);
 static void put_driving(rt_model_t *m, rt_nexus_t *n, const void *value);
 static void put_effective(rt_model_t *m, rt_nexus_t *n, const void *value);
 static void update_implicit_signal(rt_model_t *m, rt_implicit_t *imp);
 static bool run_trigger(rt_model_t *m, rt_trigger_t *t);
+static void wakeup_dense(rt_model_t *m);
 static void reset_scope(rt_model_t *m, rt_scope_t *s);
 static void async_run_process(rt_model_t *m, void *arg);
 static void async_update_property(rt_model_t *m, void *arg);
@@ -302,6 +357,28 @@ static void __model_exit(rt_model_t **save)
       diag_remove_hint_fn(model_diag_cb);
 }
 
+static rt_model_t *__model_lock(void)
+{
+   rt_model_t *m = __model;
+   if (m == NULL || !m->concurrent)
+      return NULL;
+   else if (__lock_depth++ == 0)
+      nvc_lock(&(m->lock));
+
+   return m;
+}
+
+static void __model_unlock(rt_model_t **pm)
+{
+   if (*pm != NULL && --__lock_depth == 0)
+      nvc_unlock(&((*pm)->lock));
+}
+
+static inline void assert_model_locked(rt_model_t *m)
+{
+   assert(!m->concurrent || __lock_depth > 0);
+}
+
 static char *fmt_values_r(const void *values, size_t len, char *buf, size_t max)
 {
    char *p = buf;
@@ -342,19 +419,16 @@ static const char *fmt_jit_value(jit_scalar_t value, bool scalar, uint32_t len)
       return fmt_values_r(value.pointer, len, buf, sizeof(buf));
 }
 
+static void *static_alloc(rt_model_t *m, size_t size);
+
 static model_thread_t *model_thread(rt_model_t *m)
 {
-#if RT_MULTITHREADED
    const int my_id = thread_id();
 
    if (unlikely(m->threads[my_id] == NULL))
-      return (m->threads[my_id] = xcalloc(sizeof(model_thread_t)));
+      return (m->threads[my_id] = static_alloc(m, sizeof(model_thread_t)));
 
    return m->threads[my_id];
-#else
-   assert(thread_id() == 0);
-   return m->threads[0];
-#endif
 }
 
 __attribute__((cold, noinline))
@@ -389,6 +463,22 @@ static void deferq_shuffle(deferq_t *dq)
    }
 }
 
+static bool deferq_merge(deferq_t *dst, deferq_t *src)
+{
+   if (src->count == 0)
+      return false;
+
+   while (dst->count + src->count > dst->max)
+      deferq_grow(dst);
+
+   memcpy(dst->tasks + dst->count, src->tasks,
+          src->count * sizeof(defer_task_t));
+   dst->count += src->count;
+   src->count = 0;
+
+   return true;
+}
+
 static void deferq_run(rt_model_t *m, deferq_t *dq)
 {
    const defer_task_t *tasks = dq->tasks;
@@ -414,7 +504,7 @@ static void *static_alloc(rt_model_t *m, size_t size)
 {
    const int total_bytes = ALIGN_UP(size + MEMBLOCK_REDZONE, MEMBLOCK_ALIGN);
 
-   RT_LOCK(m->memlock);
+   MODEL_LOCK();
 
    memblock_t *mb = m->memblocks;
 
@@ -472,7 +562,7 @@ rt_model_t *model_new(jit_t *jit, cover_data_t *cover)
    m->jit         = jit;
    m->nexus_tail  = &(m->nexuses);
    m->iteration   = -1;
-   m->eventq_heap = heap_new(512);
+   m->eventq      = eventq_new();
    m->res_memo    = ihash_new(128);
    m->cover       = cover;
 
@@ -522,6 +612,284 @@ rt_scope_t *get_active_scope(rt_model_t *m)
    return model_thread(m)->active_scope;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Profiling
+
+#define PROFILE_INTERVAL 1000   // Microseconds between samples
+#define PROFILE_TOP      20
+
+typedef struct {
+   rt_proc_t *proc;
+   uint64_t   wakeups;
+   uint64_t   runs;
+   uint64_t   wall_ns;
+} proc_profile_t;
+
+typedef struct {
+   rt_signal_t *signal;
+   uint64_t     events;
+   uint64_t     resolutions;
+} signal_profile_t;
+
+typedef struct _rt_profile {
+   chash_t                  *procmap;
+   chash_t                  *signalmap;
+   A(proc_profile_t *)       procs;
+   A(signal_profile_t *)     signals;
+   shash_t                  *stacks;
+   text_buf_t               *stacktb;
+   nvc_lock_t                lock;
+   uint64_t                  samples;
+   uint64_t                  steps;
+   uint64_t                  deltas;
+   int                       max_deltas;
+   uint64_t                  max_deltas_time;
+   char                     *file;
+} rt_profile_t;
+
+static proc_profile_t *get_proc_profile(rt_profile_t *p, rt_proc_t *proc)
+{
+   proc_profile_t *pp = chash_get(p->procmap, proc);
+   if (likely(pp != NULL))
+      return pp;
+
+   SCOPED_LOCK(p->lock);
+
+   if ((pp = chash_get(p->procmap, proc)) == NULL) {
+      pp = xcalloc(sizeof(proc_profile_t));
+      pp->proc = proc;
+
+      APUSH(p->procs, pp);
+      chash_put(p->procmap, proc, pp);
+   }
+
+   return pp;
+}
+
+static signal_profile_t *get_signal_profile(rt_profile_t *p, rt_signal_t *s)
+{
+   signal_profile_t *sp = chash_get(p->signalmap, s);
+   if (likely(sp != NULL))
+      return sp;
+
+   SCOPED_LOCK(p->lock);
+
+   if ((sp = chash_get(p->signalmap, s)) == NULL) {
+      sp = xcalloc(sizeof(signal_profile_t));
+      sp->signal = s;
+
+      APUSH(p->signals, sp);
+      chash_put(p->signalmap, s, sp);
+   }
+
+   return sp;
+}
+
+static void profile_sample_cb(jit_t *j, const ident_t *frames, int count,
+                              void *ctx)
+{
+   rt_profile_t *p = ctx;
+
+   SCOPED_LOCK(p->lock);
+
+   text_buf_t *tb = p->stacktb;
+   tb_rewind(tb);
+
+   rt_wakeable_t *obj = get_active_wakeable();
+   if (obj == NULL)
+      tb_cat(tb, "(kernel)");
+   else if (obj->kind == W_PROC)
+      tb_istr(tb, container_of(obj, rt_proc_t, wakeable)->name);
+   else if (obj->kind == W_PROPERTY)
+      tb_istr(tb, container_of(obj, rt_prop_t, wakeable)->name);
+   else
+      tb_cat(tb, "(callback)");
+
+   for (int i = count - 1; i >= 0; i--) {
+      tb_append(tb, ';');
+      tb_istr(tb, frames[i]);
+   }
+
+   uint64_t *hits = shash_get(p->stacks, tb_get(tb));
+   if (hits == NULL) {
+      hits = xcalloc(sizeof(uint64_t));
+      shash_put(p->stacks, tb_get(tb), hits);
+   }
+
+   (*hits)++;
+
+   p->samples++;
+}
+
+static void profile_start(rt_model_t *m, const char *file)
+{
+   rt_profile_t *p = xcalloc(sizeof(rt_profile_t));
+   p->procmap   = chash_new(1024);
+   p->signalmap = chash_new(1024);
+   p->stacks    = shash_new(256);
+   p->stacktb   = tb_new();
+   p->file      = *file != '\0' ? xstrdup(file) : NULL;
+
+   m->profile = p;
+
+   jit_start_sampling(m->jit, PROFILE_INTERVAL, profile_sample_cb, p);
+}
+
+static void profile_end_time_step(rt_model_t *m)
+{
+   rt_profile_t *p = m->profile;
+   const int deltas = m->iteration + 1;
+
+   p->steps++;
+   p->deltas += deltas;
+
+   if (deltas > p->max_deltas) {
+      p->max_deltas = deltas;
+      p->max_deltas_time = m->now;
+   }
+}
+
+static int proc_profile_cmp(const void *a, const void *b)
+{
+   const proc_profile_t *pa = *(const proc_profile_t **)a;
+   const proc_profile_t *pb = *(const proc_profile_t **)b;
+
+   if (pa->wall_ns != pb->wall_ns)
+      return pa->wall_ns < pb->wall_ns ? 1 : -1;
+   else
+      return pa->wakeups < pb->wakeups ? 1 : (pa->wakeups > pb->wakeups);
+}
+
+static int signal_profile_cmp(const void *a, const void *b)
+{
+   const signal_profile_t *sa = *(const signal_profile_t **)a;
+   const signal_profile_t *sb = *(const signal_profile_t **)b;
+
+   const uint64_t ta = sa->events + sa->resolutions;
+   const uint64_t tb = sb->events + sb->resolutions;
+
+   return ta < tb ? 1 : (ta > tb ? -1 : 0);
+}
+
+static void profile_signal_name(text_buf_t *tb, rt_signal_t *s)
+{
+   rt_scope_t *scope = s->parent;
+   while (is_signal_scope(scope))
+      scope = scope->parent;
+
+   if (scope->kind == SCOPE_INSTANCE) {
+      tree_t hier = tree_decl(scope->where, 0);
+      assert(tree_kind(hier) == T_HIER);
+      instance_name_to_path(tb, istr(tree_ident(hier)));
+      tb_append(tb, ':');
+   }
+   else if (scope->name != NULL)
+      tb_printf(tb, "%s.", istr(scope->name));
+
+   if (is_signal_scope(s->parent))
+      tb_printf(tb, "%s.", istr(s->parent->name));
+
+   tb_istr(tb, tree_ident(s->where));
+}
+
+static void profile_write_stacks(rt_profile_t *p)
+{
+   FILE *f = fopen(p->file, "w");
+   if (f == NULL)
+      fatal_errno("cannot create %s", p->file);
+
+   // Folded stack format accepted by flamegraph.pl, inferno, speedscope
+   // and other flame graph viewers
+   const char *key;
+   void *value;
+   for (hash_iter_t it = HASH_BEGIN;
+        shash_iter(p->stacks, &it, &key, &value); )
+      fprintf(f, "%s %"PRIu64"\n", key, *(uint64_t *)value);
+
+   fclose(f);
+}
+
+static void profile_report(rt_model_t *m)
+{
+   rt_profile_t *p = m->profile;
+
+   jit_stop_sampling(m->jit);
+
+   uint64_t total_ns = 0;
+   for (int i = 0; i < p->procs.count; i++)
+      total_ns += p->procs.items[i]->wall_ns;
+
+   qsort(p->procs.items, p->procs.count, sizeof(proc_profile_t *),
+         proc_profile_cmp);
+   qsort(p->signals.items, p->signals.count, sizeof(signal_profile_t *),
+         signal_profile_cmp);
+
+   LOCAL_TEXT_BUF tb = tb_new();
+
+   tb_printf(tb, "Profile of %d processes and %d signals with %"PRIu64
+             " samples\n\n", p->procs.count, p->signals.count, p->samples);
+
+   tb_printf(tb, "%"PRIu64" time steps with %"PRIu64" delta cycles",
+             p->steps, p->deltas);
+   if (p->steps > 0) {
+      char tmbuf[64];
+      fmt_time_r(tmbuf, sizeof(tmbuf), p->max_deltas_time, "");
+      tb_printf(tb, " (%.1f per step, maximum %d at %s)",
+                (double)p->deltas / p->steps, p->max_deltas, tmbuf);
+   }
+   tb_cat(tb, "\n\n");
+
+   tb_printf(tb, "%6s %10s %10s %10s  %s\n", "%TIME", "TIME(ms)",
+             "WAKEUPS", "RUNS", "PROCESS");
+
+   for (int i = 0; i < p->procs.count && i < PROFILE_TOP; i++) {
+      const proc_profile_t *pp = p->procs.items[i];
+      tb_printf(tb, "%6.2f %10.2f %10"PRIu64" %10"PRIu64"  %s\n",
+                total_ns ? 100.0 * pp->wall_ns / total_ns : 0.0,
+                pp->wall_ns / 1e6, pp->wakeups, pp->runs,
+                istr(pp->proc->name));
+   }
+
+   tb_printf(tb, "\n%10s %12s  %s\n", "EVENTS", "RESOLUTIONS", "SIGNAL");
+
+   for (int i = 0; i < p->signals.count && i < PROFILE_TOP; i++) {
+      const signal_profile_t *sp = p->signals.items[i];
+      tb_printf(tb, "%10"PRIu64" %12"PRIu64"  ", sp->events, sp->resolutions);
+      profile_signal_name(tb, sp->signal);
+      tb_append(tb, '\n');
+   }
+
+   fputs(tb_get(tb), stdout);
+   fflush(stdout);
+
+   if (p->file != NULL)
+      profile_write_stacks(p);
+}
+
+static void profile_free(rt_profile_t *p)
+{
+   for (int i = 0; i < p->procs.count; i++)
+      free(p->procs.items[i]);
+   ACLEAR(p->procs);
+
+   for (int i = 0; i < p->signals.count; i++)
+      free(p->signals.items[i]);
+   ACLEAR(p->signals);
+
+   const char *key;
+   void *value;
+   for (hash_iter_t it = HASH_BEGIN;
+        shash_iter(p->stacks, &it, &key, &value); )
+      free(value);
+
+   chash_free(p->procmap);
+   chash_free(p->signalmap);
+   shash_free(p->stacks);
+   tb_free(p->stacktb);
+   free(p->file);
+   free(p);
+}
+
 static void free_waveform(rt_model_t *m, waveform_t *w)
 {
    model_thread_t *thread = model_thread(m);
@@ -544,8 +912,11 @@ static void cleanup_nexus(rt_model_t *m, rt_nexus_t *n)
       }
    }
 
-   if (n->pending != NULL && pointer_tag(n->pending) == 0)
-      free(n->pending);
+   if (n->pending != NULL && pointer_tag(n->pending) == 0) {
+      rt_pending_t *p = untag_pointer(n->pending, rt_pending_t);
+      mask_free(&p->procs);
+      free(p);
+   }
 }
 
 static void cleanup_signal(rt_model_t *m, rt_signal_t *s)
@@ -596,6 +967,11 @@ static void cleanup_scope(rt_model_t *m, rt_scope_t *scope)
 
 void model_free(rt_model_t *m)
 {
+   if (m->profile != NULL) {
+      profile_report(m);
+      profile_free(m->profile);
+   }
+
    if (opt_get_int(OPT_RT_STATS)) {
       nvc_rusage_t ru;
       nvc_rusage(&ru);
@@ -608,8 +984,8 @@ void model_free(rt_model_t *m)
             m->ready_rusage.ms, ru.ms, ru.user, ru.sys, ru.rss, mem / 1024);
    }
 
-   while (heap_size(m->eventq_heap) > 0) {
-      void *e = heap_extract_min(m->eventq_heap);
+   while (eventq_size(m->eventq) > 0) {
+      void *e = eventq_extract_min(m->eventq);
       if (pointer_tag(e) == EVENT_TIMEOUT)
          free(untag_pointer(e, rt_callback_t));
    }
@@ -619,10 +995,19 @@ void model_free(rt_model_t *m)
 
    for (int i = 0; i < MAX_THREADS; i++) {
       model_thread_t *thread = m->threads[i];
-      if (thread != NULL)
+      if (thread != NULL) {
          tlab_release(thread->tlab);
+         free(thread->delta_procq.tasks);
+         free(thread->delta_driverq.tasks);
+
+         if (thread->free_large != NULL)
+            ihash_free(thread->free_large);
+      }
    }
 
+   if (m->workq != NULL)
+      workq_free(m->workq);
+
    free(m->procq.tasks);
    free(m->delta_procq.tasks);
    free(m->postponedq.tasks);
@@ -630,6 +1015,9 @@ void model_free(rt_model_t *m)
    free(m->driverq.tasks);
    free(m->delta_driverq.tasks);
 
+   ACLEAR(m->proctab);
+   mask_free(&m->wakemask);
+
    for (rt_watch_t *it = m->watches, *tmp; it; it = tmp) {
       tmp = it->chain_all;
       free(it);
@@ -649,10 +1037,15 @@ void model_free(rt_model_t *m)
 
    heap_free(m->effective_heap);
    heap_free(m->driving_heap);
-   heap_free(m->eventq_heap);
+   eventq_free(m->eventq);
    hash_free(m->scopes);
    ihash_free(m->res_memo);
    ACLEAR(m->eventsigs);
+   ACLEAR(m->runnable);
+   ACLEAR(m->batches);
+   ACLEAR(m->rankq);
+   ACLEAR(m->resolvejobs);
+   free(m->resolvebuf);
    free(m);
 }
 
@@ -849,15 +1242,25 @@ static void deltaq_insert_proc(rt_model_t *m, uint64_t delta, rt_proc_t *proc)
 {
    if (delta == 0) {
       set_pending(&proc->wakeable);
-      deferq_do(&m->delta_procq, async_run_process, proc);
-      m->next_is_delta = true;
+
+      if (unlikely(m->concurrent)) {
+         // Merged into the global queue after all processes have run
+         model_thread_t *thread = model_thread(m);
+         deferq_do(&thread->delta_procq, async_run_process, proc);
+      }
+      else {
+         deferq_do(&m->delta_procq, async_run_process, proc);
+         m->next_is_delta = true;
+      }
    }
    else {
       assert(!proc->wakeable.delayed);
       proc->wakeable.delayed = true;
 
+      MODEL_LOCK();
+
       void *e = tag_pointer(proc, EVENT_PROCESS);
-      heap_insert(m->eventq_heap, m->now + delta, e);
+      eventq_insert(m->eventq, m->now + delta, e);
    }
 }
 
@@ -865,12 +1268,21 @@ static void deltaq_insert_driver(rt_model_t *m, uint64_t delta,
                                  rt_source_t *source)
 {
    if (delta == 0) {
-      deferq_do(&m->delta_driverq, async_update_driver, source);
-      m->next_is_delta = true;
+      if (unlikely(m->concurrent)) {
+         // Merged into the global queue after all processes have run
+         model_thread_t *thread = model_thread(m);
+         deferq_do(&thread->delta_driverq, async_update_driver, source);
+      }
+      else {
+         deferq_do(&m->delta_driverq, async_update_driver, source);
+         m->next_is_delta = true;
+      }
    }
    else {
+      MODEL_LOCK();
+
       void *e = tag_pointer(source, EVENT_DRIVER);
-      heap_insert(m->eventq_heap, m->now + delta, e);
+      eventq_insert(m->eventq, m->now + delta, e);
    }
 }
 
@@ -954,6 +1366,12 @@ static void run_process(rt_model_t *m, rt_proc_t *proc)
 
    rt_wakeable_t *obj = &(proc->wakeable);
 
+   proc_profile_t *prof = NULL;
+   if (unlikely(m->profile != NULL)) {
+      prof = get_proc_profile(m->profile, proc);
+      prof->wakeups++;
+   }
+
    if (obj->trigger != NULL && !run_trigger(m, obj->trigger))
       return;   // Filtered
 
@@ -975,10 +1393,17 @@ static void run_process(rt_model_t *m, rt_proc_t *proc)
       .pointer = *mptr_get(proc->scope->privdata)
    };
 
+   const uint64_t start = prof ? get_timestamp_ns() : 0;
+
    if (!jit_fastcall(m->jit, proc->handle, &result, state, context,
                      proc->tlab ?: thread->tlab))
       m->force_stop = true;
 
+   if (prof != NULL) {
+      prof->wall_ns += get_timestamp_ns() - start;
+      prof->runs++;
+   }
+
    if (proc->tlab != NULL && result.pointer == NULL) {
       tlab_release(proc->tlab);
       proc->tlab = NULL;
@@ -1100,15 +1525,38 @@ static inline void *nexus_initial(rt_nexus_t *n)
    return n->signal->shared.data + n->offset + 2*n->signal->shared.size;
 }
 
+static void **free_value_list(rt_model_t *m, size_t valuesz)
+{
+   // Freed values are kept on lists for each exact size as splitting a
+   // nexus can leave a value pointing into the middle of a larger block
+   model_thread_t *thread = model_thread(m);
+
+   if (likely(valuesz <= FREE_VALUES_MAX))
+      return &(thread->free_values[valuesz]);
+
+   if (thread->free_large == NULL)
+      thread->free_large = ihash_new(16);
+
+   void **list = ihash_get(thread->free_large, valuesz);
+   if (list == NULL) {
+      list = static_alloc(m, sizeof(void *));
+      *list = NULL;
+      ihash_put(thread->free_large, valuesz, list);
+   }
+
+   return list;
+}
+
 static rt_value_t alloc_value(rt_model_t *m, rt_nexus_t *n)
 {
    rt_value_t result = {};
 
    const size_t valuesz = n->size * n->width;
    if (valuesz > sizeof(rt_value_t)) {
-      if (n->free_value != NULL) {
-         result.ext = n->free_value;
-         n->free_value = *(void **)result.ext;
+      void **list = free_value_list(m, valuesz);
+      if (*list != NULL) {
+         result.ext = *list;
+         *list = *(void **)result.ext;
       }
       else
          result.ext = static_alloc(m, valuesz);
@@ -1117,12 +1565,13 @@ static rt_value_t alloc_value(rt_model_t *m, rt_nexus_t *n)
    return result;
 }
 
-static void free_value(rt_nexus_t *n, rt_value_t v)
+static void free_value(rt_model_t *m, rt_nexus_t *n, rt_value_t v)
 {
    const size_t valuesz = n->width * n->size;
    if (valuesz > sizeof(rt_value_t)) {
-      *(void **)v.ext = n->free_value;
-      n->free_value = v.ext;
+      void **list = free_value_list(m, valuesz);
+      *(void **)v.ext = *list;
+      *list = v.ext;
    }
 }
 
@@ -1244,7 +1693,6 @@ static rt_source_t *add_source(rt_model_t *m, rt_nexus_t *n, source_kind_t kind)
       n->flags &= ~NET_F_FAST_DRIVER;
 
    src->chain_input  = NULL;
-   src->chain_output = NULL;
    src->tag          = kind;
    src->disconnected = 0;
    src->fastqueued   = 0;
@@ -1264,14 +1712,17 @@ static rt_source_t *add_source(rt_model_t *m, rt_nexus_t *n, source_kind_t kind)
       break;
 
    case SOURCE_PORT:
-      src->u.port.conv_func = NULL;
-      src->u.port.input     = NULL;
-      src->u.port.output    = n;
+      src->u.port.conv_func    = NULL;
+      src->u.port.input        = NULL;
+      src->u.port.output       = n;
+      src->u.port.chain_output = NULL;
       break;
 
+   case SOURCE_IMPLICIT:
+      src->u.port.chain_output = NULL;
+      // Fall-through
    case SOURCE_DEPOSIT:
    case SOURCE_FORCING:
-   case SOURCE_IMPLICIT:
       src->u.pseudo.nexus = n;
       src->u.pseudo.value = alloc_value(m, n);
       break;
@@ -1365,7 +1816,7 @@ static void update_index(rt_signal_t *s, rt_nexus_t *n)
 
 static rt_nexus_t *lookup_index(rt_signal_t *s, int *offset)
 {
-   if (likely(offset == 0 || s->index == NULL))
+   if (likely(*offset == 0 || s->index == NULL))
       return &(s->nexus);
    else if (!index_valid(s->index, *offset)) {
       TRACE("invalid index for %s offset=%d how=%d", istr(tree_ident(s->where)),
@@ -1493,7 +1944,6 @@ static void clone_source(rt_model_t *m, rt_nexus_t *nexus,
             if (old->u.port.input->width == offset)
                new->u.port.input = old->u.port.input->chain;  // Cycle breaking
             else {
-               RT_LOCK(old->u.port.input->signal->lock);
                rt_nexus_t *n = clone_nexus(m, old->u.port.input, offset);
                new->u.port.input = n;
             }
@@ -1550,18 +2000,39 @@ static void clone_source(rt_model_t *m, rt_nexus_t *nexus,
    }
 }
 
+static rt_nexus_t *alloc_nexus(rt_model_t *m, rt_signal_t *s)
+{
+   // Buses in gate-level netlists are often split into every element
+   // so allocate nexuses in chunks that double with the number of
+   // splits: this keeps most of the chain contiguous in memory without
+   // reserving space for signals that are split only once, and avoids
+   // padding each record to the static allocation alignment
+   const unsigned nth = s->n_nexus - 1;
+   assert(nth > 0);
+
+   const bool new_chunk = nth <= NEXUS_CHUNK_MAX
+      ? (nth & (nth - 1)) == 0 : nth % NEXUS_CHUNK_MAX == 0;
+
+   if (new_chunk) {
+      const unsigned size = MIN(nth, NEXUS_CHUNK_MAX);
+      s->spare = static_alloc(m, size * sizeof(rt_nexus_t));
+   }
+
+   return s->spare++;
+}
+
 static rt_nexus_t *clone_nexus(rt_model_t *m, rt_nexus_t *old, int offset)
 {
    assert(offset < old->width);
 
    rt_signal_t *signal = old->signal;
-   MULTITHREADED_ONLY(assert_lock_held(&signal->lock));
+   assert_model_locked(m);
    signal->n_nexus++;
 
    if (signal->n_nexus == 2 && (old->flags & NET_F_FAST_DRIVER))
       signal->shared.flags |= NET_F_FAST_DRIVER;
 
-   rt_nexus_t *new = static_alloc(m, sizeof(rt_nexus_t));
+   rt_nexus_t *new = alloc_nexus(m, signal);
    new->width        = old->width - offset;
    new->size         = old->size;
    new->signal       = signal;
@@ -1590,6 +2061,10 @@ static rt_nexus_t *clone_nexus(rt_model_t *m, rt_nexus_t *old, int offset)
       for (int i = 0; i < old_p->count; i++)
          new_p->wake[i] = old_p->wake[i];
 
+      mask_init(&new_p->procs, old_p->procs.size);
+      if (old_p->procs.size > 0)
+         mask_copy(&new_p->procs, &old_p->procs);
+
       new->pending = tag_pointer(new_p, 0);
    }
 
@@ -1601,7 +2076,8 @@ static rt_nexus_t *clone_nexus(rt_model_t *m, rt_nexus_t *old, int offset)
          clone_source(m, new, it, offset);
    }
 
-   for (rt_source_t *old_o = old->outputs; old_o; old_o = old_o->chain_output) {
+   for (rt_source_t *old_o = old->outputs; old_o;
+        old_o = old_o->u.port.chain_output) {
       assert(old_o->tag == SOURCE_PORT || old_o->tag == SOURCE_IMPLICIT);
 
       if (old_o->tag == SOURCE_PORT && old_o->u.port.conv_func != NULL) {
@@ -1614,17 +2090,15 @@ static rt_nexus_t *clone_nexus(rt_model_t *m, rt_nexus_t *old, int offset)
             out_n = old_o->u.port.output;
          else if (old_o->u.port.output->width == offset)
             out_n = old_o->u.port.output->chain;   // Cycle breaking
-         else {
-            RT_LOCK(old_o->u.port.output->signal->lock);
+         else
             out_n = clone_nexus(m, old_o->u.port.output, offset);
-         }
 
          for (rt_source_t *s = &(out_n->sources); s; s = s->chain_input) {
             if (s->tag != old_o->tag)
                continue;
             else if (s->u.port.input == new || s->u.port.input == old) {
                s->u.port.input = new;
-               s->chain_output = new->outputs;
+               s->u.port.chain_output = new->outputs;
                new->outputs = s;
                break;
             }
@@ -1671,7 +2145,7 @@ static rt_nexus_t *split_nexus_slow(rt_model_t *m, rt_signal_t *s,
 static inline rt_nexus_t *split_nexus(rt_model_t *m, rt_signal_t *s,
                                       int offset, int count)
 {
-   MULTITHREADED_ONLY(assert_lock_held(&s->lock));
+   assert_model_locked(m);
 
    rt_nexus_t *n0 = &(s->nexus);
    if (likely(offset == 0 && n0->width == count))
@@ -1823,9 +2297,44 @@ static void *source_value(rt_nexus_t *nexus, rt_source_t *src)
    return NULL;
 }
 
+static void resolve_elements(rt_model_t *m, rt_nexus_t *n, res_memo_t *r,
+                             int nonnull, rt_source_t *s0, void *resolved,
+                             int first, int count)
+{
+   // Must not modify any shared state as this may be called
+   // concurrently for different nexuses or elements of the same nexus
+
+   for (int j = first; j < first + count; j++) {
+#define CALL_RESOLUTION_FN(type) do {                                   \
+         type vals[nonnull];                                            \
+         unsigned o = 0;                                                \
+         for (rt_source_t *s = s0; s; s = s->chain_input) {             \
+            const void *data = source_value(n, s);                      \
+            if (data != NULL)                                           \
+               vals[o++] = ((const type *)data)[j];                     \
+         }                                                              \
+         assert(o == nonnull);                                          \
+         type *p = (type *)resolved;                                    \
+         jit_scalar_t result;                                           \
+         if (!jit_try_call(m->jit, r->closure.handle, &result,          \
+                           r->closure.context, vals, r->ileft,          \
+                           nonnull))                                    \
+            model_stop(m);                                              \
+         p[j] = result.integer;                                         \
+      } while (0)
+
+      FOR_ALL_SIZES(n->size, CALL_RESOLUTION_FN);
+   }
+}
+
 static void call_resolution(rt_model_t *m, rt_nexus_t *n, res_memo_t *r,
                             int nonnull, rt_source_t *s0)
 {
+   if (unlikely(m->profile != NULL)) {
+      signal_profile_t *sp = get_signal_profile(m->profile, n->signal);
+      relaxed_add(&sp->resolutions, 1);
+   }
+
    if ((n->flags & NET_F_R_IDENT) && nonnull == 1) {
       // Resolution function behaves like identity for a single driver
       put_driving(m, n, source_value(n, s0));
@@ -1900,28 +2409,7 @@ static void call_resolution(rt_model_t *m, rt_nexus_t *n, res_memo_t *r,
       assert(thread->tlab != NULL);
 
       void *resolved = tlab_alloc(thread->tlab, n->width * n->size);
-
-      for (int j = 0; j < n->width; j++) {
-#define CALL_RESOLUTION_FN(type) do {                                   \
-            type vals[nonnull];                                         \
-            unsigned o = 0;                                             \
-            for (rt_source_t *s = s0; s; s = s->chain_input) {          \
-               const void *data = source_value(n, s);                   \
-               if (data != NULL)                                        \
-                  vals[o++] = ((const type *)data)[j];                  \
-            }                                                           \
-            assert(o == nonnull);                                       \
-            type *p = (type *)resolved;                                 \
-            jit_scalar_t result;                                        \
-            if (!jit_try_call(m->jit, r->closure.handle, &result,       \
-                              r->closure.context, vals, r->ileft,       \
-                              nonnull))                                 \
-               m->force_stop = true;                                    \
-            p[j] = result.integer;                                      \
-         } while (0)
-
-         FOR_ALL_SIZES(n->size, CALL_RESOLUTION_FN);
-      }
+      resolve_elements(m, n, r, nonnull, s0, resolved, 0, n->width);
 
       put_driving(m, n, resolved);
       tlab_reset(thread->tlab);   // No allocations can be live past here
@@ -2057,7 +2545,7 @@ static void calculate_effective_value(rt_model_t *m, rt_nexus_t *n)
    // value of S is the same as the effective value of the actual part
    // of the association element that associates an actual with S
    if (n->flags & NET_F_INOUT) {
-      for (rt_source_t *s = n->outputs; s; s = s->chain_output) {
+      for (rt_source_t *s = n->outputs; s; s = s->u.port.chain_output) {
          if (s->tag == SOURCE_PORT) {
             if (likely(s->u.port.conv_func == NULL))
                put_effective(m, n, nexus_effective(s->u.port.output));
@@ -2140,7 +2628,7 @@ static void dump_one_signal(rt_model_t *m, rt_scope_t *scope, rt_signal_t *s,
 
    for (int nth = 0; nth < s->n_nexus; nth++, n = n->chain) {
       int n_outputs = 0;
-      for (rt_source_t *s = n->outputs; s != NULL; s = s->chain_output)
+      for (rt_source_t *s = n->outputs; s != NULL; s = s->u.port.chain_output)
          n_outputs++;
 
       const void *driving = NULL;
@@ -2311,6 +2799,9 @@ static void create_processes(rt_model_t *m, rt_scope_t *s)
             p->wakeable.postponed = false;
             p->wakeable.delayed   = false;
 
+            p->wakeid = m->proctab.count;
+            APUSH(m->proctab, p);
+
             APUSH(s->procs, p);
          }
          break;
@@ -2332,6 +2823,9 @@ static void create_processes(rt_model_t *m, rt_scope_t *s)
             p->wakeable.postponed = !!(tree_flags(t) & TREE_F_POSTPONED);
             p->wakeable.delayed   = false;
 
+            p->wakeid = m->proctab.count;
+            APUSH(m->proctab, p);
+
             APUSH(s->procs, p);
          }
          break;
@@ -2376,11 +2870,31 @@ void model_reset(rt_model_t *m)
    // Re-read options as these may have changed
    m->stop_delta = opt_get_int(OPT_STOP_DELTA);
    m->shuffle    = opt_get_int(OPT_SHUFFLE_PROCS);
+   m->parallel   = opt_get_int(OPT_PARALLEL_PROCS);
+
+#if USE_EMUTLS
+   m->parallel = false;   // Model pointer is not thread local
+#endif
+
+   if (m->parallel && m->cover != NULL) {
+      warnf("parallel process execution is not supported with coverage "
+            "collection enabled");
+      m->parallel = false;
+   }
+
+   if (m->parallel && m->workq == NULL)
+      m->workq = workq_new(m);
 
    __trace_on = opt_get_int(OPT_RT_TRACE);
 
+   const char *profile = opt_get_str(OPT_RT_PROFILE);
+   if (profile != NULL && m->profile == NULL)
+      profile_start(m, profile);
+
    create_processes(m, m->root);
 
+   mask_init(&m->wakemask, m->proctab.count);
+
    nvc_rusage(&m->ready_rusage);
 
    // Initialisation is described in LRM 93 section 12.6.4
@@ -2441,6 +2955,9 @@ void model_reset(rt_model_t *m)
       calculate_effective_value(m, n);
    }
 
+   if (m->densewake)
+      wakeup_dense(m);
+
    tlab_reset(thread->tlab);   // No allocations can be live past here
 
    global_event(m, RT_END_OF_INITIALISATION);
@@ -2509,11 +3026,18 @@ static void sched_event(rt_model_t *m, rt_nexus_t *n, rt_wakeable_t *obj)
       p->wake[0] = cur;
       p->wake[1] = obj;
 
+      mask_init(&p->procs, 0);
+
       n->pending = tag_pointer(p, 0);
    }
    else {
       rt_pending_t *p = untag_pointer(n->pending, rt_pending_t);
 
+      if (p->procs.size > 0 && obj->kind == W_PROC) {
+         mask_set(&p->procs, container_of(obj, rt_proc_t, wakeable)->wakeid);
+         return;
+      }
+
       for (int i = 0; i < p->count; i++) {
          if (p->wake[i] == NULL || p->wake[i] == obj) {
             p->wake[i] = obj;
@@ -2521,6 +3045,33 @@ static void sched_event(rt_model_t *m, rt_nexus_t *n, rt_wakeable_t *obj)
          }
       }
 
+      if (p->count == p->max && p->procs.size == 0
+          && p->count >= PENDING_DENSE
+          && p->count * 64 >= m->proctab.count) {
+         // Switch to a bit mask indexed by process for high fanout
+         // nexuses such as clocks and resets where this is smaller
+         // than the list of pointers
+         mask_init(&p->procs, m->proctab.count);
+
+         int j = 0;
+         for (int i = 0; i < p->count; i++) {
+            if (p->wake[i] == NULL)
+               continue;
+            else if (p->wake[i]->kind == W_PROC) {
+               rt_proc_t *proc = container_of(p->wake[i], rt_proc_t, wakeable);
+               mask_set(&p->procs, proc->wakeid);
+            }
+            else
+               p->wake[j++] = p->wake[i];
+         }
+         p->count = j;
+
+         if (obj->kind == W_PROC) {
+            mask_set(&p->procs, container_of(obj, rt_proc_t, wakeable)->wakeid);
+            return;
+         }
+      }
+
       if (p->count == p->max) {
          p->max = MAX(PENDING_MIN, p->max * 2);
          p = xrealloc_flex(p, sizeof(rt_pending_t), p->max,
@@ -2541,6 +3092,12 @@ static void clear_event(rt_model_t *m, rt_nexus_t *n, rt_wakeable_t *obj)
    }
    else if (n->pending != NULL) {
       rt_pending_t *p = untag_pointer(n->pending, rt_pending_t);
+
+      if (p->procs.size > 0 && obj->kind == W_PROC) {
+         mask_clear(&p->procs, container_of(obj, rt_proc_t, wakeable)->wakeid);
+         return;
+      }
+
       for (int i = 0; i < p->count; i++) {
          if (p->wake[i] == obj) {
             p->wake[i] = NULL;
@@ -2576,7 +3133,7 @@ static inline bool insert_transaction(rt_model_t *m, rt_nexus_t *nexus,
           && !cmp_values(nexus, it->value, w->value)) {
          waveform_t *next = it->next;
          last->next = next;
-         free_value(nexus, it->value);
+         free_value(m, nexus, it->value);
          free_waveform(m, it);
          it = next;
       }
@@ -2595,7 +3152,7 @@ static inline bool insert_transaction(rt_model_t *m, rt_nexus_t *nexus,
    for (waveform_t *next; it != NULL; it = next) {
       next = it->next;
       already_scheduled |= (it->when == when);
-      free_value(nexus, it->value);
+      free_value(m, nexus, it->value);
       free_waveform(m, it);
    }
 
@@ -2744,7 +3301,7 @@ static void async_update_property(rt_model_t *m, void *arg)
    update_property(m, prop);
 }
 
-static bool heap_delete_proc_cb(uint64_t key, void *value, void *search)
+static bool eventq_delete_proc_cb(uint64_t key, void *value, void *search)
 {
    if (pointer_tag(value) != EVENT_PROCESS)
       return false;
@@ -2822,7 +3379,7 @@ static void wakeup_one(rt_model_t *m, rt_wakeable_t *obj)
          if (proc->wakeable.delayed) {
             // This process was already scheduled to run at a later
             // time so we need to delete it from the simulation queue
-            heap_delete(m->eventq_heap, heap_delete_proc_cb, proc);
+            eventq_delete(m->eventq, eventq_delete_proc_cb, proc);
             proc->wakeable.delayed = false;
          }
       }
@@ -2879,8 +3436,18 @@ static void notify_event(rt_model_t *m, rt_nexus_t *n)
    n->last_event = m->now;
    n->event_delta = m->iteration;
 
-   if (n->flags & NET_F_CACHE_EVENT)
-      n->signal->shared.flags |= SIG_F_EVENT_FLAG;
+   if (unlikely(m->profile != NULL)) {
+      signal_profile_t *sp = get_signal_profile(m->profile, n->signal);
+      relaxed_add(&sp->events, 1);
+   }
+
+   if (n->flags & NET_F_CACHE_EVENT) {
+      sig_shared_t *ss = &(n->signal->shared);
+      if (!(ss->flags & SIG_F_EVENT_FLAG)) {
+         ss->flags |= SIG_F_EVENT_FLAG;
+         APUSH(m->eventsigs, n->signal);
+      }
+   }
 
    if (pointer_tag(n->pending) == 1) {
       rt_wakeable_t *wake = untag_pointer(n->pending, rt_wakeable_t);
@@ -2892,9 +3459,27 @@ static void notify_event(rt_model_t *m, rt_nexus_t *n)
          if (p->wake[i] != NULL)
             wakeup_one(m, p->wake[i]);
       }
+
+      if (p->procs.size > 0) {
+         mask_union(&m->wakemask, &p->procs);
+         m->densewake = true;
+      }
    }
 }
 
+static void wakeup_dense(rt_model_t *m)
+{
+   // Processes sensitive to nexuses with a bit mask of waiters are
+   // collected during the update phase and woken together here so each
+   // is visited once regardless of how many of its signals had events
+   size_t bit = -1;
+   while (mask_iter(&m->wakemask, &bit))
+      wakeup_one(m, &(m->proctab.items[bit]->wakeable));
+
+   mask_clearall(&m->wakemask);
+   m->densewake = false;
+}
+
 static void put_effective(rt_model_t *m, rt_nexus_t *n, const void *value)
 {
    TRACE("update %s effective value %s", trace_nexus(n), fmt_nexus(n, value));
@@ -2969,48 +3554,69 @@ static void defer_driving_update(rt_model_t *m, rt_nexus_t *n)
    n->flags |= NET_F_PENDING;
 }
 
-static void update_driving(rt_model_t *m, rt_nexus_t *n, bool safe)
-{
-   if (n->n_sources == 1 || safe) {
-      n->active_delta = m->iteration;
-      n->flags &= ~NET_F_PENDING;
+static void update_driving(rt_model_t *m, rt_nexus_t *n, bool safe);
 
-      calculate_driving_value(m, n);
+static void update_outputs(rt_model_t *m, rt_nexus_t *n)
+{
+   // Update outputs if the effective value must be calculated
+   // separately or there was an event on this signal
+   const bool update_outputs = !!(n->flags & NET_F_EFFECTIVE)
+      || (n->event_delta == m->iteration && n->last_event == m->now);
 
-      // Update outputs if the effective value must be calculated
-      // separately or there was an event on this signal
-      const bool update_outputs = !!(n->flags & NET_F_EFFECTIVE)
-         || (n->event_delta == m->iteration && n->last_event == m->now);
-
-      if (update_outputs) {
-         for (rt_source_t *o = n->outputs; o; o = o->chain_output) {
-            switch (o->tag) {
-            case SOURCE_PORT:
-               if (o->u.port.conv_func != NULL)
-                  defer_driving_update(m, o->u.port.output);
-               else
-                  update_driving(m, o->u.port.output, false);
-               break;
-            case SOURCE_IMPLICIT:
-               update_driving(m, o->u.pseudo.nexus , false);
-               break;
-            default:
-               should_not_reach_here();
-            }
+   if (update_outputs) {
+      for (rt_source_t *o = n->outputs; o; o = o->u.port.chain_output) {
+         switch (o->tag) {
+         case SOURCE_PORT:
+            if (o->u.port.conv_func != NULL)
+               defer_driving_update(m, o->u.port.output);
+            else
+               update_driving(m, o->u.port.output, false);
+            break;
+         case SOURCE_IMPLICIT:
+            update_driving(m, o->u.pseudo.nexus , false);
+            break;
+         default:
+            should_not_reach_here();
          }
       }
    }
+}
+
+static void update_driving(rt_model_t *m, rt_nexus_t *n, bool safe)
+{
+   if (n->n_sources == 1 || safe) {
+      n->active_delta = m->iteration;
+      n->flags &= ~NET_F_PENDING;
+
+      calculate_driving_value(m, n);
+      update_outputs(m, n);
+   }
    else
       defer_driving_update(m, n);
 }
 
+static void update_resolved(rt_model_t *m, rt_nexus_t *n, const void *value)
+{
+   n->active_delta = m->iteration;
+   n->flags &= ~NET_F_PENDING;
+
+   if (unlikely(m->profile != NULL)) {
+      // Resolved asynchronously without going through call_resolution
+      signal_profile_t *sp = get_signal_profile(m->profile, n->signal);
+      sp->resolutions++;
+   }
+
+   put_driving(m, n, value);
+   update_outputs(m, n);
+}
+
 static void update_driver(rt_model_t *m, rt_nexus_t *n, rt_source_t *source)
 {
    waveform_t *w_now  = &(source->u.driver.waveforms);
    waveform_t *w_next = w_now->next;
 
    if (likely(w_next != NULL && w_next->when == m->now)) {
-      free_value(n, w_now->value);
+      free_value(m, n, w_now->value);
       *w_now = *w_next;
       free_waveform(m, w_next);
       source->disconnected = 0;
@@ -3211,9 +3817,14 @@ static void reached_iteration_limit(rt_model_t *m)
 
 static void sync_event_cache(rt_model_t *m)
 {
+   // The list only contains signals whose cached event flag is set so
+   // the cost is proportional to the number of signals with events in
+   // this cycle or the previous one rather than all cached signals
+   int wptr = 0;
    for (int i = 0; i < m->eventsigs.count; i++) {
       rt_signal_t *s = m->eventsigs.items[i];
       assert(s->shared.flags & SIG_F_CACHE_EVENT);
+      assert(s->shared.flags & SIG_F_EVENT_FLAG);
 
       const bool event = s->nexus.last_event == m->now
          && s->nexus.event_delta == m->iteration;
@@ -3221,10 +3832,205 @@ static void sync_event_cache(rt_model_t *m)
       TRACE("sync event flag %d for %s", event, istr(tree_ident(s->where)));
 
       if (event)
-         assert(s->shared.flags & SIG_F_EVENT_FLAG);   // Set by notify_event
+         m->eventsigs.items[wptr++] = s;
       else
          s->shared.flags &= ~SIG_F_EVENT_FLAG;
    }
+
+   ATRIM(m->eventsigs, wptr);
+}
+
+static void async_run_batch(void *context, void *arg)
+{
+   rt_model_t *m = context;
+   proc_batch_t *batch = arg;
+
+   MODEL_ENTRY(m);
+
+   model_thread_t *thread = model_thread(m);
+   if (thread->tlab == NULL)
+      thread->tlab = tlab_acquire(m->mspace);
+
+   for (int i = 0; i < batch->count; i++)
+      run_process(m, batch->procs[i]);
+}
+
+static void parallel_run(rt_model_t *m, deferq_t *dq)
+{
+   // Triggers cache their result and may be shared between processes
+   // so must be evaluated before any process starts running on a
+   // worker thread
+   for (int i = 0; i < dq->count; i++) {
+      const defer_task_t *t = &(dq->tasks[i]);
+      if (t->fn == async_run_process) {
+         rt_proc_t *proc = t->arg;
+
+         assert(proc->wakeable.pending);
+         proc->wakeable.pending = false;
+
+         rt_trigger_t *trigger = proc->wakeable.trigger;
+         if (trigger == NULL || run_trigger(m, trigger))
+            APUSH(m->runnable, proc);
+      }
+      else
+         (*t->fn)(m, t->arg);   // Callbacks always run on the main thread
+   }
+
+   dq->count = 0;
+
+   for (int i = 0; i < m->runnable.count; i += PARALLEL_BATCH) {
+      const proc_batch_t batch = {
+         .procs = m->runnable.items + i,
+         .count = MIN(PARALLEL_BATCH, m->runnable.count - i),
+      };
+      APUSH(m->batches, batch);
+   }
+
+   for (int i = 0; i < m->batches.count; i++)
+      workq_do(m->workq, async_run_batch, &(m->batches.items[i]));
+
+   TRACE("running %d processes in %d batches", m->runnable.count,
+         m->batches.count);
+
+   m->concurrent = true;
+
+   workq_start(m->workq);
+   workq_drain(m->workq);
+
+   m->concurrent = false;
+
+   // Processes woken or drivers updated by the worker threads are
+   // appended to the global queues for the next delta cycle
+   for (int i = 0; i < MAX_THREADS; i++) {
+      model_thread_t *thread = m->threads[i];
+      if (thread == NULL)
+         continue;
+
+      if (deferq_merge(&m->delta_procq, &thread->delta_procq))
+         m->next_is_delta = true;
+      if (deferq_merge(&m->delta_driverq, &thread->delta_driverq))
+         m->next_is_delta = true;
+   }
+
+   ATRIM(m->runnable, 0);
+   ATRIM(m->batches, 0);
+}
+
+static bool can_resolve_async(rt_nexus_t *n, int *nonnull, rt_source_t **s0)
+{
+   // Only handle the general case in calculate_driving_value where the
+   // resolution function is called with more than two driving values
+   // and every source can be read without side effects
+
+   res_memo_t *r = n->signal->resolution;
+   if (r == NULL || (r->flags & R_COMPOSITE) || n->n_sources <= 2)
+      return false;
+
+   *nonnull = 0;
+   *s0 = NULL;
+
+   for (rt_source_t *s = &(n->sources); s; s = s->chain_input) {
+      if (s->disconnected)
+         continue;
+      else if (s->tag == SOURCE_PORT && s->u.port.conv_func != NULL)
+         return false;
+      else if (s->tag != SOURCE_DRIVER && s->tag != SOURCE_PORT)
+         return false;
+      else if (*s0 == NULL)
+         *s0 = s;
+
+      (*nonnull)++;
+   }
+
+   return *nonnull > 2;
+}
+
+static void async_resolve(void *context, void *arg)
+{
+   rt_model_t *m = context;
+   resolve_job_t *job = arg;
+
+   MODEL_ENTRY(m);
+
+   rt_nexus_t *n = job->nexus;
+   resolve_elements(m, n, n->signal->resolution, job->nonnull, job->s0,
+                    job->resolved, job->first, job->count);
+}
+
+static void parallel_update_driving(rt_model_t *m)
+{
+   while (heap_size(m->driving_heap) > 0) {
+      // Nexuses with the same rank do not depend on each other so the
+      // resolution functions for a whole rank can be called in
+      // parallel before the driving values are updated in order
+      const uint64_t rank = heap_min_key(m->driving_heap);
+
+      size_t work = 0, bufsz = 0;
+      do {
+         rank_item_t item = {
+            .nexus = heap_extract_min(m->driving_heap)
+         };
+         APUSH(m->rankq, item);
+
+         rt_nexus_t *n = item.nexus;
+         rt_source_t *s0;
+         int nonnull;
+         if (!can_resolve_async(n, &nonnull, &s0))
+            continue;
+
+         // Split wide nexuses into several jobs by element
+         const int step = MAX(1, RESOLVE_GRAIN / nonnull);
+         for (int first = 0; first < n->width; first += step) {
+            const resolve_job_t job = {
+               .nexus    = n,
+               .s0       = s0,
+               .nonnull  = nonnull,
+               .first    = first,
+               .count    = MIN(step, n->width - first),
+               .resolved = (void *)bufsz,   // Fixed up below
+            };
+            APUSH(m->resolvejobs, job);
+         }
+
+         bufsz += ALIGN_UP(n->width * n->size, 8);
+         work += nonnull * n->width;
+      } while (heap_size(m->driving_heap) > 0
+               && heap_min_key(m->driving_heap) == rank);
+
+      if (work >= RESOLVE_MIN) {
+         if (bufsz > m->resolvebufsz) {
+            m->resolvebufsz = MAX(bufsz, m->resolvebufsz * 2);
+            m->resolvebuf = xrealloc(m->resolvebuf, m->resolvebufsz);
+         }
+
+         for (int i = 0, j = 0; i < m->resolvejobs.count; i++) {
+            resolve_job_t *job = &(m->resolvejobs.items[i]);
+            job->resolved = m->resolvebuf + (uintptr_t)job->resolved;
+
+            for (; m->rankq.items[j].nexus != job->nexus; j++);
+            m->rankq.items[j].resolved = job->resolved;
+
+            workq_do(m->workq, async_resolve, job);
+         }
+
+         TRACE("resolving %d nexuses with rank %"PRIu64" in %d jobs",
+               m->rankq.count, rank, m->resolvejobs.count);
+
+         workq_start(m->workq);
+         workq_drain(m->workq);
+      }
+
+      for (int i = 0; i < m->rankq.count; i++) {
+         rank_item_t *item = &(m->rankq.items[i]);
+         if (item->resolved != NULL)
+            update_resolved(m, item->nexus, item->resolved);
+         else
+            update_driving(m, item->nexus, true);
+      }
+
+      ATRIM(m->rankq, 0);
+      ATRIM(m->resolvejobs, 0);
+   }
 }
 
 static void swap_deferq(deferq_t *a, deferq_t *b)
@@ -3244,7 +4050,7 @@ static void model_cycle(rt_model_t *m)
    if (is_delta_cycle)
       m->iteration = m->iteration + 1;
    else {
-      m->now = heap_min_key(m->eventq_heap);
+      m->now = eventq_min_key(m->eventq);
       m->iteration = 0;
    }
 
@@ -3265,7 +4071,7 @@ static void model_cycle(rt_model_t *m)
 
    if (!is_delta_cycle) {
       for (;;) {
-         void *e = heap_extract_min(m->eventq_heap);
+         void *e = eventq_extract_min(m->eventq);
          switch (pointer_tag(e)) {
          case EVENT_PROCESS:
             {
@@ -3290,18 +4096,22 @@ static void model_cycle(rt_model_t *m)
             break;
          }
 
-         if (heap_size(m->eventq_heap) == 0)
+         if (eventq_size(m->eventq) == 0)
             break;
-         else if (heap_min_key(m->eventq_heap) > m->now)
+         else if (eventq_min_key(m->eventq) > m->now)
             break;
       }
    }
 
    deferq_run(m, &m->driverq);
 
-   while (heap_size(m->driving_heap) > 0) {
-      rt_nexus_t *n = heap_extract_min(m->driving_heap);
-      update_driving(m, n, true);
+   if (m->parallel)
+      parallel_update_driving(m);
+   else {
+      while (heap_size(m->driving_heap) > 0) {
+         rt_nexus_t *n = heap_extract_min(m->driving_heap);
+         update_driving(m, n, true);
+      }
    }
 
    while (heap_size(m->effective_heap) > 0) {
@@ -3314,6 +4124,9 @@ static void model_cycle(rt_model_t *m)
    // Update implicit signals
    deferq_run(m, &m->implicitq);
 
+   if (m->densewake)
+      wakeup_dense(m);
+
 #if TRACE_SIGNALS > 0
    if (__trace_on)
       dump_signals(m, m->root);
@@ -3323,7 +4136,10 @@ static void model_cycle(rt_model_t *m)
       deferq_shuffle(&m->procq);
 
    // Run all non-postponed processes and event callbacks
-   deferq_run(m, &m->procq);
+   if (m->parallel && m->procq.count >= PARALLEL_MIN)
+      parallel_run(m, &m->procq);
+   else
+      deferq_run(m, &m->procq);
 
    global_event(m, RT_END_OF_PROCESSES);
 
@@ -3336,6 +4152,9 @@ static void model_cycle(rt_model_t *m)
       // Run all postponed processes and event callbacks
       deferq_run(m, &m->postponedq);
 
+      if (unlikely(m->profile != NULL))
+         profile_end_time_step(m);
+
       global_event(m, RT_END_TIME_STEP);
 
       m->can_create_delta = true;
@@ -3354,10 +4173,10 @@ static bool should_stop_now(rt_model_t *m, uint64_t stop_time)
    }
    else if (m->next_is_delta)
       return false;
-   else if (heap_size(m->eventq_heap) == 0)
+   else if (eventq_size(m->eventq) == 0)
       return true;
    else
-      return heap_min_key(m->eventq_heap) > stop_time;
+      return eventq_min_key(m->eventq) > stop_time;
 }
 
 static void check_liveness_properties(rt_model_t *m, rt_scope_t *s)
@@ -3440,7 +4259,7 @@ static inline void check_delay(int64_t delay)
 void force_signal(rt_model_t *m, rt_signal_t *s, const void *values,
                   int offset, size_t count)
 {
-   RT_LOCK(s->lock);
+   MODEL_LOCK();
 
    TRACE("force signal %s+%d to %s", istr(tree_ident(s->where)), offset,
          fmt_values(values, count));
@@ -3470,7 +4289,7 @@ void force_signal(rt_model_t *m, rt_signal_t *s, const void *values,
 
 void release_signal(rt_model_t *m, rt_signal_t *s, int offset, size_t count)
 {
-   RT_LOCK(s->lock);
+   MODEL_LOCK();
 
    TRACE("release signal %s+%d", istr(tree_ident(s->where)), offset);
 
@@ -3486,309 +4305,1458 @@ void release_signal(rt_model_t *m, rt_signal_t *s, int offset, size_t count)
       rt_source_t *src = get_pseudo_source(m, n, SOURCE_FORCING);
       src->disconnected = 1;
 
-      if (!src->pseudoqueued) {
-         deltaq_insert_pseudo_source(m, src);
-         src->pseudoqueued = 1;
-      }
+      if (!src->pseudoqueued) {
+         deltaq_insert_pseudo_source(m, src);
+         src->pseudoqueued = 1;
+      }
+   }
+}
+
+void deposit_signal(rt_model_t *m, rt_signal_t *s, const void *values,
+                    int offset, size_t count)
+{
+   MODEL_LOCK();
+
+   TRACE("deposit signal %s+%d to %s", istr(tree_ident(s->where)),
+         offset, fmt_values(values, count));
+
+   assert(m->can_create_delta);
+
+   rt_nexus_t *n = split_nexus(m, s, offset, count);
+   const char *vptr = values;
+   for (; count > 0; n = n->chain) {
+      count -= n->width;
+      assert(count >= 0);
+
+      rt_source_t *src = get_pseudo_source(m, n, SOURCE_DEPOSIT);
+      copy_value_ptr(n, &(src->u.pseudo.value), vptr);
+      src->disconnected = 0;
+
+      if (!src->pseudoqueued) {
+         deltaq_insert_pseudo_source(m, src);
+         src->pseudoqueued = 1;
+      }
+
+      vptr += n->width * n->size;
+   }
+}
+
+bool model_can_create_delta(rt_model_t *m)
+{
+   return m->can_create_delta;
+}
+
+int64_t model_now(rt_model_t *m, unsigned *deltas)
+{
+   if (deltas != NULL)
+      *deltas = MAX(m->iteration, 0);
+
+   return m->now;
+}
+
+int64_t model_next_time(rt_model_t *m)
+{
+   if (eventq_size(m->eventq) == 0)
+      return TIME_HIGH;
+   else
+      return eventq_min_key(m->eventq);
+}
+
+void model_stop(rt_model_t *m)
+{
+   relaxed_store(&m->force_stop, true);
+}
+
+void model_shuffle(rt_model_t *m, unsigned seed)
+{
+   m->shuffle = true;
+   srand(seed);
+}
+
+void model_set_global_cb(rt_model_t *m, rt_event_t event, rt_event_fn_t fn,
+                         void *user)
+{
+   assert(event < RT_LAST_EVENT);
+
+   // Add to end of list so callbacks are called in registration order
+   rt_callback_t **p = &(m->global_cbs[event]);
+   for (; *p; p = &(*p)->next);
+
+   rt_callback_t *cb = xcalloc(sizeof(rt_callback_t));
+   cb->next = NULL;
+   cb->fn   = fn;
+   cb->user = user;
+
+   *p = cb;
+}
+
+void model_set_timeout_cb(rt_model_t *m, uint64_t when, rt_event_fn_t fn,
+                          void *user)
+{
+   rt_callback_t *cb = xcalloc(sizeof(rt_callback_t));
+   cb->next = NULL;
+   cb->fn   = fn;
+   cb->user = user;
+
+   assert(when > m->now);   // TODO: delta timeouts?
+
+   void *e = tag_pointer(cb, EVENT_TIMEOUT);
+   eventq_insert(m->eventq, when, e);
+}
+
+rt_watch_t *watch_new(rt_model_t *m, sig_event_fn_t fn, void *user,
+                      watch_kind_t kind, unsigned slots)
+{
+   rt_watch_t *w = xcalloc_flex(sizeof(rt_watch_t), slots,
+                                sizeof(rt_signal_t *));
+   w->fn        = fn;
+   w->chain_all = m->watches;
+   w->user_data = user;
+   w->num_slots = slots;
+
+   w->wakeable.kind      = W_WATCH;
+   w->wakeable.postponed = (kind == WATCH_POSTPONED);
+   w->wakeable.pending   = false;
+   w->wakeable.delayed   = false;
+
+   m->watches = w;
+
+   return w;
+}
+
+void watch_free(rt_model_t *m, rt_watch_t *w)
+{
+   assert(!w->wakeable.zombie);
+
+   for (int i = 0; i < w->next_slot; i++) {
+      rt_nexus_t *n = &(w->signals[i]->nexus);
+      for (int j = 0; j < w->signals[i]->n_nexus; j++, n = n->chain)
+         clear_event(m, n, &(w->wakeable));
+   }
+
+   rt_watch_t **last = &m->watches;
+   for (rt_watch_t *it = *last; it;
+        last = &(it->chain_all), it = it->chain_all) {
+      if (it == w) {
+         *last = it->chain_all;
+         if (w->wakeable.pending)
+            w->wakeable.zombie = true;   // Will be freed in callback
+         else
+            free(w);
+         return;
+      }
+   }
+
+   should_not_reach_here();
+}
+
+rt_watch_t *model_set_event_cb(rt_model_t *m, rt_signal_t *s, rt_watch_t *w)
+{
+   assert(!w->wakeable.zombie);
+   assert(w->next_slot < w->num_slots);
+
+   w->signals[w->next_slot++] = s;
+
+   rt_nexus_t *n = &(s->nexus);
+   for (int i = 0; i < s->n_nexus; i++, n = n->chain)
+      sched_event(m, n, &(w->wakeable));
+
+   return w;
+}
+
+static void handle_interrupt_cb(jit_t *j, void *ctx)
+{
+   rt_proc_t *proc = get_active_proc();
+
+   if (proc != NULL)
+      jit_msg(NULL, DIAG_FATAL, "interrupted in process %s", istr(proc->name));
+   else {
+      diag_t *d = diag_new(DIAG_FATAL, NULL);
+      diag_printf(d, "interrupted");
+      diag_emit(d);
+   }
+}
+
+void model_interrupt(rt_model_t *m)
+{
+   model_stop(m);
+   jit_interrupt(m->jit, handle_interrupt_cb, m);
+}
+
+int model_exit_status(rt_model_t *m)
+{
+   int status;
+   if (jit_exit_status(m->jit, &status))
+      return status;
+   else if (m->stop_delta > 0 && m->iteration == m->stop_delta)
+      return EXIT_FAILURE;
+   else
+      return get_vhdl_assert_exit_status();
+}
+
+static bool nexus_active(rt_model_t *m, rt_nexus_t *nexus)
+{
+   if (nexus->n_sources > 0) {
+      for (rt_source_t *s = &(nexus->sources); s; s = s->chain_input) {
+         if (s->tag == SOURCE_PORT) {
+            rt_conv_func_t *cf = s->u.port.conv_func;
+            if (cf == NULL) {
+               if (nexus_active(m, s->u.port.input))
+                  return true;
+            }
+            else {
+               for (int i = 0; i < cf->ninputs; i++) {
+                  if (nexus_active(m, cf->inputs[i].nexus))
+                     return true;
+               }
+            }
+         }
+         else if (s->tag == SOURCE_DRIVER
+                  && s->u.driver.waveforms.when == m->now) {
+            if (nexus->active_delta == m->iteration)
+               return true;
+            else if (nexus->active_delta == m->iteration + 1 && s->was_active)
+               return true;
+         }
+      }
+   }
+
+   return false;
+}
+
+static uint64_t nexus_last_active(rt_model_t *m, rt_nexus_t *nexus)
+{
+   int64_t last = TIME_HIGH;
+
+   if (nexus->n_sources > 0) {
+      for (rt_source_t *s = &(nexus->sources); s; s = s->chain_input) {
+          if (s->tag == SOURCE_PORT) {
+            rt_conv_func_t *cf = s->u.port.conv_func;
+            if (cf == NULL)
+               last = MIN(last, nexus_last_active(m, s->u.port.input));
+            else {
+               for (int i = 0; i < cf->ninputs; i++)
+                  last = MIN(last, nexus_last_active(m, cf->inputs[i].nexus));
+            }
+         }
+         else if (s->tag == SOURCE_DRIVER
+                  && s->u.driver.waveforms.when <= m->now)
+            last = MIN(last, m->now - s->u.driver.waveforms.when);
+      }
+   }
+
+   return last;
+}
+
+void get_forcing_value(rt_signal_t *s, uint8_t *value)
+{
+   uint8_t *p = value;
+   rt_nexus_t *n = &(s->nexus);
+   for (int i = 0; i < s->n_nexus; i++) {
+      assert(n->n_sources > 0);
+      rt_source_t *s = NULL;
+      for (s = &(n->sources); s; s = s->chain_input) {
+         if (s->tag == SOURCE_FORCING)
+            break;
+      }
+      assert(s != NULL);
+
+      memcpy(p, s->u.pseudo.value.bytes, n->width * n->size);
+      p += n->width * n->size;
+   }
+   assert(p == value + s->shared.size);
+}
+
+int32_t *get_cover_counter(rt_model_t *m, int32_t tag, int count)
+{
+   assert(tag >= 0);
+   assert(m->cover != NULL);
+   return jit_get_cover_mem(m->jit, tag + count) + tag;
+}
+
+static rt_trigger_t *new_trigger(rt_model_t *m, trigger_kind_t kind,
+                                 uint64_t hash, jit_handle_t handle,
+                                 unsigned nargs, const jit_scalar_t *args)
+{
+   MODEL_LOCK();
+
+   rt_trigger_t **bucket = &(m->triggertab[hash % TRIGGER_TAB_SIZE]);
+
+   for (rt_trigger_t *exist = *bucket; exist; exist = exist->chain) {
+      bool hit = exist->handle == handle
+         && exist->nargs == nargs
+         && exist->kind == kind;
+
+      for (int i = 0; hit && i < nargs; i++)
+         hit &= (exist->args[i].integer == args[i].integer);
+
+      if (hit)
+         return exist;
+   }
+
+   const size_t argsz = nargs * sizeof(jit_scalar_t);
+
+   rt_trigger_t *t = static_alloc(m, sizeof(rt_trigger_t) + argsz);
+   t->handle = handle;
+   t->nargs  = nargs;
+   t->when   = TIME_HIGH;
+   t->kind   = kind;
+   t->chain  = *bucket;
+   memcpy(t->args, args, argsz);
+
+   return (*bucket = t);
+}
+
+void call_with_model(rt_model_t *m, void (*cb)(void *), void *arg)
+{
+   MODEL_ENTRY(m);
+   (*cb)(arg);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Checkpoint and restore
+//
+// The restoring process must have elaborated and reset the same design
+// with the same options so that its scopes, signals, and processes are
+// created in the same order and the heap objects allocated during
+// initialisation are at the same offsets as in the saved image.
+// Compiled code registers a map of the pointer slots in the private
+// state of each unit and in each object allocated with new.  When saving
+// these maps are followed from the private data of every unit to record
+// the address of each live pointer in the heap and process TLABs, and
+// only those slots are relocated to the new addresses of the heap,
+// signals, TLABs, and constant pools when restoring.
+
+#define CHECKPOINT_MAGIC 0x4b43564e   // "NVCK"
+#define END_OF_LIST      UINT8_MAX
+
+typedef struct {
+   uintptr_t from;
+   uintptr_t to;
+   size_t    size;
+} reloc_t;
+
+typedef struct {
+   void            *ptr;
+   const ptr_map_t *map;
+   size_t           count;
+} map_entry_t;
+
+typedef struct {
+   rt_model_t     *model;
+   fbuf_t         *fbuf;
+   signal_list_t   signals;
+   proc_list_t     procs;
+   prop_list_t     props;
+   scope_list_t    scopes;
+   hash_t         *index;
+   A(reloc_t)      relocs;
+   A(uint64_t)     keys;
+   A(void *)       events;
+   A(tlab_t *)     tlabs;
+   A(map_entry_t)  maps;
+   A(void *)       worklist;
+   A(uint64_t)     slots;
+   hset_t         *objects;
+   hset_t         *slotset;
+   ident_wr_ctx_t  ident_wr;
+   ident_rd_ctx_t  ident_rd;
+} checkpoint_t;
+
+static void checkpoint_add(checkpoint_t *cp, const void *obj, unsigned index)
+{
+   // Zero is reserved for a missing entry
+   hash_put(cp->index, obj, (void *)(uintptr_t)(index + 1));
+}
+
+static unsigned checkpoint_index(checkpoint_t *cp, const void *obj)
+{
+   const uintptr_t index = (uintptr_t)hash_get(cp->index, obj);
+   assert(index > 0);
+   return index - 1;
+}
+
+static void checkpoint_walk(checkpoint_t *cp, rt_scope_t *s)
+{
+   APUSH(cp->scopes, s);
+
+   for (int i = 0; i < s->signals.count; i++) {
+      checkpoint_add(cp, s->signals.items[i], cp->signals.count);
+      APUSH(cp->signals, s->signals.items[i]);
+   }
+
+   for (int i = 0; i < s->procs.count; i++) {
+      checkpoint_add(cp, s->procs.items[i], cp->procs.count);
+      APUSH(cp->procs, s->procs.items[i]);
+   }
+
+   for (int i = 0; i < s->properties.count; i++) {
+      checkpoint_add(cp, s->properties.items[i], cp->props.count);
+      APUSH(cp->props, s->properties.items[i]);
+   }
+
+   for (int i = 0; i < s->children.count; i++)
+      checkpoint_walk(cp, s->children.items[i]);
+}
+
+static void checkpoint_init(checkpoint_t *cp, rt_model_t *m, fbuf_t *f)
+{
+   cp->model = m;
+   cp->fbuf  = f;
+   cp->index = hash_new(1024);
+
+   checkpoint_walk(cp, m->root);
+}
+
+static void checkpoint_free(checkpoint_t *cp)
+{
+   ACLEAR(cp->signals);
+   ACLEAR(cp->procs);
+   ACLEAR(cp->props);
+   ACLEAR(cp->scopes);
+   ACLEAR(cp->relocs);
+   ACLEAR(cp->keys);
+   ACLEAR(cp->events);
+   ACLEAR(cp->tlabs);
+   ACLEAR(cp->maps);
+   ACLEAR(cp->worklist);
+   ACLEAR(cp->slots);
+
+   hash_free(cp->index);
+
+   if (cp->objects != NULL)
+      hset_free(cp->objects);
+   if (cp->slotset != NULL)
+      hset_free(cp->slotset);
+}
+
+static size_t signal_data_size(rt_signal_t *s)
+{
+   // Implicit signals do not have a separate driving value
+   const int nvalues = (s->shared.flags & SIG_F_IMPLICIT) ? 2 : 3;
+   return nvalues * s->shared.size;
+}
+
+static void *pointer_value(mptr_t mptr)
+{
+   return mptr == MPTR_INVALID ? NULL : *mptr_get(mptr);
+}
+
+static void save_check(checkpoint_t *cp)
+{
+   rt_model_t *m = cp->model;
+
+   if (m->next_is_delta || m->procq.count > 0 || m->postponedq.count > 0
+       || m->driverq.count > 0 || m->implicitq.count > 0)
+      fatal("checkpoint must be saved at the end of a time step");
+
+   if (m->cover != NULL)
+      fatal("cannot save a checkpoint with coverage collection enabled");
+
+   if (file_io_open_count() > 0)
+      fatal("cannot save a checkpoint while the design has open files");
+
+   for (int i = 0; i < cp->signals.count; i++) {
+      rt_signal_t *s = cp->signals.items[i];
+      rt_nexus_t *n = &(s->nexus);
+      for (int j = 0; j < s->n_nexus; j++, n = n->chain) {
+         if (n->n_sources == 0)
+            continue;
+
+         for (rt_source_t *src = &(n->sources); src; src = src->chain_input) {
+            if (src->tag == SOURCE_FORCING || src->tag == SOURCE_DEPOSIT)
+               fatal("cannot save a checkpoint while signal %s is forced "
+                     "or deposited", istr(tree_ident(s->where)));
+         }
+      }
+   }
+
+   // Drain the event queue into a list and then reinsert in the same
+   // order so events with the same time keep their relative order
+   while (eventq_size(m->eventq) > 0) {
+      APUSH(cp->keys, eventq_min_key(m->eventq));
+      APUSH(cp->events, eventq_extract_min(m->eventq));
+   }
+
+   for (int i = 0; i < cp->events.count; i++)
+      eventq_insert(m->eventq, cp->keys.items[i], cp->events.items[i]);
+
+   for (int i = 0; i < cp->events.count; i++) {
+      if (pointer_tag(cp->events.items[i]) == EVENT_TIMEOUT)
+         fatal("cannot save a checkpoint while VHPI or VPI callbacks "
+               "are pending");
+   }
+}
+
+static void save_object(checkpoint_t *cp, void *ptr);
+
+static void save_jit_func(jit_t *j, jit_handle_t handle, void *ctx)
+{
+   checkpoint_t *cp = ctx;
+
+   size_t cpoolsz;
+   const void *cpool = jit_get_cpool(j, handle, &cpoolsz);
+   void *privdata = jit_get_privdata(j, handle);
+
+   if (privdata == NULL && cpool == NULL)
+      return;
+
+   save_object(cp, privdata);
+
+   write_u8(1, cp->fbuf);
+   ident_write(jit_get_name(j, handle), cp->ident_wr);
+   write_u64((uintptr_t)privdata, cp->fbuf);
+   write_u64((uintptr_t)cpool, cp->fbuf);
+   write_u64(cpoolsz, cp->fbuf);
+}
+
+static size_t save_extent(checkpoint_t *cp, const void *ptr)
+{
+   // Only memory in the heap and the process TLABs is restored from
+   // the checkpoint: return the number of bytes from ptr to the end of
+   // the containing object
+   const char *p = ptr;
+
+   size_t size;
+   const char *base = mspace_find(cp->model->mspace, (void *)ptr, &size);
+   if (base != NULL)
+      return base + size - p;
+
+   for (int i = 0; i < cp->tlabs.count; i++) {
+      const tlab_t *t = cp->tlabs.items[i];
+      if (p >= t->data && p < t->data + t->alloc)
+         return t->data + t->alloc - p;
+   }
+
+   return 0;
+}
+
+static void save_slot(checkpoint_t *cp, void **slot)
+{
+   if (*slot == NULL || hset_contains(cp->slotset, slot))
+      return;
+   else if (save_extent(cp, slot) < sizeof(void *))
+      return;
+
+   hset_insert(cp->slotset, slot);
+   APUSH(cp->slots, (uintptr_t)slot);
+}
+
+static void save_object(checkpoint_t *cp, void *ptr)
+{
+   if (ptr == NULL || hset_contains(cp->objects, ptr))
+      return;
+
+   hset_insert(cp->objects, ptr);
+   APUSH(cp->worklist, ptr);
+}
+
+static void save_map(checkpoint_t *cp, char *base, const ptr_map_t *map,
+                     size_t count)
+{
+   for (size_t i = 0; i < count; i++, base += map->size) {
+      for (int j = 0; j < map->nslots; j++) {
+         const ptr_slot_t *s = &(map->slots[j]);
+         const ptr_map_t *elem =
+            s->elem ? (const ptr_map_t *)((char *)map + s->elem) : NULL;
+         void **slot = (void **)(base + s->offset);
+
+         switch (s->kind) {
+         case PTR_PLAIN:
+            save_slot(cp, slot);
+            break;
+         case PTR_OBJECT:
+            save_slot(cp, slot);
+            save_object(cp, *slot);
+            break;
+         case PTR_ARRAY:
+            save_map(cp, (char *)slot, elem, s->count);
+            break;
+         case PTR_UARRAY:
+            save_slot(cp, slot);
+
+            if (elem != NULL && *slot != NULL) {
+               const int64_t *dims = (const int64_t *)(slot + 1);
+
+               size_t total = 1;
+               for (int k = 0; k < s->ndims; k++) {
+                  const int64_t length = dims[k*2 + 1];
+                  total *= (length >> 63) ^ length;   // Sign encodes direction
+               }
+
+               if (total > 0 && save_extent(cp, *slot) >= total * elem->size)
+                  save_map(cp, *slot, elem, total);
+            }
+            break;
+         default:
+            should_not_reach_here();
+         }
+      }
+   }
+}
+
+static void save_pointers(checkpoint_t *cp)
+{
+   // Starting from the private data of each unit, follow the pointer
+   // maps registered by compiled code to find every pointer slot in the
+   // heap and process TLABs
+   mspace_t *m = cp->model->mspace;
+
+   while (cp->worklist.count > 0) {
+      void *ptr = APOP(cp->worklist);
+
+      size_t count;
+      const ptr_map_t *map = mspace_get_map(m, ptr, &count);
+      if (map == NULL || save_extent(cp, ptr) < count * map->size)
+         continue;
+
+      APUSH(cp->maps, ((map_entry_t){ ptr, map, count }));
+      save_map(cp, ptr, map, count);
+   }
+
+   write_u32(cp->maps.count, cp->fbuf);
+   for (int i = 0; i < cp->maps.count; i++) {
+      write_u64((uintptr_t)cp->maps.items[i].ptr, cp->fbuf);
+      write_u64((uintptr_t)cp->maps.items[i].map, cp->fbuf);
+      write_u64(cp->maps.items[i].count, cp->fbuf);
+   }
+
+   write_u32(cp->slots.count, cp->fbuf);
+   for (int i = 0; i < cp->slots.count; i++)
+      write_u64(cp->slots.items[i], cp->fbuf);
+}
+
+static void save_trigger(checkpoint_t *cp, rt_trigger_t *t)
+{
+   write_u8(t->kind, cp->fbuf);
+
+   switch (t->kind) {
+   case FUNC_TRIGGER:
+      ident_write(jit_get_name(cp->model->jit, t->handle), cp->ident_wr);
+      write_u32(t->nargs, cp->fbuf);
+      for (int i = 0; i < t->nargs; i++)
+         write_u64(t->args[i].integer, cp->fbuf);
+      break;
+
+   case OR_TRIGGER:
+      save_trigger(cp, t->args[0].pointer);
+      save_trigger(cp, t->args[1].pointer);
+      break;
+
+   case CMP_TRIGGER:
+      write_u32(checkpoint_index(cp, t->args[0].pointer), cp->fbuf);
+      write_u32(t->args[1].integer, cp->fbuf);
+      write_u64(t->args[2].integer, cp->fbuf);
+      break;
+   }
+}
+
+static void save_value(checkpoint_t *cp, rt_nexus_t *n, rt_value_t *v)
+{
+   const size_t valuesz = n->width * n->size;
+   if (valuesz > sizeof(rt_value_t) && v->ext == NULL)
+      write_u8(0, cp->fbuf);   // Null transaction
+   else {
+      write_u8(1, cp->fbuf);
+      write_raw(value_ptr(n, v), valuesz, cp->fbuf);
+   }
+}
+
+static void save_wakeable(checkpoint_t *cp, rt_wakeable_t *obj)
+{
+   switch (obj->kind) {
+   case W_PROC:
+      write_u8(W_PROC, cp->fbuf);
+      write_u32(checkpoint_index(cp, container_of(obj, rt_proc_t, wakeable)),
+                cp->fbuf);
+      break;
+
+   case W_PROPERTY:
+      write_u8(W_PROPERTY, cp->fbuf);
+      write_u32(checkpoint_index(cp, container_of(obj, rt_prop_t, wakeable)),
+                cp->fbuf);
+      break;
+
+   case W_IMPLICIT:
+      {
+         rt_implicit_t *imp = container_of(obj, rt_implicit_t, wakeable);
+         write_u8(W_IMPLICIT, cp->fbuf);
+         write_u32(checkpoint_index(cp, &(imp->signal)), cp->fbuf);
+      }
+      break;
+
+   case W_WATCH:
+   case W_TRANSFER:
+      break;   // Recreated by the restoring process
+   }
+}
+
+static void save_nexus(checkpoint_t *cp, rt_nexus_t *n)
+{
+   write_u16(n->active_delta, cp->fbuf);
+   write_u16(n->event_delta, cp->fbuf);
+   write_u64(n->last_event, cp->fbuf);
+   write_u8(n->flags, cp->fbuf);
+   write_u8(n->n_sources, cp->fbuf);
+
+   if (n->n_sources > 0) {
+      for (rt_source_t *s = &(n->sources); s; s = s->chain_input) {
+         write_u8(s->tag, cp->fbuf);
+         write_u8(s->disconnected | (s->was_active << 1), cp->fbuf);
+
+         if (s->tag != SOURCE_DRIVER)
+            continue;
+
+         for (waveform_t *w = &(s->u.driver.waveforms); w; w = w->next) {
+            write_u8(1, cp->fbuf);
+            write_u64(w->when, cp->fbuf);
+            save_value(cp, n, &(w->value));
+         }
+         write_u8(0, cp->fbuf);
+      }
+   }
+
+   if (pointer_tag(n->pending) == 1)
+      save_wakeable(cp, untag_pointer(n->pending, rt_wakeable_t));
+   else if (n->pending != NULL) {
+      rt_pending_t *p = untag_pointer(n->pending, rt_pending_t);
+      for (int i = 0; i < p->count; i++) {
+         if (p->wake[i] != NULL)
+            save_wakeable(cp, p->wake[i]);
+      }
+
+      size_t bit = -1;
+      while (mask_iter(&p->procs, &bit))
+         save_wakeable(cp, &(cp->model->proctab.items[bit]->wakeable));
+   }
+
+   write_u8(END_OF_LIST, cp->fbuf);
+}
+
+static void save_event(checkpoint_t *cp, uint64_t when, void *e)
+{
+   write_u64(when, cp->fbuf);
+   write_u8(pointer_tag(e), cp->fbuf);
+
+   switch (pointer_tag(e)) {
+   case EVENT_PROCESS:
+      write_u32(checkpoint_index(cp, untag_pointer(e, rt_proc_t)), cp->fbuf);
+      break;
+
+   case EVENT_DRIVER:
+      {
+         rt_source_t *src = untag_pointer(e, rt_source_t);
+         rt_nexus_t *n = src->u.driver.nexus;
+
+         unsigned nth = 0;
+         for (rt_nexus_t *it = &(n->signal->nexus); it != n; it = it->chain)
+            nth++;
+
+         unsigned pos = 0;
+         for (rt_source_t *it = &(n->sources); it != src; it = it->chain_input)
+            pos++;
+
+         write_u32(checkpoint_index(cp, n->signal), cp->fbuf);
+         write_u32(nth, cp->fbuf);
+         write_u32(pos, cp->fbuf);
+      }
+      break;
+
+   default:
+      should_not_reach_here();
+   }
+}
+
+void model_save(rt_model_t *m, fbuf_t *f)
+{
+   MODEL_ENTRY(m);
+
+   checkpoint_t cp = {};
+   checkpoint_init(&cp, m, f);
+
+   save_check(&cp);
+
+   cp.objects = hset_new(1024);
+   cp.slotset = hset_new(1024);
+
+   for (int i = 0; i < cp.procs.count; i++) {
+      if (cp.procs.items[i]->tlab != NULL)
+         APUSH(cp.tlabs, cp.procs.items[i]->tlab);
+   }
+
+   write_u32(CHECKPOINT_MAGIC, f);
+   write_u32(RT_ABI_VERSION, f);
+
+   cp.ident_wr = ident_write_begin(f);
+   ident_write(tree_ident(m->top), cp.ident_wr);
+
+   write_u64(m->now, f);
+   write_u32(m->iteration, f);
+
+   // Standard files in the TEXTIO package point at the C library streams
+   write_u64((uintptr_t)stdin, f);
+   write_u64((uintptr_t)stdout, f);
+   write_u64((uintptr_t)stderr, f);
+
+   mspace_save(m->mspace, f);
+
+   jit_walk_funcs(m->jit, save_jit_func, &cp);
+   write_u8(0, f);
+
+   write_u32(cp.signals.count, f);
+   for (int i = 0; i < cp.signals.count; i++) {
+      rt_signal_t *s = cp.signals.items[i];
+      write_u64((uintptr_t)s, f);
+      write_u32(s->shared.size, f);
+      write_u32(s->shared.flags, f);
+      write_u32(s->n_nexus, f);
+
+      rt_nexus_t *n = &(s->nexus);
+      for (int j = 0; j < s->n_nexus; j++, n = n->chain)
+         write_u32(n->width, f);
+
+      write_raw(s->shared.data, signal_data_size(s), f);
+   }
+
+   write_u32(cp.scopes.count, f);
+   for (int i = 0; i < cp.scopes.count; i++) {
+      void *privdata = pointer_value(cp.scopes.items[i]->privdata);
+      save_object(&cp, privdata);
+      write_u64((uintptr_t)privdata, f);
+   }
+
+   write_u32(cp.procs.count, f);
+   for (int i = 0; i < cp.procs.count; i++) {
+      rt_proc_t *p = cp.procs.items[i];
+      assert(!p->wakeable.pending);
+
+      void *privdata = pointer_value(p->privdata);
+      save_object(&cp, privdata);
+
+      write_u64((uintptr_t)privdata, f);
+      write_u8(p->wakeable.delayed, f);
+
+      if (p->tlab == NULL)
+         write_u8(0, f);
+      else {
+         // Suspended inside a procedure with live temporaries
+         write_u8(1, f);
+         write_u64((uintptr_t)p->tlab->data, f);
+         write_u32(p->tlab->alloc, f);
+         write_raw(p->tlab->data, p->tlab->alloc, f);
+      }
+   }
+
+   write_u32(cp.props.count, f);
+   for (int i = 0; i < cp.props.count; i++) {
+      rt_prop_t *p = cp.props.items[i];
+
+      void *privdata = pointer_value(p->privdata);
+      save_object(&cp, privdata);
+
+      write_u64((uintptr_t)privdata, f);
+      write_u8(p->strong, f);
+
+      write_u32(mask_popcount(&p->state), f);
+
+      size_t bit = -1;
+      while (mask_iter(&p->state, &bit))
+         write_u32(bit, f);
+   }
+
+   save_pointers(&cp);
+
+   for (int i = 0; i < cp.signals.count; i++) {
+      rt_signal_t *s = cp.signals.items[i];
+      rt_nexus_t *n = &(s->nexus);
+      for (int j = 0; j < s->n_nexus; j++, n = n->chain)
+         save_nexus(&cp, n);
+   }
+
+   // Triggers are saved last so they can be recreated after all
+   // relocations are known
+   for (int i = 0; i < cp.procs.count; i++) {
+      rt_proc_t *p = cp.procs.items[i];
+      if (p->wakeable.trigger != NULL) {
+         write_u8(1, f);
+         write_u32(i, f);
+         save_trigger(&cp, p->wakeable.trigger);
+      }
+   }
+   write_u8(0, f);
+
+   write_u32(cp.events.count, f);
+   for (int i = 0; i < cp.events.count; i++)
+      save_event(&cp, cp.keys.items[i], cp.events.items[i]);
+
+   ident_write_end(cp.ident_wr);
+
+   checkpoint_free(&cp);
+}
+
+static void add_reloc(checkpoint_t *cp, uintptr_t from, const void *to,
+                      size_t size)
+{
+   if (from != 0 && size > 0)
+      APUSH(cp->relocs, ((reloc_t){ from, (uintptr_t)to, size }));
+}
+
+static int reloc_cmp(const void *a, const void *b)
+{
+   const reloc_t *ra = a, *rb = b;
+   return ra->from < rb->from ? -1 : (ra->from > rb->from);
+}
+
+static intptr_t relocate(intptr_t value, void *ctx)
+{
+   checkpoint_t *cp = ctx;
+
+   // Binary search for the last range starting at or below the value
+   int low = 0, high = cp->relocs.count - 1, found = -1;
+   while (low <= high) {
+      const int mid = (low + high) / 2;
+      if (cp->relocs.items[mid].from <= (uintptr_t)value) {
+         found = mid;
+         low = mid + 1;
+      }
+      else
+         high = mid - 1;
+   }
+
+   if (found == -1)
+      return value;
+
+   const reloc_t *r = &(cp->relocs.items[found]);
+   if ((uintptr_t)value - r->from < r->size)
+      return r->to + ((uintptr_t)value - r->from);
+   else
+      return value;
+}
+
+static void *relocate_ptr(checkpoint_t *cp, uint64_t value)
+{
+   return (void *)relocate(value, cp);
+}
+
+__attribute__((noreturn))
+static void restore_mismatch(checkpoint_t *cp)
+{
+   fatal("checkpoint %s does not match the elaborated design",
+         fbuf_file_name(cp->fbuf));
+}
+
+static rt_trigger_t *restore_trigger(checkpoint_t *cp)
+{
+   switch (read_u8(cp->fbuf)) {
+   case FUNC_TRIGGER:
+      {
+         ident_t name = ident_read(cp->ident_rd);
+         jit_handle_t handle = jit_lazy_compile(cp->model->jit, name);
+         if (handle == JIT_HANDLE_INVALID)
+            restore_mismatch(cp);
+
+         const unsigned nargs = read_u32(cp->fbuf);
+         jit_scalar_t *args LOCAL = xmalloc_array(nargs, sizeof(jit_scalar_t));
+         for (int i = 0; i < nargs; i++)
+            args[i].pointer = relocate_ptr(cp, read_u64(cp->fbuf));
+
+         return x_function_trigger(handle, nargs, args);
+      }
+
+   case OR_TRIGGER:
+      {
+         rt_trigger_t *left = restore_trigger(cp);
+         rt_trigger_t *right = restore_trigger(cp);
+         return x_or_trigger(left, right);
+      }
+
+   case CMP_TRIGGER:
+      {
+         const unsigned index = read_u32(cp->fbuf);
+         if (index >= cp->signals.count)
+            restore_mismatch(cp);
+
+         rt_signal_t *s = cp->signals.items[index];
+         const uint32_t offset = read_u32(cp->fbuf);
+         const int64_t right = read_u64(cp->fbuf);
+         return x_cmp_trigger(&(s->shared), offset, right);
+      }
+
+   default:
+      restore_mismatch(cp);
+   }
+}
+
+static void restore_value(checkpoint_t *cp, rt_nexus_t *n, rt_value_t *v)
+{
+   const size_t valuesz = n->width * n->size;
+   if (read_u8(cp->fbuf)) {
+      if (valuesz > sizeof(rt_value_t) && v->ext == NULL)
+         *v = alloc_value(cp->model, n);
+      read_raw(value_ptr(n, v), valuesz, cp->fbuf);
+   }
+   else {
+      if (valuesz > sizeof(rt_value_t) && v->ext != NULL)
+         free_value(cp->model, n, *v);
+      v->qword = 0;
+   }
+}
+
+static void restore_pending(rt_nexus_t *n)
+{
+   // Only value change callbacks and signal transfers set up by the
+   // restoring process are kept, everything else is replaced by the
+   // sensitivity in the checkpoint
+   if (pointer_tag(n->pending) == 1) {
+      rt_wakeable_t *obj = untag_pointer(n->pending, rt_wakeable_t);
+      if (obj->kind == W_TRANSFER)
+         obj->pending = false;
+      else if (obj->kind != W_WATCH)
+         n->pending = NULL;
+   }
+   else if (n->pending != NULL) {
+      rt_pending_t *p = untag_pointer(n->pending, rt_pending_t);
+      if (p->procs.size > 0)
+         mask_clearall(&p->procs);
+
+      for (int i = 0; i < p->count; i++) {
+         if (p->wake[i] == NULL)
+            continue;
+         else if (p->wake[i]->kind == W_TRANSFER)
+            p->wake[i]->pending = false;
+         else if (p->wake[i]->kind != W_WATCH)
+            p->wake[i] = NULL;
+      }
+   }
+}
+
+static void restore_nexus(checkpoint_t *cp, rt_nexus_t *n)
+{
+   rt_model_t *m = cp->model;
+   fbuf_t *f = cp->fbuf;
+
+   n->active_delta = read_u16(f);
+   n->event_delta  = read_u16(f);
+   n->last_event   = read_u64(f);
+   n->flags        = read_u8(f) & ~NET_F_PENDING;
+
+   if (read_u8(f) != n->n_sources)
+      restore_mismatch(cp);
+
+   if (n->n_sources > 0) {
+      for (rt_source_t *s = &(n->sources); s; s = s->chain_input) {
+         if (read_u8(f) != s->tag)
+            restore_mismatch(cp);
+
+         const uint8_t bits = read_u8(f);
+         s->disconnected = !!(bits & 1);
+         s->was_active   = !!(bits & 2);
+         s->fastqueued   = 0;
+         s->sigqueued    = 0;
+         s->pseudoqueued = 0;
+
+         if (s->tag != SOURCE_DRIVER)
+            continue;
+
+         waveform_t *w0 = &(s->u.driver.waveforms);
+         for (waveform_t *it = w0->next, *tmp; it; it = tmp) {
+            tmp = it->next;
+            free_value(m, n, it->value);
+            free_waveform(m, it);
+         }
+         w0->next = NULL;
+
+         if (!read_u8(f))
+            restore_mismatch(cp);
+
+         w0->when = read_u64(f);
+         restore_value(cp, n, &(w0->value));
+
+         waveform_t **tail = &(w0->next);
+         while (read_u8(f)) {
+            waveform_t *w = alloc_waveform(m);
+            w->when  = read_u64(f);
+            w->next  = NULL;
+            w->value = (rt_value_t){};
+
+            restore_value(cp, n, &(w->value));
+
+            *tail = w;
+            tail = &(w->next);
+         }
+      }
+   }
+
+   restore_pending(n);
+
+   for (;;) {
+      const uint8_t kind = read_u8(f);
+      if (kind == END_OF_LIST)
+         break;
+
+      const unsigned index = read_u32(f);
+
+      rt_wakeable_t *obj = NULL;
+      if (kind == W_PROC && index < cp->procs.count)
+         obj = &(cp->procs.items[index]->wakeable);
+      else if (kind == W_PROPERTY && index < cp->props.count)
+         obj = &(cp->props.items[index]->wakeable);
+      else if (kind == W_IMPLICIT && index < cp->signals.count) {
+         rt_signal_t *s = cp->signals.items[index];
+         if (!(s->shared.flags & SIG_F_IMPLICIT))
+            restore_mismatch(cp);
+
+         obj = &(container_of(s, rt_implicit_t, signal)->wakeable);
+      }
+      else
+         restore_mismatch(cp);
+
+      sched_event(m, n, obj);
+   }
+}
+
+static void restore_event(checkpoint_t *cp)
+{
+   rt_model_t *m = cp->model;
+   fbuf_t *f = cp->fbuf;
+
+   const uint64_t when = read_u64(f);
+
+   switch (read_u8(f)) {
+   case EVENT_PROCESS:
+      {
+         const unsigned index = read_u32(f);
+         if (index >= cp->procs.count)
+            restore_mismatch(cp);
+
+         rt_proc_t *proc = cp->procs.items[index];
+         if (!proc->wakeable.delayed)
+            restore_mismatch(cp);
+
+         eventq_insert(m->eventq, when, tag_pointer(proc, EVENT_PROCESS));
+      }
+      break;
+
+   case EVENT_DRIVER:
+      {
+         const unsigned index = read_u32(f);
+         unsigned nth = read_u32(f);
+         unsigned pos = read_u32(f);
+
+         if (index >= cp->signals.count)
+            restore_mismatch(cp);
+
+         rt_signal_t *s = cp->signals.items[index];
+         if (nth >= s->n_nexus)
+            restore_mismatch(cp);
+
+         rt_nexus_t *n = &(s->nexus);
+         for (; nth > 0; nth--)
+            n = n->chain;
+
+         rt_source_t *src = &(n->sources);
+         for (; src && pos > 0; pos--)
+            src = src->chain_input;
+
+         if (src == NULL || src->tag != SOURCE_DRIVER)
+            restore_mismatch(cp);
+
+         eventq_insert(m->eventq, when, tag_pointer(src, EVENT_DRIVER));
+      }
+      break;
+
+   default:
+      restore_mismatch(cp);
+   }
+}
+
+static void restore_signal(checkpoint_t *cp, rt_signal_t *s)
+{
+   rt_model_t *m = cp->model;
+   fbuf_t *f = cp->fbuf;
+
+   const uintptr_t old = read_u64(f);
+   if (read_u32(f) != s->shared.size)
+      restore_mismatch(cp);
+
+   const sig_flags_t flags = read_u32(f);
+   if ((flags & SIG_F_IMPLICIT) != (s->shared.flags & SIG_F_IMPLICIT))
+      restore_mismatch(cp);
+
+   // Split the signal into the same nexuses as the saved model
+   const unsigned n_nexus = read_u32(f);
+   for (unsigned i = 0, offset = 0; i < n_nexus; i++) {
+      const unsigned width = read_u32(f);
+      if (offset + width > s->shared.size / s->nexus.size)
+         restore_mismatch(cp);
+
+      split_nexus(m, s, offset, width);
+      offset += width;
+   }
+
+   if (s->n_nexus != n_nexus)
+      restore_mismatch(cp);
+
+   s->shared.flags = flags;
+   read_raw(s->shared.data, signal_data_size(s), f);
+
+   add_reloc(cp, old, s, offsetof(rt_signal_t, shared.data)
+             + signal_data_size(s));
+}
+
+static void restore_clear_queues(rt_model_t *m, checkpoint_t *cp)
+{
+   // Discard everything scheduled by initialisation in this process
+   while (eventq_size(m->eventq) > 0) {
+      void *e = eventq_extract_min(m->eventq);
+      if (pointer_tag(e) == EVENT_TIMEOUT)
+         free(untag_pointer(e, rt_callback_t));
+   }
+
+   m->procq.count = m->delta_procq.count = 0;
+   m->driverq.count = m->delta_driverq.count = 0;
+   m->postponedq.count = m->implicitq.count = 0;
+
+   model_thread_t *thread = model_thread(m);
+   thread->delta_procq.count = thread->delta_driverq.count = 0;
+
+   for (int i = 0; i < cp->procs.count; i++) {
+      rt_proc_t *p = cp->procs.items[i];
+      p->wakeable.pending = p->wakeable.delayed = false;
+      p->wakeable.trigger = NULL;
+   }
+
+   for (int i = 0; i < cp->props.count; i++)
+      cp->props.items[i]->wakeable.pending = false;
+
+   for (int i = 0; i < cp->signals.count; i++) {
+      rt_signal_t *s = cp->signals.items[i];
+      if (s->shared.flags & SIG_F_IMPLICIT)
+         container_of(s, rt_implicit_t, signal)->wakeable.pending = false;
    }
 }
 
-void deposit_signal(rt_model_t *m, rt_signal_t *s, const void *values,
-                    int offset, size_t count)
+void model_restore(rt_model_t *m, fbuf_t *f)
 {
-   RT_LOCK(s->lock);
+   MODEL_ENTRY(m);
 
-   TRACE("deposit signal %s+%d to %s", istr(tree_ident(s->where)),
-         offset, fmt_values(values, count));
+   if (m->force_stop)
+      return;   // Error in intialisation
 
-   assert(m->can_create_delta);
+   checkpoint_t cp = {};
+   checkpoint_init(&cp, m, f);
 
-   rt_nexus_t *n = split_nexus(m, s, offset, count);
-   const char *vptr = values;
-   for (; count > 0; n = n->chain) {
-      count -= n->width;
-      assert(count >= 0);
+   if (read_u32(f) != CHECKPOINT_MAGIC)
+      fatal("%s is not a checkpoint file", fbuf_file_name(f));
+   else if (read_u32(f) != RT_ABI_VERSION)
+      fatal("checkpoint %s was saved by an incompatible version of "
+            PACKAGE_NAME, fbuf_file_name(f));
 
-      rt_source_t *src = get_pseudo_source(m, n, SOURCE_DEPOSIT);
-      copy_value_ptr(n, &(src->u.pseudo.value), vptr);
-      src->disconnected = 0;
+   cp.ident_rd = ident_read_begin(f);
 
-      if (!src->pseudoqueued) {
-         deltaq_insert_pseudo_source(m, src);
-         src->pseudoqueued = 1;
-      }
+   ident_t top = ident_read(cp.ident_rd);
+   if (top != tree_ident(m->top))
+      fatal("checkpoint %s was saved from %s", fbuf_file_name(f), istr(top));
 
-      vptr += n->width * n->size;
-   }
-}
+   const uint64_t now = read_u64(f);
+   const int iteration = read_u32(f);
 
-bool model_can_create_delta(rt_model_t *m)
-{
-   return m->can_create_delta;
-}
+   restore_clear_queues(m, &cp);
 
-int64_t model_now(rt_model_t *m, unsigned *deltas)
-{
-   if (deltas != NULL)
-      *deltas = MAX(m->iteration, 0);
+   add_reloc(&cp, read_u64(f), stdin, 1);
+   add_reloc(&cp, read_u64(f), stdout, 1);
+   add_reloc(&cp, read_u64(f), stderr, 1);
 
-   return m->now;
-}
+   void *heap_from, *heap_to;
+   size_t heap_size;
+   mspace_restore(m->mspace, f, &heap_from, &heap_to, &heap_size);
+   add_reloc(&cp, (uintptr_t)heap_from, heap_to, heap_size);
 
-int64_t model_next_time(rt_model_t *m)
-{
-   if (heap_size(m->eventq_heap) == 0)
-      return TIME_HIGH;
-   else
-      return heap_min_key(m->eventq_heap);
-}
+   A(jit_handle_t) handles = AINIT;
+   A(uint64_t) privdata = AINIT;
 
-void model_stop(rt_model_t *m)
-{
-   relaxed_store(&m->force_stop, true);
-}
+   while (read_u8(f)) {
+      ident_t name = ident_read(cp.ident_rd);
+      jit_handle_t handle = jit_lazy_compile(m->jit, name);
+      if (handle == JIT_HANDLE_INVALID)
+         restore_mismatch(&cp);
 
-void model_set_global_cb(rt_model_t *m, rt_event_t event, rt_event_fn_t fn,
-                         void *user)
-{
-   assert(event < RT_LAST_EVENT);
+      APUSH(handles, handle);
+      APUSH(privdata, read_u64(f));
 
-   // Add to end of list so callbacks are called in registration order
-   rt_callback_t **p = &(m->global_cbs[event]);
-   for (; *p; p = &(*p)->next);
+      const uintptr_t old_cpool = read_u64(f);
+      const size_t old_cpoolsz = read_u64(f);
 
-   rt_callback_t *cb = xcalloc(sizeof(rt_callback_t));
-   cb->next = NULL;
-   cb->fn   = fn;
-   cb->user = user;
+      size_t cpoolsz;
+      const void *cpool = jit_get_cpool(m->jit, handle, &cpoolsz);
+      if (cpoolsz != old_cpoolsz)
+         restore_mismatch(&cp);
 
-   *p = cb;
-}
+      add_reloc(&cp, old_cpool, cpool, cpoolsz);
+   }
 
-void model_set_timeout_cb(rt_model_t *m, uint64_t when, rt_event_fn_t fn,
-                          void *user)
-{
-   rt_callback_t *cb = xcalloc(sizeof(rt_callback_t));
-   cb->next = NULL;
-   cb->fn   = fn;
-   cb->user = user;
+   if (read_u32(f) != cp.signals.count)
+      restore_mismatch(&cp);
 
-   assert(when > m->now);   // TODO: delta timeouts?
+   for (int i = 0; i < cp.signals.count; i++)
+      restore_signal(&cp, cp.signals.items[i]);
 
-   void *e = tag_pointer(cb, EVENT_TIMEOUT);
-   heap_insert(m->eventq_heap, when, e);
-}
+   if (read_u32(f) != cp.scopes.count)
+      restore_mismatch(&cp);
 
-rt_watch_t *watch_new(rt_model_t *m, sig_event_fn_t fn, void *user,
-                      watch_kind_t kind, unsigned slots)
-{
-   rt_watch_t *w = xcalloc_flex(sizeof(rt_watch_t), slots,
-                                sizeof(rt_signal_t *));
-   w->fn        = fn;
-   w->chain_all = m->watches;
-   w->user_data = user;
-   w->num_slots = slots;
+   A(uint64_t) scope_privdata = AINIT;
+   for (int i = 0; i < cp.scopes.count; i++)
+      APUSH(scope_privdata, read_u64(f));
 
-   w->wakeable.kind      = W_WATCH;
-   w->wakeable.postponed = (kind == WATCH_POSTPONED);
-   w->wakeable.pending   = false;
-   w->wakeable.delayed   = false;
+   if (read_u32(f) != cp.procs.count)
+      restore_mismatch(&cp);
 
-   m->watches = w;
+   A(uint64_t) proc_privdata = AINIT;
+   for (int i = 0; i < cp.procs.count; i++) {
+      rt_proc_t *p = cp.procs.items[i];
+      APUSH(proc_privdata, read_u64(f));
+      p->wakeable.delayed = read_u8(f);
 
-   return w;
-}
+      if (p->tlab != NULL) {
+         tlab_release(p->tlab);
+         p->tlab = NULL;
+      }
 
-void watch_free(rt_model_t *m, rt_watch_t *w)
-{
-   assert(!w->wakeable.zombie);
+      if (read_u8(f)) {
+         const uintptr_t old = read_u64(f);
+         const uint32_t alloc = read_u32(f);
 
-   for (int i = 0; i < w->next_slot; i++) {
-      rt_nexus_t *n = &(w->signals[i]->nexus);
-      for (int j = 0; j < w->signals[i]->n_nexus; j++, n = n->chain)
-         clear_event(m, n, &(w->wakeable));
-   }
+         p->tlab = tlab_acquire(m->mspace);
+         if (alloc > p->tlab->limit)
+            restore_mismatch(&cp);
 
-   rt_watch_t **last = &m->watches;
-   for (rt_watch_t *it = *last; it;
-        last = &(it->chain_all), it = it->chain_all) {
-      if (it == w) {
-         *last = it->chain_all;
-         if (w->wakeable.pending)
-            w->wakeable.zombie = true;   // Will be freed in callback
-         else
-            free(w);
-         return;
+         p->tlab->alloc = alloc;
+         read_raw(p->tlab->data, alloc, f);
+
+         add_reloc(&cp, old, p->tlab->data, TLAB_SIZE);
       }
    }
 
-   should_not_reach_here();
-}
-
-rt_watch_t *model_set_event_cb(rt_model_t *m, rt_signal_t *s, rt_watch_t *w)
-{
-   assert(!w->wakeable.zombie);
-   assert(w->next_slot < w->num_slots);
+   if (read_u32(f) != cp.props.count)
+      restore_mismatch(&cp);
 
-   w->signals[w->next_slot++] = s;
+   A(uint64_t) prop_privdata = AINIT;
+   for (int i = 0; i < cp.props.count; i++) {
+      rt_prop_t *p = cp.props.items[i];
+      APUSH(prop_privdata, read_u64(f));
 
-   rt_nexus_t *n = &(s->nexus);
-   for (int i = 0; i < s->n_nexus; i++, n = n->chain)
-      sched_event(m, n, &(w->wakeable));
+      p->strong = read_u8(f);
+      m->liveness |= p->strong;
 
-   return w;
-}
+      mask_clearall(&p->state);
 
-static void handle_interrupt_cb(jit_t *j, void *ctx)
-{
-   rt_proc_t *proc = get_active_proc();
+      const unsigned nbits = read_u32(f);
+      for (int j = 0; j < nbits; j++) {
+         const unsigned bit = read_u32(f);
+         if (bit >= p->state.size)
+            restore_mismatch(&cp);
 
-   if (proc != NULL)
-      jit_msg(NULL, DIAG_FATAL, "interrupted in process %s", istr(proc->name));
-   else {
-      diag_t *d = diag_new(DIAG_FATAL, NULL);
-      diag_printf(d, "interrupted");
-      diag_emit(d);
+         mask_set(&p->state, bit);
+      }
    }
-}
 
-void model_interrupt(rt_model_t *m)
-{
-   model_stop(m);
-   jit_interrupt(m->jit, handle_interrupt_cb, m);
-}
+   const unsigned nmaps = read_u32(f);
+   for (int i = 0; i < nmaps; i++) {
+      const uint64_t ptr = read_u64(f);
+      const uint64_t map = read_u64(f);
+      const uint64_t count = read_u64(f);
+      APUSH(cp.maps, ((map_entry_t){ (void *)ptr, (void *)map, count }));
+   }
 
-int model_exit_status(rt_model_t *m)
-{
-   int status;
-   if (jit_exit_status(m->jit, &status))
-      return status;
-   else if (m->stop_delta > 0 && m->iteration == m->stop_delta)
-      return EXIT_FAILURE;
-   else
-      return get_vhdl_assert_exit_status();
-}
+   const unsigned nslots = read_u32(f);
+   for (int i = 0; i < nslots; i++)
+      APUSH(cp.slots, read_u64(f));
 
-static bool nexus_active(rt_model_t *m, rt_nexus_t *nexus)
-{
-   if (nexus->n_sources > 0) {
-      for (rt_source_t *s = &(nexus->sources); s; s = s->chain_input) {
-         if (s->tag == SOURCE_PORT) {
-            rt_conv_func_t *cf = s->u.port.conv_func;
-            if (cf == NULL) {
-               RT_LOCK(s->u.port.input->signal->lock);
-               if (nexus_active(m, s->u.port.input))
-                  return true;
-            }
-            else {
-               for (int i = 0; i < cf->ninputs; i++) {
-                  if (nexus_active(m, cf->inputs[i].nexus))
-                     return true;
-               }
-            }
-         }
-         else if (s->tag == SOURCE_DRIVER
-                  && s->u.driver.waveforms.when == m->now) {
-            if (nexus->active_delta == m->iteration)
-               return true;
-            else if (nexus->active_delta == m->iteration + 1 && s->was_active)
-               return true;
-         }
-      }
+   for (int i = 0; i < cp.signals.count; i++) {
+      rt_signal_t *s = cp.signals.items[i];
+      rt_nexus_t *n = &(s->nexus);
+      for (int j = 0; j < s->n_nexus; j++, n = n->chain)
+         restore_nexus(&cp, n);
    }
 
-   return false;
-}
+   // All the address ranges are now known so pointers saved in the
+   // heap and process state can be fixed up
+   qsort(cp.relocs.items, cp.relocs.count, sizeof(reloc_t), reloc_cmp);
 
-static uint64_t nexus_last_active(rt_model_t *m, rt_nexus_t *nexus)
-{
-   int64_t last = TIME_HIGH;
+   for (int i = 0; i < cp.slots.count; i++) {
+      void **slot = relocate_ptr(&cp, cp.slots.items[i]);
+      if ((uintptr_t)slot == cp.slots.items[i])
+         restore_mismatch(&cp);
 
-   if (nexus->n_sources > 0) {
-      for (rt_source_t *s = &(nexus->sources); s; s = s->chain_input) {
-          if (s->tag == SOURCE_PORT) {
-            rt_conv_func_t *cf = s->u.port.conv_func;
-            if (cf == NULL) {
-               RT_LOCK(s->u.port.input->signal->lock);
-               last = MIN(last, nexus_last_active(m, s->u.port.input));
-            }
-            else {
-               for (int i = 0; i < cf->ninputs; i++) {
-                  RT_LOCK(cf->inputs[i]->signal->lock);
-                  last = MIN(last, nexus_last_active(m, cf->inputs[i].nexus));
-               }
-            }
-         }
-         else if (s->tag == SOURCE_DRIVER
-                  && s->u.driver.waveforms.when <= m->now)
-            last = MIN(last, m->now - s->u.driver.waveforms.when);
-      }
+      *slot = relocate_ptr(&cp, (uintptr_t)*slot);
    }
 
-   return last;
-}
+   // Register the maps again so the restored state can itself be saved
+   for (int i = 0; i < cp.maps.count; i++) {
+      const map_entry_t *e = &(cp.maps.items[i]);
+      void *ptr = relocate_ptr(&cp, (uintptr_t)e->ptr);
+      const ptr_map_t *map = relocate_ptr(&cp, (uintptr_t)e->map);
+      if (ptr == e->ptr || map == e->map)
+         restore_mismatch(&cp);
 
-void get_forcing_value(rt_signal_t *s, uint8_t *value)
-{
-   uint8_t *p = value;
-   rt_nexus_t *n = &(s->nexus);
-   for (int i = 0; i < s->n_nexus; i++) {
-      assert(n->n_sources > 0);
-      rt_source_t *s = NULL;
-      for (s = &(n->sources); s; s = s->chain_input) {
-         if (s->tag == SOURCE_FORCING)
-            break;
-      }
-      assert(s != NULL);
+      mspace_set_map(m->mspace, ptr, map, e->count);
+   }
 
-      memcpy(p, s->u.pseudo.value.bytes, n->width * n->size);
-      p += n->width * n->size;
+   for (int i = 0; i < cp.procs.count; i++)
+      *mptr_get(cp.procs.items[i]->privdata) =
+         relocate_ptr(&cp, proc_privdata.items[i]);
+
+   for (int i = 0; i < cp.props.count; i++)
+      *mptr_get(cp.props.items[i]->privdata) =
+         relocate_ptr(&cp, prop_privdata.items[i]);
+
+   for (int i = 0; i < cp.scopes.count; i++) {
+      rt_scope_t *s = cp.scopes.items[i];
+      if (s->privdata != MPTR_INVALID)
+         *mptr_get(s->privdata) = relocate_ptr(&cp, scope_privdata.items[i]);
+      else if (scope_privdata.items[i] != 0)
+         restore_mismatch(&cp);
    }
-   assert(p == value + s->shared.size);
-}
 
-int32_t *get_cover_counter(rt_model_t *m, int32_t tag, int count)
-{
-   assert(tag >= 0);
-   assert(m->cover != NULL);
-   return jit_get_cover_mem(m->jit, tag + count) + tag;
-}
+   for (int i = 0; i < handles.count; i++)
+      jit_set_privdata(m->jit, handles.items[i],
+                       relocate_ptr(&cp, privdata.items[i]));
 
-static rt_trigger_t *new_trigger(rt_model_t *m, trigger_kind_t kind,
-                                 uint64_t hash, jit_handle_t handle,
-                                 unsigned nargs, const jit_scalar_t *args)
-{
-   rt_trigger_t **bucket = &(m->triggertab[hash % TRIGGER_TAB_SIZE]);
+   while (read_u8(f)) {
+      const unsigned index = read_u32(f);
+      if (index >= cp.procs.count)
+         restore_mismatch(&cp);
 
-   for (rt_trigger_t *exist = *bucket; exist; exist = exist->chain) {
-      bool hit = exist->handle == handle
-         && exist->nargs == nargs
-         && exist->kind == kind;
+      cp.procs.items[index]->wakeable.trigger = restore_trigger(&cp);
+   }
 
-      for (int i = 0; hit && i < nargs; i++)
-         hit &= (exist->args[i].integer == args[i].integer);
+   const unsigned nevents = read_u32(f);
+   for (int i = 0; i < nevents; i++)
+      restore_event(&cp);
 
-      if (hit)
-         return exist;
+   ident_read_end(cp.ident_rd);
+
+   ATRIM(m->eventsigs, 0);
+   for (int i = 0; i < cp.signals.count; i++) {
+      rt_signal_t *s = cp.signals.items[i];
+      if (s->shared.flags & SIG_F_EVENT_FLAG)
+         APUSH(m->eventsigs, s);
    }
 
-   const size_t argsz = nargs * sizeof(jit_scalar_t);
+   m->now              = now;
+   m->iteration        = iteration;
+   m->next_is_delta    = false;
+   m->can_create_delta = true;
 
-   rt_trigger_t *t = static_alloc(m, sizeof(rt_trigger_t) + argsz);
-   t->handle = handle;
-   t->nargs  = nargs;
-   t->when   = TIME_HIGH;
-   t->kind   = kind;
-   t->chain  = *bucket;
-   memcpy(t->args, args, argsz);
+   TRACE("restored checkpoint from %s", fbuf_file_name(f));
 
-   return (*bucket = t);
-}
+   ACLEAR(handles);
+   ACLEAR(privdata);
+   ACLEAR(scope_privdata);
+   ACLEAR(proc_privdata);
+   ACLEAR(prop_privdata);
 
-void call_with_model(rt_model_t *m, void (*cb)(void *), void *arg)
-{
-   MODEL_ENTRY(m);
-   (*cb)(arg);
+   checkpoint_free(&cp);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -3837,7 +5805,7 @@ sig_shared_t *x_init_signal(int64_t count, uint32_t size, jit_scalar_t value,
 void x_drive_signal(sig_shared_t *ss, uint32_t offset, int32_t count)
 {
    rt_signal_t *s = container_of(ss, rt_signal_t, shared);
-   RT_LOCK(s->lock);
+   MODEL_LOCK();
 
    TRACE("drive signal %s+%d count=%d", istr(tree_ident(s->where)),
          offset, count);
@@ -3879,7 +5847,7 @@ void x_sched_waveform_s(sig_shared_t *ss, uint32_t offset, uint64_t scalar,
                         int64_t after, int64_t reject)
 {
    rt_signal_t *s = container_of(ss, rt_signal_t, shared);
-   RT_LOCK(s->lock);
+   MODEL_LOCK();
 
    TRACE("_sched_waveform_s %s+%d value=%"PRIi64" after=%s reject=%s",
          istr(tree_ident(s->where)), offset, scalar, trace_time(after),
@@ -3901,7 +5869,7 @@ void x_sched_waveform(sig_shared_t *ss, uint32_t offset, void *values,
                       int32_t count, int64_t after, int64_t reject)
 {
    rt_signal_t *s = container_of(ss, rt_signal_t, shared);
-   RT_LOCK(s->lock);
+   MODEL_LOCK();
 
    TRACE("_sched_waveform %s+%d value=%s count=%d after=%s reject=%s",
          istr(tree_ident(s->where)), offset, fmt_values(values, count),
@@ -3974,7 +5942,7 @@ void x_transfer_signal(sig_shared_t *target_ss, uint32_t toffset,
 int32_t x_test_net_event(sig_shared_t *ss, uint32_t offset, int32_t count)
 {
    rt_signal_t *s = container_of(ss, rt_signal_t, shared);
-   RT_LOCK(s->lock);
+   MODEL_LOCK();
 
    TRACE("_test_net_event %s offset=%d count=%d",
          istr(tree_ident(s->where)), offset, count);
@@ -3994,9 +5962,13 @@ int32_t x_test_net_event(sig_shared_t *ss, uint32_t offset, int32_t count)
 
    if (ss->size == s->nexus.size) {
       assert(!(ss->flags & SIG_F_CACHE_EVENT));   // Should have taken fast-path
-      ss->flags |= SIG_F_CACHE_EVENT | (result ? SIG_F_EVENT_FLAG : 0);
+      ss->flags |= SIG_F_CACHE_EVENT;
       s->nexus.flags |= NET_F_CACHE_EVENT;
-      APUSH(m->eventsigs, s);
+
+      if (result) {
+         ss->flags |= SIG_F_EVENT_FLAG;
+         APUSH(m->eventsigs, s);
+      }
    }
 
    return result;
@@ -4005,7 +5977,7 @@ int32_t x_test_net_event(sig_shared_t *ss, uint32_t offset, int32_t count)
 int32_t x_test_net_active(sig_shared_t *ss, uint32_t offset, int32_t count)
 {
    rt_signal_t *s = container_of(ss, rt_signal_t, shared);
-   RT_LOCK(s->lock);
+   MODEL_LOCK();
 
    TRACE("_test_net_active %s offset=%d count=%d",
          istr(tree_ident(s->where)), offset, count);
@@ -4026,7 +5998,7 @@ int32_t x_test_net_active(sig_shared_t *ss, uint32_t offset, int32_t count)
 void x_sched_event(sig_shared_t *ss, uint32_t offset, int32_t count)
 {
    rt_signal_t *s = container_of(ss, rt_signal_t, shared);
-   RT_LOCK(s->lock);
+   MODEL_LOCK();
 
    TRACE("_sched_event %s+%d count=%d", istr(tree_ident(s->where)),
          offset, count);
@@ -4046,7 +6018,7 @@ void x_sched_event(sig_shared_t *ss, uint32_t offset, int32_t count)
 void x_clear_event(sig_shared_t *ss, uint32_t offset, int32_t count)
 {
    rt_signal_t *s = container_of(ss, rt_signal_t, shared);
-   RT_LOCK(s->lock);
+   MODEL_LOCK();
 
    TRACE("clear event %s+%d count=%d",
          istr(tree_ident(s->where)), offset, count);
@@ -4075,7 +6047,7 @@ void x_enter_state(int32_t state, bool strong)
 void x_alias_signal(sig_shared_t *ss, tree_t where)
 {
    rt_signal_t *s = container_of(ss, rt_signal_t, shared);
-   RT_LOCK(s->lock);
+   MODEL_LOCK();
 
    TRACE("alias signal %s to %s", istr(tree_ident(s->where)),
          istr(tree_ident(where)));
@@ -4091,7 +6063,7 @@ void x_alias_signal(sig_shared_t *ss, tree_t where)
 int64_t x_last_event(sig_shared_t *ss, uint32_t offset, int32_t count)
 {
    rt_signal_t *s = container_of(ss, rt_signal_t, shared);
-   RT_LOCK(s->lock);
+   MODEL_LOCK();
 
    TRACE("_last_event %s offset=%d count=%d",
          istr(tree_ident(s->where)), offset, count);
@@ -4114,7 +6086,7 @@ int64_t x_last_event(sig_shared_t *ss, uint32_t offset, int32_t count)
 int64_t x_last_active(sig_shared_t *ss, uint32_t offset, int32_t count)
 {
    rt_signal_t *s = container_of(ss, rt_signal_t, shared);
-   RT_LOCK(s->lock);
+   MODEL_LOCK();
 
    TRACE("_last_active %s offset=%d count=%d",
          istr(tree_ident(s->where)), offset, count);
@@ -4137,10 +6109,9 @@ void x_map_signal(sig_shared_t *src_ss, uint32_t src_offset,
                   sig_shared_t *dst_ss, uint32_t dst_offset, uint32_t count)
 {
    rt_signal_t *src_s = container_of(src_ss, rt_signal_t, shared);
-   RT_LOCK(src_s->lock);
+   MODEL_LOCK();
 
    rt_signal_t *dst_s = container_of(dst_ss, rt_signal_t, shared);
-   RT_LOCK(dst_s->lock);
 
    TRACE("map signal %s+%d to %s+%d count %d",
          istr(tree_ident(src_s->where)), src_offset,
@@ -4169,7 +6140,7 @@ void x_map_signal(sig_shared_t *src_ss, uint32_t src_offset,
       rt_source_t *port = add_source(m, dst_n, SOURCE_PORT);
       port->u.port.input = src_n;
 
-      port->chain_output = src_n->outputs;
+      port->u.port.chain_output = src_n->outputs;
       src_n->outputs = port;
 
       count -= src_n->width;
@@ -4184,7 +6155,7 @@ void x_map_const(sig_shared_t *ss, uint32_t offset,
                  const uint8_t *values, uint32_t count)
 {
    rt_signal_t *s = container_of(ss, rt_signal_t, shared);
-   RT_LOCK(s->lock);
+   MODEL_LOCK();
 
    TRACE("map const %s to %s+%d count %d", fmt_values(values, count),
          istr(tree_ident(s->where)), offset, count);
@@ -4209,10 +6180,9 @@ void x_map_implicit(sig_shared_t *src_ss, uint32_t src_offset,
                     uint32_t count)
 {
    rt_signal_t *src_s = container_of(src_ss, rt_signal_t, shared);
-   RT_LOCK(src_s->lock);
+   MODEL_LOCK();
 
    rt_signal_t *dst_s = container_of(dst_ss, rt_signal_t, shared);
-   RT_LOCK(dst_s->lock);
 
    TRACE("map implicit signal %s+%d to %s+%d count %d",
          istr(tree_ident(src_s->where)), src_offset,
@@ -4230,7 +6200,7 @@ void x_map_implicit(sig_shared_t *src_ss, uint32_t src_offset,
       rt_source_t *src = add_source(m, &(dst_s->nexus), SOURCE_IMPLICIT);
       src->u.port.input = n;
 
-      src->chain_output = n->outputs;
+      src->u.port.chain_output = n->outputs;
       n->outputs = src;
 
       n->flags |= NET_F_EFFECTIVE;   // Update outputs when active
@@ -4306,7 +6276,7 @@ void x_pop_scope(void)
 bool x_driving(sig_shared_t *ss, uint32_t offset, int32_t count)
 {
    rt_signal_t *s = container_of(ss, rt_signal_t, shared);
-   RT_LOCK(s->lock);
+   MODEL_LOCK();
 
    TRACE("_driving %s offset=%d count=%d",
          istr(tree_ident(s->where)), offset, count);
@@ -4340,7 +6310,7 @@ bool x_driving(sig_shared_t *ss, uint32_t offset, int32_t count)
 void *x_driving_value(sig_shared_t *ss, uint32_t offset, int32_t count)
 {
    rt_signal_t *s = container_of(ss, rt_signal_t, shared);
-   RT_LOCK(s->lock);
+   MODEL_LOCK();
 
    TRACE("driving value %s offset=%d count=%d", istr(tree_ident(s->where)),
          offset, count);
@@ -4413,6 +6383,7 @@ void x_disconnect(sig_shared_t *ss, uint32_t offset, int32_t count,
                   int64_t after, int64_t reject)
 {
    rt_signal_t *s = container_of(ss, rt_signal_t, shared);
+   MODEL_LOCK();
 
    TRACE("_disconnect %s+%d len=%d after=%s reject=%s",
          istr(tree_ident(s->where)), offset, count, trace_time(after),
@@ -4676,7 +6647,9 @@ void x_convert_in(void *ptr, sig_shared_t *ss, uint32_t offset, int32_t count)
       add_conversion_input(m, cf, n);
 
       rt_source_t **p = &(n->outputs);
-      for (; *p != NULL && *p != cf->outputs; p = &((*p)->chain_output));
+      for (; *p != NULL && *p != cf->outputs;
+           p = &((*p)->u.port.chain_output))
+         ;
       *p = cf->outputs;
    }
 }
@@ -4702,7 +6675,7 @@ void x_convert_out(void *ptr, sig_shared_t *ss, uint32_t offset, int32_t count)
       src->u.port.conv_func   = cf;
       src->u.port.conv_result = alloc_value(m, n);
 
-      src->chain_output = cf->outputs;
+      src->u.port.chain_output = cf->outputs;
       cf->outputs = src;
    }
 }
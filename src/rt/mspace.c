@@ -19,6 +19,8 @@
 #include "array.h"
 #include "cpustate.h"
 #include "diag.h"
+#include "fbuf.h"
+#include "hash.h"
 #include "mask.h"
 #include "option.h"
 #include "rt/mspace.h"
@@ -67,6 +69,11 @@ typedef struct {
 #endif
 } gc_state_t;
 
+typedef struct {
+   const ptr_map_t *map;
+   size_t           count;
+} map_entry_t;
+
 typedef struct _free_list free_list_t;
 
 struct _free_list {
@@ -88,6 +95,7 @@ struct _mspace {
    uint64_t         create_us;
    linked_tlab_t   *live_tlabs;
    linked_tlab_t   *free_tlabs;
+   hash_t          *maps;
    unsigned         total_gc;
    unsigned         num_cycles;
 #ifdef DEBUG
@@ -99,6 +107,7 @@ static intptr_t *stack_limit[MAX_THREADS];
 
 static void mspace_gc(mspace_t *m);
 static bool is_mspace_ptr(mspace_t *m, char *p);
+static void mspace_purge_maps(mspace_t *m, bit_mask_t *live);
 
 mspace_t *mspace_new(size_t size)
 {
@@ -165,6 +174,16 @@ void mspace_destroy(mspace_t *m)
       free(p);
    }
 
+   if (m->maps != NULL) {
+      const void *key;
+      void *value;
+      hash_iter_t it = HASH_BEGIN;
+      while (hash_iter(m->maps, &it, &key, &value))
+         free(value);
+
+      hash_free(m->maps);
+   }
+
    mask_free(&(m->headmask));
    nvc_munmap(m->space, m->maxsize);
    free(m);
@@ -540,6 +559,9 @@ static void mspace_gc(mspace_t *m)
    }
    m->free_list = NULL;
 
+   if (m->maps != NULL)
+      mspace_purge_maps(m, &(state.markmask));
+
    int freefrags = 0, freelines = 0;
    free_list_t **tail = &(m->free_list);
    for (size_t line = 0; line < m->maxlines;) {
@@ -602,3 +624,172 @@ void *mspace_find(mspace_t *m, void *ptr, size_t *size)
    *size = objlen * LINE_SIZE;
    return m->space + line * LINE_SIZE;
 }
+
+static size_t mspace_object_lines(mspace_t *m, size_t line)
+{
+   assert(mask_test(&(m->headmask), line));
+
+   size_t objlen = 1;
+   if (line + 1 < m->maxlines)
+      objlen += mask_count_clear(&(m->headmask), line + 1);
+
+   return objlen;
+}
+
+void mspace_save(mspace_t *m, fbuf_t *f)
+{
+   // Collect first so dead objects are not written out
+   mspace_gc(m);
+
+   SCOPED_LOCK(m->lock);
+
+   write_u64(m->maxsize, f);
+   write_u64((uintptr_t)m->space, f);
+
+   // The free list is always sorted by address so the live objects
+   // are exactly the gaps between free list entries
+   size_t line = 0;
+   for (free_list_t *it = m->free_list; ; it = it->next) {
+      const size_t limit = it ? (it->ptr - m->space) / LINE_SIZE : m->maxlines;
+
+      while (line < limit) {
+         const size_t objlen = mspace_object_lines(m, line);
+         assert(line + objlen <= limit);
+
+         char *base = m->space + line * LINE_SIZE;
+         ASAN_UNPOISON(base, objlen * LINE_SIZE);
+
+         write_u8(1, f);
+         write_u32(line, f);
+         write_u32(objlen, f);
+         write_raw(base, objlen * LINE_SIZE, f);
+
+         line += objlen;
+      }
+
+      if (it == NULL)
+         break;
+
+      line = limit + it->size / LINE_SIZE;
+   }
+
+   write_u8(0, f);
+}
+
+static free_list_t **mspace_add_free(mspace_t *m, free_list_t **tail,
+                                     size_t first, size_t nlines)
+{
+   free_list_t *fl = xmalloc(sizeof(free_list_t));
+   fl->next = NULL;
+   fl->ptr  = m->space + first * LINE_SIZE;
+   fl->size = nlines * LINE_SIZE;
+
+   *tail = fl;
+   return &(fl->next);
+}
+
+void mspace_restore(mspace_t *m, fbuf_t *f, void **from, void **to,
+                    size_t *size)
+{
+   SCOPED_LOCK(m->lock);
+
+   const uint64_t maxsize = read_u64(f);
+   if (maxsize != m->maxsize)
+      fatal("checkpoint was saved with a heap size of %"PRIu64" bytes but "
+            "the current heap size is %zu bytes", maxsize, m->maxsize);
+
+   // Return the mapping so the caller can relocate pointers into the
+   // heap held outside of it
+   *from = (void *)(uintptr_t)read_u64(f);
+   *to   = m->space;
+   *size = m->maxsize;
+
+   for (free_list_t *it = m->free_list, *tmp; it; it = tmp) {
+      tmp = it->next;
+      free(it);
+   }
+   m->free_list = NULL;
+
+   // All existing objects are replaced by those in the checkpoint
+   mask_setall(&(m->headmask));
+
+   if (m->maps != NULL)
+      mspace_purge_maps(m, NULL);
+
+   free_list_t **tail = &(m->free_list);
+   size_t next = 0;
+   while (read_u8(f)) {
+      const size_t line = read_u32(f);
+      const size_t objlen = read_u32(f);
+
+      if (line < next || line + objlen > m->maxlines)
+         fatal("corrupt heap image in checkpoint");
+      else if (line > next)
+         tail = mspace_add_free(m, tail, next, line - next);
+
+      char *base = m->space + line * LINE_SIZE;
+      ASAN_UNPOISON(base, objlen * LINE_SIZE);
+      read_raw(base, objlen * LINE_SIZE, f);
+
+      if (objlen > 1)
+         mask_clear_range(&(m->headmask), line + 1, objlen - 1);
+
+      next = line + objlen;
+   }
+
+   if (next < m->maxlines)
+      mspace_add_free(m, tail, next, m->maxlines - next);
+}
+
+static void mspace_purge_maps(mspace_t *m, bit_mask_t *live)
+{
+   // Forget the layout of heap objects which are no longer live as the
+   // memory may be reused for an object without a map
+   const void *key;
+   void *value;
+   hash_iter_t it = HASH_BEGIN;
+   while (hash_iter(m->maps, &it, &key, &value)) {
+      if (!is_mspace_ptr(m, (char *)key))
+         continue;
+      else if (live != NULL) {
+         const size_t line = ((char *)key - m->space) / LINE_SIZE;
+         if (mask_test(live, line))
+            continue;
+      }
+
+      hash_delete(m->maps, key);
+      free(value);
+   }
+}
+
+void mspace_set_map(mspace_t *m, void *ptr, const ptr_map_t *map,
+                    size_t count)
+{
+   SCOPED_LOCK(m->lock);
+
+   if (m->maps == NULL)
+      m->maps = hash_new(256);
+
+   map_entry_t *e = hash_get(m->maps, ptr);
+   if (e == NULL) {
+      e = xmalloc(sizeof(map_entry_t));
+      hash_put(m->maps, ptr, e);
+   }
+
+   e->map   = map;
+   e->count = count;
+}
+
+const ptr_map_t *mspace_get_map(mspace_t *m, void *ptr, size_t *count)
+{
+   SCOPED_LOCK(m->lock);
+
+   map_entry_t *e = m->maps ? hash_get(m->maps, ptr) : NULL;
+   if (e == NULL) {
+      *count = 0;
+      return NULL;
+   }
+
+   *count = e->count;
+   return e->map;
+}
@@ -42,6 +42,30 @@ typedef struct _tlab {
       (t)->alloc = 0;                           \
    } while (0)
 
+typedef enum {
+   PTR_PLAIN,     // Pointer to an object without a known layout
+   PTR_OBJECT,    // Pointer to an object registered with a map
+   PTR_ARRAY,     // Inline array of elements described by a nested map
+   PTR_UARRAY,    // Data pointer and dimensions of an unconstrained array
+} ptr_kind_t;
+
+// The code generator knows the layout of this struct
+typedef struct {
+   uint32_t offset;
+   uint16_t kind;
+   uint16_t ndims;
+   uint32_t count;
+   int32_t  elem;    // Offset of the element map from the containing map
+} ptr_slot_t;
+
+// Pointer slots in an object which must be relocated when restoring a
+// checkpoint
+typedef struct {
+   uint32_t   size;
+   uint32_t   nslots;
+   ptr_slot_t slots[0];
+} ptr_map_t;
+
 mspace_t *mspace_new(size_t size);
 void mspace_destroy(mspace_t *m);
 void *mspace_alloc(mspace_t *m, size_t size);
@@ -49,6 +73,12 @@ void *mspace_alloc_array(mspace_t *m, int nelems, size_t size);
 void *mspace_alloc_flex(mspace_t *m, size_t fixed, int nelems, size_t size);
 void mspace_set_oom_handler(mspace_t *m, mspace_oom_fn_t fn);
 void *mspace_find(mspace_t *m, void *ptr, size_t *size);
+void mspace_save(mspace_t *m, fbuf_t *f);
+void mspace_restore(mspace_t *m, fbuf_t *f, void **from, void **to,
+                    size_t *size);
+void mspace_set_map(mspace_t *m, void *ptr, const ptr_map_t *map,
+                    size_t count);
+const ptr_map_t *mspace_get_map(mspace_t *m, void *ptr, size_t *count);
 
 tlab_t *tlab_acquire(mspace_t *m);
 void tlab_release(tlab_t *t);
@@ -23,20 +23,11 @@
 
 #include <stdint.h>
 
-#define RT_ABI_VERSION   29
+#define RT_ABI_VERSION   31
 #define RT_ALIGN_MASK    0x7
-#define RT_MULTITHREADED 0
 
 #define TIME_HIGH INT64_MAX  // Value of TIME'HIGH
 
-#if RT_MULTITHREADED
-#define RT_LOCK(x) SCOPED_LOCK(x)
-#define MULTITHREADED_ONLY(x) x
-#else
-#define RT_LOCK(x)
-#define MULTITHREADED_ONLY(x)
-#endif
-
 typedef void (*sig_event_fn_t)(uint64_t now, rt_signal_t *signal,
                                rt_watch_t *watch, void *user);
 typedef void (*rt_event_fn_t)(rt_model_t *m, void *user);
@@ -104,6 +95,9 @@ void _std_standard_init(void);
 void _std_env_init(void);
 void _std_reflection_init(void);
 void _file_io_init(void);
+int file_io_open_count(void);
 void _nvc_sim_pkg_init(void);
+void sim_pkg_set_plusargs(int nargs, char **args);
+void sim_pkg_add_plusargs(int nargs, char **args);
 
 #endif  // _RT_H
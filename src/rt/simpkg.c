@@ -16,12 +16,18 @@
 //
 
 #include "util.h"
+#include "array.h"
 #include "option.h"
 #include "jit/jit.h"
 #include "jit/jit-ffi.h"
 #include "rt/model.h"
 #include "rt/rt.h"
 
+#include <stdlib.h>
+#include <string.h>
+
+static A(const char *) plusargs;
+
 DLLEXPORT
 void _nvc_ieee_warnings(jit_scalar_t *args)
 {
@@ -43,6 +49,43 @@ void _nvc_current_delta(jit_scalar_t *args)
    }
 }
 
+static const char *find_plusarg(const uint8_t *name, size_t len)
+{
+   for (int i = 0; i < plusargs.count; i++) {
+      const char *arg = plusargs.items[i] + 1;   // Skip leading '+'
+      if (strncmp(arg, (const char *)name, len) == 0)
+         return arg + len;
+   }
+
+   return NULL;
+}
+
+DLLEXPORT
+void _nvc_test_plusargs(jit_scalar_t *args)
+{
+   const size_t len = ffi_array_length(args[3].integer);
+   args[0].integer = find_plusarg(args[1].pointer, len) != NULL;
+}
+
+DLLEXPORT
+void _nvc_value_plusargs(jit_scalar_t *args, tlab_t *tlab)
+{
+   const size_t len = ffi_array_length(args[3].integer);
+   ffi_return_string(find_plusarg(args[1].pointer, len) ?: "", args, tlab);
+}
+
+void sim_pkg_set_plusargs(int nargs, char **args)
+{
+   ACLEAR(plusargs);
+   sim_pkg_add_plusargs(nargs, args);
+}
+
+void sim_pkg_add_plusargs(int nargs, char **args)
+{
+   for (int i = 0; i < nargs; i++)
+      APUSH(plusargs, args[i]);
+}
+
 void _nvc_sim_pkg_init(void)
 {
    // Dummy function to force linking
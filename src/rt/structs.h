@@ -70,6 +70,7 @@ typedef struct _rt_proc {
    tree_t         where;
    ident_t        name;
    jit_handle_t   handle;
+   unsigned       wakeid;
    tlab_t        *tlab;
    rt_scope_t    *scope;
    mptr_t         privdata;
@@ -108,6 +109,7 @@ STATIC_ASSERT(sizeof(waveform_t) <= 24);
 typedef struct {
    unsigned       count;
    unsigned       max;
+   bit_mask_t     procs;
    rt_wakeable_t *wake[];
 } rt_pending_t;
 
@@ -147,6 +149,7 @@ typedef struct {
    rt_nexus_t     *input;
    rt_conv_func_t *conv_func;
    rt_value_t      conv_result;
+   rt_source_t    *chain_output;
 } rt_port_t;
 
 typedef struct {
@@ -156,7 +159,6 @@ typedef struct {
 
 typedef struct _rt_source {
    rt_source_t    *chain_input;
-   rt_source_t    *chain_output;
    source_kind_t   tag;
    unsigned        disconnected : 1;
    unsigned        fastqueued : 1;
@@ -170,7 +172,7 @@ typedef struct _rt_source {
    } u;
 } rt_source_t;
 
-STATIC_ASSERT(sizeof(rt_source_t) <= 64);
+STATIC_ASSERT(sizeof(rt_source_t) <= 56);
 
 typedef struct {
    ffi_closure_t closure;
@@ -194,11 +196,10 @@ typedef struct _rt_nexus {
    uint64_t       last_event;
    void          *pending;
    rt_source_t   *outputs;
-   void          *free_value;
    rt_source_t    sources;
 } rt_nexus_t;
 
-STATIC_ASSERT(sizeof(rt_nexus_t) <= 128);
+STATIC_ASSERT(sizeof(rt_nexus_t) <= 112);
 
 // The code generator knows the layout of this struct
 typedef struct _sig_shared {
@@ -216,8 +217,8 @@ typedef struct _rt_signal {
    tree_t        where;
    rt_scope_t   *parent;
    rt_index_t   *index;
+   rt_nexus_t   *spare;
    res_memo_t   *resolution;
-   nvc_lock_t    lock;
    uint32_t      offset;
    uint32_t      n_nexus;
    rt_nexus_t    nexus;
@@ -27,6 +27,7 @@
 #include "rt/rt.h"
 #include "rt/structs.h"
 #include "rt/wave.h"
+#include "thread.h"
 #include "tree.h"
 #include "type.h"
 
@@ -41,6 +42,9 @@
 
 #define USE_FST_ENUMS 0
 
+#define WAVE_CHUNK_SIZE 0x10000
+#define WAVE_RING_SIZE  16
+
 typedef struct {
    char  *text;
    size_t len;
@@ -50,7 +54,7 @@ typedef A(glob_t) glob_array_t;
 
 typedef struct _fst_data fst_data_t;
 
-typedef void (*fst_fmt_fn_t)(rt_watch_t *, fst_data_t *);
+typedef void (*fst_fmt_fn_t)(fst_data_t *, const void *);
 
 typedef struct {
    int64_t  mult;
@@ -96,6 +100,18 @@ typedef struct {
    range_kind_t dir;
 } fst_dim_t;
 
+typedef struct {
+   fst_data_t *data;
+   uint64_t    when;
+   uint8_t     value[];
+} wave_record_t;
+
+typedef struct {
+   size_t  capacity;
+   size_t  used;
+   uint8_t bytes[];
+} wave_chunk_t;
+
 typedef struct {
    FILE       *file;
    int         colour;
@@ -114,6 +130,11 @@ typedef struct _wave_dumper {
    jit_t         *jit;
    hash_t        *typecache;
    data_array_t   dumped;
+   wave_chunk_t  *chunk;
+   wave_chunk_t  *ring[WAVE_RING_SIZE];
+   unsigned       ring_head;
+   unsigned       ring_tail;
+   bool           writer_busy;
 } wave_dumper_t;
 
 static glob_array_t incl;
@@ -122,6 +143,7 @@ static glob_array_t excl;
 static void fst_process_signal(wave_dumper_t *wd, rt_scope_t *scope, tree_t d,
                                type_t type, text_buf_t *tb);
 static bool wave_should_dump(ident_t name);
+static void fst_publish_chunk(wave_dumper_t *wd);
 
 static bool should_dump_array(tree_t where, unsigned length)
 {
@@ -145,6 +167,12 @@ static void fst_close(rt_model_t *m, void *arg)
 {
    wave_dumper_t *wd = arg;
 
+   // Wait for the writer to drain the ring buffer
+   fst_publish_chunk(wd);
+   async_barrier();
+
+   assert(wd->ring_head == wd->ring_tail);
+
    fstWriterEmitTimeChange(wd->fst_ctx, model_now(m, NULL));
    fstWriterClose(wd->fst_ctx);
 
@@ -188,10 +216,26 @@ static inline void fst_write_binary(uint64_t val, size_t size, char *buf)
    buf[size] = '\0';
 }
 
-static void fst_fmt_int(rt_watch_t *w, fst_data_t *data)
+static size_t fst_expand(fst_data_t *data, const void *value, uint64_t *buf,
+                         size_t max)
+{
+   const size_t total = signal_width(data->signal);
+
+#define FST_EXPAND_U64(type) do {                               \
+      const type *sp = value;                                   \
+      for (int i = 0; i < max && i < total; i++)                \
+         buf[i] = sp[i];                                        \
+   } while (0)
+
+   FOR_ALL_SIZES(signal_size(data->signal), FST_EXPAND_U64);
+
+   return total;
+}
+
+static void fst_fmt_int(fst_data_t *data, const void *value)
 {
    uint64_t val[data->count];
-   signal_expand(data->signal, val, data->count);
+   fst_expand(data, value, val, data->count);
 
    for (int i = 0; i < data->count; i++) {
       char buf[data->type->size + 1];
@@ -201,16 +245,15 @@ static void fst_fmt_int(rt_watch_t *w, fst_data_t *data)
    }
 }
 
-static void fst_fmt_real(rt_watch_t *w, fst_data_t *data)
+static void fst_fmt_real(fst_data_t *data, const void *value)
 {
-   const void *buf = signal_value(data->signal);
-   fstWriterEmitValueChange(data->dumper->fst_ctx, data->handle[0], buf);
+   fstWriterEmitValueChange(data->dumper->fst_ctx, data->handle[0], value);
 }
 
-static void fst_fmt_physical(rt_watch_t *w, fst_data_t *data)
+static void fst_fmt_physical(fst_data_t *data, const void *value)
 {
    uint64_t val;
-   signal_expand(data->signal, &val, 1);
+   fst_expand(data, value, &val, 1);
 
    fst_unit_t *unit = data->type->u.units;
    while ((val % unit->mult) != 0)
@@ -224,9 +267,9 @@ static void fst_fmt_physical(rt_watch_t *w, fst_data_t *data)
       data->dumper->fst_ctx, data->handle[0], buf, strlen(buf));
 }
 
-static void fst_fmt_chars(rt_watch_t *w, fst_data_t *data)
+static void fst_fmt_chars(fst_data_t *data, const void *value)
 {
-   const uint8_t *p = signal_value(data->signal);
+   const uint8_t *p = value;
    for (int i = 0; i < data->count; i++, p += data->size) {
       if (likely(data->type->u.map != NULL)) {
          char buf[data->size];
@@ -241,10 +284,10 @@ static void fst_fmt_chars(rt_watch_t *w, fst_data_t *data)
 }
 
 #if !USE_FST_ENUMS
-static void fst_fmt_enum(rt_watch_t *w, fst_data_t *data)
+static void fst_fmt_enum(fst_data_t *data, const void *value)
 {
    uint64_t val;
-   signal_expand(data->signal, &val, 1);
+   fst_expand(data, value, &val, 1);
 
    fst_enum_t *e = &(data->type->u.literals);
    assert(val < e->count);
@@ -257,18 +300,103 @@ static void fst_fmt_enum(rt_watch_t *w, fst_data_t *data)
 }
 #endif
 
+static void fst_write_chunk(wave_dumper_t *wd, wave_chunk_t *chunk)
+{
+   for (size_t pos = 0; pos < chunk->used; ) {
+      const wave_record_t *r = (wave_record_t *)(chunk->bytes + pos);
+
+      if (r->when != wd->last_time) {
+         fstWriterEmitTimeChange(wd->fst_ctx, r->when);
+         wd->last_time = r->when;
+      }
+
+      (*r->data->type->fn)(r->data, r->value);
+
+      pos += ALIGN_UP(sizeof(wave_record_t) + r->data->signal->shared.size,
+                      sizeof(uint64_t));
+   }
+}
+
+static void fst_writer_task(void *context, void *arg)
+{
+   wave_dumper_t *wd = context;
+
+   for (;;) {
+      unsigned head = atomic_load(&wd->ring_head);
+      while (head != atomic_load(&wd->ring_tail)) {
+         fst_write_chunk(wd, wd->ring[head % WAVE_RING_SIZE]);
+         atomic_store(&wd->ring_head, ++head);
+      }
+
+      atomic_store(&wd->writer_busy, false);
+
+      // Check again in case a chunk was published after the loop above
+      // but before the busy flag was cleared
+      if (head == atomic_load(&wd->ring_tail))
+         break;
+      else if (!atomic_cas(&wd->writer_busy, false, true))
+         break;   // Another task was started
+   }
+}
+
+static void fst_publish_chunk(wave_dumper_t *wd)
+{
+   if (wd->chunk == NULL || wd->chunk->used == 0)
+      return;
+
+   atomic_add(&wd->ring_tail, 1);
+   wd->chunk = NULL;
+
+   if (atomic_cas(&wd->writer_busy, false, true))
+      async_do(fst_writer_task, wd, NULL);
+}
+
+static wave_chunk_t *fst_get_chunk(wave_dumper_t *wd, size_t need)
+{
+   if (wd->chunk != NULL && wd->chunk->used + need <= wd->chunk->capacity)
+      return wd->chunk;
+
+   fst_publish_chunk(wd);
+
+   // Wait for the writer to finish with the chunk in the next slot
+   const unsigned tail = relaxed_load(&wd->ring_tail);
+   for (int spins = 0; tail - atomic_load(&wd->ring_head) >= WAVE_RING_SIZE;) {
+      if (spins++ < 100)
+         spin_wait();
+      else
+         thread_sleep(10);
+   }
+
+   wave_chunk_t **slot = &(wd->ring[tail % WAVE_RING_SIZE]);
+   if (*slot == NULL || (*slot)->capacity < need) {
+      const size_t capacity = MAX(need, WAVE_CHUNK_SIZE);
+      *slot = xrealloc_flex(*slot, sizeof(wave_chunk_t), capacity, 1);
+      (*slot)->capacity = capacity;
+   }
+
+   (*slot)->used = 0;
+   return (wd->chunk = *slot);
+}
+
 static void fst_event_cb(uint64_t now, rt_signal_t *s, rt_watch_t *w,
                          void *user)
 {
    fst_data_t *data = user;
+   wave_dumper_t *wd = data->dumper;
 
-   if (now != data->dumper->last_time) {
-      fstWriterEmitTimeChange(data->dumper->fst_ctx, now);
-      data->dumper->last_time = now;
-   }
+   // Copy the raw value into the ring buffer to be formatted and
+   // compressed later by the writer task
+   const size_t need =
+      ALIGN_UP(sizeof(wave_record_t) + s->shared.size, sizeof(uint64_t));
+
+   wave_chunk_t *chunk = fst_get_chunk(wd, need);
 
-   if (likely(data != NULL))
-      (*data->type->fn)(w, data);
+   wave_record_t *r = (wave_record_t *)(chunk->bytes + chunk->used);
+   r->data = data;
+   r->when = now;
+   memcpy(r->value, s->shared.data, s->shared.size);
+
+   chunk->used += need;
 }
 
 static fst_unit_t *fst_make_unit_map(type_t type)
@@ -1140,6 +1268,11 @@ wave_dumper_t *wave_dumper_new(const char *file, const char *gtkw_file,
 
 void wave_dumper_free(wave_dumper_t *wd)
 {
+   async_barrier();   // Writer may still be running if the model failed
+
+   for (int i = 0; i < WAVE_RING_SIZE; i++)
+      free(wd->ring[i]);
+
    for (int i = 0; i < wd->dumped.count; i++)
       free(wd->dumped.items[i]);
    ACLEAR(wd->dumped);
@@ -650,6 +650,44 @@ nvc_thread_t *get_thread(int id)
    return atomic_load(&threads[id]);
 }
 
+#ifndef __MINGW32__
+pid_t thread_fork(void)
+{
+   assert(my_thread->kind == MAIN_THREAD);
+
+   // Only the calling thread exists in the child so make sure the
+   // worker threads are idle and not holding any locks
+   async_barrier();
+
+   SCOPED_LOCK(stop_lock);   // Avoid races with thread creation
+
+   platform_mutex_lock(&wakelock);
+
+   const pid_t pid = fork();
+   if (pid == 0) {
+      // Forget about the worker threads in the parent: new workers
+      // will be created on demand
+      for (int i = 0; i < MAX_THREADS; i++) {
+         nvc_thread_t *t = atomic_load(&(threads[i]));
+         if (t != NULL && t != my_thread)
+            atomic_store(&(threads[i]), NULL);
+      }
+
+      atomic_store(&running_threads, 1);
+      atomic_store(&max_thread_id, my_thread->id);
+
+      PTHREAD_CHECK(pthread_cond_init, &wake_workers, NULL);
+   }
+
+   platform_mutex_unlock(&wakelock);
+
+   if (pid < 0)
+      fatal_errno("fork");
+
+   return pid;
+}
+#endif
+
 static inline parking_bay_t *parking_bay_for(void *cookie)
 {
    return &(parking_bays[mix_bits_64(cookie) % PARKING_BAYS]);
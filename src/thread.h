@@ -22,6 +22,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <sys/types.h>
 
 #define atomic_add(p, n) __atomic_add_fetch((p), (n), __ATOMIC_SEQ_CST)
 #define atomic_fetch_add(p, n) __atomic_fetch_add((p), (n), __ATOMIC_SEQ_CST)
@@ -68,6 +69,10 @@ void *thread_join(nvc_thread_t *thread);
 
 nvc_thread_t *get_thread(int id);
 
+#ifndef __MINGW32__
+pid_t thread_fork(void);
+#endif
+
 void spin_wait(void);
 
 typedef int8_t nvc_lock_t;
@@ -1980,6 +1980,27 @@ void *map_file(int fd, size_t size)
    return ptr;
 }
 
+void map_file_fixed(int fd, void *addr, size_t size)
+{
+#if defined __MINGW32__ || ASAN_ENABLED
+   // The memory from nvc_memalign cannot be replaced with a mapping
+   if (lseek(fd, 0, SEEK_SET) < 0)
+      fatal_errno("lseek");
+
+   for (size_t nread = 0; nread < size; ) {
+      const ssize_t nbytes = read(fd, (char *)addr + nread, size - nread);
+      if (nbytes <= 0)
+         fatal_errno("read");
+      nread += nbytes;
+   }
+#else
+   void *ptr = mmap(addr, size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_FIXED, fd, 0);
+   if (ptr == MAP_FAILED)
+      fatal_errno("mmap failed to map %zu byte file", size);
+#endif
+}
+
 void unmap_file(void *ptr, size_t size)
 {
 #ifdef __MINGW32__
@@ -396,6 +396,7 @@ void file_write_lock(int fd);
 void file_unlock(int fd);
 
 void *map_file(int fd, size_t size);
+void map_file_fixed(int fd, void *addr, size_t size);
 void unmap_file(void *ptr, size_t size);
 void make_dir(const char *path);
 char *search_path(const char *name);
@@ -6266,6 +6266,85 @@ void vcode_check_shape(vcode_unit_t vu, vcode_unit_t shape)
 #endif
 }
 
+static const vtype_t *vtype_in_unit(vcode_unit_t vu, vcode_type_t type)
+{
+   const int depth = MASK_CONTEXT(type);
+   assert(depth <= vu->depth);
+   while (depth != vu->depth)
+      vu = vu->context;
+
+   return vtype_array_nth_ptr(&(vu->types), MASK_INDEX(type));
+}
+
+static bool vtype_same(vcode_unit_t ua, vcode_type_t a,
+                       vcode_unit_t ub, vcode_type_t b)
+{
+   if (a == VCODE_INVALID_TYPE || b == VCODE_INVALID_TYPE)
+      return a == b;
+
+   const vtype_t *at = vtype_in_unit(ua, a);
+   const vtype_t *bt = vtype_in_unit(ub, b);
+
+   if (at->kind != bt->kind)
+      return false;
+
+   switch (at->kind) {
+   case VCODE_TYPE_INT:
+      return at->low == bt->low && at->high == bt->high;
+   case VCODE_TYPE_REAL:
+      return at->rlow == bt->rlow && at->rhigh == bt->rhigh;
+   case VCODE_TYPE_CARRAY:
+      return at->size == bt->size
+         && vtype_same(ua, at->elem, ub, bt->elem)
+         && vtype_same(ua, at->bounds, ub, bt->bounds);
+   case VCODE_TYPE_UARRAY:
+      return at->dims == bt->dims
+         && vtype_same(ua, at->elem, ub, bt->elem)
+         && vtype_same(ua, at->bounds, ub, bt->bounds);
+   case VCODE_TYPE_POINTER:
+   case VCODE_TYPE_ACCESS:
+      return vtype_same(ua, at->pointed, ub, bt->pointed);
+   case VCODE_TYPE_OFFSET:
+   case VCODE_TYPE_OPAQUE:
+   case VCODE_TYPE_DEBUG_LOCUS:
+   case VCODE_TYPE_TRIGGER:
+   case VCODE_TYPE_CONVERSION:
+      return true;
+   case VCODE_TYPE_RESOLUTION:
+   case VCODE_TYPE_CLOSURE:
+   case VCODE_TYPE_SIGNAL:
+   case VCODE_TYPE_FILE:
+      return vtype_same(ua, at->base, ub, bt->base);
+   case VCODE_TYPE_RECORD:
+   case VCODE_TYPE_CONTEXT:
+      return at->name == bt->name;
+   }
+
+   return false;
+}
+
+bool vcode_same_layout(vcode_unit_t a, vcode_unit_t b)
+{
+   // True if code compiled against the variables of instance A can be
+   // used with the variables of instance B unchanged
+   if (a->kind != b->kind || a->vars.count != b->vars.count)
+      return false;
+
+   for (int i = 0; i < a->vars.count; i++) {
+      const var_t *va = var_array_nth_ptr(&(a->vars), i);
+      const var_t *vb = var_array_nth_ptr(&(b->vars), i);
+
+      if (va->name != vb->name || va->flags != vb->flags)
+         return false;
+      else if (!vtype_same(a, va->type, b, vb->type))
+         return false;
+      else if (!vtype_same(a, va->bounds, b, vb->bounds))
+         return false;
+   }
+
+   return true;
+}
+
 #if VCODE_CHECK_UNIONS
 #define OP_USE_COUNT_U0(x)                                              \
    (OP_HAS_IDENT(x) + OP_HAS_FUNC(x) + OP_HAS_ADDRESS(x))
@@ -315,6 +315,7 @@ vcode_unit_t vcode_unit_context(vcode_unit_t vu);
 object_t *vcode_unit_object(vcode_unit_t vu);
 void vcode_set_result(vcode_type_t type);
 void vcode_check_shape(vcode_unit_t vu, vcode_unit_t shape);
+bool vcode_same_layout(vcode_unit_t a, vcode_unit_t b);
 
 void vcode_state_save(vcode_state_t *state);
 void vcode_state_restore(const vcode_state_t *state);
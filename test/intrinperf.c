@@ -0,0 +1,168 @@
+//
+//  Copyright (C) 2025  Nick Gasson
+//
+//  This program is free software: you can redistribute it and/or modify
+//  it under the terms of the GNU General Public License as published by
+//  the Free Software Foundation, either version 3 of the License, or
+//  (at your option) any later version.
+//
+//  This program is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//  GNU General Public License for more details.
+//
+//  You should have received a copy of the GNU General Public License
+//  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+#include "util.h"
+#include "ident.h"
+#include "jit/jit-priv.h"
+#include "jit/jit.h"
+#include "option.h"
+#include "rt/mspace.h"
+#include "thread.h"
+
+#include <assert.h>
+#include <getopt.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Benchmark for the IEEE library intrinsics in jit-intrin.c: set
+// NVC_VECTOR_INTRINSICS=0 in the environment to measure the scalar
+// implementations
+
+#define NS "IEEE.NUMERIC_STD."
+#define SL "IEEE.STD_LOGIC_1164."
+#define SU "IEEE.STD_LOGIC_UNSIGNED."
+#define SS "IEEE.STD_LOGIC_SIGNED."
+#define U  "25IEEE.NUMERIC_STD.UNSIGNED"
+#define S  "23IEEE.NUMERIC_STD.SIGNED"
+
+#define DURATION_US 200000
+
+typedef enum {
+   ARGS_BINARY,
+   ARGS_UNARY,
+   ARGS_RESIZE,
+} args_kind_t;
+
+typedef struct {
+   const char  *label;
+   const char  *name;
+   args_kind_t  kind;
+} benchmark_t;
+
+static const benchmark_t benchmarks[] = {
+   { "unsigned +",    NS "\"+\"(" U U ")" U,   ARGS_BINARY },
+   { "signed -",      NS "\"-\"(" S S ")" S,   ARGS_BINARY },
+   { "unsigned *",    NS "\"*\"(" U U ")" U,   ARGS_BINARY },
+   { "signed *",      NS "\"*\"(" S S ")" S,   ARGS_BINARY },
+   { "unsigned <",    NS "\"<\"(" U U ")B",    ARGS_BINARY },
+   { "resize",        NS "RESIZE(" U "N)" U,   ARGS_RESIZE },
+   { "to_x01",        SL "TO_X01(V)V",         ARGS_UNARY },
+   { "and",           SL "\"and\"(VV)V",       ARGS_BINARY },
+   { "or",            SL "\"or\"(VV)V",        ARGS_BINARY },
+   { "xor",           SL "\"xor\"(VV)V",       ARGS_BINARY },
+   { "=",             SL "\"=\"(VV)B$predef",  ARGS_BINARY },
+   { "synopsys +",    SU "\"+\"(VV)V",         ARGS_BINARY },
+   { "synopsys *",    SS "\"*\"(VV)V",         ARGS_BINARY },
+};
+
+static const int widths[] = { 8, 32, 64, 256, 1024 };
+
+static uint8_t *random_vector(int width)
+{
+   // Allow the vectorised intrinsics to read past the end
+   uint8_t *vec = xcalloc(width + 64);
+   for (int i = 0; i < width; i++)
+      vec[i] = 2 + (rand() & 1);   // '0' or '1'
+
+   return vec;
+}
+
+static void run_benchmark(const benchmark_t *b, int width, tlab_t *tlab)
+{
+   jit_entry_fn_t entry = jit_bind_intrinsic(ident_new(b->name));
+   if (entry == NULL)
+      fatal("no intrinsic for %s", b->name);
+
+   uint8_t *left = random_vector(width);
+   uint8_t *right = random_vector(width);
+
+   const uint64_t start = get_timestamp_us();
+   uint64_t now, iters = 0;
+   for (; (now = get_timestamp_us()) < start + DURATION_US; iters++) {
+      for (int i = 0; i < 100; i++) {
+         jit_scalar_t args[8] = {
+            [1] = { .pointer = left },
+            [2] = { .integer = width - 1 },
+            [3] = { .integer = ~width },
+         };
+
+         switch (b->kind) {
+         case ARGS_BINARY:
+            args[4].pointer = right;
+            args[5].integer = width - 1;
+            args[6].integer = ~width;
+            break;
+         case ARGS_RESIZE:
+            args[4].integer = width * 2;
+            break;
+         case ARGS_UNARY:
+            break;
+         }
+
+         (*entry)(NULL, NULL, args, tlab);
+         tlab_reset(tlab);
+      }
+   }
+
+   const double nsec = (now - start) * 1000.0 / (iters * 100);
+   printf("%-14s %6d %10.1f ns/op\n", b->label, width, nsec);
+
+   free(left);
+   free(right);
+}
+
+int main(int argc, char **argv)
+{
+   term_init();
+   set_default_options();
+   thread_init();
+   mspace_stack_limit(MSPACE_CURRENT_FRAME);
+
+   opt_set_int(OPT_IEEE_WARNINGS, 0);
+
+   const char *filter = NULL;
+   int c;
+   while ((c = getopt(argc, argv, "f:")) != -1) {
+      switch (c) {
+      case 'f':
+         filter = optarg;
+         break;
+      default:
+         fatal("usage: %s [-f PATTERN]", argv[0]);
+      }
+   }
+
+   jit_t *j = jit_new(NULL);
+   tlab_t *tlab = tlab_acquire(jit_get_mspace(j));
+
+   printf("Vector intrinsics %s\n\n",
+          opt_get_int(OPT_VECTOR_INTRINSICS) ? "enabled" : "disabled");
+
+   for (int i = 0; i < ARRAY_LEN(benchmarks); i++) {
+      if (filter != NULL && strstr(benchmarks[i].label, filter) == NULL)
+         continue;
+
+      for (int w = 0; w < ARRAY_LEN(widths); w++)
+         run_benchmark(&(benchmarks[i]), widths[w], tlab);
+
+      printf("\n");
+   }
+
+   tlab_release(tlab);
+   jit_free(j);
+   return 0;
+}
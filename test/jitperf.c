@@ -66,11 +66,12 @@ static void run_benchmark(tree_t pack, tree_t proc, unit_registry_t *ur)
    jit_preload(j);
 #endif
 
-#if defined HAVE_LLVM && 1
-   jit_register_llvm_plugin(j);
-#elif defined ARCH_X86_64 && 0
+#ifdef ARCH_X86_64
    jit_register_native_plugin(j);
 #endif
+#ifdef HAVE_LLVM
+   jit_register_llvm_plugin(j);
+#endif
 
    jit_handle_t hpack = jit_compile(j, tree_ident(pack));
    jit_scalar_t context = { .pointer = jit_link(j, hpack) };
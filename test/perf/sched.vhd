@@ -0,0 +1,40 @@
+-- Scheduling microbenchmark: many processes waiting on a small set of
+-- repeating clock periods plus some transport delayed assignments to
+-- stress the event queue.  Run with:
+--
+--   nvc -a sched.vhd -e sched -r --stats
+--
+
+entity sched is
+    generic ( N : positive := 2000;
+              CYCLES : positive := 2000 );
+end entity;
+
+architecture test of sched is
+    type time_vector is array (natural range <>) of delay_length;
+
+    constant PERIODS : time_vector := (5 ns, 10 ns, 7 ns, 20 ns);
+
+    type int_vector is array (natural range <>) of integer;
+
+    signal delayed : int_vector(1 to N);
+begin
+
+    g: for i in 1 to N generate
+        constant PERIOD : delay_length := PERIODS(i mod PERIODS'length);
+    begin
+
+        timer: process is
+            variable count : natural := 0;
+        begin
+            for j in 1 to CYCLES loop
+                wait for PERIOD;
+                count := count + 1;
+                delayed(i) <= transport count after PERIOD / 2;
+            end loop;
+            wait;
+        end process;
+
+    end generate;
+
+end architecture;
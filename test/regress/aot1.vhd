@@ -0,0 +1,91 @@
+package aot1_pack is
+    function scale (x : integer; k : integer) return integer;
+    function clamp (x, lo, hi : integer) return integer;
+
+    type int_vector is array (natural range <>) of integer;
+    function sum_all (v : int_vector) return integer;
+    subtype rint is sum_all integer;
+end package;
+
+package body aot1_pack is
+    function scale (x : integer; k : integer) return integer is
+    begin
+        return x * k + 1;
+    end function;
+
+    function clamp (x, lo, hi : integer) return integer is
+    begin
+        if x < lo then
+            return lo;
+        elsif x > hi then
+            return hi;
+        else
+            return x;
+        end if;
+    end function;
+
+    function sum_all (v : int_vector) return integer is
+        variable r : integer := 0;
+    begin
+        for i in v'range loop
+            r := r + v(i);
+        end loop;
+        return r;
+    end function;
+end package body;
+
+-------------------------------------------------------------------------------
+
+use work.aot1_pack.all;
+
+entity aot1_sub is
+    generic ( K : integer );
+    port ( clk : in bit;
+           o   : out rint := 0 );
+end entity;
+
+architecture test of aot1_sub is
+begin
+    process (clk) is
+        variable acc : integer := 0;
+    begin
+        if clk'event and clk = '1' then
+            acc := clamp(scale(acc, K), 0, 1000);
+            o <= acc;
+        end if;
+    end process;
+end architecture;
+
+-------------------------------------------------------------------------------
+
+use work.aot1_pack.all;
+
+entity aot1 is
+end entity;
+
+architecture test of aot1 is
+    signal clk : bit := '0';
+    signal s   : rint := 0;
+begin
+
+    clk <= not clk after 5 ns when now < 100 ns;
+
+    u1: entity work.aot1_sub generic map (2) port map (clk, s);
+    u2: entity work.aot1_sub generic map (3) port map (clk, s);
+
+    check: process is
+    begin
+        wait for 1 ns;
+        assert s = 0;
+        wait until clk = '1';
+        wait for 1 ns;
+        assert s = 2 report integer'image(s);   -- 1 + 1
+        wait until clk = '1';
+        wait for 1 ns;
+        assert s = 7 report integer'image(s);   -- 3 + 4
+        wait for 100 ns;
+        assert s = 2000 report integer'image(s);   -- Both clamped
+        wait;
+    end process;
+
+end architecture;
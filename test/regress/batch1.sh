@@ -0,0 +1,28 @@
+set -xe
+
+nvc --std=2019 -a $TESTDIR/regress/batch1.vhd -e batch1
+
+cat >jobs.txt <<EOF2
+# Each line is a separate run
+EXPECT=10 +MODE=fast
+EXPECT=10 --seed=42 +VERBOSE
+
+EXPECT=5    # Should fail
+EOF2
+
+if nvc -r --batch=jobs.txt --jobs=2 batch1 2>out.txt; then
+  echo "expected batch to fail"
+  exit 1
+fi
+
+cat out.txt
+grep "batch1.1.log passed" out.txt
+grep "batch1.2.log passed" out.txt
+grep "batch1.3.log failed" out.txt
+grep "2 of 3 batch jobs passed" out.txt
+
+grep "count=10 expect=10" batch1.1.log
+grep "mode=fast verbose=false" batch1.1.log
+grep "count=10 expect=10" batch1.2.log
+grep "mode= verbose=true" batch1.2.log
+grep "count=10 expect=5" batch1.3.log
@@ -0,0 +1,36 @@
+use std.env.all;
+
+library nvc;
+use nvc.sim_pkg.all;
+
+entity batch1 is
+end entity;
+
+architecture test of batch1 is
+    signal count : natural;
+
+    -- Read during elaboration so the job environment must be applied
+    -- before the model is reset
+    constant EXPECT : string := getenv("EXPECT");
+    constant MODE   : string := value_plusargs("MODE=");
+begin
+
+    counter: process is
+    begin
+        for i in 1 to 10 loop
+            count <= count + 1;
+            wait for 1 ns;
+        end loop;
+        wait;
+    end process;
+
+    check: process is
+    begin
+        wait for 20 ns;
+        report "count=" & integer'image(count) & " expect=" & EXPECT;
+        report "mode=" & MODE & " verbose=" & boolean'image(test_plusargs("VERBOSE"));
+        assert integer'image(count) = EXPECT;
+        wait;
+    end process;
+
+end architecture;
@@ -0,0 +1,39 @@
+entity bitblast1 is
+end entity;
+
+architecture test of bitblast1 is
+    signal bus16 : bit_vector(15 downto 0);
+    signal wide  : bit_vector(99 downto 0);
+    signal nib   : bit_vector(7 downto 0);
+begin
+
+    g1: for i in bus16'range generate
+        bus16(i) <= '1' after (i + 1) * ns;
+    end generate;
+
+    g2: for i in 0 to 49 generate
+        wide(i * 2) <= '1' after 1 ns;
+    end generate;
+
+    nib(7 downto 4) <= X"a";
+    nib(1) <= '1';
+    nib(3 downto 2) <= "01";
+    nib(0) <= '0';
+
+    check: process is
+    begin
+        wait for 0 ns;
+        assert nib = X"a6";
+        assert bus16 = X"0000";
+        wait for 1 ns;
+        assert bus16 = X"0001";
+        wait for 10 ns;
+        assert bus16 = X"07ff";
+        assert wide(0) = '1' and wide(1) = '0' and wide(98) = '1';
+        wait on bus16(15);
+        assert now = 16 ns;
+        assert bus16 = X"ffff";
+        wait;
+    end process;
+
+end architecture;
@@ -0,0 +1,15 @@
+set -xe
+
+nvc -a $TESTDIR/regress/checkpoint1.vhd -e checkpoint1
+
+nvc -r checkpoint1 2>full.txt
+
+nvc -r --checkpoint-at=50ns --checkpoint=checkpoint1.dat checkpoint1
+test -f checkpoint1.dat
+
+nvc -r --restore=checkpoint1.dat checkpoint1 2>restored.txt
+
+cat restored.txt
+grep "count=10 vec(4)=45 hello" restored.txt
+grep "reached 15" restored.txt
+diff -u full.txt restored.txt
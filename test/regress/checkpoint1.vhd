@@ -0,0 +1,37 @@
+entity checkpoint1 is
+end entity;
+
+architecture test of checkpoint1 is
+    type int_vec is array (natural range <>) of integer;
+
+    signal clk   : bit := '0';
+    signal count : natural;
+    signal vec   : int_vec(1 to 4);
+begin
+
+    clk <= not clk after 5 ns when now < 200 ns;
+
+    counter: process (clk) is
+        variable total : natural;
+    begin
+        if clk'event and clk = '1' then
+            total := total + count;
+            count <= count + 1;
+            vec <= vec(2 to 4) & total;
+        end if;
+    end process;
+
+    check: process is
+        type string_ptr is access string;
+        variable p : string_ptr;
+    begin
+        p := new string'("hello");
+        wait for 100 ns;
+        report "count=" & integer'image(count) & " vec(4)="
+            & integer'image(vec(4)) & " " & p.all;
+        wait until count = 15;
+        report "reached 15 at " & time'image(now);
+        wait;
+    end process;
+
+end architecture;
@@ -0,0 +1,20 @@
+set -xe
+
+nvc -a $TESTDIR/regress/checkpoint2.vhd -e checkpoint2
+
+nvc -r checkpoint2 2>full.txt
+
+nvc -r --checkpoint-at=50ns --checkpoint=checkpoint2.dat checkpoint2
+test -f checkpoint2.dat
+
+nvc -r --restore=checkpoint2.dat checkpoint2 2>restored.txt
+
+cat restored.txt
+grep "sum=21" restored.txt
+grep "total=100" restored.txt
+diff -u full.txt restored.txt
+
+if nvc -r --checkpoint-at=50ns checkpoint2 2>err.txt; then
+    exit 1
+fi
+grep "cannot be used without" err.txt
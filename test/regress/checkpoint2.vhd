@@ -0,0 +1,62 @@
+entity checkpoint2 is
+end entity;
+
+architecture test of checkpoint2 is
+    type node_t;
+    type node_ptr is access node_t;
+    type node_t is record
+        value : integer;
+        link  : node_ptr;
+    end record;
+
+    type int_ptr is access integer;
+    type int_ptr_vec is array (natural range <>) of int_ptr;
+
+    signal tick : natural;
+begin
+
+    tick <= tick + 1 after 10 ns when tick < 20;
+
+    list: process is
+        variable head : node_ptr;
+        variable sum  : integer;
+        variable it   : node_ptr;
+    begin
+        for i in 1 to 5 loop
+            head := new node_t'(i, head);
+        end loop;
+        wait for 100 ns;
+        head := new node_t'(6, head);
+        sum := 0;
+        it := head;
+        while it /= null loop
+            sum := sum + it.value;
+            it := it.link;
+        end loop;
+        report "sum=" & integer'image(sum);
+        wait;
+    end process;
+
+    suspended: process is
+        procedure hold (n : positive) is
+            variable v : int_ptr_vec(1 to n);
+            variable total : integer := 0;
+        begin
+            for i in v'range loop
+                v(i) := new integer'(i * 10);
+            end loop;
+            wait for 100 ns;
+            for i in v'range loop
+                total := total + v(i).all;
+            end loop;
+            report "total=" & integer'image(total);
+        end procedure;
+
+        variable n : positive := 4;
+    begin
+        wait for 1 ns;
+        hold(n);
+        wait;
+    end process;
+
+end architecture;
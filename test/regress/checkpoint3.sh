@@ -0,0 +1,14 @@
+set -xe
+
+nvc -a $TESTDIR/regress/checkpoint3.vhd -e checkpoint3
+
+nvc -r checkpoint3 2>full.txt
+
+nvc -r --checkpoint-at=100ns --checkpoint=checkpoint3.dat checkpoint3
+test -f checkpoint3.dat
+
+nvc -r --restore=checkpoint3.dat checkpoint3 2>restored.txt
+
+cat restored.txt
+grep "done" restored.txt
+diff -u full.txt restored.txt
@@ -0,0 +1,54 @@
+entity checkpoint3 is
+end entity;
+
+architecture test of checkpoint3 is
+    constant N : positive := 100;
+
+    type int_vector is array (natural range <>) of integer;
+
+    signal clk, rst : bit := '0';
+    signal counts   : int_vector(1 to N);
+    signal wakes    : int_vector(1 to N) := (others => 0);
+begin
+
+    clkgen: clk <= not clk after 5 ns when now < 500 ns;
+
+    g: for i in 1 to N generate
+        p: process (clk, rst) is
+        begin
+            if rst = '1' then
+                counts(i) <= 0;
+            elsif clk'event and clk = '1' then
+                counts(i) <= counts(i) + i;
+            end if;
+        end process;
+
+        -- Waiting on the reset when the checkpoint is taken
+        q: process is
+        begin
+            wait until clk = '1';
+            wait on rst;
+            wakes(i) <= wakes(i) + 1;
+        end process;
+    end generate;
+
+    check: process is
+    begin
+        wait for 200 ns;
+        rst <= '1';
+        wait for 1 ns;
+        rst <= '0';
+        wait for 1 us;
+        for i in 1 to N loop
+            assert counts(i) = i * 30
+                report "counts(" & integer'image(i) & ") = "
+                & integer'image(counts(i)) severity failure;
+            assert wakes(i) = 1
+                report "wakes(" & integer'image(i) & ") = "
+                & integer'image(wakes(i)) severity failure;
+        end loop;
+        report "done";
+        wait;
+    end process;
+
+end architecture;
@@ -0,0 +1,65 @@
+set -xe
+
+cat >pack.vhd <<EOF
+package pack is
+    constant WIDTH : natural := 8;
+    function double (x : natural) return natural;
+end package;
+
+package body pack is
+    function double (x : natural) return natural is
+    begin
+        return x * 2;
+    end function;
+end package body;
+EOF
+
+cat >sub.vhd <<EOF
+use work.pack.all;
+
+entity sub is
+    port ( x : in natural; y : out natural );
+end entity;
+
+architecture test of sub is
+begin
+    y <= double(x) + WIDTH;
+end architecture;
+EOF
+
+cat >other.vhd <<EOF
+entity other is
+end entity;
+
+architecture test of other is
+begin
+end architecture;
+EOF
+
+cat >top.vhd <<EOF
+entity top is
+end entity;
+
+architecture test of top is
+    signal x, y : natural;
+begin
+    u1: entity work.sub port map ( x, y );
+    u2: entity work.other;
+
+    check: process is
+    begin
+        x <= 5;
+        wait for 1 ns;
+        report "y=" & integer'image(y);
+        assert y = 18;
+        wait;
+    end process;
+end architecture;
+EOF
+
+# Each file depends on one or more of the earlier files
+nvc -a -j 3 pack.vhd sub.vhd other.vhd top.vhd
+nvc -e top -r 2>out.txt
+
+cat out.txt
+grep "y=18" out.txt
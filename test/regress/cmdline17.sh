@@ -0,0 +1,62 @@
+set -xe
+
+cat >pack.vhd <<EOF
+package pack is
+    constant WIDTH : natural := 8;
+    function double (x : natural) return natural;
+end package;
+
+package body pack is
+    function double (x : natural) return natural is
+    begin
+        return x * 2;
+    end function;
+end package body;
+EOF
+
+cat >bad.vhd <<EOF
+entity bad is
+end entity;
+
+architecture test of bad is
+    signal s : integer := "hello";
+begin
+end architecture;
+EOF
+
+cat >user.vhd <<EOF
+entity user is
+end entity;
+
+architecture test of user is
+begin
+    u: entity work.bad;
+end architecture;
+EOF
+
+cat >indep.vhd <<EOF
+use work.pack.all;
+
+entity indep is
+end entity;
+
+architecture test of indep is
+begin
+    assert double(WIDTH) = 16;
+end architecture;
+EOF
+
+nvc -a --jobs=4 pack.vhd bad.vhd user.vhd indep.vhd 2>err.txt && exit 1
+
+cat err.txt
+grep "type of string literal cannot be determined" err.txt
+
+# Units from files that analysed cleanly are saved but a file that
+# depends on a failed file is skipped
+[ -f work/WORK.PACK ]
+[ -f work/WORK.PACK-body ]
+[ -f work/WORK.INDEP-TEST ]
+[ ! -f work/WORK.BAD ]
+[ ! -f work/WORK.USER ]
+
+nvc -e indep -r
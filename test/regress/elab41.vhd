@@ -0,0 +1,75 @@
+-- Many instances of the same entity with identical generics
+entity elab41_pe is
+    generic ( SCALE : integer; TAG : character := 'x' );
+    port ( clk : in bit;
+           x   : in integer;
+           y   : out integer;
+           z   : out integer := 0 );
+end entity;
+
+architecture test of elab41_pe is
+    constant K : integer := SCALE * 2;
+    signal acc : integer := 0;
+begin
+
+    process (clk) is
+    begin
+        if clk'event and clk = '1' then
+            acc <= acc + x * K;
+        end if;
+    end process;
+
+    y <= acc;
+
+    g: if TAG = 'y' generate
+        z <= acc + 1;
+    end generate;
+
+end architecture;
+
+-------------------------------------------------------------------------------
+
+entity elab41 is
+end entity;
+
+architecture test of elab41 is
+    constant N : positive := 16;
+
+    type int_vector is array (natural range <>) of integer;
+
+    signal clk              : bit := '0';
+    signal xs, ys1, ys2, zs : int_vector(1 to N);
+begin
+
+    clk <= not clk after 5 ns when now < 100 ns;
+
+    g: for i in 1 to N generate
+        xs(i) <= i;
+
+        u1: entity work.elab41_pe
+            generic map ( SCALE => 1 )
+            port map ( clk, xs(i), ys1(i) );
+
+        u2: entity work.elab41_pe
+            generic map ( SCALE => 3, TAG => 'y' )
+            port map ( clk => clk, x => i * 2, y => ys2(i), z => zs(i) );
+    end generate;
+
+    check: process is
+    begin
+        wait for 200 ns;
+        for i in 1 to N loop
+            assert ys1(i) = 20 * i
+                report "ys1(" & integer'image(i) & ") = "
+                & integer'image(ys1(i)) severity failure;
+            assert ys2(i) = 120 * i
+                report "ys2(" & integer'image(i) & ") = "
+                & integer'image(ys2(i)) severity failure;
+            assert zs(i) = ys2(i) + 1
+                report "zs(" & integer'image(i) & ") = "
+                & integer'image(zs(i)) severity failure;
+        end loop;
+        wait;
+    end process;
+
+end architecture;
@@ -0,0 +1,52 @@
+entity fanout1 is
+end entity;
+
+architecture test of fanout1 is
+    constant N : positive := 200;
+
+    type int_vector is array (natural range <>) of integer;
+
+    signal clk, rst : bit := '0';
+    signal counts   : int_vector(1 to N);
+begin
+
+    clkgen: clk <= not clk after 5 ns when now < 500 ns;
+
+    g: for i in 1 to N generate
+        p: process (clk, rst) is
+        begin
+            if rst = '1' then
+                counts(i) <= 0;
+            elsif clk'event and clk = '1' then
+                counts(i) <= counts(i) + i;
+            end if;
+        end process;
+
+        -- Remove half the processes from the clock sensitivity while
+        -- waiting on the reset only
+        odd: if i mod 2 = 1 generate
+            q: process is
+            begin
+                wait until clk = '1';
+                wait on rst;
+                report "unexpected wakeup" severity failure;
+            end process;
+        end generate;
+    end generate;
+
+    check: process is
+    begin
+        rst <= '1';
+        wait for 1 ns;
+        rst <= '0';
+        wait for 1 us;
+        for i in 1 to N loop
+            assert counts(i) = i * 50
+                report "counts(" & integer'image(i) & ") = "
+                & integer'image(counts(i)) severity failure;
+        end loop;
+        report "done";
+        wait;
+    end process;
+
+end architecture;
@@ -0,0 +1,219 @@
+-- Compare the fixed_pkg and float_pkg intrinsics against the VHDL
+-- reference implementation in identical local instances
+
+library ieee;
+
+package ref_fixed is new ieee.fixed_generic_pkg
+    generic map (
+        fixed_round_style    => ieee.fixed_float_types.fixed_round,
+        fixed_overflow_style => ieee.fixed_float_types.fixed_saturate,
+        fixed_guard_bits     => 3,
+        no_warning           => false );
+
+-------------------------------------------------------------------------------
+
+library ieee;
+
+package ref_float is new ieee.float_generic_pkg
+    generic map (
+        float_exponent_width => 8,
+        float_fraction_width => 23,
+        float_round_style    => ieee.fixed_float_types.round_nearest,
+        float_denormalize    => true,
+        float_check_error    => true,
+        float_guard_bits     => 3,
+        no_warning           => false,
+        fixed_pkg            => ieee.fixed_pkg );
+
+-------------------------------------------------------------------------------
+
+entity ieee18 is
+end entity;
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.math_real.all;
+use ieee.fixed_float_types.all;
+use ieee.fixed_pkg.all;
+use ieee.float_pkg.all;
+use work.ref_fixed;
+use work.ref_float;
+
+architecture test of ieee18 is
+
+    procedure check (got, want : std_ulogic_vector; what : string) is
+    begin
+        assert got = want
+            report what & ": got " & to_string(got) & " expected "
+            & to_string(want)
+            severity failure;
+    end procedure;
+
+begin
+
+    main: process is
+        variable s1, s2   : positive := 42;
+
+        impure function random_real (scale : real) return real is
+            variable r : real;
+        begin
+            uniform(s1, s2, r);
+            return (r - 0.5) * scale;
+        end function;
+
+        impure function random_bits (n : natural) return std_ulogic_vector is
+            variable v : std_ulogic_vector(1 to n);
+        begin
+            for i in v'range loop
+                v(i) := '1' when random_real(1.0) > 0.0 else '0';
+            end loop;
+            return v;
+        end function;
+
+        impure function random_int (lo, hi : integer) return integer is
+            variable r : real;
+        begin
+            uniform(s1, s2, r);
+            return lo + integer(floor(r * real(hi - lo + 1)));
+        end function;
+
+        variable ua      : ufixed(7 downto -5);
+        variable ub      : ufixed(3 downto -9);
+        variable sa      : sfixed(7 downto -5);
+        variable sb      : sfixed(12 downto 2);
+        variable rua     : ref_fixed.ufixed(7 downto -5);
+        variable rub     : ref_fixed.ufixed(3 downto -9);
+        variable rsa     : ref_fixed.sfixed(7 downto -5);
+        variable rsb     : ref_fixed.sfixed(12 downto 2);
+        variable left    : integer;
+        variable right   : integer;
+        variable ovf     : fixed_overflow_style_type;
+        variable rnd     : fixed_round_style_type;
+        variable guard   : natural;
+        variable x       : real;
+        variable n       : integer;
+        variable fa, fb  : float32;
+        variable ra, rb  : ref_float.float32;
+        variable da, db  : float64;
+        variable rda     : ref_float.float64;
+        variable rdb     : ref_float.float64;
+    begin
+        for i in 1 to 2000 loop
+            ua := to_ufixed(random_bits(ua'length), ua'high, ua'low);
+            ub := to_ufixed(random_bits(ub'length), ub'high, ub'low);
+            sa := to_sfixed(random_bits(sa'length), sa'high, sa'low);
+            sb := to_sfixed(random_bits(sb'length), sb'high, sb'low);
+
+            if i mod 100 = 0 then
+                ua(0) := 'X';           -- Metavalues propagate
+                sb(5) := 'H';
+            end if;
+
+            rua := ref_fixed.to_ufixed(to_slv(ua), ua'high, ua'low);
+            rub := ref_fixed.to_ufixed(to_slv(ub), ub'high, ub'low);
+            rsa := ref_fixed.to_sfixed(to_slv(sa), sa'high, sa'low);
+            rsb := ref_fixed.to_sfixed(to_slv(sb), sb'high, sb'low);
+
+            check(to_slv(ua + ub), ref_fixed.to_slv(ref_fixed."+"(rua, rub)),
+                  "ufixed +");
+            check(to_slv(ua - ub), ref_fixed.to_slv(ref_fixed."-"(rua, rub)),
+                  "ufixed -");
+            check(to_slv(ua * ub), ref_fixed.to_slv(ref_fixed."*"(rua, rub)),
+                  "ufixed *");
+            check(to_slv(sa + sb), ref_fixed.to_slv(ref_fixed."+"(rsa, rsb)),
+                  "sfixed +");
+            check(to_slv(sa - sb), ref_fixed.to_slv(ref_fixed."-"(rsa, rsb)),
+                  "sfixed -");
+            check(to_slv(sa * sb), ref_fixed.to_slv(ref_fixed."*"(rsa, rsb)),
+                  "sfixed *");
+
+            left  := random_int(-8, 16);
+            right := left - random_int(0, 16);
+            ovf   := fixed_overflow_style_type'val(random_int(0, 1));
+            rnd   := fixed_round_style_type'val(random_int(0, 1));
+
+            check(to_slv(resize(ua, left, right, ovf, rnd)),
+                  ref_fixed.to_slv(ref_fixed.resize(rua, left, right, ovf,
+                                                    rnd)),
+                  "ufixed resize");
+            check(to_slv(resize(sa, left, right, ovf, rnd)),
+                  ref_fixed.to_slv(ref_fixed.resize(rsa, left, right, ovf,
+                                                    rnd)),
+                  "sfixed resize");
+            check(to_slv(resize(sb, left, right, ovf, rnd)),
+                  ref_fixed.to_slv(ref_fixed.resize(rsb, left, right, ovf,
+                                                    rnd)),
+                  "sfixed resize");
+
+            left  := random_int(0, 20);
+            right := left - random_int(0, 24);
+            guard := random_int(0, 4);
+
+            x := random_real(2.0 ** left);
+            check(to_slv(to_sfixed(x, left, right, ovf, rnd, guard)),
+                  ref_fixed.to_slv(ref_fixed.to_sfixed(x, left, right, ovf,
+                                                       rnd, guard)),
+                  "to_sfixed real " & real'image(x));
+            x := abs x;
+            check(to_slv(to_ufixed(x, left, right, ovf, rnd, guard)),
+                  ref_fixed.to_slv(ref_fixed.to_ufixed(x, left, right, ovf,
+                                                       rnd, guard)),
+                  "to_ufixed real " & real'image(x));
+
+            n := integer(random_real(2.0 ** left));
+            check(to_slv(to_sfixed(n, left, right, ovf, rnd)),
+                  ref_fixed.to_slv(ref_fixed.to_sfixed(n, left, right, ovf,
+                                                       rnd)),
+                  "to_sfixed integer " & integer'image(n));
+            n := abs n;
+            check(to_slv(to_ufixed(n, left, right, ovf, rnd)),
+                  ref_fixed.to_slv(ref_fixed.to_ufixed(n, left, right, ovf,
+                                                       rnd)),
+                  "to_ufixed integer " & integer'image(n));
+        end loop;
+
+        for i in 1 to 1000 loop
+            if i mod 10 = 0 then
+                -- Includes denormals, infinities, and NaNs
+                fa := to_float(random_bits(32), 8, 23);
+                fb := to_float(random_bits(32), 8, 23);
+            else
+                fa := to_float(random_real(2.0 ** random_int(-20, 20)), 8, 23);
+                fb := to_float(random_real(2.0 ** random_int(-20, 20)), 8, 23);
+            end if;
+
+            if i mod 50 = 0 then
+                fb := fa;
+            end if;
+
+            ra := ref_float.to_float(to_slv(fa), 8, 23);
+            rb := ref_float.to_float(to_slv(fb), 8, 23);
+
+            check(to_slv(fa + fb), ref_float.to_slv(ref_float."+"(ra, rb)),
+                  "float32 +");
+            check(to_slv(fa - fb), ref_float.to_slv(ref_float."-"(ra, rb)),
+                  "float32 -");
+            check(to_slv(fa * fb), ref_float.to_slv(ref_float."*"(ra, rb)),
+                  "float32 *");
+
+            da := to_float(random_bits(64), 11, 52);
+            db := to_float(random_real(2.0 ** random_int(-500, 500)), 11, 52);
+
+            if i mod 10 /= 0 then
+                da(10) := not da(9);    -- Keep exponent in range
+            end if;
+
+            rda := ref_float.to_float(to_slv(da), 11, 52);
+            rdb := ref_float.to_float(to_slv(db), 11, 52);
+
+            check(to_slv(da + db), ref_float.to_slv(ref_float."+"(rda, rdb)),
+                  "float64 +");
+            check(to_slv(da - db), ref_float.to_slv(ref_float."-"(rda, rdb)),
+                  "float64 -");
+            check(to_slv(da * db), ref_float.to_slv(ref_float."*"(rda, rdb)),
+                  "float64 *");
+        end loop;
+        wait;
+    end process;
+
+end architecture;
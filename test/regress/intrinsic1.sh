@@ -0,0 +1,7 @@
+set -xe
+
+nvc --std=2008 -a $TESTDIR/regress/intrinsic1.vhd -e intrinsic1
+
+# The vector kernels must agree with the scalar code
+NVC_VECTOR_INTRINSICS=1 nvc -r intrinsic1
+NVC_VECTOR_INTRINSICS=0 nvc -r intrinsic1
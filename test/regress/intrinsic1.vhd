@@ -0,0 +1,115 @@
+-- Compare the numeric_std "+" and "*" intrinsics against a bit-serial
+-- reference at widths around the vector and limb boundaries
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+use ieee.math_real.all;
+
+entity intrinsic1 is
+end entity;
+
+architecture test of intrinsic1 is
+
+    type int_vector is array (natural range <>) of positive;
+
+    constant WIDTHS : int_vector := (31, 32, 33, 63, 64, 65, 128, 129);
+    constant ROUNDS : positive := 50;
+
+    -- Sum modulo 2**N where both arguments have length N
+    function ref_add (a, b : std_logic_vector) return std_logic_vector is
+        alias aa : std_logic_vector(a'length - 1 downto 0) is a;
+        alias bb : std_logic_vector(b'length - 1 downto 0) is b;
+        variable r : std_logic_vector(a'length - 1 downto 0);
+        variable c : std_logic := '0';
+    begin
+        for i in 0 to a'length - 1 loop
+            r(i) := aa(i) xor bb(i) xor c;
+            c := (aa(i) and bb(i)) or (c and (aa(i) xor bb(i)));
+        end loop;
+        return r;
+    end function;
+
+    -- Product modulo 2**N where both arguments have length N
+    function ref_mul (a, b : std_logic_vector) return std_logic_vector is
+        alias bb : std_logic_vector(b'length - 1 downto 0) is b;
+        variable r, s : std_logic_vector(a'length - 1 downto 0);
+    begin
+        r := (others => '0');
+        s := a;
+        for i in 0 to b'length - 1 loop
+            if bb(i) = '1' then
+                r := ref_add(r, s);
+            end if;
+            s := s(s'left - 1 downto 0) & '0';
+        end loop;
+        return r;
+    end function;
+
+    function zext (x : std_logic_vector; n : natural) return std_logic_vector is
+    begin
+        return (1 to n - x'length => '0') & x;
+    end function;
+
+    function sext (x : std_logic_vector; n : natural) return std_logic_vector is
+    begin
+        return (1 to n - x'length => x(x'left)) & x;
+    end function;
+
+begin
+
+    check: process is
+        variable s1, s2 : positive := 42;
+
+        impure function random_vector (n : positive) return std_logic_vector is
+            variable r : real;
+            variable v : std_logic_vector(n - 1 downto 0);
+        begin
+            for i in v'range loop
+                uniform(s1, s2, r);
+                v(i) := '1' when r > 0.5 else '0';
+            end loop;
+            return v;
+        end function;
+
+        procedure check_pair (a, b : std_logic_vector) is
+            constant n : positive := a'length;
+        begin
+            assert std_logic_vector(unsigned(a) + unsigned(b)) = ref_add(a, b)
+                report "unsigned + failed at width " & integer'image(n)
+                severity failure;
+            assert std_logic_vector(signed(a) + signed(b)) = ref_add(a, b)
+                report "signed + failed at width " & integer'image(n)
+                severity failure;
+            assert std_logic_vector(unsigned(a) * unsigned(b))
+                = ref_mul(zext(a, 2 * n), zext(b, 2 * n))
+                report "unsigned * failed at width " & integer'image(n)
+                severity failure;
+            assert std_logic_vector(signed(a) * signed(b))
+                = ref_mul(sext(a, 2 * n), sext(b, 2 * n))
+                report "signed * failed at width " & integer'image(n)
+                severity failure;
+        end procedure;
+
+        procedure check_width (n : positive) is
+            constant zeros : std_logic_vector(n - 1 downto 0) := (others => '0');
+            constant ones  : std_logic_vector(n - 1 downto 0) := (others => '1');
+            constant min   : std_logic_vector(n - 1 downto 0) := '1' & zeros(n - 2 downto 0);
+        begin
+            check_pair(ones, ones);
+            check_pair(min, min);
+            check_pair(min, ones);
+            check_pair(ones, zeros);
+            for i in 1 to ROUNDS loop
+                check_pair(random_vector(n), random_vector(n));
+            end loop;
+        end procedure;
+    begin
+        for i in WIDTHS'range loop
+            check_width(WIDTHS(i));
+        end loop;
+        report "checked " & integer'image(WIDTHS'length) & " widths";
+        wait;
+    end process;
+
+end architecture;
@@ -0,0 +1,42 @@
+set -xe
+
+nvc -a - <<EOF
+entity jitcache1 is
+end entity;
+
+architecture test of jitcache1 is
+    function triangle (n : natural) return natural is
+        variable sum : natural := 0;
+    begin
+        for i in 1 to n loop
+            sum := sum + i;
+        end loop;
+        return sum;
+    end function;
+begin
+    p: process is
+    begin
+        report "sum=" & integer'image(triangle(100));
+        wait;
+    end process;
+end architecture;
+EOF
+
+nvc -e --jit jitcache1
+
+export NVC_JIT_CACHE=$(pwd)/cache
+export NVC_JIT_THRESHOLD=1
+export NVC_JIT_ASYNC=0
+export NVC_JIT_LOG=1
+
+nvc -r jitcache1 2>first.txt
+grep "sum=5050" first.txt
+ls cache >first.lst
+[ -s first.lst ]
+
+# The second run should load all the code from the cache
+nvc -r jitcache1 2>second.txt
+grep "sum=5050" second.txt
+grep ", cached" second.txt
+ls cache >second.lst
+diff -u first.lst second.lst
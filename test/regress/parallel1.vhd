@@ -0,0 +1,59 @@
+entity parallel1 is
+end entity;
+
+architecture test of parallel1 is
+    constant N : natural := 256;
+
+    type int_vector is array (natural range <>) of integer;
+
+    signal clk    : bit := '0';
+    signal counts : int_vector(0 to N - 1) := (others => 0);
+    signal sums   : int_vector(0 to N - 1) := (others => 0);
+    signal done   : boolean := false;
+begin
+
+    clk <= not clk after 5 ns when not done;
+
+    g: for i in 0 to N - 1 generate
+
+        counter: process (clk) is
+        begin
+            if clk'event and clk = '1' then
+                counts(i) <= counts(i) + 1;
+            end if;
+        end process;
+
+        -- Woken in the delta cycle after every counter update
+        accum: process (counts(i)) is
+            variable total : integer := 0;
+        begin
+            for j in 1 to 10 loop
+                total := total + counts(i) mod j;
+            end loop;
+            sums(i) <= total;
+        end process;
+
+    end generate;
+
+    check: process is
+        variable expect : integer := 0;
+    begin
+        for k in 1 to 100 loop
+            wait until clk = '1';
+            wait for 1 ns;
+            for j in 1 to 10 loop
+                expect := expect + k mod j;
+            end loop;
+            for i in 0 to N - 1 loop
+                assert counts(i) = k;
+                assert sums(i) = expect
+                    report "sums(" & integer'image(i) & ") = "
+                    & integer'image(sums(i)) & " expected "
+                    & integer'image(expect);
+            end loop;
+        end loop;
+        done <= true;
+        wait;
+    end process;
+
+end architecture;
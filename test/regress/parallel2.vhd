@@ -0,0 +1,36 @@
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+entity parallel2 is
+end entity;
+
+architecture test of parallel2 is
+    constant N : natural := 160;
+
+    type slv_vector is array (natural range <>) of std_logic_vector(31 downto 0);
+
+    signal sel  : natural range 0 to N - 1 := 0;
+    signal bus1 : std_logic_vector(31 downto 0);
+    signal bus2 : std_logic_vector(31 downto 0);
+begin
+
+    g: for i in 0 to N - 1 generate
+        bus1 <= std_logic_vector(to_unsigned(i * 3, 32)) when sel = i
+                else (others => 'Z');
+        bus2 <= (others => 'H') when sel = i else (others => 'Z');
+    end generate;
+
+    check: process is
+    begin
+        for i in 0 to N - 1 loop
+            sel <= i;
+            wait for 1 ns;
+            assert bus1 = std_logic_vector(to_unsigned(i * 3, 32))
+                report "bad value for " & integer'image(i);
+            assert bus2 = (31 downto 0 => 'H');
+        end loop;
+        wait;
+    end process;
+
+end architecture;
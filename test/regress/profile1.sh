@@ -0,0 +1,11 @@
+set -xe
+
+nvc -a $TESTDIR/regress/profile1.vhd -e profile1 \
+    -r --profile=stacks.txt profile1 >out.txt
+
+cat out.txt
+grep "PROCESS" out.txt
+grep -i "counter" out.txt
+grep "SIGNAL" out.txt
+grep -i "count\b" out.txt
+test -f stacks.txt
@@ -0,0 +1,25 @@
+entity profile1 is
+end entity;
+
+architecture test of profile1 is
+    signal clk   : bit := '0';
+    signal count : natural;
+begin
+
+    clkgen: clk <= not clk after 5 ns when now < 1 us;
+
+    counter: process (clk) is
+    begin
+        if clk'event and clk = '1' then
+            count <= count + 1;
+        end if;
+    end process;
+
+    check: process is
+    begin
+        wait for 2 us;
+        assert count = 100;
+        wait;
+    end process;
+
+end architecture;
@@ -0,0 +1,15 @@
+set -xe
+
+# Resolution calls made on worker threads with --parallel should be
+# counted the same as those made serially
+nvc --std=2008 -a $TESTDIR/regress/parallel2.vhd -e parallel2
+
+nvc --std=2008 -r --profile parallel2 >serial.txt
+nvc --std=2008 -r --parallel --profile parallel2 >parallel.txt
+
+sed -n '/RESOLUTIONS/,$p' serial.txt >serial.sig
+sed -n '/RESOLUTIONS/,$p' parallel.txt >parallel.sig
+
+cat parallel.sig
+grep "161  :parallel2:BUS1" parallel.sig
+diff -u serial.sig parallel.sig
@@ -97,6 +97,8 @@
 #define F_SHUFFLE (1 << 24)
 #define F_NOTBSD  (1 << 25)
 #define F_ARRAYS  (1 << 26)
+#define F_PARALL  (1 << 27)
+#define F_AOT     (1 << 28)
 
 typedef struct test test_t;
 typedef struct param param_t;
@@ -403,6 +405,10 @@ static bool parse_test_list(void)
             test->flags |= F_TCL;
          else if (strcmp(opt, "shuffle") == 0)
             test->flags |= F_SHUFFLE;
+         else if (strcmp(opt, "parallel") == 0)
+            test->flags |= F_PARALL;
+         else if (strcmp(opt, "aot") == 0)
+            test->flags |= F_AOT;
          else if (strcmp(opt, "no-collapse") == 0)
             test->flags |= F_NOCOLL;
          else if (strcmp(opt, "dump-arrays") == 0)
@@ -782,7 +788,7 @@ static bool run_test(test_t *test)
    skip |= (test->flags & F_NOTBSD);
 #endif
 #ifndef HAVE_LLVM
-   skip |= (test->flags & F_SLOW);
+   skip |= (test->flags & (F_SLOW | F_AOT));
 #else
    if (force_jit) skip |= (test->flags & F_SLOW);
 #endif
@@ -900,6 +906,9 @@ static bool run_test(test_t *test)
       if (test->flags & F_NOCOLL)
          push_arg(&args, "--no-collapse");
 
+      if (test->flags & F_AOT)
+         push_arg(&args, "--aot");
+
       if (test->flags & F_COVER) {
          if (test->cover)
             push_arg(&args, "--cover=%s", test->cover);
@@ -959,6 +968,9 @@ static bool run_test(test_t *test)
       if (test->flags & F_SHUFFLE)
          push_arg(&args, "--shuffle");
 
+      if (test->flags & F_PARALL)
+         push_arg(&args, "--parallel");
+
       if (test->plusarg != NULL)
          push_arg(&args, "+%s", test->plusarg);
 
@@ -2048,6 +2048,379 @@ START_TEST(test_lscan1)
 }
 END_TEST
 
+static int tierup_count = 0;
+
+static void *tierup_init(jit_t *j)
+{
+   return NULL;
+}
+
+static void tierup_cgen(jit_t *j, jit_handle_t handle, void *context)
+{
+   tierup_count++;
+}
+
+static void tierup_cleanup(void *context)
+{
+}
+
+START_TEST(test_tierup1)
+{
+   opt_set_int(OPT_JIT_ASYNC, 0);
+
+   jit_t *j = jit_new(NULL);
+
+   const jit_plugin_t plugin = {
+      .init    = tierup_init,
+      .cgen    = tierup_cgen,
+      .cleanup = tierup_cleanup,
+   };
+   jit_add_tier(j, 10, &plugin);
+
+   const char *text1 =
+      "    RECV    R0, #0      \n"
+      "    MOV     R1, #0      \n"
+      "    MOV     R2, #0      \n"
+      "L1: ADD     R1, R1, R2  \n"
+      "    ADD     R2, R2, #1  \n"
+      "    CMP.LT  R2, R0      \n"
+      "    JUMP.T  L1          \n"
+      "    SEND    #0, R1      \n"
+      "    RET                 \n";
+
+   jit_handle_t h1 = jit_assemble(j, ident_new("myfunc1"), text1);
+
+   tlab_t tlab = jit_null_tlab(j);
+   jit_scalar_t result, p0 = { .integer = 100 };
+   fail_unless(jit_fastcall(j, h1, &result, p0, p0, &tlab));
+   ck_assert_int_eq(result.integer, 4950);
+
+   // Loop iterations count towards the threshold
+   ck_assert_int_eq(tierup_count, 1);
+
+   jit_func_t *f = jit_get_func(j, h1);
+   ck_assert_ptr_nonnull(f->profile);
+   ck_assert_int_eq(f->profile->calls, 1);
+   ck_assert_int_eq(f->profile->irs[6].hits, 100);
+   ck_assert_int_eq(f->profile->irs[6].taken, 99);
+
+   jit_free(j);
+}
+END_TEST
+
+START_TEST(test_inline1)
+{
+   jit_t *j = jit_new(NULL);
+
+   const char *text1 =
+      "    RECV    R0, #0      \n"
+      "    ADD     R1, R0, #1  \n"
+      "    SEND    #0, R1      \n"
+      "    RET                 \n";
+
+   jit_assemble(j, ident_new("myfunc2"), text1);
+
+   const char *text2 =
+      "    RECV    R0, #0      \n"
+      "    SEND    #0, R0      \n"
+      "    CALL    <myfunc2>   \n"
+      "    RECV    R1, #0      \n"
+      "    MUL     R2, R1, #2  \n"
+      "    SEND    #0, R2      \n"
+      "    RET                 \n";
+
+   jit_handle_t h1 = jit_assemble(j, ident_new("myfunc1"), text2);
+
+   jit_func_t *f = jit_get_func(j, h1);
+   jit_do_inline(f);
+
+   ck_assert_int_eq(f->nirs, 10);
+   ck_assert_int_eq(f->nregs, 5);
+   ck_assert_int_eq(f->ninlines, 1);
+   ck_assert_int_eq(f->inlines[0].first, 2);
+   ck_assert_int_eq(f->inlines[0].last, 5);
+   ck_assert_int_eq(f->inlines[0].parent, -1);
+
+   check_unary(f, 2, J_RECV, CONST(0));
+   check_binary(f, 3, J_ADD, REG(3), CONST(1));
+   check_unary(f, 5, J_JUMP, LABEL(6));
+
+   tlab_t tlab = jit_null_tlab(j);
+   jit_scalar_t result, p0 = { .integer = 5 };
+   fail_unless(jit_fastcall(j, h1, &result, p0, p0, &tlab));
+   ck_assert_int_eq(result.integer, 12);
+
+   jit_free(j);
+}
+END_TEST
+
+START_TEST(test_gvn1)
+{
+   jit_t *j = jit_new(NULL);
+
+   const char *text1 =
+      "    RECV    R0, #0      \n"
+      "    RECV    R1, #1      \n"
+      "    ADD     R2, R0, R1  \n"
+      "    CMP.GT  R0, #0      \n"
+      "    JUMP.T  L1          \n"
+      "    MUL     R3, R0, R1  \n"
+      "    ADD     R4, R1, R0  \n"
+      "    SEND    #0, R4      \n"
+      "    RET                 \n"
+      "L1: MUL     R5, R1, R0  \n"
+      "    ADD     R6, R5, R2  \n"
+      "    SEND    #0, R6      \n"
+      "    RET                 \n";
+
+   jit_handle_t h1 = jit_assemble(j, ident_new("myfunc1"), text1);
+
+   jit_func_t *f = jit_get_func(j, h1);
+   jit_do_gvn(f);
+
+   check_unary(f, 6, J_MOV, REG(2));
+   check_binary(f, 9, J_MUL, REG(1), REG(0));   // Not dominated
+
+   tlab_t tlab = jit_null_tlab(j);
+   jit_scalar_t result, p0 = { .integer = 5 }, p1 = { .integer = 3 };
+   fail_unless(jit_fastcall(j, h1, &result, p0, p1, &tlab));
+   ck_assert_int_eq(result.integer, 23);
+
+   jit_free(j);
+}
+END_TEST
+
+START_TEST(test_licm1)
+{
+   jit_t *j = jit_new(NULL);
+
+   const char *text1 =
+      "    RECV    R0, #0      \n"
+      "    RECV    R1, #1      \n"
+      "    MOV     R2, #0      \n"
+      "    MOV     R3, #0      \n"
+      "L1: MUL     R4, R1, #4  \n"
+      "    ADD     R2, R2, R4  \n"
+      "    ADD     R3, R3, #1  \n"
+      "    CMP.LT  R3, R0      \n"
+      "    JUMP.T  L1          \n"
+      "    SEND    #0, R2      \n"
+      "    RET                 \n";
+
+   jit_handle_t h1 = jit_assemble(j, ident_new("myfunc1"), text1);
+
+   jit_func_t *f = jit_get_func(j, h1);
+   jit_do_licm(f);
+
+   ck_assert_int_eq(f->nirs, 12);
+   check_binary(f, 4, J_MUL, REG(1), CONST(4));
+   ck_assert_int_eq(f->irbuf[5].op, J_NOP);
+   check_unary(f, 9, J_JUMP, LABEL(5));
+
+   tlab_t tlab = jit_null_tlab(j);
+   jit_scalar_t result, p0 = { .integer = 10 }, p1 = { .integer = 3 };
+   fail_unless(jit_fastcall(j, h1, &result, p0, p1, &tlab));
+   ck_assert_int_eq(result.integer, 120);
+
+   jit_free(j);
+}
+END_TEST
+
+START_TEST(test_licm2)
+{
+   jit_t *j = jit_new(NULL);
+
+   const char *text1 =
+      "    RECV    R0, #0      \n"
+      "    RECV    R1, #1      \n"
+      "    MOV     R2, #0      \n"
+      "    MOV     R3, #0      \n"
+      "L1: CMP.GE  R1, #0      \n"
+      "    JUMP.T  L2          \n"
+      "    SEND    #0, R1      \n"
+      "    $EXIT   #0          \n"
+      "L2: ADD     R2, R2, R1  \n"
+      "    ADD     R3, R3, #1  \n"
+      "    CMP.LT  R3, R0      \n"
+      "    JUMP.T  L1          \n"
+      "    SEND    #0, R2      \n"
+      "    RET                 \n";
+
+   jit_handle_t h1 = jit_assemble(j, ident_new("myfunc1"), text1);
+
+   jit_func_t *f = jit_get_func(j, h1);
+   jit_do_licm(f);
+
+   // Check moved before the loop
+   ck_assert_int_eq(f->nirs, 18);
+   check_binary(f, 4, J_CMP, REG(1), CONST(0));
+   check_unary(f, 5, J_JUMP, LABEL(8));
+   ck_assert_int_eq(f->irbuf[8].op, J_NOP);
+   ck_assert_int_eq(f->irbuf[9].op, J_NOP);
+   ck_assert_int_eq(f->irbuf[10].op, J_NOP);
+   ck_assert_int_eq(f->irbuf[11].op, J_NOP);
+   check_unary(f, 15, J_JUMP, LABEL(8));
+
+   tlab_t tlab = jit_null_tlab(j);
+   jit_scalar_t result, p0 = { .integer = 5 }, p1 = { .integer = 2 };
+   fail_unless(jit_fastcall(j, h1, &result, p0, p1, &tlab));
+   ck_assert_int_eq(result.integer, 10);
+
+   jit_free(j);
+}
+END_TEST
+
+START_TEST(test_bce1)
+{
+   jit_t *j = jit_new(NULL);
+
+   const char *text1 =
+      "    RECV    R0, #0      \n"
+      "    RECV    R1, #1      \n"
+      "    CMP.GE  R0, #0      \n"
+      "    CCMP.LE R0, R1      \n"
+      "    JUMP.T  L1          \n"
+      "    SEND    #0, R0      \n"
+      "    $EXIT   #0          \n"
+      "L1: AND     R2, R0, #7  \n"
+      "    CMP.GE  R2, #0      \n"
+      "    CCMP.LE R2, #7      \n"
+      "    JUMP.T  L2          \n"
+      "    SEND    #0, R2      \n"
+      "    $EXIT   #0          \n"
+      "L2: CMP.GE  R0, #0      \n"
+      "    CCMP.LE R0, R1      \n"
+      "    JUMP.T  L3          \n"
+      "    SEND    #0, R0      \n"
+      "    $EXIT   #0          \n"
+      "L3: CMP.GE  R0, #1      \n"
+      "    CCMP.LE R0, R1      \n"
+      "    JUMP.T  L4          \n"
+      "    SEND    #0, R0      \n"
+      "    $EXIT   #0          \n"
+      "L4: ADD     R3, R0, R2  \n"
+      "    SEND    #0, R3      \n"
+      "    RET                 \n";
+
+   jit_handle_t h1 = jit_assemble(j, ident_new("myfunc1"), text1);
+
+   jit_func_t *f = jit_get_func(j, h1);
+   ck_assert_int_eq(jit_do_bce(f), 2);
+
+   for (int i = 8; i < 18; i++)
+      ck_assert_int_eq(f->irbuf[i].op, J_NOP);
+
+   check_binary(f, 2, J_CMP, REG(0), CONST(0));
+   check_binary(f, 18, J_CMP, REG(0), CONST(1));   // Lower bound differs
+
+   tlab_t tlab = jit_null_tlab(j);
+   jit_scalar_t result, p0 = { .integer = 5 }, p1 = { .integer = 10 };
+   fail_unless(jit_fastcall(j, h1, &result, p0, p1, &tlab));
+   ck_assert_int_eq(result.integer, 10);
+
+   jit_free(j);
+}
+END_TEST
+
+START_TEST(test_bce2)
+{
+   jit_t *j = jit_new(NULL);
+
+   const char *text1 =
+      "    RECV    R0, #0      \n"
+      "    MOV     R1, #0      \n"
+      "    MOV     R2, #0      \n"
+      "L1: CMP.GE  R1, #8      \n"
+      "    JUMP.T  L3          \n"
+      "    CMP.GE  R1, #0      \n"
+      "    CCMP.LE R1, #7      \n"
+      "    JUMP.T  L2          \n"
+      "    SEND    #0, R1      \n"
+      "    $EXIT   #0          \n"
+      "L2: ADD     R2, R2, R1  \n"
+      "    ADD     R1, R1, #1  \n"
+      "    CMP.GE  R1, #1      \n"
+      "    CCMP.LE R1, #8      \n"
+      "    JUMP.T  L1          \n"
+      "    SEND    #0, R1      \n"
+      "    $EXIT   #0          \n"
+      "L3: ADD     R3, R2, R0  \n"
+      "    SEND    #0, R3      \n"
+      "    RET                 \n";
+
+   jit_handle_t h1 = jit_assemble(j, ident_new("myfunc1"), text1);
+
+   jit_func_t *f = jit_get_func(j, h1);
+
+   // The induction variable is in the range 0 to 8 and less than 8
+   // inside the loop body
+   ck_assert_int_eq(jit_do_bce(f), 2);
+
+   for (int i = 5; i < 10; i++)
+      ck_assert_int_eq(f->irbuf[i].op, J_NOP);
+
+   ck_assert_int_eq(f->irbuf[12].op, J_NOP);
+   ck_assert_int_eq(f->irbuf[13].op, J_NOP);
+   check_unary(f, 14, J_JUMP, LABEL(3));
+   ck_assert_int_eq(f->irbuf[14].cc, JIT_CC_NONE);
+
+   tlab_t tlab = jit_null_tlab(j);
+   jit_scalar_t result, p0 = { .integer = 100 };
+   fail_unless(jit_fastcall(j, h1, &result, p0, p0, &tlab));
+   ck_assert_int_eq(result.integer, 128);
+
+   jit_free(j);
+}
+END_TEST
+
+START_TEST(test_interp1)
+{
+   jit_t *j = jit_new(NULL);
+
+   const char *text1 =
+      "    RECV     R0, #0       \n"
+      "    RECV     R1, #1       \n"
+      "    MOV      R2, #0       \n"
+      "    MOV      R3, #0       \n"
+      "    MOV      R5, #0       \n"
+      "L1: CMP.GE   R3, R1       \n"
+      "    JUMP.T   L3           \n"
+      "    LOAD.32  R4, [R0]     \n"
+      "    ADD      R2, R2, R4   \n"
+      "    CLAMP    R6, R4       \n"
+      "    CMP.EQ   R6, #0       \n"
+      "    JUMP.T   L2           \n"
+      "    ADD      R5, R5, #1   \n"
+      "L2: STORE.32 R6, [R0]     \n"
+      "    STORE.8  #1, [R0+3]   \n"
+      "    ADD      R0, R0, #4   \n"
+      "    ADD      R3, R3, #1   \n"
+      "    JUMP     L1           \n"
+      "L3: MUL      R7, R5, #1000 \n"
+      "    ADD      R7, R7, R2   \n"
+      "    SEND     #0, R7       \n"
+      "    RET                   \n";
+
+   jit_handle_t h1 = jit_assemble(j, ident_new("myfunc1"), text1);
+
+   int32_t data[] = { 5, -3, 0, 7, -1, 2, 9, -4 };
+
+   tlab_t tlab = jit_null_tlab(j);
+   jit_scalar_t result, p0 = { .pointer = data }, p1 = { .integer = 8 };
+   fail_unless(jit_fastcall(j, h1, &result, p0, p1, &tlab));
+   ck_assert_int_eq(result.integer, 4015);
+
+   const int32_t expect[] = {
+      0x1000005, 0x1000000, 0x1000000, 0x1000007,
+      0x1000000, 0x1000002, 0x1000009, 0x1000000
+   };
+   for (int i = 0; i < ARRAY_LEN(expect); i++)
+      ck_assert_int_eq(data[i], expect[i]);
+
+   jit_free(j);
+}
+END_TEST
+
 Suite *get_jit_tests(void)
 {
    Suite *s = suite_create("jit");
@@ -2104,6 +2477,14 @@ Suite *get_jit_tests(void)
    tcase_add_test(tc, test_cprop2);
    tcase_add_test(tc, test_mem2reg1);
    tcase_add_test(tc, test_lscan1);
+   tcase_add_test(tc, test_tierup1);
+   tcase_add_test(tc, test_inline1);
+   tcase_add_test(tc, test_gvn1);
+   tcase_add_test(tc, test_licm1);
+   tcase_add_test(tc, test_licm2);
+   tcase_add_test(tc, test_bce1);
+   tcase_add_test(tc, test_bce2);
+   tcase_add_test(tc, test_interp1);
    suite_add_tcase(s, tc);
 
    return s;
@@ -17,6 +17,7 @@
 
 #include "test_util.h"
 #include "common.h"
+#include "diag.h"
 #include "lib.h"
 #include "object.h"
 #include "tree.h"
@@ -325,6 +326,140 @@ START_TEST(test_lib_save)
 }
 END_TEST
 
+static tree_t fingerprint_entity(int line, int nliterals)
+{
+   make_new_arena();
+
+   const file_ref_t file = loc_file_ref("fingerprint.vhd", NULL);
+   const loc_t loc = get_loc(line, 1, line, 20, file);
+
+   tree_t ent = tree_new(T_ENTITY);
+   tree_set_ident(ent, ident_new("TEST_LIB.fingerprint"));
+   tree_set_loc(ent, &loc);
+
+   type_t e = type_new(T_ENUM);
+   type_set_ident(e, ident_new("myenum"));
+
+   for (int i = 0; i < nliterals; i++) {
+      char name[] = { '\'', 'a' + i, '\'', '\0' };
+      tree_t lit = tree_new(T_ENUM_LIT);
+      tree_set_ident(lit, ident_new(name));
+      tree_set_type(lit, e);
+      tree_set_pos(lit, i);
+      tree_set_loc(lit, &loc);
+      type_enum_add_literal(e, lit);
+   }
+
+   tree_t p = tree_new(T_PORT_DECL);
+   tree_set_ident(p, ident_new("x"));
+   tree_set_subkind(p, PORT_IN);
+   tree_set_type(p, e);
+   tree_set_loc(p, &loc);
+   tree_add_port(ent, p);
+
+   lib_put(work, ent);
+   return ent;
+}
+
+static tree_t fingerprint_arch(int line, const char *name, tree_t ent)
+{
+   make_new_arena();
+
+   const file_ref_t file = loc_file_ref("fingerprint.vhd", NULL);
+   const loc_t loc = get_loc(line, 1, line, 20, file);
+
+   tree_t ar = tree_new(T_ARCH);
+   tree_set_ident(ar, ident_new(name));
+   tree_set_ident2(ar, ident_new("fingerprint"));
+   tree_set_loc(ar, &loc);
+
+   tree_t pr = tree_new(T_PROCESS);
+   tree_set_ident(pr, ident_new("proc"));
+   tree_add_stmt(ar, pr);
+
+   tree_t r = tree_new(T_REF);
+   tree_set_ident(r, ident_new("x"));
+   tree_set_ref(r, tree_port(ent, 0));
+
+   tree_t s = tree_new(T_VAR_ASSIGN);
+   tree_set_ident(s, ident_new("var_assign"));
+   tree_set_target(s, r);
+   tree_set_value(s, r);
+   tree_add_stmt(pr, s);
+
+   lib_put(work, ar);
+   return ar;
+}
+
+START_TEST(test_lib_fingerprint)
+{
+   const error_t expect[] = {
+      {  5, "design unit TEST_LIB.fingerprint replaces a previously" },
+      { 30, "depends on an obsolete version of TEST_LIB.fingerprint" },
+      { -1, NULL }
+   };
+   expect_errors(expect);
+
+   // Moving the entity in the source file does not change its interface
+   tree_t e1 = fingerprint_entity(1, 2);
+   fingerprint_arch(20, "TEST_LIB.arch1", e1);
+   tree_t e2 = fingerprint_entity(5, 2);
+
+   object_arena_t *a1 = object_arena(tree_to_object(e1));
+   object_arena_t *a2 = object_arena(tree_to_object(e2));
+
+   lib_save(work);
+
+   ck_assert_int_eq(arena_fingerprint(a1), arena_fingerprint(a2));
+   ck_assert_int_eq(error_count(), 0);
+
+   // Adding an enumeration literal does
+   fingerprint_arch(30, "TEST_LIB.arch2", e2);
+   tree_t e3 = fingerprint_entity(5, 3);
+
+   lib_save(work);
+
+   object_arena_t *a3 = object_arena(tree_to_object(e3));
+   ck_assert_int_ne(arena_fingerprint(a2), arena_fingerprint(a3));
+
+   check_expected_errors();
+}
+END_TEST
+
+START_TEST(test_lib_corrupt)
+{
+   make_new_arena();
+
+   tree_t ent = tree_new(T_ENTITY);
+   tree_set_ident(ent, ident_new("TEST_LIB.CORRUPT"));
+   lib_put(work, ent);
+
+   lib_save(work);
+
+   // Flip a byte in the middle of the saved image
+   FILE *f = lib_fopen(work, "TEST_LIB.CORRUPT", "r+b");
+   fail_if(f == NULL);
+   fail_if(fseek(f, 0, SEEK_END) != 0);
+   const long size = ftell(f);
+   fail_if(fseek(f, size / 2, SEEK_SET) != 0);
+   const int byte = fgetc(f);
+   fail_if(byte == EOF);
+   fail_if(fseek(f, size / 2, SEEK_SET) != 0);
+   fputc(byte ^ 0xff, f);
+   fclose(f);
+
+   lib_free(work);
+
+   lib_add_search_path(tmp);
+   work = lib_find(ident_new("test_lib"));
+   fail_if(work == NULL);
+
+   // Should fail with a fatal error as the checksum does not match
+   lib_get(work, ident_new("TEST_LIB.CORRUPT"));
+   ck_abort_msg("loaded corrupt library unit");
+}
+END_TEST
+
 Suite *get_lib_tests(void)
 {
    Suite *s = suite_create("lib");
@@ -334,6 +469,8 @@ Suite *get_lib_tests(void)
    tcase_add_test(tc_core, test_lib_new);
    tcase_add_test(tc_core, test_lib_fopen);
    tcase_add_test(tc_core, test_lib_save);
+   tcase_add_test(tc_core, test_lib_fingerprint);
+   tcase_add_exit_test(tc_core, test_lib_corrupt, 1);
    suite_add_tcase(s, tc_core);
 
    return s;
@@ -22,6 +22,7 @@
 #include "mask.h"
 #include "option.h"
 #include "rt/copy.h"
+#include "rt/eventq.h"
 #include "rt/heap.h"
 #include "thread.h"
 #include "util.h"
@@ -374,6 +375,109 @@ START_TEST(test_heap_delete)
 }
 END_TEST
 
+START_TEST(test_eventq_basic)
+{
+   eventq_t *eq = eventq_new();
+
+   eventq_insert(eq, 5, (void*)1);
+   eventq_insert(eq, 2, (void*)2);
+   eventq_insert(eq, 5, (void*)3);
+   eventq_insert(eq, 62, (void*)4);
+
+   ck_assert_int_eq(eventq_size(eq), 4);
+   ck_assert_int_eq(eventq_min_key(eq), 2);
+
+   ck_assert_ptr_eq(eventq_extract_min(eq), (void*)2);
+   ck_assert_int_eq(eventq_min_key(eq), 5);
+   ck_assert_ptr_eq(eventq_extract_min(eq), (void*)1);
+   ck_assert_ptr_eq(eventq_extract_min(eq), (void*)3);
+   ck_assert_int_eq(eventq_min_key(eq), 62);
+
+   eventq_insert(eq, 10, (void*)5);
+   ck_assert_ptr_eq(eventq_extract_min(eq), (void*)5);
+   ck_assert_ptr_eq(eventq_extract_min(eq), (void*)4);
+
+   ck_assert_int_eq(eventq_size(eq), 0);
+
+   eventq_free(eq);
+}
+END_TEST
+
+START_TEST(test_eventq_rand)
+{
+   eventq_t *eq = eventq_new();
+
+   static const int N = 4096;
+   uintptr_t keys[N];
+
+   // Mostly a few repeating times with some far future events that
+   // will not fit in the wheel
+   for (int i = 0; i < N; i++) {
+      if (rand() % 8 == 0)
+         keys[i] = 1 + rand();
+      else
+         keys[i] = 1 + (rand() % 200) * 1000;
+
+      eventq_insert(eq, keys[i], (void*)keys[i]);
+   }
+
+   ck_assert_int_eq(eventq_size(eq), N);
+
+   qsort(keys, N, sizeof(uintptr_t), magnitude_compar);
+
+   for (int i = 0; i < N; i++) {
+      ck_assert_int_eq(eventq_min_key(eq), keys[i]);
+      ck_assert_ptr_eq(eventq_extract_min(eq), (void*)keys[i]);
+   }
+
+   ck_assert_int_eq(eventq_size(eq), 0);
+
+   eventq_free(eq);
+}
+END_TEST
+
+static bool eventq_delete_cb(uint64_t key, void *value, void *context)
+{
+   ck_assert_int_eq(key, (uintptr_t)value);
+   return value == context;
+}
+
+START_TEST(test_eventq_delete)
+{
+   eventq_t *eq = eventq_new();
+
+   static const int N = 1024;
+   uintptr_t keys[N];
+
+   for (int i = 0; i < N; i++) {
+      keys[i] = 1 + rand() % 10000;
+      eventq_insert(eq, keys[i], (void*)keys[i]);
+   }
+
+   int deleted = 0;
+   for (int i = 0; i < N; i++) {
+      if (rand() % 20 == 0) {
+         ck_assert(eventq_delete(eq, eventq_delete_cb, (void*)keys[i]));
+         keys[i] = 0;
+         deleted++;
+      }
+   }
+
+   ck_assert(!eventq_delete(eq, eventq_delete_cb, (void*)100000));
+   ck_assert_int_eq(eventq_size(eq), N - deleted);
+
+   qsort(keys, N, sizeof(uintptr_t), magnitude_compar);
+
+   for (int i = 0; i < deleted; i++)
+      ck_assert_int_eq(keys[i], 0);
+
+   for (int i = deleted; i < N; i++)
+      ck_assert_ptr_eq(eventq_extract_min(eq), (void*)keys[i]);
+
+   eventq_free(eq);
+}
+END_TEST
+
 START_TEST(test_color_printf)
 {
    setenv("NVC_COLORS", "always", 1);
@@ -891,6 +995,12 @@ Suite *get_misc_tests(void)
    tcase_add_test(tc_heap, test_heap_delete);
    suite_add_tcase(s, tc_heap);
 
+   TCase *tc_eventq = tcase_create("eventq");
+   tcase_add_test(tc_eventq, test_eventq_basic);
+   tcase_add_test(tc_eventq, test_eventq_rand);
+   tcase_add_test(tc_eventq, test_eventq_delete);
+   suite_add_tcase(s, tc_eventq);
+
    TCase *tc_util = tcase_create("util");
    tcase_add_test(tc_util, test_color_printf);
    tcase_add_test(tc_util, test_strip);
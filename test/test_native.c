@@ -21,6 +21,7 @@
 #include "jit/jit.h"
 #include "option.h"
 
+#include <math.h>
 #include <stdlib.h>
 #include <inttypes.h>
 
@@ -50,7 +51,7 @@ static jit_handle_t assemble(jit_t *j, const char *text, const char *name,
 
 static jit_t *get_native_jit(void)
 {
-   opt_set_int(OPT_JIT_THRESHOLD, 1);
+   opt_set_int(OPT_JIT_NATIVE_THRESHOLD, 1);
    opt_set_int(OPT_JIT_ASYNC, 0);
 
    jit_t *j = jit_new(NULL);
@@ -904,6 +905,31 @@ START_TEST(test_exp)
    ck_assert_int_eq(jit_call(j, h1, 666, 1).integer, 666);
    ck_assert_int_eq(jit_call(j, h1, 99, 0).integer, 1);
 
+   const char *text2 =
+      "    RECV       R0, #0          \n"
+      "    RECV       R1, #1          \n"
+      "    $EXP.O.32  R2, R0, R1      \n"
+      "    CSET       R3              \n"
+      "    SEND       #0, R3          \n"
+      "    RET                        \n";
+
+   jit_handle_t h2 = assemble(j, text2, "exp2", "ii");
+   ck_assert_int_eq(jit_call(j, h2, 3, 4).integer, 0);
+   ck_assert_int_eq(jit_call(j, h2, 2, 31).integer, 1);
+   ck_assert_int_eq(jit_call(j, h2, -2, 31).integer, 0);
+   ck_assert_int_eq(jit_call(j, h2, 10, 10).integer, 1);
+
+   const char *text3 =
+      "    RECV       R0, #0          \n"
+      "    RECV       R1, #1          \n"
+      "    $EXP.C.8   R2, R0, R1      \n"
+      "    SEND       #0, R2          \n"
+      "    RET                        \n";
+
+   jit_handle_t h3 = assemble(j, text3, "exp3", "ii");
+   ck_assert_int_eq(jit_call(j, h3, 3, 5).integer, 243);
+   ck_assert_int_eq(jit_call(j, h3, 2, 7).integer, 128);
+
    jit_free(j);
 }
 END_TEST
@@ -1236,6 +1262,90 @@ START_TEST(test_sub)
 }
 END_TEST
 
+START_TEST(test_nan)
+{
+   jit_t *j = get_native_jit();
+
+   static const struct {
+      const char *cc;
+      int         ordered;
+      int         nan;
+   } cases[] = {
+      { "LT", 1, 0 }, { "LE", 1, 0 }, { "GT", 0, 0 },
+      { "GE", 0, 0 }, { "EQ", 0, 0 }, { "NE", 1, 1 },
+   };
+
+   for (int i = 0; i < ARRAY_LEN(cases); i++) {
+      char text[256], name[16];
+      checked_sprintf(text, sizeof(text),
+                      "    RECV     R0, #0          \n"
+                      "    RECV     R1, #1          \n"
+                      "    FCMP.%s  R0, R1          \n"
+                      "    CSET     R2              \n"
+                      "    SEND     #0, R2          \n"
+                      "    RET                      \n", cases[i].cc);
+      checked_sprintf(name, sizeof(name), "nan%d", i);
+
+      jit_handle_t h = assemble(j, text, name, "ff");
+      ck_assert_int_eq(jit_call(j, h, 1.0, 2.0).integer, cases[i].ordered);
+      ck_assert_int_eq(jit_call(j, h, NAN, 2.0).integer, cases[i].nan);
+      ck_assert_int_eq(jit_call(j, h, 1.0, NAN).integer, cases[i].nan);
+   }
+
+   const char *text1 =
+      "    RECV     R0, #0          \n"
+      "    RECV     R1, #1          \n"
+      "    CMP.EQ   R1, #1          \n"
+      "    FCCMP.EQ R0, R0          \n"
+      "    CSET     R2              \n"
+      "    SEND     #0, R2          \n"
+      "    RET                      \n";
+
+   jit_handle_t h1 = assemble(j, text1, "nanccmp", "fi");
+   ck_assert_int_eq(jit_call(j, h1, 1.0, 1).integer, 1);
+   ck_assert_int_eq(jit_call(j, h1, 1.0, 0).integer, 0);
+   ck_assert_int_eq(jit_call(j, h1, NAN, 1).integer, 0);
+
+   jit_free(j);
+}
+END_TEST
+
+START_TEST(test_narrow)
+{
+   jit_t *j = get_native_jit();
+
+   const char *text1 =
+      "    $SALLOC   R0, #0, #8      \n"
+      "    STORE.64  #-1, [R0]       \n"
+      "    STORE.8   #0x42, [R0]     \n"
+      "    STORE.16  #0x1234, [R0+2] \n"
+      "    LOAD.64   R1, [R0]        \n"
+      "    SEND      #0, R1          \n"
+      "    RET                       \n";
+
+   jit_handle_t h1 = assemble(j, text1, "narrow1", "");
+   ck_assert_int_eq(jit_call(j, h1).integer, (int64_t)0xffffffff1234ff42);
+
+   const char *text2 =
+      "    RECV      R0, #0          \n"
+      "    $SALLOC   R1, #0, #8      \n"
+      "    STORE.64  R0, [R1]        \n"
+      "    LOAD.8    R2, [R1+1]      \n"
+      "    LOAD.16   R3, [R1+2]      \n"
+      "    ADD       R4, R2, R3      \n"
+      "    SEND      #0, R4          \n"
+      "    RET                       \n";
+
+   jit_handle_t h2 = assemble(j, text2, "narrow2", "I");
+   ck_assert_int_eq(jit_call(j, h2, INT64_C(0x00007fff8000)).integer,
+                    INT16_MAX - 128);
+   ck_assert_int_eq(jit_call(j, h2, INT64_C(0x800001ff)).integer,
+                    INT16_MIN + 1);
+
+   jit_free(j);
+}
+END_TEST
+
 Suite *get_native_tests(void)
 {
    Suite *s = suite_create("native");
@@ -1264,6 +1374,8 @@ Suite *get_native_tests(void)
    tcase_add_test(tc, test_memset);
    tcase_add_test(tc, test_move);
    tcase_add_test(tc, test_sub);
+   tcase_add_test(tc, test_nan);
+   tcase_add_test(tc, test_narrow);
    suite_add_tcase(s, tc);
 
    return s;